@@ -0,0 +1,286 @@
+#include "asset_cache.hpp"
+
+#include <cmrc/cmrc.hpp>
+CMRC_DECLARE(asset);
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <tuple>
+
+
+
+namespace oe::asset
+{
+	AssetCache& AssetCache::get()
+	{
+		static AssetCache singleton;
+		return singleton;
+	}
+
+	size_t AssetCache::key_hash::operator()(const key& k) const noexcept
+	{
+		return std::hash<std::string>{}(k.path) ^ (k.type.hash_code() << 1) ^ static_cast<size_t>(k.from);
+	}
+
+	// MurmurHash64A
+	uint64_t AssetCache::content_hash(gsl::span<const uint8_t> bytes) noexcept
+	{
+		constexpr uint64_t m = 0xc6a4a7935bd1e995ull;
+		constexpr int r = 47;
+
+		const size_t size = bytes.size();
+		uint64_t hash = 0x9e3779b97f4a7c15ull ^ (size * m);
+		const uint8_t* data = bytes.data();
+		for (size_t i = 0; i < size / 8; i++)
+		{
+			uint64_t k;
+			std::memcpy(&k, data + i * 8, 8);
+			k *= m;
+			k ^= k >> r;
+			k *= m;
+			hash ^= k;
+			hash *= m;
+		}
+
+		if (size % 8)
+		{
+			uint64_t k = 0;
+			std::memcpy(&k, data + size / 8 * 8, size % 8);
+			hash ^= k;
+			hash *= m;
+		}
+
+		hash ^= hash >> r;
+		hash *= m;
+		hash ^= hash >> r;
+		return hash;
+	}
+
+	// zip entries have the stamp of the archive
+	AssetCache::file_stamp AssetCache::stamp_of(const fs::path& path)
+	{
+		std::error_code ec;
+		fs::path existing = path;
+		while (!fs::exists(existing, ec) && existing.has_parent_path() && existing.parent_path() != existing)
+			existing = existing.parent_path();
+
+		file_stamp stamp;
+		stamp.modified = fs::last_write_time(existing, ec);
+		if (fs::is_regular_file(existing, ec))
+			stamp.size = fs::file_size(existing, ec);
+		return stamp;
+	}
+
+	gsl::span<const uint8_t> AssetCache::read(source from, const std::string& path, oe::utils::mapped_file& mapped)
+	{
+		if (from == source::file)
+		{
+			mapped = oe::utils::FileIO{ fs::path{ path } }.map();
+			return mapped.span();
+		}
+
+		const auto file = cmrc::asset::get_filesystem().open("asset/" + path);
+		return { reinterpret_cast<const uint8_t*>(&*file.begin()), file.size() };
+	}
+
+	bool AssetCache::same_bytes(gsl::span<const uint8_t> bytes, source from, const std::string& path)
+	{
+		try
+		{
+			oe::utils::mapped_file mapped;
+			const auto other = read(from, path, mapped);
+			return other.size() == bytes.size() && std::memcmp(other.data(), bytes.data(), bytes.size()) == 0;
+		}
+		catch (const std::exception&)
+		{
+			return false; // gone since, decoded again
+		}
+	}
+
+	std::shared_ptr<const void> AssetCache::lookup(source from, std::string path, std::type_index type, const decode_fn& decode)
+	{
+		key id{ from, std::move(path), type };
+		const auto now = std::chrono::steady_clock::now();
+		{
+			std::scoped_lock lock(m_mtx);
+			const auto found = m_lookup.find(id);
+			if (found != m_lookup.end() && (from == source::resource || now - found->second->checked < stamp_interval))
+			{
+				m_lru.splice(m_lru.begin(), m_lru, found->second);
+				m_stats.hits++;
+				return found->second->asset;
+			}
+		}
+
+		const file_stamp stamp = from == source::file ? stamp_of(id.path) : file_stamp{};
+		{
+			std::scoped_lock lock(m_mtx);
+			const auto found = m_lookup.find(id);
+			if (found != m_lookup.end())
+			{
+				if (found->second->stamp == stamp)
+				{
+					found->second->checked = now;
+					m_lru.splice(m_lru.begin(), m_lru, found->second);
+					m_stats.hits++;
+					return found->second->asset;
+				}
+
+				remove(found->second);
+				m_stats.reloads++;
+			}
+			m_stats.misses++;
+		}
+
+		// reading and decoding without the lock
+		oe::utils::mapped_file mapped;
+		const gsl::span<const uint8_t> bytes = read(from, id.path, mapped);
+
+		const content_key content{ content_hash(bytes), bytes.size(), type };
+		std::shared_ptr<const void> asset;
+		size_t size = 0;
+		source same_from = source::file;
+		std::string same_path;
+		{
+			std::scoped_lock lock(m_mtx);
+			const auto same = m_contents.find(content);
+			if (same != m_contents.end())
+			{
+				asset = same->second.asset.lock();
+				size = same->second.bytes;
+				same_from = same->second.from;
+				same_path = same->second.path;
+				if (!asset)
+					m_contents.erase(same);
+			}
+		}
+
+		// the hash and the size matching is not enough
+		if (asset && !same_bytes(bytes, same_from, same_path))
+			asset.reset();
+
+		const bool deduplicated = asset != nullptr;
+		if (!deduplicated)
+			std::tie(asset, size) = decode(bytes);
+
+		std::scoped_lock lock(m_mtx);
+		// another thread loaded it meanwhile
+		const auto found = m_lookup.find(id);
+		if (found != m_lookup.end())
+			return found->second->asset;
+
+		auto [record, inserted] = m_contents.try_emplace(content);
+		if (inserted || record->second.asset.expired())
+			record->second = { asset, size, 0, from, id.path };
+
+		// the bytes are counted once for every entry sharing the asset
+		// a decode that lost a race to the same content or collides with other content counts its own
+		const bool shared = record->second.asset.lock() == asset;
+		if (!shared || record->second.entries++ == 0)
+			m_stats.bytes += size;
+		if (deduplicated)
+			m_stats.deduplicated++;
+
+		m_lru.push_front({ id, content, asset, shared ? 0 : size, shared, stamp, now });
+		m_lookup.emplace(std::move(id), m_lru.begin());
+		evict();
+		return asset;
+	}
+
+	void AssetCache::remove(lru_list::iterator it)
+	{
+		const content_key content = it->content;
+		const bool shared = it->shared;
+		m_stats.bytes -= it->bytes;
+		m_lookup.erase(it->id);
+		m_lru.erase(it);
+		if (!shared)
+			return;
+
+		// the last entry holding it, no longer in the budget, dropped too if nothing else holds it
+		const auto same = m_contents.find(content);
+		if (same == m_contents.end() || --same->second.entries != 0)
+			return;
+		m_stats.bytes -= same->second.bytes;
+		if (same->second.asset.expired())
+			m_contents.erase(same);
+	}
+
+	void AssetCache::evict()
+	{
+		// the most recent one stays even if it alone is over the budget
+		while (m_stats.bytes > m_budget && m_lru.size() > 1)
+		{
+			remove(std::prev(m_lru.end()));
+			m_stats.evictions++;
+		}
+	}
+
+	std::vector<fs::path> AssetCache::check_for_changes()
+	{
+		std::vector<std::pair<key, file_stamp>> files;
+		{
+			std::scoped_lock lock(m_mtx);
+			for (const auto& cached : m_lru)
+				if (cached.id.from == source::file)
+					files.emplace_back(cached.id, cached.stamp);
+		}
+
+		// no lock for the file system
+		files.erase(std::remove_if(files.begin(), files.end(), [](const auto& file){ return stamp_of(file.first.path) == file.second; }), files.end());
+
+		std::vector<fs::path> changed;
+		std::scoped_lock lock(m_mtx);
+		for (const auto& [id, stamp] : files)
+		{
+			const auto found = m_lookup.find(id);
+			if (found != m_lookup.end() && found->second->stamp == stamp)
+			{
+				remove(found->second);
+				m_stats.reloads++;
+			}
+			if (std::find(changed.begin(), changed.end(), fs::path{ id.path }) == changed.end())
+				changed.emplace_back(id.path);
+		}
+		return changed;
+	}
+
+	void AssetCache::invalidate(const oe::utils::FileIO& path)
+	{
+		const std::string generic = path.getPath().generic_string();
+		std::scoped_lock lock(m_mtx);
+		for (auto it = m_lru.begin(); it != m_lru.end();)
+		{
+			const auto next = std::next(it);
+			if (it->id.from == source::file && it->id.path == generic)
+				remove(it);
+			it = next;
+		}
+	}
+
+	void AssetCache::clear()
+	{
+		std::scoped_lock lock(m_mtx);
+		m_lookup.clear();
+		m_lru.clear();
+		m_contents.clear();
+		m_stats.bytes = 0;
+	}
+
+	void AssetCache::set_budget(size_t bytes)
+	{
+		std::scoped_lock lock(m_mtx);
+		m_budget = bytes;
+		evict();
+	}
+
+	asset_cache_stats AssetCache::stats()
+	{
+		std::scoped_lock lock(m_mtx);
+		asset_cache_stats stats = m_stats;
+		stats.entries = m_lru.size();
+		stats.budget = m_budget;
+		return stats;
+	}
+}
@@ -0,0 +1,203 @@
+#pragma once
+
+#include "engine/utility/fileio.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <typeindex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+
+
+/*
+
+	Decoded assets shared by everything that loads them, instead of a fresh copy per load
+
+		std::shared_ptr<const oe::utils::image_data> a = oe::asset::AssetCache::get().load<oe::utils::image_data>("res/player.png");
+		auto b = oe::asset::AssetCache::get().load<oe::utils::image_data>("res/player.png"); // same object, no decoding
+		auto c = oe::asset::AssetCache::get().load<oe::utils::image_data>("res/player_copy.png"); // same bytes, also the same object
+		auto vert = oe::asset::AssetCache::get().resource<std::string>("shader/default_shader/shader.vert.glsl"); // built in assets
+
+	a file that changed on disk is decoded again on its next load, loads within stamp_interval of the last check trust it
+	check_for_changes() drops every changed one right away and tells which, to rebuild whatever was made out of them
+
+*/
+
+namespace oe::asset
+{
+	struct asset_cache_stats
+	{
+		size_t entries = 0;
+		size_t bytes = 0;        // decoded and held by the cache, an asset shared by several paths is counted once
+		size_t budget = 0;
+		size_t hits = 0;
+		size_t misses = 0;
+		size_t deduplicated = 0; // misses that found the same content already decoded
+		size_t evictions = 0;    // least recently used over the budget
+		size_t reloads = 0;      // changed on disk
+	};
+
+	// the types the cache can decode, T(bytes) and the memory it takes
+	template<typename T> struct asset_decoder;
+
+	template<> struct asset_decoder<oe::utils::image_data>
+	{
+		static oe::utils::image_data decode(gsl::span<const uint8_t> bytes) { return { bytes }; }
+		static size_t size_of(const oe::utils::image_data& image) noexcept { return image.size; }
+	};
+
+	template<> struct asset_decoder<oe::utils::audio_data>
+	{
+		static oe::utils::audio_data decode(gsl::span<const uint8_t> bytes) { return { bytes }; }
+		static size_t size_of(const oe::utils::audio_data& audio) noexcept { return static_cast<size_t>(audio.size); } // already bytes
+	};
+
+	template<> struct asset_decoder<std::string>
+	{
+		static std::string decode(gsl::span<const uint8_t> bytes) { return { bytes.data(), bytes.data() + bytes.size() }; }
+		static size_t size_of(const std::string& string) noexcept { return string.size(); }
+	};
+
+	template<> struct asset_decoder<oe::utils::byte_string>
+	{
+		static oe::utils::byte_string decode(gsl::span<const uint8_t> bytes) { return { bytes.data(), bytes.data() + bytes.size() }; }
+		static size_t size_of(const oe::utils::byte_string& data) noexcept { return data.size(); }
+	};
+
+	// process wide cache of decoded assets keyed by path and by content hash, thread safe
+	class AssetCache
+	{
+	public:
+		static constexpr size_t default_budget = 256 * 1024 * 1024;
+		// a cached file is stat'ed again on a load only after this long
+		static constexpr std::chrono::milliseconds stamp_interval{ 500 };
+
+		using decoded = std::pair<std::shared_ptr<const void>, size_t>; // the asset and its size
+		using decode_fn = std::function<decoded(gsl::span<const uint8_t>)>;
+
+	private:
+		enum class source : uint8_t { file, resource };
+
+		struct file_stamp
+		{
+			fs::file_time_type modified{};
+			uintmax_t size = 0;
+
+			inline bool operator==(const file_stamp& other) const noexcept { return modified == other.modified && size == other.size; }
+			inline bool operator!=(const file_stamp& other) const noexcept { return !(*this == other); }
+		};
+
+		struct key
+		{
+			source from;
+			std::string path;
+			std::type_index type;
+
+			inline bool operator==(const key& other) const noexcept { return from == other.from && type == other.type && path == other.path; }
+		};
+
+		struct key_hash
+		{
+			size_t operator()(const key& k) const noexcept;
+		};
+
+		struct content_key
+		{
+			uint64_t hash;
+			size_t size; // of the encoded content
+			std::type_index type;
+
+			inline bool operator==(const content_key& other) const noexcept { return hash == other.hash && size == other.size && type == other.type; }
+		};
+
+		struct content_key_hash
+		{
+			inline size_t operator()(const content_key& k) const noexcept { return static_cast<size_t>(k.hash) ^ k.type.hash_code(); }
+		};
+
+		// a decoded asset, whichever entries hold it share its bytes
+		struct content_record
+		{
+			std::weak_ptr<const void> asset;
+			size_t bytes = 0;
+			size_t entries = 0; // in the cache holding it, its bytes count towards the budget while there are any
+			source from;        // where it was read from, the bytes are compared before sharing it
+			std::string path;
+		};
+
+		struct entry
+		{
+			key id;
+			content_key content;
+			std::shared_ptr<const void> asset;
+			size_t bytes;     // counted here if not shared
+			bool shared;      // the bytes are counted in m_contents
+			file_stamp stamp; // when it was read, files only
+			std::chrono::steady_clock::time_point checked;
+		};
+		using lru_list = std::list<entry>;
+
+		std::mutex m_mtx;
+		lru_list m_lru; // most recently used first
+		std::unordered_map<key, lru_list::iterator, key_hash> m_lookup;
+		std::unordered_map<content_key, content_record, content_key_hash> m_contents;
+		size_t m_budget = default_budget;
+		asset_cache_stats m_stats;
+
+	public:
+		static AssetCache& get();
+
+		// any file FileIO reads, zip entries included
+		// throws whatever reading or decoding throws
+		template<typename T>
+		[[nodiscard]] std::shared_ptr<const T> load(const oe::utils::FileIO& path)
+		{
+			return std::static_pointer_cast<const T>(lookup(source::file, path.getPath().generic_string(), typeid(T), &decode<T>));
+		}
+
+		// the assets built into the engine, what AssetLoader reads
+		template<typename T>
+		[[nodiscard]] std::shared_ptr<const T> resource(const std::string& resource_path)
+		{
+			return std::static_pointer_cast<const T>(lookup(source::resource, resource_path, typeid(T), &decode<T>));
+		}
+
+		// drops the files that changed on disk since they were loaded and returns their paths
+		std::vector<fs::path> check_for_changes();
+		// the next load of it decodes it again, handles already given out stay valid
+		void invalidate(const oe::utils::FileIO& path);
+		void clear();
+		// evicts right away if it is over the new budget
+		void set_budget(size_t bytes);
+
+		[[nodiscard]] asset_cache_stats stats();
+
+		// 64 bit hash of the content, what deduplication compares
+		[[nodiscard]] static uint64_t content_hash(gsl::span<const uint8_t> bytes) noexcept;
+
+	private:
+		template<typename T>
+		static decoded decode(gsl::span<const uint8_t> bytes)
+		{
+			auto asset = std::make_shared<const T>(asset_decoder<T>::decode(bytes));
+			const size_t size = asset_decoder<T>::size_of(*asset);
+			return { std::move(asset), size };
+		}
+
+		std::shared_ptr<const void> lookup(source from, std::string path, std::type_index type, const decode_fn& decode);
+		static file_stamp stamp_of(const fs::path& path);
+		// the encoded content, 'mapped' keeps a file mapped
+		static gsl::span<const uint8_t> read(source from, const std::string& path, oe::utils::mapped_file& mapped);
+		static bool same_bytes(gsl::span<const uint8_t> bytes, source from, const std::string& path);
+		// m_mtx held
+		void remove(lru_list::iterator it);
+		void evict();
+	};
+}
@@ -0,0 +1,190 @@
+#include "asset_streamer.hpp"
+
+#include <algorithm>
+
+
+
+namespace oe::asset
+{
+	size_t AssetStreamer::default_worker_count() noexcept
+	{
+		const size_t cores = std::thread::hardware_concurrency();
+		return std::max<size_t>(cores, 2) - 1;
+	}
+
+	AssetStreamer::AssetStreamer(size_t workers)
+	{
+		workers = std::max<size_t>(workers, 1);
+		m_workers.reserve(workers);
+		for (size_t i = 0; i < workers; i++)
+			m_workers.emplace_back([this](){ work(); });
+	}
+
+	AssetStreamer::~AssetStreamer()
+	{
+		{
+			std::scoped_lock lock(m_queue_mtx);
+			m_stopping = true;
+		}
+		m_queue_cv.notify_all();
+		for (auto& worker : m_workers)
+			worker.join();
+
+		// nobody is going to decode or upload these anymore
+		for (job_queue* queue : { &m_queue, &m_uploads })
+		{
+			for (; !queue->empty(); queue->pop())
+			{
+				// decoded data of a job cancelled before this is still in it
+				const job_ptr& job = queue->top();
+				job->cancel();
+				job->discard();
+			}
+		}
+	}
+
+	asset_handle<oe::graphics::Texture> AssetStreamer::load_texture(const oe::utils::FileIO& path, const oe::TextureInfo& settings, load_priority priority)
+	{
+		return submit<oe::graphics::Texture>(
+			[path](){ return path.read<oe::utils::image_data>(); },
+			[settings](oe::utils::image_data& image){
+				oe::TextureInfo info = settings;
+				info.empty = false;
+				info.data = image.data;
+				info.data_type = oe::TextureInfo::data_types::bytes;
+				info.data_format = image.format;
+				info.size_offset = { { image.width, 0 }, { image.height, 0 } };
+				return oe::graphics::Texture{ info };
+			},
+			priority);
+	}
+
+	asset_handle<oe::graphics::Texture> AssetStreamer::load_baked_texture(const oe::utils::FileIO& path, const oe::TextureInfo& settings, load_priority priority)
+	{
+		return submit<oe::graphics::Texture>(
+			[path](){ return BakedTexture{ path }; },
+			[settings](BakedTexture& baked){ return baked.texture(settings); },
+			priority);
+	}
+
+	asset_handle<AssetLoader::res_variant> AssetStreamer::load_resource(const std::string& resource_path, AssetLoader::asset_type type, load_priority priority)
+	{
+		return submit<AssetLoader::res_variant>([resource_path, type](){ return AssetLoader::resource(resource_path, type); }, priority);
+	}
+
+	size_t AssetStreamer::upload(std::chrono::microseconds budget)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		size_t uploaded = 0;
+		while (true)
+		{
+			job_ptr job;
+			{
+				std::scoped_lock lock(m_upload_mtx);
+				if (m_uploads.empty())
+					break;
+				job = m_uploads.top();
+				m_uploads.pop();
+			}
+
+			// cancelled after decoding
+			if (!job->advance(load_status::decoded, load_status::uploading))
+			{
+				job->discard();
+				continue;
+			}
+
+			try
+			{
+				job->upload();
+				job->finish(load_status::ready);
+			}
+			catch (...)
+			{
+				job->m_error = std::current_exception();
+				job->finish(load_status::failed);
+			}
+
+			uploaded++;
+			if (std::chrono::steady_clock::now() - start >= budget)
+				break;
+		}
+		return uploaded;
+	}
+
+	size_t AssetStreamer::queued()
+	{
+		std::scoped_lock lock(m_queue_mtx);
+		return m_queue.size();
+	}
+
+	size_t AssetStreamer::waiting_uploads()
+	{
+		std::scoped_lock lock(m_upload_mtx);
+		return m_uploads.size();
+	}
+
+	void AssetStreamer::enqueue(job_ptr job, load_priority priority)
+	{
+		{
+			std::scoped_lock lock(m_queue_mtx);
+			job->m_priority = priority;
+			job->m_sequence = m_sequence++;
+			m_queue.push(std::move(job));
+		}
+		m_queue_cv.notify_one();
+	}
+
+	void AssetStreamer::work()
+	{
+		while (true)
+		{
+			job_ptr job;
+			{
+				std::unique_lock lock(m_queue_mtx);
+				m_queue_cv.wait(lock, [this](){ return m_stopping || !m_queue.empty(); });
+				if (m_stopping)
+					return;
+				job = m_queue.top();
+				m_queue.pop();
+			}
+
+			// cancelled while queued
+			if (job->advance(load_status::queued, load_status::loading))
+				decode(job);
+		}
+	}
+
+	void AssetStreamer::decode(const job_ptr& job)
+	{
+		try
+		{
+			job->decode();
+		}
+		catch (...)
+		{
+			job->m_error = std::current_exception();
+			if (job->advance(load_status::loading, load_status::failed))
+				job->m_done.notify();
+			return;
+		}
+
+		if (!job->has_upload())
+		{
+			if (job->advance(load_status::loading, load_status::ready))
+				job->m_done.notify();
+			else
+				job->discard(); // cancelled while decoding
+			return;
+		}
+
+		if (!job->advance(load_status::loading, load_status::decoded))
+		{
+			job->discard();
+			return;
+		}
+
+		std::scoped_lock lock(m_upload_mtx);
+		m_uploads.push(job);
+	}
+}
@@ -0,0 +1,293 @@
+#pragma once
+
+#include "engine/asset/asset_loader.hpp"
+#include "engine/asset/baked_texture.hpp"
+#include "engine/interfacegen.hpp"
+#include "engine/utility/event_count.hpp"
+#include "engine/utility/fileio.hpp"
+#include "engine/utility/formatted_error.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+
+
+/*
+
+	Assets decoded on worker threads, highest priority first, with the GPU uploads left to the GL thread
+
+	any thread:
+		auto atlas = streamer.load_texture("res/level_1/atlas.png", {}, oe::asset::load_priority::high);
+		auto music = streamer.load<oe::utils::audio_data>("res/level_1/music.mp3", oe::asset::load_priority::background);
+		auto level = streamer.submit<level_data>([](){ return parse_level("res/level_1.json"); });
+	GL thread, every RenderEvent:
+		streamer.upload(); // texture uploads until the per frame budget is used up
+		if (atlas.ready()) sprite.m_owner = atlas.get();
+	or let the window do the uploads:
+		window->connect_listener<oe::RenderEvent, &oe::asset::AssetStreamer::on_render>(&streamer);
+	anywhere:
+		music.cancel(); // dropped before, or right after decoding
+
+	never wait() or get() a texture on the GL thread before it is ready(), its upload would never run
+
+*/
+
+namespace oe::asset
+{
+	enum class load_priority : uint8_t
+	{
+		background, normal, high, critical
+	};
+
+	enum class load_status : uint8_t
+	{
+		queued, loading, decoded, uploading, // in progress
+		ready, failed, cancelled             // finished
+	};
+
+	namespace detail
+	{
+		// the part of a load the workers and the upload stage see
+		struct stream_job
+		{
+			std::atomic<load_status> m_status{ load_status::queued };
+			oe::utils::event_count m_done;
+			std::exception_ptr m_error;
+			load_priority m_priority = load_priority::normal;
+			uint64_t m_sequence = 0;
+
+			virtual ~stream_job() = default;
+			virtual void decode() = 0; // worker thread
+			virtual void upload() = 0; // GL thread
+			virtual void discard() noexcept = 0; // drops decoded data of a cancelled load
+			[[nodiscard]] virtual bool has_upload() const noexcept = 0;
+
+			// whoever moves it out of 'from' owns the next step, cancel() races the workers and the upload stage for it
+			inline bool advance(load_status from, load_status to) noexcept
+			{
+				return m_status.compare_exchange_strong(from, to, std::memory_order_acq_rel);
+			}
+
+			inline void finish(load_status status) noexcept
+			{
+				m_status.store(status, std::memory_order_release);
+				m_done.notify();
+			}
+
+			[[nodiscard]] inline bool finished() const noexcept
+			{
+				return m_status.load(std::memory_order_acquire) >= load_status::ready;
+			}
+
+			// true if it will not become ready, false if it already finished or is being uploaded
+			inline bool cancel() noexcept
+			{
+				for (const load_status from : { load_status::queued, load_status::loading, load_status::decoded })
+				{
+					if (advance(from, load_status::cancelled))
+					{
+						m_done.notify();
+						return true;
+					}
+				}
+				return false;
+			}
+		};
+
+		template<typename T>
+		struct stream_state : stream_job
+		{
+			std::optional<T> m_result;
+		};
+
+		template<typename T, typename Decoded>
+		struct stream_task final : stream_state<T>
+		{
+			std::function<Decoded()> m_decode_fn;
+			std::function<T(Decoded&)> m_upload_fn; // none if decoding is all there is
+
+			std::optional<Decoded> m_decoded;
+
+			void decode() override
+			{
+				if constexpr (std::is_same_v<T, Decoded>)
+				{
+					if (!m_upload_fn)
+					{
+						this->m_result.emplace(m_decode_fn());
+						return;
+					}
+				}
+				m_decoded.emplace(m_decode_fn());
+			}
+
+			void upload() override
+			{
+				this->m_result.emplace(m_upload_fn(*m_decoded));
+				m_decoded.reset();
+			}
+
+			void discard() noexcept override
+			{
+				m_decoded.reset();
+				this->m_result.reset();
+			}
+
+			[[nodiscard]] bool has_upload() const noexcept override { return static_cast<bool>(m_upload_fn); }
+		};
+	}
+
+	// the result of an AssetStreamer load, shared by all copies
+	template<typename T>
+	class asset_handle
+	{
+	private:
+		std::shared_ptr<detail::stream_state<T>> m_state;
+
+	public:
+		asset_handle() = default;
+		explicit asset_handle(std::shared_ptr<detail::stream_state<T>> state) noexcept
+			: m_state(std::move(state))
+		{}
+
+		[[nodiscard]] inline bool valid() const noexcept { return static_cast<bool>(m_state); }
+		// failed if default constructed
+		[[nodiscard]] inline load_status status() const noexcept { return m_state ? m_state->m_status.load(std::memory_order_acquire) : load_status::failed; }
+		[[nodiscard]] inline bool ready() const noexcept { return status() == load_status::ready; }
+		// ready, failed or cancelled
+		[[nodiscard]] inline bool finished() const noexcept { return status() >= load_status::ready; }
+
+		inline void wait() const
+		{
+			m_state->m_done.wait([this](){ return m_state->finished(); });
+		}
+
+		template<typename Rep, typename Period>
+		inline bool wait_for(const std::chrono::duration<Rep, Period>& duration) const
+		{
+			return m_state->m_done.wait_for([this](){ return m_state->finished(); }, duration);
+		}
+
+		// waits, then throws whatever the loader threw or if it was cancelled
+		[[nodiscard]] inline const T& get() const
+		{
+			wait();
+			switch (status())
+			{
+			case load_status::failed:
+				std::rethrow_exception(m_state->m_error);
+			case load_status::cancelled:
+				throw oe::utils::formatted_error("Asset load was cancelled");
+			default:
+				return *m_state->m_result;
+			}
+		}
+
+		// true if it will not become ready, a decode in progress is dropped once it is done
+		inline bool cancel() noexcept { return m_state->cancel(); }
+	};
+
+	// worker threads decoding assets by priority, and a GL thread stage for the uploads
+	class AssetStreamer
+	{
+	public:
+		static constexpr std::chrono::microseconds default_upload_budget{ 2000 };
+
+	private:
+		using job_ptr = std::shared_ptr<detail::stream_job>;
+
+		// highest priority first, then in submission order
+		struct job_order
+		{
+			inline bool operator()(const job_ptr& a, const job_ptr& b) const noexcept
+			{
+				return a->m_priority != b->m_priority ? a->m_priority < b->m_priority : a->m_sequence > b->m_sequence;
+			}
+		};
+		using job_queue = std::priority_queue<job_ptr, std::vector<job_ptr>, job_order>;
+
+		std::mutex m_queue_mtx;
+		std::condition_variable m_queue_cv;
+		job_queue m_queue;
+		uint64_t m_sequence = 0;
+		bool m_stopping = false;
+		std::vector<std::thread> m_workers;
+
+		std::mutex m_upload_mtx;
+		job_queue m_uploads;
+		std::chrono::microseconds m_upload_budget = default_upload_budget;
+
+	public:
+		// one less than the cores, the GL thread keeps one
+		[[nodiscard]] static size_t default_worker_count() noexcept;
+
+		explicit AssetStreamer(size_t workers = default_worker_count());
+		AssetStreamer(const AssetStreamer&) = delete;
+		// cancels everything not decoded yet and joins the workers
+		~AssetStreamer();
+
+		// 'decode' runs on a worker thread and returns the asset
+		template<typename T, typename Decode>
+		asset_handle<T> submit(Decode&& decode, load_priority priority = load_priority::normal)
+		{
+			auto task = std::make_shared<detail::stream_task<T, T>>();
+			task->m_decode_fn = std::forward<Decode>(decode);
+			enqueue(task, priority);
+			return asset_handle<T>{ std::move(task) };
+		}
+
+		// 'decode' runs on a worker thread, then 'upload' turns its result into the asset during upload() on the GL thread
+		template<typename T, typename Decode, typename Upload, typename Decoded = std::decay_t<std::invoke_result_t<Decode&>>, typename = std::enable_if_t<std::is_invocable_r_v<T, Upload&, Decoded&>>>
+		asset_handle<T> submit(Decode&& decode, Upload&& upload, load_priority priority = load_priority::normal)
+		{
+			auto task = std::make_shared<detail::stream_task<T, Decoded>>();
+			task->m_decode_fn = std::forward<Decode>(decode);
+			task->m_upload_fn = std::forward<Upload>(upload);
+			enqueue(task, priority);
+			return asset_handle<T>{ std::move(task) };
+		}
+
+		// any FileIO::read type: image_data, audio_data, std::string, byte_string, mapped_file
+		template<typename T>
+		asset_handle<T> load(const oe::utils::FileIO& path, load_priority priority = load_priority::normal)
+		{
+			return submit<T>([path](){ return path.read<T>(); }, priority);
+		}
+
+		// decoded on a worker, uploaded by upload()
+		// 'settings' without the data, format and size, those come from the image
+		asset_handle<oe::graphics::Texture> load_texture(const oe::utils::FileIO& path, const oe::TextureInfo& settings = {}, load_priority priority = load_priority::normal);
+		// a .oetex mapped on a worker, uploaded by upload() with its mip levels
+		asset_handle<oe::graphics::Texture> load_baked_texture(const oe::utils::FileIO& path, const oe::TextureInfo& settings = {}, load_priority priority = load_priority::normal);
+		// AssetLoader::resource on a worker
+		asset_handle<AssetLoader::res_variant> load_resource(const std::string& resource_path, AssetLoader::asset_type type, load_priority priority = load_priority::normal);
+
+		// GL thread: uploads decoded assets until 'budget' is used up, at least one if any are waiting
+		// returns the number of uploads
+		size_t upload(std::chrono::microseconds budget = default_upload_budget);
+
+		// upload() with the budget from set_upload_budget
+		inline void on_render(const oe::RenderEvent& /* event */) { upload(m_upload_budget); }
+		inline void set_upload_budget(std::chrono::microseconds budget) noexcept { m_upload_budget = budget; }
+
+		// not started decoding yet
+		[[nodiscard]] size_t queued();
+		// decoded and waiting for upload()
+		[[nodiscard]] size_t waiting_uploads();
+
+	private:
+		void enqueue(job_ptr job, load_priority priority);
+		void work();
+		void decode(const job_ptr& job);
+	};
+}
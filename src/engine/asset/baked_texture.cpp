@@ -0,0 +1,290 @@
+#include "baked_texture.hpp"
+
+#include "engine/graphics/spritePacker.hpp"
+#include "engine/utility/formatted_error.hpp"
+
+#include <lz4.h>
+#include <lz4hc.h>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+
+
+namespace oe::asset
+{
+	static size_t align_up(size_t value) noexcept
+	{
+		return (value + baked::data_alignment - 1) / baked::data_alignment * baked::data_alignment;
+	}
+
+	// the same halving GL does for mip levels
+	static constexpr int level_size(int size, size_t level) noexcept
+	{
+		return std::max(1, size >> level);
+	}
+
+	static size_t level_bytes(oe::formats format, int width, int height, size_t level) noexcept
+	{
+		return static_cast<size_t>(level_size(width, level)) * static_cast<size_t>(level_size(height, level)) * oe::sizeofFormat(format);
+	}
+
+	// the tables are written field by field in little endian, whatever the host is
+	template<typename T>
+	using field_bits = std::conditional_t<sizeof(T) == 8, uint64_t, std::conditional_t<sizeof(T) == 4, uint32_t, std::conditional_t<sizeof(T) == 2, uint16_t, uint8_t>>>;
+
+	template<typename T>
+	static void store(uint8_t*& out, const T& value) noexcept
+	{
+		field_bits<T> bits;
+		std::memcpy(&bits, &value, sizeof(T));
+		for (size_t i = 0; i < sizeof(T); i++)
+			*out++ = static_cast<uint8_t>(bits >> (i * 8));
+	}
+
+	template<typename T>
+	static void load(const uint8_t*& in, T& value) noexcept
+	{
+		field_bits<T> bits = 0;
+		for (size_t i = 0; i < sizeof(T); i++)
+			bits |= static_cast<field_bits<T>>(static_cast<field_bits<T>>(*in++) << (i * 8));
+		std::memcpy(&value, &bits, sizeof(T));
+	}
+
+	static void store(uint8_t*& out, const baked::header& header) noexcept
+	{
+		std::memcpy(out, header.magic, sizeof(header.magic));
+		out += sizeof(header.magic);
+		store(out, header.version);
+		store(out, header.format);
+		store(out, header.compression);
+		store(out, header.width);
+		store(out, header.height);
+		store(out, header.mip_count);
+		store(out, header.sprite_count);
+	}
+
+	static void load(const uint8_t*& in, baked::header& header) noexcept
+	{
+		std::memcpy(header.magic, in, sizeof(header.magic));
+		in += sizeof(header.magic);
+		load(in, header.version);
+		load(in, header.format);
+		load(in, header.compression);
+		load(in, header.width);
+		load(in, header.height);
+		load(in, header.mip_count);
+		load(in, header.sprite_count);
+	}
+
+	static void store(uint8_t*& out, const baked::mip_entry& mip) noexcept
+	{
+		store(out, mip.offset);
+		store(out, mip.stored_size);
+		store(out, mip.size);
+	}
+
+	static void load(const uint8_t*& in, baked::mip_entry& mip) noexcept
+	{
+		load(in, mip.offset);
+		load(in, mip.stored_size);
+		load(in, mip.size);
+	}
+
+	static void store(uint8_t*& out, const baked::sprite_entry& sprite) noexcept
+	{
+		store(out, sprite.x);
+		store(out, sprite.y);
+		store(out, sprite.width);
+		store(out, sprite.height);
+		store(out, sprite.flags);
+	}
+
+	static void load(const uint8_t*& in, baked::sprite_entry& sprite) noexcept
+	{
+		load(in, sprite.x);
+		load(in, sprite.y);
+		load(in, sprite.width);
+		load(in, sprite.height);
+		load(in, sprite.flags);
+	}
+
+	oe::utils::byte_string BakedTexture::bake(const oe::utils::image_data& image, const bake_settings& settings)
+	{
+		return bake(image, {}, settings);
+	}
+
+	oe::utils::byte_string BakedTexture::bake(oe::graphics::SpritePack& sprite_pack, const bake_settings& settings)
+	{
+		const oe::utils::image_data atlas = sprite_pack.pack();
+
+		std::vector<baked::sprite_entry> sprites;
+		sprites.reserve(sprite_pack.getSprites().size());
+		for (const auto& sprite : sprite_pack.getSprites())
+			sprites.push_back({ sprite->position.x, sprite->position.y, sprite->size.x, sprite->size.y, sprite->opacity ? baked::sprite_opacity : 0u });
+
+		return bake(atlas, sprites, settings);
+	}
+
+	oe::utils::byte_string BakedTexture::bake(const oe::utils::image_data& image, const std::vector<baked::sprite_entry>& sprites, const bake_settings& settings)
+	{
+		if (image.format == oe::formats::none || image.width <= 0 || image.height <= 0)
+			throw oe::utils::formatted_error("Can't bake an empty image");
+		if (image.size > std::numeric_limits<uint32_t>::max() || sprites.size() > std::numeric_limits<uint16_t>::max())
+			throw oe::utils::formatted_error("Image too large to bake: {}x{} with {} sprites", image.width, image.height, sprites.size());
+
+		// every level from the one before it
+		std::vector<oe::utils::image_data> smaller;
+		for (size_t level = 1; settings.mipmaps && (level_size(image.width, level - 1) > 1 || level_size(image.height, level - 1) > 1); level++)
+		{
+			const oe::utils::image_data_base& previous = smaller.empty() ? static_cast<const oe::utils::image_data_base&>(image) : smaller.back();
+			smaller.push_back(previous.cast(oe::formats::none, level_size(image.width, level), level_size(image.height, level), oe::utils::image_filter::box));
+		}
+
+		std::vector<const oe::utils::image_data_base*> levels{ &image };
+		for (const auto& level : smaller)
+			levels.push_back(&level);
+
+		// level data, compressed only if that makes it smaller
+		std::vector<oe::utils::byte_string> compressed(levels.size());
+		if (settings.compress)
+		{
+			for (size_t i = 0; i < levels.size(); i++)
+			{
+				const int size = static_cast<int>(levels[i]->size);
+				compressed[i].resize(static_cast<size_t>(LZ4_compressBound(size)));
+				const int written = LZ4_compress_HC(reinterpret_cast<const char*>(levels[i]->data), reinterpret_cast<char*>(compressed[i].data()), size, static_cast<int>(compressed[i].size()), LZ4HC_CLEVEL_DEFAULT);
+				compressed[i].resize(written > 0 && written < size ? static_cast<size_t>(written) : 0);
+			}
+		}
+
+		baked::header header;
+		std::memcpy(header.magic, baked::magic, sizeof(header.magic));
+		header.version = baked::version;
+		header.format = static_cast<uint8_t>(image.format);
+		header.compression = static_cast<uint8_t>(settings.compress ? baked::compression::lz4 : baked::compression::none);
+		header.width = static_cast<uint32_t>(image.width);
+		header.height = static_cast<uint32_t>(image.height);
+		header.mip_count = static_cast<uint16_t>(levels.size());
+		header.sprite_count = static_cast<uint16_t>(sprites.size());
+
+		std::vector<baked::mip_entry> mips(levels.size());
+		size_t offset = align_up(sizeof(header) + sizeof(baked::mip_entry) * mips.size() + sizeof(baked::sprite_entry) * sprites.size());
+		for (size_t i = 0; i < levels.size(); i++)
+		{
+			mips[i].offset = offset;
+			mips[i].size = static_cast<uint32_t>(levels[i]->size);
+			mips[i].stored_size = compressed[i].empty() ? mips[i].size : static_cast<uint32_t>(compressed[i].size());
+			offset = align_up(offset + mips[i].stored_size);
+		}
+
+		oe::utils::byte_string file(offset, 0);
+		uint8_t* tables = file.data();
+		store(tables, header);
+		for (const auto& mip : mips)
+			store(tables, mip);
+		for (const auto& sprite : sprites)
+			store(tables, sprite);
+		for (size_t i = 0; i < levels.size(); i++)
+			std::memcpy(file.data() + mips[i].offset, compressed[i].empty() ? levels[i]->data : compressed[i].data(), mips[i].stored_size);
+
+		return file;
+	}
+
+	BakedTexture::BakedTexture(const oe::utils::FileIO& path)
+		: BakedTexture(path.map())
+	{}
+
+	BakedTexture::BakedTexture(oe::utils::mapped_file&& file)
+		: m_file(std::move(file))
+	{
+		const auto bytes = m_file.span();
+		baked::header header;
+		if (bytes.size() < sizeof(header))
+			throw oe::utils::formatted_error("Not a baked texture, only {} bytes", bytes.size());
+		const uint8_t* tables = bytes.data();
+		load(tables, header);
+
+		if (std::memcmp(header.magic, baked::magic, sizeof(header.magic)) != 0)
+			throw oe::utils::formatted_error("Not a baked texture");
+		if (header.version != baked::version)
+			throw oe::utils::formatted_error("Baked texture version {} is not supported, expected {}", header.version, baked::version);
+		if (header.format < static_cast<uint8_t>(oe::formats::rgba) || header.format > static_cast<uint8_t>(oe::formats::mono) || header.compression > static_cast<uint8_t>(baked::compression::lz4))
+			throw oe::utils::formatted_error("Baked texture has an unknown format ({}) or compression ({})", header.format, header.compression);
+		if (header.width == 0 || header.height == 0 || header.width > static_cast<uint32_t>(std::numeric_limits<int>::max()) || header.height > static_cast<uint32_t>(std::numeric_limits<int>::max()) || header.mip_count == 0 || header.mip_count > 32)
+			throw oe::utils::formatted_error("Baked texture has an invalid size {}x{} or {} levels", header.width, header.height, header.mip_count);
+
+		m_format = static_cast<oe::formats>(header.format);
+		m_width = static_cast<int>(header.width);
+		m_height = static_cast<int>(header.height);
+
+		const size_t table_bytes = sizeof(header) + sizeof(baked::mip_entry) * header.mip_count + sizeof(baked::sprite_entry) * header.sprite_count;
+		if (bytes.size() < table_bytes)
+			throw oe::utils::formatted_error("Baked texture is truncated");
+
+		std::vector<baked::mip_entry> mips(header.mip_count);
+		for (auto& mip : mips)
+			load(tables, mip);
+		m_sprites.resize(header.sprite_count);
+		for (auto& sprite : m_sprites)
+			load(tables, sprite);
+
+		for (size_t i = 0; i < mips.size(); i++)
+		{
+			const baked::mip_entry& mip = mips[i];
+			if (mip.size != level_bytes(m_format, m_width, m_height, i) || mip.offset > bytes.size() || bytes.size() - mip.offset < mip.stored_size)
+				throw oe::utils::formatted_error("Baked texture level {} is out of bounds", i);
+
+			const uint8_t* stored = bytes.data() + mip.offset;
+			if (mip.stored_size == mip.size)
+			{
+				m_levels.emplace_back(stored, mip.size);
+				continue;
+			}
+
+			if (header.compression != static_cast<uint8_t>(baked::compression::lz4))
+				throw oe::utils::formatted_error("Baked texture level {} is compressed in an uncompressed file", i);
+
+			auto& level = m_decompressed.emplace_back(mip.size);
+			const int read = LZ4_decompress_safe(reinterpret_cast<const char*>(stored), reinterpret_cast<char*>(level.data()), static_cast<int>(mip.stored_size), static_cast<int>(mip.size));
+			if (read != static_cast<int>(mip.size))
+				throw oe::utils::formatted_error("Baked texture level {} is corrupted", i);
+			m_levels.emplace_back(level.data(), level.size());
+		}
+	}
+
+	oe::TextureInfo BakedTexture::texture_info(const oe::TextureInfo& settings) const
+	{
+		oe::TextureInfo info = settings;
+		info.empty = false;
+		info.data = m_levels.front().data();
+		info.data_type = oe::TextureInfo::data_types::bytes;
+		info.data_format = m_format;
+		info.size_offset = { { m_width, 0 }, { m_height, 0 } };
+		info.mipmaps.clear();
+		for (size_t i = 1; i < m_levels.size(); i++)
+			info.mipmaps.push_back(m_levels[i].data());
+		return info;
+	}
+
+	oe::graphics::Texture BakedTexture::texture(const oe::TextureInfo& settings) const
+	{
+		return oe::graphics::Texture{ texture_info(settings) };
+	}
+
+	std::vector<oe::graphics::Sprite> BakedTexture::sprites(const oe::graphics::Texture& owner) const
+	{
+		std::vector<oe::graphics::Sprite> sprites;
+		sprites.reserve(m_sprites.size());
+		for (const auto& sprite : m_sprites)
+			sprites.push_back({ owner, { sprite.x, sprite.y }, { sprite.width, sprite.height }, (sprite.flags & baked::sprite_opacity) != 0 });
+		return sprites;
+	}
+
+	oe::utils::image_data BakedTexture::image(size_t level) const
+	{
+		return { m_levels.at(level).data(), m_format, level_size(m_width, level), level_size(m_height, level) };
+	}
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include "engine/graphics/sprite.hpp"
+#include "engine/interfacegen.hpp"
+#include "engine/utility/fileio.hpp"
+
+#include <cstdint>
+#include <vector>
+
+
+
+/*
+
+	Textures and sprite pack atlases preprocessed into a file the runtime maps and uploads as is
+
+	baking, offline (see tools/texture-baker):
+		oe::utils::FileIO{ "res/ui.oetex" }.write(oe::asset::BakedTexture::bake(sprite_pack, { true, true }));
+	loading:
+		oe::asset::BakedTexture baked{ "res/ui.oetex" };
+		oe::graphics::Texture texture = baked.texture(); // no decoding, mip levels included
+		std::vector<oe::graphics::Sprite> sprites = baked.sprites(texture);
+
+	.oetex layout, little endian on every host (level data is bytes):
+		header
+		mip_entry[mip_count]
+		sprite_entry[sprite_count]
+		mip levels, largest first, each 16 byte aligned
+
+*/
+
+namespace oe::graphics { class SpritePack; }
+namespace oe::asset
+{
+	namespace baked
+	{
+		constexpr char magic[4] = { 'O', 'E', 'T', 'X' };
+		constexpr uint16_t version = 1;
+		constexpr size_t data_alignment = 16;
+
+		enum class compression : uint8_t
+		{
+			none, // mapped straight to the texture
+			lz4   // smaller, decompressed when loaded
+		};
+
+		enum sprite_flags : uint32_t
+		{
+			sprite_opacity = 1 << 0 // has pixels that are not fully opaque
+		};
+
+		struct header
+		{
+			char magic[4];
+			uint16_t version;
+			uint8_t format;      // oe::formats
+			uint8_t compression; // baked::compression
+			uint32_t width;
+			uint32_t height;
+			uint16_t mip_count;  // including the full size level
+			uint16_t sprite_count;
+		};
+
+		struct mip_entry
+		{
+			uint64_t offset;      // from the start of the file
+			uint32_t stored_size; // compressed
+			uint32_t size;
+		};
+
+		struct sprite_entry
+		{
+			float x, y, width, height; // in texture coordinates
+			uint32_t flags;            // sprite_flags
+		};
+
+		// the size in the file too, the fields are packed without padding
+		static_assert(sizeof(header) == 20 && sizeof(mip_entry) == 16 && sizeof(sprite_entry) == 20);
+	}
+
+	struct bake_settings
+	{
+		bool mipmaps = true; // down to 1x1, box filtered
+		bool compress = false;
+	};
+
+	// a mapped .oetex
+	class BakedTexture
+	{
+	private:
+		oe::utils::mapped_file m_file;
+		oe::formats m_format = oe::formats::none;
+		int m_width = 0, m_height = 0;
+
+		std::vector<gsl::span<const uint8_t>> m_levels;     // into m_file, or m_decompressed if compressed
+		std::vector<std::vector<uint8_t>> m_decompressed;
+		std::vector<baked::sprite_entry> m_sprites;
+
+	public:
+		// throws if it is not a valid .oetex
+		explicit BakedTexture(const oe::utils::FileIO& path);
+		explicit BakedTexture(oe::utils::mapped_file&& file);
+
+		[[nodiscard]] static oe::utils::byte_string bake(const oe::utils::image_data& image, const bake_settings& settings = {});
+		// packs it, the sprites keep their order
+		[[nodiscard]] static oe::utils::byte_string bake(oe::graphics::SpritePack& sprite_pack, const bake_settings& settings = {});
+
+		[[nodiscard]] inline oe::formats format() const noexcept { return m_format; }
+		[[nodiscard]] inline int width() const noexcept { return m_width; }
+		[[nodiscard]] inline int height() const noexcept { return m_height; }
+		[[nodiscard]] inline size_t levels() const noexcept { return m_levels.size(); }
+		[[nodiscard]] inline gsl::span<const uint8_t> level(size_t index) const { return m_levels.at(index); }
+		[[nodiscard]] inline bool mapped() const noexcept { return m_file.mapped() && m_decompressed.empty(); }
+
+		// 'settings' without the data, format, size and mipmaps, those point into this BakedTexture
+		// and only have to stay valid until the texture is created
+		[[nodiscard]] oe::TextureInfo texture_info(const oe::TextureInfo& settings = {}) const;
+		[[nodiscard]] oe::graphics::Texture texture(const oe::TextureInfo& settings = {}) const;
+		// the sprite pack's sprites, in the order they were created
+		[[nodiscard]] std::vector<oe::graphics::Sprite> sprites(const oe::graphics::Texture& owner) const;
+		// a copy of one level
+		[[nodiscard]] oe::utils::image_data image(size_t level = 0) const;
+
+	private:
+		[[nodiscard]] static oe::utils::byte_string bake(const oe::utils::image_data& image, const std::vector<baked::sprite_entry>& sprites, const bake_settings& settings);
+	};
+}
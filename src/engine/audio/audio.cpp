@@ -3,6 +3,12 @@
 #include "engine/engine.hpp"
 #include "engine/utility/formatted_error.hpp"
 #include "engine/utility/fileio.hpp"
+#include "engine/utility/audio_decoder.hpp"
+#include "engine/utility/spsc_queue.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 
 
 
@@ -30,15 +36,816 @@
 #pragma warning( pop )
 #endif
 
+
+
+// plain loops over float blocks the compiler vectorizes, no intrinsics so that emscripten builds them too
+namespace oe::audio::mix_kernels
+{
+	constexpr float int16_scale = 1.0f / 32768.0f;
+	constexpr float quarter_pi = 0.785398163f;
+	constexpr float root_two = 1.41421356f;
+
+	static void convert(const int16_t* in, float* out, size_t count) noexcept
+	{
+		for (size_t i = 0; i < count; i++)
+			out[i] = static_cast<float>(in[i]) * int16_scale;
+	}
+
+	// source frames to stereo with linear interpolation, returns the frames written
+	// the last source frame is only interpolated towards, the caller leaves it out unless the source ends there
+	template<size_t Channels>
+	static size_t resample(const float* source, size_t source_frames, double& position, double step, float* out, size_t frame_count) noexcept
+	{
+		size_t written = 0;
+		if (step == 1.0 && position == std::floor(position))
+		{
+			const size_t first = static_cast<size_t>(position);
+			written = std::min(frame_count, source_frames - std::min(first, source_frames));
+			const float* in = source + first * Channels;
+			for (size_t i = 0; i < written; i++)
+			{
+				out[i * 2 + 0] = in[i * Channels];
+				out[i * 2 + 1] = in[i * Channels + Channels - 1];
+			}
+			position += static_cast<double>(written);
+			return written;
+		}
+
+		for (; written < frame_count; written++)
+		{
+			const size_t i = static_cast<size_t>(position);
+			if (i >= source_frames)
+				break;
+
+			const float t = static_cast<float>(position - static_cast<double>(i));
+			const float* a = source + i * Channels;
+			const float* b = i + 1 < source_frames ? a + Channels : a;
+			out[written * 2 + 0] = a[0] + (b[0] - a[0]) * t;
+			out[written * 2 + 1] = a[Channels - 1] + (b[Channels - 1] - a[Channels - 1]) * t;
+			position += step;
+		}
+		return written;
+	}
+
+	// out += in * gain, the gain going linearly from..to over the block, separately for left and right
+	static void accumulate(float* out, const float* in, size_t frame_count, float left_from, float right_from, float left_to, float right_to) noexcept
+	{
+		const float left_step = (left_to - left_from) / static_cast<float>(frame_count);
+		const float right_step = (right_to - right_from) / static_cast<float>(frame_count);
+		for (size_t i = 0; i < frame_count; i++)
+		{
+			out[i * 2 + 0] += in[i * 2 + 0] * (left_from + left_step * static_cast<float>(i));
+			out[i * 2 + 1] += in[i * 2 + 1] * (right_from + right_step * static_cast<float>(i));
+		}
+	}
+
+	static void clip(float* samples, size_t count) noexcept
+	{
+		for (size_t i = 0; i < count; i++)
+			samples[i] = std::clamp(samples[i], -1.0f, 1.0f);
+	}
+
+	// equal power for mono, balance for stereo, so that a centered voice is as loud either way
+	static std::pair<float, float> pan_gains(float gain, float pan, size_t channels) noexcept
+	{
+		pan = std::clamp(pan, -1.0f, 1.0f);
+		if (channels == 1)
+		{
+			const float angle = (pan + 1.0f) * quarter_pi;
+			return { gain * std::cos(angle) * root_two, gain * std::sin(angle) * root_two };
+		}
+		return { gain * std::min(1.0f, 1.0f - pan), gain * std::min(1.0f, 1.0f + pan) };
+	}
+}
+
+namespace oe::audio::detail
+{
+	struct stream_state
+	{
+		std::unique_ptr<AudioStream> source;
+		const size_t channels;
+		const int sample_rate;
+		oe::utils::spsc_queue<float> ring; // whole frames only
+		std::atomic<bool> loop;
+		std::atomic<bool> ended{ false };  // nothing more will be pushed
+		std::atomic<bool> closed{ false }; // its voice is done
+
+		// audio thread: popped but not played yet
+		std::vector<float> window;
+		size_t window_frames = 0;
+
+		stream_state(std::unique_ptr<AudioStream> _source, size_t ring_frames, bool _loop)
+			: source(std::move(_source))
+			, channels(static_cast<size_t>(source->channels()))
+			, sample_rate(source->sample_rate())
+			, ring(ring_frames * channels)
+			, loop(_loop)
+			, window((AudioDevice::block_frames * static_cast<size_t>(AudioDevice::max_step) + 4) * channels)
+		{}
+	};
+}
+
 namespace oe::audio
 {
-	AudioDevice::AudioDevice()
+	// the stream thread already reads ahead, so a plain decoder rather than a decode_ahead
+	class DecoderStream : public AudioStream
+	{
+	private:
+		std::unique_ptr<oe::utils::audio_decoder> m_decoder;
+		std::vector<int16_t> m_samples;
+
+	public:
+		DecoderStream(std::unique_ptr<oe::utils::audio_decoder>&& decoder)
+			: m_decoder(std::move(decoder))
+		{
+			if (m_decoder->channels() < 1 || m_decoder->channels() > 2)
+				throw oe::utils::formatted_error("Audio has {} channels, only mono and stereo can be played", m_decoder->channels());
+		}
+
+		int channels() const noexcept override { return m_decoder->channels(); }
+		int sample_rate() const noexcept override { return m_decoder->sample_rate(); }
+
+		size_t read(float* frames, size_t frame_count) override
+		{
+			m_samples.resize(frame_count * static_cast<size_t>(channels()));
+			const size_t read = m_decoder->read(m_samples.data(), frame_count);
+			mix_kernels::convert(m_samples.data(), frames, read * static_cast<size_t>(channels()));
+			return read;
+		}
+
+		bool rewind() override
+		{
+			return m_decoder->seek(0);
+		}
+	};
+
+	std::unique_ptr<AudioStream> AudioStream::open(std::unique_ptr<oe::utils::audio_decoder> decoder)
+	{
+		if (!decoder)
+			throw oe::utils::formatted_error("No decoder to stream from");
+		return std::make_unique<DecoderStream>(std::move(decoder));
+	}
+
+	std::unique_ptr<AudioStream> AudioStream::open(const oe::utils::FileIO& path)
+	{
+		try
+		{
+			return open(oe::utils::audio_decoder::open(path));
+		}
+		catch (const std::exception& e)
+		{
+			throw oe::utils::formatted_error("Failed to stream audiofile \"{}\": {}", path.getPath().generic_string(), e.what());
+		}
+	}
+
+
+
+	bool AudioPlayer::playing() const noexcept
 	{
+		if (!m_device)
+			return false;
+
+		const auto& slot = m_device->m_slots[m_slot];
+		const auto state = slot.state.load(std::memory_order_acquire);
+		return slot.generation.load(std::memory_order_acquire) == m_generation && state != detail::voice_slot::state_t::free && state != detail::voice_slot::state_t::finished;
+	}
+
+	bool AudioPlayer::paused() const noexcept
+	{
+		return playing() && m_device->m_slots[m_slot].state.load(std::memory_order_acquire) == detail::voice_slot::state_t::paused;
+	}
+
+	using command_type = detail::command::type_t;
+
+	void AudioPlayer::stop() { if (m_device) m_device->send({ command_type::stop, m_slot, m_generation, 0.0f }); }
+	void AudioPlayer::pause() { if (m_device) m_device->send({ command_type::pause, m_slot, m_generation, 0.0f }); }
+	void AudioPlayer::resume() { if (m_device) m_device->send({ command_type::resume, m_slot, m_generation, 0.0f }); }
+	void AudioPlayer::set_gain(float gain) { if (m_device) m_device->send({ command_type::gain, m_slot, m_generation, gain }); }
+	void AudioPlayer::set_pan(float pan) { if (m_device) m_device->send({ command_type::pan, m_slot, m_generation, pan }); }
+	void AudioPlayer::set_pitch(float pitch) { if (m_device) m_device->send({ command_type::pitch, m_slot, m_generation, pitch }); }
+	void AudioPlayer::set_loop(bool loop) { if (m_device) m_device->send({ command_type::loop, m_slot, m_generation, loop ? 1.0f : 0.0f }); }
+
+
+
+	// audio thread only
+	struct AudioDevice::voice
+	{
+		enum class fade_t : uint8_t { none, to_stop, to_pause };
+
+		bool active = false;
+		bool paused = false;
+		bool done = false;    // the source ended
+		bool started = false; // streams: something was played already
+		fade_t fade = fade_t::none;
+		uint32_t slot = 0;
+		uint32_t generation = 0;
+
+		const oe::utils::audio_data* clip = nullptr;
+		detail::stream_state* stream = nullptr;
+		size_t channels = 0;
+		size_t frames = 0;   // clips only
+		double position = 0; // clips: in source frames, streams: into the window
+		double rate = 1.0;   // source sample rate / device sample rate
+
+		voice_params params;
+		float left = 0.0f, right = 0.0f; // the gains at the end of the last block, the next one ramps from them
+
+		[[nodiscard]] inline double step() const noexcept
+		{
+			return std::min(static_cast<double>(max_step), static_cast<double>(std::clamp(params.pitch, 0.125f, 8.0f)) * rate);
+		}
+	};
+
+	AudioDevice::AudioDevice(const device_settings& settings)
+		: m_settings(settings)
+		, m_slots(std::max<size_t>(settings.max_voices, 1))
+		, m_commands(std::max<size_t>(settings.max_voices * 16, 1024))
+		, m_voices(m_slots.size())
+		, m_buses(bus_count * block_frames * channels)
+		, m_scratch(block_frames * channels)
+		, m_source((block_frames * static_cast<size_t>(max_step) + 4) * channels)
+	{
+		if (m_settings.sample_rate == 0)
+			throw oe::utils::formatted_error("Audio sample rate can't be 0");
+
+		m_bus_gain.fill(1.0f);
+		m_bus_gain_target.fill(1.0f);
+		m_free_slots.reserve(m_slots.size());
+		for (size_t i = m_slots.size(); i > 0; i--)
+			m_free_slots.push_back(static_cast<uint32_t>(i - 1));
+
+		if (m_settings.backend != audio_backend::none)
+			open_device();
+		m_stream_thread = std::thread(&AudioDevice::stream_thread, this);
+	}
+
+	void AudioDevice::open_device()
+	{
+		try
+		{
+			m_context = std::make_unique<ma_context>();
+			const ma_backend null_backend = ma_backend_null;
+			const bool null = m_settings.backend == audio_backend::null;
+			ma_result result = ma_context_init(null ? &null_backend : nullptr, null ? 1 : 0, nullptr, m_context.get());
+			if (result != MA_SUCCESS)
+			{
+				m_context.reset();
+				throw oe::utils::formatted_error("Failed to open an audio backend: {}", ma_result_description(result));
+			}
+
+			ma_device_config config = ma_device_config_init(ma_device_type_playback);
+			config.playback.format = ma_format_f32;
+			config.playback.channels = static_cast<ma_uint32>(channels);
+			config.sampleRate = m_settings.sample_rate;
+			config.periodSizeInFrames = m_settings.period_frames;
+			config.noClip = MA_TRUE; // mix() clips already
+			config.pUserData = this;
+			config.dataCallback = [](ma_device* device, void* output, const void* /* input */, ma_uint32 frame_count)
+			{
+				static_cast<AudioDevice*>(device->pUserData)->mix(static_cast<float*>(output), frame_count);
+			};
+
+			m_device = std::make_unique<ma_device>();
+			result = ma_device_init(m_context.get(), &config, m_device.get());
+			if (result != MA_SUCCESS)
+			{
+				m_device.reset();
+				throw oe::utils::formatted_error("Failed to open an audio device: {}", ma_result_description(result));
+			}
+
+			result = ma_device_start(m_device.get());
+			if (result != MA_SUCCESS)
+				throw oe::utils::formatted_error("Failed to start the audio device: {}", ma_result_description(result));
+		}
+		catch (...)
+		{
+			close_device();
+			throw;
+		}
+	}
+
+	void AudioDevice::close_device()
+	{
+		if (m_device)
+			ma_device_uninit(m_device.get());
+		if (m_context)
+			ma_context_uninit(m_context.get());
+		m_device.reset();
+		m_context.reset();
+	}
+
+	AudioDevice::~AudioDevice()
+	{
+		close_device();
+
+		m_stopping = true;
+		m_stream_wake.notify();
+		if (m_stream_thread.joinable())
+			m_stream_thread.join();
+	}
+
+	AudioPlayer AudioDevice::play(std::shared_ptr<const oe::utils::audio_data> clip, const voice_params& params)
+	{
+		if (!clip || clip->channels < 1 || clip->channels > 2 || clip->sample_rate <= 0)
+			throw oe::utils::formatted_error("Only mono and stereo audio can be played, got {} channels at {} Hz", clip ? clip->channels : 0, clip ? clip->sample_rate : 0);
+
+		return start({ std::move(clip), nullptr, params });
+	}
+
+	AudioPlayer AudioDevice::play(std::unique_ptr<AudioStream> stream, const voice_params& params)
+	{
+		if (!stream || stream->channels() < 1 || stream->channels() > 2 || stream->sample_rate() <= 0)
+			throw oe::utils::formatted_error("Only mono and stereo audio can be played, got {} channels at {} Hz", stream ? stream->channels() : 0, stream ? stream->sample_rate() : 0);
+
+		const size_t ring_frames = static_cast<size_t>(stream->sample_rate()) * static_cast<size_t>(std::max<int64_t>(m_settings.stream_buffer.count(), 50)) / 1000;
+		auto state = std::make_shared<detail::stream_state>(std::move(stream), ring_frames, params.loop);
+		AudioPlayer player = start({ nullptr, state, params });
+		if (!player)
+			return player;
 
+		{
+			std::scoped_lock lock(m_streams_mtx);
+			m_streams.push_back(std::move(state));
+			m_streams_added = true;
+		}
+		m_stream_wake.notify();
+		return player;
 	}
 
-	AudioPlayer::AudioPlayer()
+	AudioPlayer AudioDevice::start(detail::voice_source&& source)
 	{
+		std::scoped_lock lock(m_slots_mtx);
+		if (m_free_slots.empty())
+			reclaim();
+		if (m_free_slots.empty())
+		{
+			m_stats.rejected.fetch_add(1, std::memory_order_relaxed);
+			return {};
+		}
+
+		const uint32_t index = m_free_slots.back();
+		m_free_slots.pop_back();
+
+		auto& slot = m_slots[index];
+		const uint32_t generation = slot.generation.load(std::memory_order_relaxed);
+		slot.source = std::move(source);
+		slot.state.store(detail::voice_slot::state_t::starting, std::memory_order_release);
+		// the queue publishes the source to the audio thread
+		// never blocks, with audio_backend::none this thread might be the one that would have to mix to make room
+		// the audio thread has not seen the slot yet so it goes straight back
+		if (!m_commands.try_push({ command_type::start, index, generation, 0.0f }))
+		{
+			slot.source = {};
+			slot.state.store(detail::voice_slot::state_t::free, std::memory_order_release);
+			m_free_slots.push_back(index);
+			m_stats.rejected.fetch_add(1, std::memory_order_relaxed);
+			return {};
+		}
+		return { this, index, generation };
+	}
+
+	void AudioDevice::send(const detail::command& command)
+	{
+		// audio_backend::none: the caller is the one that renders, waiting for room would wait forever
+		if (!m_device)
+		{
+			if (!m_commands.try_push(command))
+				m_stats.rejected.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+
+		// only blocks if the audio thread is many callbacks behind
+		m_commands.push(command);
+	}
+
+	void AudioDevice::send(const detail::command* commands, size_t count)
+	{
+		const detail::command* last = commands + count;
+		if (!m_device)
+		{
+			const detail::command* pushed = m_commands.try_push(commands, last);
+			m_stats.rejected.fetch_add(static_cast<size_t>(last - pushed), std::memory_order_relaxed);
+			return;
+		}
+
+		while (commands != last)
+		{
+			commands = m_commands.try_push(commands, last);
+			// full, the rest one at a time as the audio thread makes room
+			if (commands != last)
+				m_commands.push(*commands++);
+		}
+	}
+
+	void AudioDevice::update_voices(gsl::span<const voice_update> updates)
+	{
+		std::array<detail::command, 96> batch;
+		size_t count = 0;
+		for (const auto& update : updates)
+		{
+			if (update.voice.m_device != this)
+				continue;
+			if (count + 3 > batch.size())
+			{
+				send(batch.data(), count);
+				count = 0;
+			}
+			const uint32_t slot = update.voice.m_slot;
+			const uint32_t generation = update.voice.m_generation;
+			batch[count++] = { command_type::gain, slot, generation, update.gain };
+			batch[count++] = { command_type::pan, slot, generation, update.pan };
+			batch[count++] = { command_type::pitch, slot, generation, update.pitch };
+		}
+		send(batch.data(), count);
+	}
+
+	void AudioDevice::set_bus_gain(bus output, float gain)
+	{
+		send({ command_type::bus_gain, static_cast<uint32_t>(output), 0, gain });
+	}
+
+	void AudioDevice::set_master_gain(float gain)
+	{
+		send({ command_type::master_gain, 0, 0, gain });
+	}
+
+	void AudioDevice::update()
+	{
+		std::scoped_lock lock(m_slots_mtx);
+		reclaim();
+	}
+
+	void AudioDevice::reclaim()
+	{
+		for (size_t i = 0; i < m_slots.size(); i++)
+		{
+			auto& slot = m_slots[i];
+			if (slot.state.load(std::memory_order_acquire) != detail::voice_slot::state_t::finished)
+				continue;
+
+			if (slot.source.stream)
+				slot.source.stream->closed = true;
+			slot.source = {};
+			slot.generation.fetch_add(1, std::memory_order_release);
+			slot.state.store(detail::voice_slot::state_t::free, std::memory_order_release);
+			m_free_slots.push_back(static_cast<uint32_t>(i));
+		}
+	}
+
+	void AudioDevice::render(float* out, size_t frame_count)
+	{
+		if (m_device)
+			throw oe::utils::formatted_error("render() is for audio_backend::none, the device is mixing already");
+		mix(out, frame_count);
+	}
+
+	audio_stats AudioDevice::stats()
+	{
+		audio_stats stats;
+		stats.voices = m_stats.voices.load(std::memory_order_relaxed);
+		stats.callbacks = m_stats.callbacks.load(std::memory_order_relaxed);
+		stats.frames = m_stats.frames.load(std::memory_order_relaxed);
+		stats.commands = m_stats.commands.load(std::memory_order_relaxed);
+		stats.rejected = m_stats.rejected.load(std::memory_order_relaxed);
+		stats.underruns = m_stats.underruns.load(std::memory_order_relaxed);
+		const size_t mixes = std::max<size_t>(stats.callbacks, 1);
+		stats.mix_ms_average = static_cast<float>(m_stats.mix_ns.load(std::memory_order_relaxed)) / static_cast<float>(mixes) * 1e-6f;
+		stats.mix_ms_peak = static_cast<float>(m_stats.mix_ns_peak.load(std::memory_order_relaxed)) * 1e-6f;
+
+		std::scoped_lock lock(m_streams_mtx);
+		stats.streams = m_streams.size();
+		return stats;
+	}
+
+
+
+	void AudioDevice::process_commands()
+	{
+		std::array<detail::command, 64> commands;
+		size_t count;
+		while ((count = m_commands.try_pop(commands.begin(), commands.size())) != 0)
+		{
+			m_stats.commands.fetch_add(count, std::memory_order_relaxed);
+			for (size_t i = 0; i < count; i++)
+			{
+				const auto& command = commands[i];
+				switch (command.type)
+				{
+				case command_type::bus_gain:
+					if (command.slot < bus_count)
+						m_bus_gain_target[command.slot] = std::max(command.value, 0.0f);
+					continue;
+				case command_type::master_gain:
+					m_master_gain_target = std::max(command.value, 0.0f);
+					continue;
+				case command_type::start:
+				{
+					const auto& source = m_slots[command.slot].source;
+					voice& v = m_voices[command.slot];
+					v = voice{};
+					v.active = true;
+					v.slot = command.slot;
+					v.generation = command.generation;
+					v.clip = source.clip.get();
+					v.stream = source.stream.get();
+					v.params = source.params;
+					if (v.clip)
+					{
+						v.channels = static_cast<size_t>(v.clip->channels);
+						v.frames = v.clip->frames();
+						v.rate = static_cast<double>(v.clip->sample_rate) / m_settings.sample_rate;
+						v.position = std::max(v.params.offset, 0.0);
+					}
+					else
+					{
+						v.channels = v.stream->channels;
+						v.rate = static_cast<double>(v.stream->sample_rate) / m_settings.sample_rate;
+					}
+					m_slots[command.slot].state.store(detail::voice_slot::state_t::playing, std::memory_order_release);
+					continue;
+				}
+				default:
+					break;
+				}
+
+				voice& v = m_voices[command.slot];
+				if (!v.active || v.generation != command.generation)
+					continue;
+
+				switch (command.type)
+				{
+				case command_type::stop:
+					if (v.paused)
+						finish(v);
+					else
+						v.fade = voice::fade_t::to_stop;
+					break;
+				case command_type::pause:
+					if (!v.paused && v.fade == voice::fade_t::none)
+						v.fade = voice::fade_t::to_pause;
+					break;
+				case command_type::resume:
+					if (v.fade == voice::fade_t::to_pause)
+						v.fade = voice::fade_t::none;
+					if (v.paused)
+					{
+						v.paused = false;
+						m_slots[v.slot].state.store(detail::voice_slot::state_t::playing, std::memory_order_release);
+					}
+					break;
+				case command_type::gain:
+					v.params.gain = std::max(command.value, 0.0f);
+					break;
+				case command_type::pan:
+					v.params.pan = command.value;
+					break;
+				case command_type::pitch:
+					v.params.pitch = command.value;
+					break;
+				case command_type::loop:
+					v.params.loop = command.value != 0.0f;
+					if (v.stream)
+						v.stream->loop = v.params.loop;
+					break;
+				default:
+					break;
+				}
+			}
+		}
+	}
+
+	void AudioDevice::mix(float* out, size_t frame_count)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		process_commands();
+
+		size_t active = 0, streams = 0;
+		for (size_t offset = 0; offset < frame_count; offset += block_frames)
+		{
+			const size_t count = std::min(block_frames, frame_count - offset);
+			std::fill(m_buses.begin(), m_buses.end(), 0.0f);
+
+			active = streams = 0;
+			for (auto& v : m_voices)
+			{
+				if (!v.active)
+					continue;
+				active++;
+				streams += v.stream ? 1 : 0;
+				if (!v.paused && !render_voice(v, count))
+					finish(v);
+			}
+
+			float* block = out + offset * channels;
+			std::fill(block, block + count * channels, 0.0f);
+			for (size_t i = 0; i < bus_count; i++)
+			{
+				const float from = m_bus_gain[i] * m_master_gain, to = m_bus_gain_target[i] * m_master_gain_target;
+				if (from != 0.0f || to != 0.0f)
+					mix_kernels::accumulate(block, m_buses.data() + i * block_frames * channels, count, from, from, to, to);
+				m_bus_gain[i] = m_bus_gain_target[i];
+			}
+			m_master_gain = m_master_gain_target;
+			mix_kernels::clip(block, count * channels);
+		}
+
+		// the stream thread tops up what this took
+		if (streams)
+			m_stream_wake.notify();
+
+		const auto time = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+		m_stats.voices.store(active, std::memory_order_relaxed);
+		m_stats.callbacks.fetch_add(1, std::memory_order_relaxed);
+		m_stats.frames.fetch_add(frame_count, std::memory_order_relaxed);
+		m_stats.mix_ns.fetch_add(time, std::memory_order_relaxed);
+		if (time > m_stats.mix_ns_peak.load(std::memory_order_relaxed))
+			m_stats.mix_ns_peak.store(time, std::memory_order_relaxed);
+	}
+
+	bool AudioDevice::render_voice(voice& v, size_t frame_count)
+	{
+		float* scratch = m_scratch.data();
+		const size_t written = v.clip ? render_clip(v, scratch, frame_count) : render_stream(v, scratch, frame_count);
+		std::fill(scratch + written * channels, scratch + frame_count * channels, 0.0f);
+
+		auto [left, right] = mix_kernels::pan_gains(v.params.gain, v.params.pan, v.channels);
+		if (v.fade != voice::fade_t::none)
+			left = right = 0.0f;
+
+		float* bus = m_buses.data() + static_cast<size_t>(v.params.output) % bus_count * block_frames * channels;
+		mix_kernels::accumulate(bus, scratch, frame_count, v.left, v.right, left, right);
+		v.left = left;
+		v.right = right;
+
+		switch (v.fade)
+		{
+		case voice::fade_t::to_stop:
+			return false;
+		case voice::fade_t::to_pause:
+			v.fade = voice::fade_t::none;
+			v.paused = true;
+			m_slots[v.slot].state.store(detail::voice_slot::state_t::paused, std::memory_order_release);
+			break;
+		default:
+			break;
+		}
+		return !v.done;
+	}
+
+	size_t AudioDevice::render_clip(voice& v, float* out, size_t frame_count)
+	{
+		const double step = v.step();
+		size_t written = 0;
+		while (written < frame_count)
+		{
+			if (v.position >= static_cast<double>(v.frames))
+			{
+				if (!v.params.loop || v.frames == 0)
+				{
+					v.done = true;
+					break;
+				}
+				v.position = std::fmod(v.position, static_cast<double>(v.frames));
+			}
+
+			// converted to float as far as this block reaches, the rest of the clip stays int16
+			const size_t first = static_cast<size_t>(v.position);
+			const size_t wanted = static_cast<size_t>(static_cast<double>(frame_count - written) * step) + 2;
+			const size_t count = std::min(v.frames - first, wanted);
+			mix_kernels::convert(v.clip->data + first * v.channels, m_source.data(), count * v.channels);
+
+			// one frame of lookahead for the interpolation, unless the clip ends here
+			const size_t usable = first + count == v.frames ? count : count - 1;
+			double position = v.position - static_cast<double>(first);
+			written += v.channels == 1
+				? mix_kernels::resample<1>(m_source.data(), usable, position, step, out + written * channels, frame_count - written)
+				: mix_kernels::resample<2>(m_source.data(), usable, position, step, out + written * channels, frame_count - written);
+			v.position = static_cast<double>(first) + position;
+		}
+		return written;
+	}
+
+	size_t AudioDevice::render_stream(voice& v, float* out, size_t frame_count)
+	{
+		auto& stream = *v.stream;
+		const double step = v.step();
+
+		size_t written = 0;
+		bool at_end = false;
+		// a second try for the frames the stream thread pushed right after the first pop, the last ones of a stream usually
+		for (size_t attempt = 0; attempt < 2 && written < frame_count && !at_end; attempt++)
+		{
+			// ended first, then whatever is left in the ring is the last of it
+			const bool ended = stream.ended.load(std::memory_order_acquire);
+			const size_t wanted = std::min(static_cast<size_t>(v.position + static_cast<double>(frame_count - written) * step) + 2, stream.window.size() / v.channels);
+			if (stream.window_frames < wanted)
+				stream.window_frames += stream.ring.try_pop(stream.window.data() + stream.window_frames * v.channels, (wanted - stream.window_frames) * v.channels) / v.channels;
+			at_end = ended && stream.ring.empty();
+
+			// one frame of lookahead for the interpolation, unless the stream ends here
+			const size_t usable = at_end || stream.window_frames == 0 ? stream.window_frames : stream.window_frames - 1;
+			written += v.channels == 1
+				? mix_kernels::resample<1>(stream.window.data(), usable, v.position, step, out + written * channels, frame_count - written)
+				: mix_kernels::resample<2>(stream.window.data(), usable, v.position, step, out + written * channels, frame_count - written);
+		}
+
+		// a stream that hasn't played anything yet is only waiting for its first decode
+		if (written < frame_count)
+		{
+			if (at_end)
+				v.done = true;
+			else if (v.started)
+				m_stats.underruns.fetch_add(1, std::memory_order_relaxed);
+		}
+		v.started |= written != 0;
+
+		// drop what was played
+		const size_t consumed = std::min(static_cast<size_t>(v.position), stream.window_frames);
+		std::memmove(stream.window.data(), stream.window.data() + consumed * v.channels, (stream.window_frames - consumed) * v.channels * sizeof(float));
+		stream.window_frames -= consumed;
+		v.position -= static_cast<double>(consumed);
+		return written;
+	}
+
+	void AudioDevice::finish(voice& v)
+	{
+		v.active = false;
+		if (v.stream)
+			v.stream->closed.store(true, std::memory_order_relaxed);
+		m_slots[v.slot].state.store(detail::voice_slot::state_t::finished, std::memory_order_release);
+	}
+
+
+
+	void AudioDevice::stream_thread()
+	{
+		std::vector<std::shared_ptr<detail::stream_state>> streams;
+		std::vector<float> buffer;
+		while (!m_stopping)
+		{
+			{
+				std::scoped_lock lock(m_streams_mtx);
+				m_streams.erase(std::remove_if(m_streams.begin(), m_streams.end(), [](const auto& stream){ return stream->closed.load(std::memory_order_relaxed); }), m_streams.end());
+				streams = m_streams;
+				m_streams_added = false;
+			}
+
+			for (const auto& stream : streams)
+			{
+				try
+				{
+					fill(*stream, buffer);
+				}
+				catch (const std::exception& e)
+				{
+					spdlog::warn("Audio stream failed: {}", e.what());
+					stream->ended = true;
+				}
+			}
+
+			// woken up by the audio thread after every mix with streams, and by play()
+			const auto half_empty = [&](){
+				if (m_stopping)
+					return true;
+				std::scoped_lock lock(m_streams_mtx);
+				return m_streams_added || std::any_of(m_streams.begin(), m_streams.end(), [](const auto& stream){
+					return !stream->ended.load(std::memory_order_relaxed) && stream->ring.size() * 2 < stream->ring.capacity();
+				});
+			};
+			streams.clear();
+			m_stream_wake.wait(half_empty);
+		}
+	}
+
+	void AudioDevice::fill(detail::stream_state& stream, std::vector<float>& buffer)
+	{
+		constexpr size_t chunk_frames = 4096;
+		const size_t channels = stream.channels;
+		bool rewound = false;
+		while (!stream.ended.load(std::memory_order_relaxed) && !stream.closed.load(std::memory_order_relaxed))
+		{
+			// the only producer, so this much will fit
+			const size_t free_frames = (stream.ring.capacity() - stream.ring.size()) / channels;
+			const size_t count = std::min(free_frames, chunk_frames);
+			if (count == 0)
+				break;
+
+			buffer.resize(count * channels);
+			const size_t read = stream.source->read(buffer.data(), count);
+			(void)stream.ring.try_push(buffer.begin(), buffer.begin() + static_cast<std::ptrdiff_t>(read * channels));
+			if (read == count)
+				continue;
 
+			// a short read is the end, marked right away so that the audio thread doesn't take it for an underrun
+			// an empty stream would rewind forever
+			rewound &= read == 0;
+			if (!rewound && stream.loop.load(std::memory_order_relaxed) && stream.source->rewind())
+			{
+				rewound = true;
+				continue;
+			}
+			stream.ended.store(true, std::memory_order_release);
+			break;
+		}
 	}
-}
\ No newline at end of file
+}
@@ -1,22 +1,285 @@
 #pragma once
 
 #include "engine/internal_libs.hpp"
+#include "engine/utility/event_count.hpp"
+#include "engine/utility/mpmc_queue.hpp"
 
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <gsl/span>
 
 
-namespace oe::utils { struct audio_data; }
+
+/*
+
+	Voices mixed on the audio thread, controlled from any thread
+
+		oe::audio::AudioDevice audio;
+		auto clip = oe::asset::AssetCache::get().load<oe::utils::audio_data>("res/jump.mp3");
+		audio.play(clip, { 0.8f, -0.5f }); // gain, pan
+		auto music = audio.play(oe::audio::AudioStream::open("res/music.ogg"), { 0.5f, 0.0f, 1.0f, true, oe::audio::bus::music });
+		music.set_pitch(1.2f);
+		audio.set_bus_gain(oe::audio::bus::music, 0.25f);
+
+	clips are decoded once and shared, streams are decoded a bit ahead on the stream thread
+	the audio thread never locks, allocates or frees, everything reaches it through a lock-free queue
+
+*/
+
+namespace oe::utils { struct audio_data; class FileIO; class audio_decoder; }
+
+struct ma_context;
+struct ma_device;
 
 namespace oe::audio
 {
-	class AudioDevice
+	enum class bus : uint8_t
+	{
+		effects, music, ambient, ui
+	};
+	constexpr size_t bus_count = 4;
+
+	enum class audio_backend : uint8_t
+	{
+		system, // the default output device
+		null,   // miniaudio's null device, plays in real time without any sound card
+		none    // no device thread, render() is called by hand
+	};
+
+	struct device_settings
+	{
+		audio_backend backend = audio_backend::system;
+		uint32_t sample_rate = 48000;
+		uint32_t period_frames = 480; // 10 ms at 48 kHz
+		size_t max_voices = 64;
+		std::chrono::milliseconds stream_buffer{ 500 }; // decoded ahead per stream
+	};
+
+	struct voice_params
+	{
+		float gain = 1.0f;
+		float pan = 0.0f;   // -1 left, 1 right
+		float pitch = 1.0f; // playback speed, 0.125 to 8
+		bool loop = false;
+		bus output = bus::effects;
+		double offset = 0.0; // clips: the source frame to start from
+	};
+
+	struct audio_stats
+	{
+		size_t voices = 0;    // playing or paused
+		size_t streams = 0;   // open on the stream thread
+		size_t callbacks = 0;
+		size_t frames = 0;    // mixed in total
+		size_t commands = 0;
+		size_t rejected = 0;  // play() with every voice in use or a full command queue, commands dropped without a backend
+		size_t underruns = 0; // blocks a stream had no data for
+		float mix_ms_average = 0.0f;
+		float mix_ms_peak = 0.0f;
+	};
+
+	// a sound decoded a bit at a time, read on the stream thread only
+	class AudioStream
 	{
 	public:
-		AudioDevice();
+		virtual ~AudioStream() = default;
+
+		// 1 or 2
+		[[nodiscard]] virtual int channels() const noexcept = 0;
+		[[nodiscard]] virtual int sample_rate() const noexcept = 0;
+		// frame_count interleaved frames, fewer only at the end
+		virtual size_t read(float* frames, size_t frame_count) = 0;
+		// false if it can't go back to the start
+		virtual bool rewind() = 0;
+
+		// an mp3, wav or ogg file, mapped and decoded as it plays
+		[[nodiscard]] static std::unique_ptr<AudioStream> open(const oe::utils::FileIO& path);
+		[[nodiscard]] static std::unique_ptr<AudioStream> open(std::unique_ptr<oe::utils::audio_decoder> decoder);
 	};
 
+	namespace detail
+	{
+		struct stream_state;
+
+		// what play() hands to the audio thread
+		struct voice_source
+		{
+			std::shared_ptr<const oe::utils::audio_data> clip;
+			std::shared_ptr<stream_state> stream;
+			voice_params params;
+		};
+
+		struct voice_slot
+		{
+			enum class state_t : uint8_t { free, starting, playing, paused, finished };
+
+			std::atomic<uint32_t> generation{ 0 };
+			std::atomic<state_t> state{ state_t::free };
+			voice_source source; // written before the start command, then only read by the audio thread
+		};
+
+		struct command
+		{
+			enum class type_t : uint8_t { start, stop, pause, resume, gain, pan, pitch, loop, bus_gain, master_gain };
+
+			type_t type;
+			uint32_t slot;
+			uint32_t generation;
+			float value;
+		};
+	}
+
+	class AudioDevice;
+
+	// a voice playing on an AudioDevice, copies control the same voice
+	// does nothing once the voice is done, and must not outlive the device
 	class AudioPlayer
 	{
+	private:
+		friend class AudioDevice;
+
+		AudioDevice* m_device = nullptr;
+		uint32_t m_slot = 0;
+		uint32_t m_generation = 0;
+
+	public:
+		AudioPlayer() = default;
+		AudioPlayer(AudioDevice* device, uint32_t slot, uint32_t generation) noexcept
+			: m_device(device), m_slot(slot), m_generation(generation)
+		{}
+
+		[[nodiscard]] inline bool valid() const noexcept { return m_device != nullptr; }
+		[[nodiscard]] inline explicit operator bool() const noexcept { return valid(); }
+		// not stopped or finished yet, paused counts
+		[[nodiscard]] bool playing() const noexcept;
+		[[nodiscard]] bool paused() const noexcept;
+
+		void stop();
+		void pause();
+		void resume();
+		void set_gain(float gain);
+		void set_pan(float pan);
+		void set_pitch(float pitch);
+		void set_loop(bool loop);
+	};
+
+	// new parameters for a playing voice
+	struct voice_update
+	{
+		AudioPlayer voice;
+		float gain = 1.0f;
+		float pan = 0.0f;
+		float pitch = 1.0f;
+	};
+
+	// an output device and the mixer feeding it
+	class AudioDevice
+	{
+	public:
+		static constexpr size_t channels = 2;
+		static constexpr size_t block_frames = 256; // mixed at a time
+		static constexpr float max_step = 16.0f;    // source frames per output frame, pitch and sample rate together
+
+	private:
+		struct voice;
+
+		device_settings m_settings;
+		std::unique_ptr<ma_context> m_context;
+		std::unique_ptr<ma_device> m_device;
+
+		// game threads
+		std::mutex m_slots_mtx;
+		std::vector<detail::voice_slot> m_slots;
+		std::vector<uint32_t> m_free_slots;
+		oe::utils::mpmc_queue<detail::command> m_commands;
+
+		// audio thread
+		std::vector<voice> m_voices;
+		std::array<float, bus_count> m_bus_gain;
+		std::array<float, bus_count> m_bus_gain_target;
+		float m_master_gain = 1.0f;
+		float m_master_gain_target = 1.0f;
+		std::vector<float> m_buses;   // bus_count * block_frames * channels
+		std::vector<float> m_scratch; // one voice, resampled to stereo
+		std::vector<float> m_source;  // one voice, converted to float before resampling
+
+		// stream thread
+		std::mutex m_streams_mtx;
+		std::vector<std::shared_ptr<detail::stream_state>> m_streams;
+		bool m_streams_added = false;
+		oe::utils::event_count m_stream_wake;
+		std::atomic<bool> m_stopping{ false };
+		std::thread m_stream_thread;
+
+		struct atomic_stats
+		{
+			std::atomic<size_t> voices{ 0 };
+			std::atomic<size_t> callbacks{ 0 };
+			std::atomic<size_t> frames{ 0 };
+			std::atomic<size_t> commands{ 0 };
+			std::atomic<size_t> rejected{ 0 };
+			std::atomic<size_t> underruns{ 0 };
+			std::atomic<uint64_t> mix_ns{ 0 };
+			std::atomic<uint64_t> mix_ns_peak{ 0 };
+		} m_stats;
+
 	public:
-		AudioPlayer();
+		// throws if the backend can't be opened
+		explicit AudioDevice(const device_settings& settings = {});
+		AudioDevice(const AudioDevice&) = delete;
+		AudioDevice& operator=(const AudioDevice&) = delete;
+		~AudioDevice();
+
+		// an invalid AudioPlayer if every voice is in use or the audio thread is too far behind on commands
+		// throws if it isn't mono or stereo
+		AudioPlayer play(std::shared_ptr<const oe::utils::audio_data> clip, const voice_params& params = {});
+		AudioPlayer play(std::unique_ptr<AudioStream> stream, const voice_params& params = {});
+
+		void set_bus_gain(bus output, float gain);
+		void set_master_gain(float gain);
+
+		// the same as set_gain(), set_pan() and set_pitch() on every voice, pushed to the audio thread as one batch
+		void update_voices(gsl::span<const voice_update> updates);
+
+		// frees what finished voices were playing, play() does it too when it runs out of voices
+		void update();
+
+		// audio_backend::none: mixes frame_count interleaved stereo frames into out
+		void render(float* out, size_t frame_count);
+
+		[[nodiscard]] inline uint32_t sample_rate() const noexcept { return m_settings.sample_rate; }
+		[[nodiscard]] inline size_t max_voices() const noexcept { return m_slots.size(); }
+		// frames mixed so far, the clock voices play by
+		[[nodiscard]] inline uint64_t frame_clock() const noexcept { return m_stats.frames.load(std::memory_order_relaxed); }
+		[[nodiscard]] audio_stats stats();
+
+	private:
+		friend class AudioPlayer;
+
+		void open_device();
+		void close_device();
+
+		AudioPlayer start(detail::voice_source&& source);
+		void send(const detail::command& command);
+		void send(const detail::command* commands, size_t count);
+		void reclaim(); // m_slots_mtx held
+
+		// audio thread
+		void process_commands();
+		void mix(float* out, size_t frame_count);
+		bool render_voice(voice& v, size_t frame_count);
+		size_t render_clip(voice& v, float* out, size_t frame_count);
+		size_t render_stream(voice& v, float* out, size_t frame_count);
+		void finish(voice& v);
+
+		// stream thread
+		void stream_thread();
+		static void fill(detail::stream_state& stream, std::vector<float>& buffer);
 	};
-}
\ No newline at end of file
+}
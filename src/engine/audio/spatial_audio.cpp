@@ -0,0 +1,203 @@
+#include "spatial_audio.hpp"
+
+#include "engine/ecs/world.hpp"
+#include "engine/utility/fileio.hpp"
+#include "engine/utility/profiler.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+
+
+namespace oe::audio
+{
+	float distance_gain(const SoundEmitter& emitter, float distance) noexcept
+	{
+		const float min_distance = std::max(emitter.min_distance, 1e-3f);
+		const float max_distance = std::max(emitter.max_distance, min_distance);
+		if (distance >= max_distance)
+			return 0.0f;
+		if (distance <= min_distance)
+			return 1.0f;
+
+		// shifted and scaled to reach 0 at max_distance instead of cutting off there
+		const auto inverse = [&](float d){ return min_distance / (min_distance + std::max(emitter.rolloff, 0.0f) * (d - min_distance)); };
+		const float floor = inverse(max_distance);
+		if (floor > 0.999f) // next to no rolloff, linear
+			return (max_distance - distance) / (max_distance - min_distance);
+		return (inverse(distance) - floor) / (1.0f - floor);
+	}
+
+	float distance_pan(const SoundEmitter& emitter, const glm::vec2& offset) noexcept
+	{
+		const float distance = std::max(glm::length(offset), std::max(emitter.min_distance, 1e-3f));
+		return std::clamp(offset.x / distance, -1.0f, 1.0f);
+	}
+
+	SpatialAudio::SpatialAudio(AudioDevice& device, oe::ecs::World& world, const spatial_settings& settings)
+		: m_device(device)
+		, m_world(world)
+		, m_settings(settings)
+		, m_clock(device.frame_clock())
+	{
+		m_real.reserve(m_settings.max_voices);
+		m_kept.reserve(m_settings.max_voices);
+		m_updates.reserve(m_settings.max_voices);
+	}
+
+	SpatialAudio::~SpatialAudio()
+	{
+		stop();
+	}
+
+	SoundEmitter* SpatialAudio::find(entt::entity entity) const
+	{
+		auto& registry = m_world.m_scene;
+		return registry.valid(entity) ? registry.try_get<SoundEmitter>(entity) : nullptr;
+	}
+
+	void SpatialAudio::stop()
+	{
+		for (auto& real : m_real)
+		{
+			real.voice.stop();
+			if (auto* emitter = find(real.entity))
+				emitter->state.real = false;
+		}
+		m_real.clear();
+	}
+
+	void SpatialAudio::update(const glm::vec2& listener)
+	{
+		OE_PROFILE_SCOPE("SpatialAudio::update");
+		const auto start = std::chrono::steady_clock::now();
+		auto& registry = m_world.m_scene;
+
+		m_stats = {};
+		if (++m_update == 0)
+			m_update = 1;
+		// frees the voices stopped last time
+		m_device.update();
+
+		const uint64_t clock = m_device.frame_clock();
+		const double elapsed = static_cast<double>(clock - m_clock);
+		const double device_rate = static_cast<double>(m_device.sample_rate());
+		m_clock = clock;
+
+		// every emitter: playhead, gain and pan
+		// nothing here touches the AudioDevice, virtual emitters cost a few multiplies
+		m_candidates.clear();
+		registry.view<SoundEmitter>().each([&](const entt::entity entity, SoundEmitter& emitter)
+		{
+			m_stats.emitters++;
+			auto& state = emitter.state;
+			state.gain = 0.0f;
+			if (!emitter.clip || state.ended)
+				return;
+			const size_t frames = emitter.clip->frames();
+			if (frames == 0 || emitter.clip->sample_rate <= 0)
+				return;
+
+			// the same step the mixer takes
+			const double step = std::min(static_cast<double>(AudioDevice::max_step), static_cast<double>(std::clamp(emitter.pitch, 0.125f, 8.0f)) * emitter.clip->sample_rate / device_rate);
+			state.playhead += elapsed * step;
+			if (state.playhead >= static_cast<double>(frames))
+			{
+				if (!emitter.loop)
+				{
+					state.ended = true;
+					return;
+				}
+				state.playhead = std::fmod(state.playhead, static_cast<double>(frames));
+			}
+
+			const glm::vec2 offset = emitter.position - listener;
+			state.gain = std::max(emitter.gain, 0.0f) * distance_gain(emitter, glm::length(offset));
+			state.pan = distance_pan(emitter, offset);
+			if (state.gain <= m_settings.audible_gain)
+				return;
+
+			const float audibility = state.gain * emitter.priority * (state.real ? m_settings.hysteresis : 1.0f);
+			m_candidates.emplace_back(audibility, entity);
+		});
+		m_stats.audible = m_candidates.size();
+
+		// the loudest max_voices, linear time for the split and a sort of only the ones kept
+		const auto louder = [](const std::pair<float, entt::entity>& a, const std::pair<float, entt::entity>& b){ return a.first > b.first; };
+		if (m_candidates.size() > m_settings.max_voices)
+		{
+			std::nth_element(m_candidates.begin(), m_candidates.begin() + static_cast<std::ptrdiff_t>(m_settings.max_voices), m_candidates.end(), louder);
+			m_candidates.resize(m_settings.max_voices);
+		}
+		std::sort(m_candidates.begin(), m_candidates.end(), louder);
+		for (const auto& candidate : m_candidates)
+			registry.get<SoundEmitter>(candidate.second).state.selected = m_update;
+
+		// the voices already playing are kept, updated or stopped
+		m_kept.clear();
+		m_updates.clear();
+		for (auto& real : m_real)
+		{
+			SoundEmitter* emitter = find(real.entity);
+			if (!emitter || !emitter->state.real)
+			{
+				// destroyed, or replaced with a new component
+				real.voice.stop();
+				m_stats.demoted++;
+				continue;
+			}
+
+			auto& state = emitter->state;
+			if (!real.voice.playing())
+			{
+				// played to its end before the playhead did
+				state.real = false;
+				state.ended = !emitter->loop;
+				continue;
+			}
+
+			if (state.selected != m_update)
+			{
+				real.voice.stop();
+				state.real = false;
+				m_stats.demoted++;
+				continue;
+			}
+
+			const float pitch = emitter->pitch;
+			if (std::abs(state.gain - real.gain) > 1e-3f || std::abs(state.pan - real.pan) > 1e-3f || pitch != real.pitch)
+			{
+				m_updates.push_back({ real.voice, state.gain, state.pan, pitch });
+				real.gain = state.gain;
+				real.pan = state.pan;
+				real.pitch = pitch;
+			}
+			m_kept.push_back(real);
+		}
+
+		// and the newly picked ones start where their playhead is
+		for (const auto& candidate : m_candidates)
+		{
+			auto& emitter = registry.get<SoundEmitter>(candidate.second);
+			auto& state = emitter.state;
+			if (state.real)
+				continue;
+
+			const AudioPlayer voice = m_device.play(emitter.clip, { state.gain, state.pan, emitter.pitch, emitter.loop, emitter.output, state.playhead });
+			// the device is out of voices, the rest stay virtual until the stopped ones are freed
+			if (!voice)
+				break;
+			state.real = true;
+			m_kept.push_back({ candidate.second, voice, state.gain, state.pan, emitter.pitch });
+			m_stats.promoted++;
+		}
+		std::swap(m_real, m_kept);
+
+		if (!m_updates.empty())
+			m_device.update_voices(m_updates);
+
+		m_stats.real = m_real.size();
+		m_stats.updated = m_updates.size();
+		m_stats.update_ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include "audio.hpp"
+
+#include <entt/entt.hpp>
+
+
+
+/*
+
+	Sounds placed on entities, only the most audible ones mixed
+
+		oe::audio::SpatialAudio spatial{ audio, world, { 32 } };
+		auto& emitter = entity.setComponent<oe::audio::SoundEmitter>();
+		emitter.clip = oe::asset::AssetCache::get().load<oe::utils::audio_data>("res/fire.ogg");
+		emitter.max_distance = 40.0f;
+
+		// every tick, from the thread that owns the World
+		emitter.position = ...;
+		spatial.update(camera_center);
+
+	every emitter keeps a playhead, the max_voices most audible get a voice on the AudioDevice
+	the rest are virtual, their playheads keep moving and they pick up from there when they get a voice again
+	update() sends the gain, pan and pitch of every voice it plays as one batch
+
+*/
+
+namespace oe::ecs { struct World; }
+
+namespace oe::audio
+{
+	namespace detail
+	{
+		// owned by SpatialAudio, reset when the component is replaced
+		struct emitter_state
+		{
+			double playhead = 0.0; // in source frames
+			float gain = 0.0f;     // after distance and priority
+			float pan = 0.0f;
+			uint32_t selected = 0; // the update() that last picked it
+			bool real = false;     // has a voice
+			bool ended = false;    // a one-shot played to the end
+		};
+	}
+
+	// a clip playing at a point, attenuated by the distance to the listener
+	struct SoundEmitter
+	{
+		std::shared_ptr<const oe::utils::audio_data> clip;
+		glm::vec2 position{ 0.0f };
+		float gain = 1.0f;
+		float pitch = 1.0f;
+		float min_distance = 1.0f;  // full volume up to here
+		float max_distance = 50.0f; // silent from here on
+		float rolloff = 1.0f;       // how fast it gets quieter in between
+		float priority = 1.0f;      // scales the gain when picking what gets a voice
+		bool loop = true;           // one-shots go silent at the end, set the component again to replay
+		bus output = bus::effects;
+
+		detail::emitter_state state;
+	};
+
+	struct spatial_settings
+	{
+		size_t max_voices = 32;          // mixed at once, the AudioDevice needs a few more for the ones fading out
+		float hysteresis = 1.25f;        // a voice playing already is kept until another is this much louder
+		float audible_gain = 1.0f / 1024.0f; // quieter emitters never get a voice
+	};
+
+	struct spatial_stats
+	{
+		size_t emitters = 0;
+		size_t audible = 0;  // louder than audible_gain
+		size_t real = 0;     // with a voice
+		size_t promoted = 0; // got a voice this update
+		size_t demoted = 0;  // lost one
+		size_t updated = 0;  // voices sent new parameters
+		float update_ms = 0.0f;
+	};
+
+	// inverse distance, clamped to min_distance and brought down to 0 at max_distance
+	[[nodiscard]] float distance_gain(const SoundEmitter& emitter, float distance) noexcept;
+	// by how far left or right of the listener it is, centered when closer than min_distance
+	[[nodiscard]] float distance_pan(const SoundEmitter& emitter, const glm::vec2& offset) noexcept;
+
+	// the SoundEmitters of a World played on an AudioDevice
+	// destroyed or replaced emitters lose their voice on the next update(), must not outlive the device or the World
+	class SpatialAudio
+	{
+	private:
+		struct real_voice
+		{
+			entt::entity entity;
+			AudioPlayer voice;
+			float gain;
+			float pan;
+			float pitch;
+		};
+
+		AudioDevice& m_device;
+		oe::ecs::World& m_world;
+		spatial_settings m_settings;
+
+		uint64_t m_clock = 0; // AudioDevice::frame_clock() at the last update()
+		uint32_t m_update = 0;
+		std::vector<real_voice> m_real;
+		std::vector<real_voice> m_kept;
+		std::vector<std::pair<float, entt::entity>> m_candidates;
+		std::vector<voice_update> m_updates;
+		spatial_stats m_stats;
+
+	public:
+		SpatialAudio(AudioDevice& device, oe::ecs::World& world, const spatial_settings& settings = {});
+		SpatialAudio(const SpatialAudio&) = delete;
+		~SpatialAudio();
+
+		// moves the playheads, picks the voices and sends their parameters
+		// call once per tick from the thread that owns the World
+		void update(const glm::vec2& listener);
+
+		// stops every voice, the playheads stay and the next update() picks again
+		void stop();
+
+		[[nodiscard]] inline const spatial_stats& stats() const noexcept { return m_stats; }
+		[[nodiscard]] inline const spatial_settings& settings() const noexcept { return m_settings; }
+
+	private:
+		[[nodiscard]] SoundEmitter* find(entt::entity entity) const;
+	};
+}
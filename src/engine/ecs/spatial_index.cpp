@@ -0,0 +1,135 @@
+#include "spatial_index.hpp"
+
+#include "engine/utility/formatted_error.hpp"
+
+
+
+namespace oe::ecs
+{
+	SpatialIndex::SpatialIndex(float cell_size)
+		: m_cell_size(cell_size)
+		, m_inv_cell_size(1.0f / cell_size)
+	{
+		if (cell_size <= 0.0f)
+			throw oe::utils::formatted_error("Invalid SpatialIndex cell size: {}", cell_size);
+	}
+
+	SpatialIndex::item_t& SpatialIndex::item(const entry_t& entry)
+	{
+		return entry.oversized ? m_oversized[entry.index_in_cell] : m_cells.find(entry.cell)->second[entry.index_in_cell];
+	}
+
+	const SpatialIndex::item_t& SpatialIndex::item(const entry_t& entry) const
+	{
+		return entry.oversized ? m_oversized[entry.index_in_cell] : m_cells.find(entry.cell)->second[entry.index_in_cell];
+	}
+
+	void SpatialIndex::link(entt::entity entity, const AABB& aabb, entry_t& entry)
+	{
+		entry.oversized = is_oversized(aabb);
+		if (entry.oversized)
+		{
+			entry.cell = 0;
+			entry.index_in_cell = m_oversized.size();
+			m_oversized.push_back({ aabb, entity });
+			return;
+		}
+
+		const glm::ivec2 coord = cell_coord(aabb.center());
+		m_cell_min = glm::min(m_cell_min, coord);
+		m_cell_max = glm::max(m_cell_max, coord);
+
+		entry.cell = cell_key(coord);
+		auto& cell = m_cells[entry.cell];
+		entry.index_in_cell = cell.size();
+		cell.push_back({ aabb, entity });
+	}
+
+	void SpatialIndex::unlink(const entry_t& entry)
+	{
+		auto cell_iter = m_cells.end();
+		cell_t* cell = &m_oversized;
+		if (!entry.oversized)
+		{
+			cell_iter = m_cells.find(entry.cell);
+			cell = &cell_iter->second;
+		}
+
+		// swap and pop, the swapped entity needs its index fixed
+		const item_t last = cell->back();
+		(*cell)[entry.index_in_cell] = last;
+		m_entries.find(last.entity)->second.index_in_cell = entry.index_in_cell;
+		cell->pop_back();
+
+		if (cell_iter != m_cells.end() && cell->empty())
+			m_cells.erase(cell_iter);
+	}
+
+	void SpatialIndex::update(entt::entity entity, const AABB& aabb)
+	{
+		auto [iter, inserted] = m_entries.try_emplace(entity);
+		auto& entry = iter->second;
+		if (inserted)
+		{
+			link(entity, aabb, entry);
+			return;
+		}
+
+		// still in the same cell
+		const bool oversized = is_oversized(aabb);
+		if (oversized == entry.oversized && (oversized || cell_key(cell_coord(aabb.center())) == entry.cell))
+		{
+			item(entry).aabb = aabb;
+			return;
+		}
+
+		unlink(entry);
+		link(entity, aabb, entry);
+	}
+
+	void SpatialIndex::remove(entt::entity entity)
+	{
+		auto iter = m_entries.find(entity);
+		if (iter == m_entries.end())
+			return;
+
+		unlink(iter->second);
+		m_entries.erase(iter);
+	}
+
+	void SpatialIndex::clear()
+	{
+		m_cells.clear();
+		m_entries.clear();
+		m_oversized.clear();
+		m_cell_min = { std::numeric_limits<int32_t>::max(), std::numeric_limits<int32_t>::max() };
+		m_cell_max = { std::numeric_limits<int32_t>::min(), std::numeric_limits<int32_t>::min() };
+	}
+
+	bool SpatialIndex::contains(entt::entity entity) const
+	{
+		return m_entries.find(entity) != m_entries.end();
+	}
+
+	const AABB& SpatialIndex::get(entt::entity entity) const
+	{
+		auto iter = m_entries.find(entity);
+		if (iter == m_entries.end())
+			throw oe::utils::formatted_error("Entity {} is not in the SpatialIndex", static_cast<uint32_t>(entity));
+		return item(iter->second).aabb;
+	}
+
+	std::vector<entt::entity> SpatialIndex::query(const AABB& area) const
+	{
+		std::vector<entt::entity> result;
+		query(area, [&result](entt::entity entity){ result.push_back(entity); });
+		return result;
+	}
+
+	std::vector<entt::entity> SpatialIndex::query(const glm::vec2& center, float radius) const
+	{
+		std::vector<entt::entity> result;
+		query(center, radius, [&result](entt::entity entity){ result.push_back(entity); });
+		return result;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,177 @@
+#pragma once
+
+#include "engine/internal_libs.hpp"
+
+#include <unordered_map>
+#include <vector>
+
+
+
+namespace oe::ecs
+{
+	// axis aligned bounding box
+	struct AABB
+	{
+		glm::vec2 min = { 0.0f, 0.0f };
+		glm::vec2 max = { 0.0f, 0.0f };
+
+		[[nodiscard]] inline glm::vec2 center() const noexcept { return (min + max) * 0.5f; }
+		[[nodiscard]] inline glm::vec2 half_size() const noexcept { return (max - min) * 0.5f; }
+		[[nodiscard]] inline bool overlaps(const AABB& other) const noexcept
+		{
+			return min.x <= other.max.x && max.x >= other.min.x && min.y <= other.max.y && max.y >= other.min.y;
+		}
+		[[nodiscard]] inline bool overlaps(const glm::vec2& circle_center, float radius) const noexcept
+		{
+			const glm::vec2 closest = glm::clamp(circle_center, min, max);
+			const glm::vec2 delta = circle_center - closest;
+			return glm::dot(delta, delta) <= radius * radius;
+		}
+	};
+
+	// loose uniform grid
+	// entities are binned by the center of their AABB and every cell is
+	// allowed to leak half a cell past its borders, so moving entities
+	// only get rebinned when their center crosses a cell border
+	// entities larger than a cell are kept in a separate list
+	class SpatialIndex
+	{
+	private:
+		using cell_key_t = uint64_t;
+
+		// bounds are stored in the cells for linear queries
+		struct item_t
+		{
+			AABB aabb;
+			entt::entity entity;
+		};
+		using cell_t = std::vector<item_t>;
+
+		struct entry_t
+		{
+			cell_key_t cell;
+			size_t index_in_cell;
+			bool oversized;
+		};
+
+		float m_cell_size;
+		float m_inv_cell_size;
+		std::unordered_map<cell_key_t, cell_t> m_cells;
+		std::unordered_map<entt::entity, entry_t> m_entries;
+		cell_t m_oversized;
+
+		// occupied cell range, used to clamp huge queries
+		glm::ivec2 m_cell_min = { std::numeric_limits<int32_t>::max(), std::numeric_limits<int32_t>::max() };
+		glm::ivec2 m_cell_max = { std::numeric_limits<int32_t>::min(), std::numeric_limits<int32_t>::min() };
+
+	private:
+		[[nodiscard]] inline glm::ivec2 cell_coord(const glm::vec2& point) const noexcept
+		{
+			return glm::ivec2(glm::floor(point * m_inv_cell_size));
+		}
+		[[nodiscard]] static inline cell_key_t cell_key(const glm::ivec2& coord) noexcept
+		{
+			return (static_cast<cell_key_t>(static_cast<uint32_t>(coord.x)) << 32) | static_cast<cell_key_t>(static_cast<uint32_t>(coord.y));
+		}
+		[[nodiscard]] inline bool is_oversized(const AABB& aabb) const noexcept
+		{
+			const glm::vec2 half_size = aabb.half_size();
+			return half_size.x > m_cell_size * 0.5f || half_size.y > m_cell_size * 0.5f;
+		}
+
+		void link(entt::entity entity, const AABB& aabb, entry_t& entry);
+		void unlink(const entry_t& entry);
+		[[nodiscard]] item_t& item(const entry_t& entry);
+		[[nodiscard]] const item_t& item(const entry_t& entry) const;
+
+		// calls fn(const item_t&) for every item in the cells the area touches
+		template<typename Fn>
+		void query_items(const AABB& area, Fn&& fn) const
+		{
+			if (!m_cells.empty())
+				query_cells(area, fn);
+
+			for (const auto& item : m_oversized)
+				fn(item);
+		}
+
+		// m_cell_min and m_cell_max are only set with cells
+		template<typename Fn>
+		void query_cells(const AABB& area, Fn& fn) const
+		{
+			const float margin = m_cell_size * 0.5f;
+			const glm::ivec2 first = glm::max(cell_coord(area.min - margin), m_cell_min);
+			const glm::ivec2 last = glm::min(cell_coord(area.max + margin), m_cell_max);
+			const int64_t columns = std::max<int64_t>(0, static_cast<int64_t>(last.x) - first.x + 1);
+			const int64_t rows = std::max<int64_t>(0, static_cast<int64_t>(last.y) - first.y + 1);
+			if (columns == 0 || rows == 0)
+				return;
+
+			const size_t cell_count = static_cast<size_t>(columns) * static_cast<size_t>(rows);
+
+			if (cell_count > m_cells.size())
+			{
+				// less work to go through all occupied cells than the whole area
+				for (const auto& [key, cell] : m_cells)
+				{
+					const glm::ivec2 coord = { static_cast<int32_t>(key >> 32), static_cast<int32_t>(key & 0xFFFFFFFF) };
+					if (coord.x < first.x || coord.x > last.x || coord.y < first.y || coord.y > last.y)
+						continue;
+					for (const auto& item : cell)
+						fn(item);
+				}
+			}
+			else
+			{
+				for (int32_t x = first.x; x <= last.x; x++)
+					for (int32_t y = first.y; y <= last.y; y++)
+					{
+						auto iter = m_cells.find(cell_key({ x, y }));
+						if (iter == m_cells.end())
+							continue;
+						for (const auto& item : iter->second)
+							fn(item);
+					}
+			}
+		}
+
+	public:
+		SpatialIndex(float cell_size = 4.0f);
+
+		// insert or move an entity
+		// O(1) when the entity stays in its current cell
+		void update(entt::entity entity, const AABB& aabb);
+		void remove(entt::entity entity);
+		void clear();
+
+		[[nodiscard]] bool contains(entt::entity entity) const;
+		[[nodiscard]] const AABB& get(entt::entity entity) const;
+		[[nodiscard]] inline size_t size() const noexcept { return m_entries.size(); }
+		[[nodiscard]] inline float cell_size() const noexcept { return m_cell_size; }
+
+		// calls fn(entt::entity) for every entity overlapping the area
+		template<typename Fn>
+		void query(const AABB& area, Fn&& fn) const
+		{
+			query_items(area, [&](const item_t& item)
+			{
+				if (item.aabb.overlaps(area))
+					fn(item.entity);
+			});
+		}
+
+		// calls fn(entt::entity) for every entity overlapping the circle
+		template<typename Fn>
+		void query(const glm::vec2& center, float radius, Fn&& fn) const
+		{
+			query_items(AABB{ center - radius, center + radius }, [&](const item_t& item)
+			{
+				if (item.aabb.overlaps(center, radius))
+					fn(item.entity);
+			});
+		}
+
+		[[nodiscard]] std::vector<entt::entity> query(const AABB& area) const;
+		[[nodiscard]] std::vector<entt::entity> query(const glm::vec2& center, float radius) const;
+	};
+}
\ No newline at end of file
@@ -1,6 +1,10 @@
 #include "world.hpp"
 
 #include "entity.hpp"
+#include "components/quad.hpp"
+#include "engine/graphics/primitives.hpp"
+
+#include <algorithm>
 
 
 
@@ -8,6 +12,15 @@ namespace oe::ecs
 {
 	World::World()
 	{
+		m_scene.on_construct<QuadComponent>().connect<&World::on_quad_construct>(*this);
+		m_scene.on_destroy<QuadComponent>().connect<&World::on_quad_destroy>(*this);
+		m_renderer.setCullSource(cullSource(m_renderer));
+	}
+
+	World::~World()
+	{
+		// while the index and the maps are still alive
+		m_scene.clear();
 	}
 
 	Entity World::create()
@@ -33,6 +46,10 @@ namespace oe::ecs
 	void World::clear()
 	{
 		m_scene.clear();
+		m_spatial_index.clear();
+		m_quads_added.clear();
+		m_quads_moved.clear();
+		m_quad_entities.clear();
 		m_renderer.clear();
 		m_debug_renderer.clear();
 	}
@@ -41,4 +58,82 @@ namespace oe::ecs
 	{
 		return m_scene.alive();
 	}
+
+	void World::updateSpatialIndex()
+	{
+		// the ones still without a quad stay, it can be given later
+		auto waiting = std::remove_if(m_quads_added.begin(), m_quads_added.end(), [this](entt::entity entity) {
+			if (!m_scene.valid(entity) || !m_scene.has<QuadComponent>(entity))
+				return true;
+
+			auto* quad = m_scene.get<QuadComponent>(entity).quad_holder.get();
+			if (!quad)
+				return false;
+			if (quad->getObserver())
+				return true;
+
+			m_quad_entities.emplace(quad, entity);
+			quad->setObserver(this); // moved right away
+			return true;
+		});
+		m_quads_added.erase(waiting, m_quads_added.end());
+
+		for (auto* quad : m_quads_moved)
+		{
+			AABB aabb;
+			quad->gen_bounds(aabb.min, aabb.max);
+			quad->clearMoved();
+			m_spatial_index.update(m_quad_entities.find(quad)->second, aabb);
+		}
+		m_quads_moved.clear();
+	}
+
+	oe::graphics::Renderer::cull_source_t World::cullSource(oe::graphics::Renderer& renderer)
+	{
+		return [this, &renderer](const glm::vec2& min, const glm::vec2& max, oe::graphics::Renderer::quads_t& visible) {
+			updateSpatialIndex();
+			m_spatial_index.query(AABB{ min, max }, [&](entt::entity entity) {
+				auto* quad = m_scene.get<QuadComponent>(entity).quad_holder.get();
+				if (&quad->getRenderer() == &renderer)
+					visible.push_back(quad);
+			});
+		};
+	}
+
+	void World::on_quad_construct(entt::registry& /* registry */, entt::entity entity)
+	{
+		m_quads_added.push_back(entity);
+	}
+
+	void World::on_quad_destroy(entt::registry& registry, entt::entity entity)
+	{
+		// the quad dies with the component, nothing to hear from it
+		if (auto* quad = registry.get<QuadComponent>(entity).quad_holder.get(); quad && quad->getObserver() == this)
+		{
+			untrack(*quad);
+			quad->setObserver(nullptr);
+		}
+		m_spatial_index.remove(entity);
+	}
+
+	void World::on_quad_moved(oe::graphics::Quad& quad)
+	{
+		m_quads_moved.push_back(&quad);
+	}
+
+	void World::on_quad_destroyed(oe::graphics::Quad& quad)
+	{
+		// quad_holder reset or replaced, the component may get a new quad
+		const entt::entity entity = m_quad_entities.find(&quad)->second;
+		untrack(quad);
+		m_spatial_index.remove(entity);
+		m_quads_added.push_back(entity);
+	}
+
+	void World::untrack(oe::graphics::Quad& quad)
+	{
+		if (quad.moved())
+			m_quads_moved.erase(std::find(m_quads_moved.begin(), m_quads_moved.end(), &quad));
+		m_quad_entities.erase(&quad);
+	}
 }
\ No newline at end of file
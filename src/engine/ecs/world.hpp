@@ -2,6 +2,7 @@
 
 #include "engine/graphics/renderer.hpp"
 #include "engine/asset/default_shader/default_shader.hpp"
+#include "spatial_index.hpp"
 
 #include <entt/entt.hpp>
 
@@ -11,9 +12,16 @@ namespace oe::ecs
 {
 	struct Entity;
 
-	struct World
+	struct World : private oe::graphics::QuadObserver
 	{
 		World();
+		~World();
+
+		// the registry signals and the quads point back to this
+		World(const World&) = delete;
+		World(World&&) = delete;
+		World& operator=(const World&) = delete;
+		World& operator=(World&&) = delete;
 
 		oe::asset::DefaultShader m_shader{};
 		oe::graphics::Renderer m_renderer{ 10000 };
@@ -23,6 +31,10 @@ namespace oe::ecs
 
 		entt::registry m_scene;
 
+		// bounds of every entity with a QuadComponent
+		// for rectangle and radius queries
+		SpatialIndex m_spatial_index{};
+
 		Entity create(); // create new entity
 		Entity create(entt::entity entity); // find existing entity
 
@@ -31,5 +43,25 @@ namespace oe::ecs
 		
 		void clear();
 		size_t count() const;
+
+		// rebin the QuadComponents that were added, given a new quad or moved since the last call
+		// m_renderer does this itself when culling
+		void updateSpatialIndex();
+
+		// culls 'renderer' with m_spatial_index, only the QuadComponents of that renderer are drawn
+		// m_renderer uses this
+		oe::graphics::Renderer::cull_source_t cullSource(oe::graphics::Renderer& renderer);
+
+	private:
+		// QuadComponents whose quad_holder is not tracked yet, it is usually set after the component
+		std::vector<entt::entity> m_quads_added;
+		std::vector<oe::graphics::Quad*> m_quads_moved;
+		std::unordered_map<const oe::graphics::Quad*, entt::entity> m_quad_entities;
+
+		void on_quad_construct(entt::registry& registry, entt::entity entity);
+		void on_quad_destroy(entt::registry& registry, entt::entity entity);
+		void on_quad_moved(oe::graphics::Quad& quad) override;
+		void on_quad_destroyed(oe::graphics::Quad& quad) override;
+		void untrack(oe::graphics::Quad& quad);
 	};
 }
\ No newline at end of file
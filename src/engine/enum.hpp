@@ -3,6 +3,7 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/constants.hpp>
 #include <string>
+#include <chrono>
 #include <array>
 #include <vector>
 #include <functional>
@@ -420,6 +421,7 @@ namespace oe {
 		void* share_handle = nullptr; // pointer to the first window obj for multiwindow setups
 		uint8_t swap_interval = 1;
 		size_t main_updatesystem_ups = 60;
+		bool raw_cursor = false; // every CursorPosEvent is delivered instead of only the latest one per frame
 	};
 	enum class file_extype { must_exist, must_not_exist, does_not_matter };
 
@@ -489,6 +491,9 @@ namespace oe {
 		data_types data_type = data_types::bytes;
 		oe::formats data_format = oe::formats::rgba;
 		bool generate_mipmaps = false;
+		// pre-built mip levels 1.., each half the size of the one before, used instead of generate_mipmaps (2D only)
+		// only read while the texture is created
+		std::vector<const void*> mipmaps = {};
 
 		texture_wrap wrap = texture_wrap::clamp_to_border;
 		texture_filter filter = texture_filter::nearest;
@@ -531,15 +536,20 @@ namespace oe {
 	struct CleanupEvent {};
 	struct RenderEvent {};
 
+    // time the input callback was called, for measuring input latency
+    using input_timestamp = std::chrono::steady_clock::time_point;
+
     struct CursorPosEvent
     {
         glm::ivec2 cursor_windowspace = { 0, 0 };
         glm::vec2 cursor_worldspace = { 0.0f, 0.0f };
+        input_timestamp timestamp{};
     };
 
 	struct ScrollEvent
     {
         glm::vec2 scroll_delta = { 0.0f, 0.0f };
+        input_timestamp timestamp{};
     };
 
 	struct MouseButtonEvent
@@ -549,6 +559,7 @@ namespace oe {
         oe::mouse_buttons button = oe::mouse_buttons::none;
         oe::actions action = oe::actions::none;
         oe::modifiers mods = oe::modifiers::none;
+        input_timestamp timestamp{};
 	};
 
     struct KeyboardEvent
@@ -556,6 +567,7 @@ namespace oe {
         oe::keys key = oe::keys::none;
         oe::actions action = oe::actions::none;
         oe::modifiers mods = oe::modifiers::none;
+        input_timestamp timestamp{};
     };
 
 	struct CodepointEvent
@@ -563,6 +575,7 @@ namespace oe {
         // unicode text input
         char32_t codepoint = 0;
         oe::modifiers mods = oe::modifiers::none;
+        input_timestamp timestamp{};
 	};
 
 	struct ResizeEvent
@@ -570,5 +583,6 @@ namespace oe {
         glm::uvec2 framebuffer_size = { 0, 0 };
         glm::uvec2 framebuffer_size_old = { 0, 0 };
 		float aspect = 0.0f;
+        input_timestamp timestamp{};
 	};
 }
\ No newline at end of file
@@ -4,7 +4,9 @@
 #include "engine/engine.hpp"
 #include "engine/graphics/spritePacker.hpp"
 #include "engine/utility/fileio.hpp"
+#include "engine/utility/byte_pool.hpp"
 #include "engine/utility/formatted_error.hpp"
+#include "engine/utility/profiler.hpp"
 
 
 
@@ -17,6 +19,9 @@
 #pragma GCC diagnostic ignored "-Wparentheses"
 #endif
 
+// glyph bitmaps and rasterizer scratch buffers
+#define STBTT_malloc(size, user) ((void)(user), oe::utils::byte_pool::get().allocate(size))
+#define STBTT_free(ptr, user)    ((void)(user), oe::utils::byte_pool::get().free(ptr))
 #define STB_TRUETYPE_IMPLEMENTATION
 #include <stb_truetype.h>
 
@@ -41,6 +46,7 @@ namespace oe::graphics
 
 	bool Font::gen_codepoint_glyph(char32_t codepoint)
 	{
+		OE_PROFILE_SCOPE("Font::gen_codepoint_glyph");
 		if(m_sdf)
 		{
 			// glyph info
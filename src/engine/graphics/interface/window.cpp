@@ -22,6 +22,14 @@ namespace oe::graphics
 		glViewport(0, 0, e.framebuffer_size.x, e.framebuffer_size.y);
 	}
 
+	template<typename Event>
+	void push_input_event(oe::utils::spsc_queue<Event>& queue, const Event& event)
+	{
+		// the gameloop thread is lagging behind by a whole queue worth of events
+		if (!queue.try_push(event))
+			spdlog::warn("Input event queue full, event dropped");
+	}
+
 	void IWindow::postglfw() 
 	{
 		glfwSetWindowUserPointer(m_window_handle, this);
@@ -33,10 +41,9 @@ namespace oe::graphics
 				oe::CodepointEvent event;
 				event.codepoint = codepoint;
 				event.mods = static_cast<modifiers>(mods);
+				event.timestamp = std::chrono::steady_clock::now();
 
-				this_class->dispatcher_mutex.lock();
-				this_class->m_window_gameloop.getDispatcher().enqueue(event);
-				this_class->dispatcher_mutex.unlock();
+				push_input_event(this_class->m_codepoint_events, event);
 				// if (this_class->m_window_info.text_callback) this_class->m_window_info.text_callback(static_cast<uint32_t>(codepoint), static_cast<oe::modifiers>(mods));
 			});
 		
@@ -55,11 +62,9 @@ namespace oe::graphics
 				event.framebuffer_size = this_class->m_window_info.size;
 				event.framebuffer_size_old = old;
 				event.aspect = this_class->getAspect();
+				event.timestamp = std::chrono::steady_clock::now();
 				
-				this_class->dispatcher_mutex.lock();
-				this_class->m_window_gameloop.getDispatcher().clear<oe::ResizeEvent>();
-				this_class->m_window_gameloop.getDispatcher().enqueue(event);
-				this_class->dispatcher_mutex.unlock();
+				this_class->m_latest_resize_event.write(event);
 				//if (this_class->m_window_info.resize_callback) this_class->m_window_info.resize_callback(this_class->m_window_info.size);
 			});
 		
@@ -76,11 +81,12 @@ namespace oe::graphics
 				oe::CursorPosEvent event;
 				event.cursor_windowspace = this_class->m_cursor_window;
 				event.cursor_worldspace = this_class->m_cursor_transformed;
+				event.timestamp = std::chrono::steady_clock::now();
 
-				this_class->dispatcher_mutex.lock();
-				this_class->m_window_gameloop.getDispatcher().clear<oe::CursorPosEvent>(); // should multiple cursor pos events be sent to the application per frame 
-				this_class->m_window_gameloop.getDispatcher().enqueue(event);
-				this_class->dispatcher_mutex.unlock();
+				if (this_class->m_raw_cursor.load(std::memory_order_relaxed))
+					push_input_event(this_class->m_cursor_events, event);
+				else
+					this_class->m_latest_cursor_event.write(event);
 				// if (this_class->m_window_info.cursor_callback) this_class->m_window_info.cursor_callback(this_class->m_cursor_transformed, this_class->m_cursor_window);
 			});
 		
@@ -100,10 +106,10 @@ namespace oe::graphics
 				event.mods = static_cast<oe::modifiers>(mods);
 				event.cursor_pos.cursor_windowspace = this_class->m_cursor_window;
 				event.cursor_pos.cursor_worldspace = this_class->m_cursor_transformed;
+				event.timestamp = std::chrono::steady_clock::now();
+				event.cursor_pos.timestamp = event.timestamp;
 
-				this_class->dispatcher_mutex.lock();
-				this_class->m_window_gameloop.getDispatcher().enqueue(event);
-				this_class->dispatcher_mutex.unlock();
+				push_input_event(this_class->m_button_events, event);
 				// if (this_class->m_window_info.button_callback) this_class->m_window_info.button_callback(static_cast<oe::mouse_buttons>(button), static_cast<oe::actions>(action));
 			});
 		
@@ -121,10 +127,9 @@ namespace oe::graphics
 				event.key = static_cast<oe::keys>(key);
 				event.action = static_cast<oe::actions>(action);
 				event.mods = static_cast<oe::modifiers>(mods);
+				event.timestamp = std::chrono::steady_clock::now();
 
-				this_class->dispatcher_mutex.lock();
-				this_class->m_window_gameloop.getDispatcher().enqueue(event);
-				this_class->dispatcher_mutex.unlock();
+				push_input_event(this_class->m_key_events, event);
 				// if (this_class->m_window_info.key_callback) this_class->m_window_info.key_callback(static_cast<oe::keys>(key), static_cast<oe::actions>(action), static_cast<oe::modifiers>(mods));
 			});
 		
@@ -134,10 +139,9 @@ namespace oe::graphics
 
 				oe::ScrollEvent event;
 				event.scroll_delta = { xoffset, yoffset };
+				event.timestamp = std::chrono::steady_clock::now();
 
-				this_class->dispatcher_mutex.lock();
-				this_class->m_window_gameloop.getDispatcher().enqueue(event);
-				this_class->dispatcher_mutex.unlock();
+				push_input_event(this_class->m_scroll_events, event);
 				// if (this_class->m_window_info.scroll_callback) this_class->m_window_info.scroll_callback(yoffset);
 			});
 
@@ -146,6 +150,7 @@ namespace oe::graphics
 		glfwSetWindowSize(m_window_handle, m_window_info.size.x, m_window_info.size.y);
 
 		swapInterval(m_window_info.swap_interval);
+		setRawCursor(m_window_info.raw_cursor);
 		setIcon(oe::asset::TextureSet::sprite("logo"));
 
 		connect_listener<oe::ResizeEvent, &resize_viewport>();
@@ -154,6 +159,7 @@ namespace oe::graphics
 	IWindow::IWindow(const std::unique_ptr<Instance>& /* instance */, const WindowInfo& window_config) 
 		: m_window_info(window_config)
 		, m_window_gameloop(this)
+		, m_raw_cursor(window_config.raw_cursor)
 	{
 		m_window_info.size.y = std::max(m_window_info.size.y, static_cast<uint32_t>(1));
 		m_aspect_ratio = static_cast<float>(m_window_info.size.x) / static_cast<float>(m_window_info.size.y);
@@ -176,7 +182,7 @@ namespace oe::graphics
 
 	void IWindow::setIcon(const oe::utils::image_data& image) 
 	{
-		oe::utils::image_data icon = image.cast(oe::formats::rgba, 32, 32);
+		oe::utils::image_data icon = image.cast(oe::formats::rgba, 32, 32, oe::utils::image_filter::box);
 
 		GLFWimage glfwicon; 
 		glfwicon.height = icon.height;
@@ -185,6 +191,43 @@ namespace oe::graphics
 		glfwSetWindowIcon(m_window_handle, 1, &glfwicon);
 	}
 
+	void IWindow::dispatchInputEvents()
+	{
+		auto& dispatcher = m_window_gameloop.getDispatcher();
+		const auto now = std::chrono::steady_clock::now();
+		auto dispatch = [&](const auto& event)
+		{
+			m_input_latency.log(now - event.timestamp);
+			dispatcher.trigger(event);
+		};
+		auto drain = [&](auto& queue)
+		{
+			while (auto event = queue.try_pop())
+				dispatch(*event);
+		};
+
+		if (auto event = m_latest_resize_event.read())
+			dispatch(*event);
+		drain(m_cursor_events);
+		if (auto event = m_latest_cursor_event.read())
+			dispatch(*event);
+		drain(m_button_events);
+		drain(m_scroll_events);
+		drain(m_key_events);
+		drain(m_codepoint_events);
+
+		// events enqueued by the user
+		dispatcher.update();
+	}
+
+	void IWindow::setRawCursor(bool raw)
+	{
+		m_window_info.raw_cursor = raw;
+		m_raw_cursor = raw;
+		if (glfwRawMouseMotionSupported())
+			glfwSetInputMode(m_window_handle, GLFW_RAW_MOUSE_MOTION, raw ? GLFW_TRUE : GLFW_FALSE);
+	}
+
 	void IWindow::showCursor(bool show) 
 	{
 		if (!show) glfwSetInputMode(m_window_handle, GLFW_CURSOR, GLFW_CURSOR_HIDDEN);
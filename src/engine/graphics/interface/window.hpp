@@ -8,6 +8,8 @@
 #include "engine/utility/fileio.hpp"
 #include "engine/utility/gameloop.hpp"
 #include "engine/utility/extra.hpp"
+#include "engine/utility/spsc_queue.hpp"
+#include "engine/utility/triple_buffer.hpp"
 
 
 
@@ -34,10 +36,13 @@ namespace oe::graphics
 	{
 	public:
 		WindowInfo m_window_info{};
+		// only serializes connect/disconnect, the gameloop thread dispatches without it like the rest of GameLoop
+		// so listeners are connected before start() or from the gameloop thread
 		std::mutex dispatcher_mutex{};
 
 		constexpr static size_t max_number_of_keys = 2048;
 		constexpr static size_t max_number_of_buttons = 1024;
+		constexpr static size_t input_queue_size = 1024;
 
 	protected:
 		GLFWwindow* m_window_handle = nullptr;
@@ -53,7 +58,22 @@ namespace oe::graphics
 		
 		bool m_processing_events = false;
 
+		// glfw callbacks (main thread) to updateEvents (gameloop thread)
+		// only the latest cursor pos and resize are kept, unless raw_cursor is set
+		oe::utils::spsc_queue<oe::CodepointEvent> m_codepoint_events{ input_queue_size };
+		oe::utils::spsc_queue<oe::MouseButtonEvent> m_button_events{ input_queue_size };
+		oe::utils::spsc_queue<oe::KeyboardEvent> m_key_events{ input_queue_size };
+		oe::utils::spsc_queue<oe::ScrollEvent> m_scroll_events{ input_queue_size };
+		oe::utils::spsc_queue<oe::CursorPosEvent> m_cursor_events{ input_queue_size };
+		oe::utils::triple_buffer<oe::CursorPosEvent> m_latest_cursor_event{};
+		oe::utils::triple_buffer<oe::ResizeEvent> m_latest_resize_event{};
+		std::atomic<bool> m_raw_cursor = false;
+
+		// time from the glfw callback to the event being dispatched
+		oe::utils::PerfLogger m_input_latency{};
+
 		void postglfw();
+		void dispatchInputEvents(); // gameloop thread, called by updateEvents
 		void makeFullscreen();
 		void makeWindowed();
 
@@ -79,6 +99,13 @@ namespace oe::graphics
 		void setIcon(const oe::utils::image_data& image);
 		void showCursor(bool show);
 
+		// deliver every cursor movement instead of only the latest per frame
+		// also enables raw (unaccelerated) mouse motion if supported
+		void setRawCursor(bool raw);
+		[[nodiscard]] inline bool getRawCursor() const noexcept { return m_raw_cursor; }
+
+		[[nodiscard]] inline const oe::utils::PerfLogger& getInputLatencyLogger() const noexcept { return m_input_latency; }
+
 		// for multiwindow setups
 		// active window while rendering needs to be specified first
 		virtual void active_context() const = 0;
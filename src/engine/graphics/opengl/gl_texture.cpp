@@ -135,7 +135,12 @@ namespace oe::graphics
 		}
 
 		// mipmaps
-		if (m_texture_info.generate_mipmaps) {
+		if (dimensions == 2 && !m_texture_info.empty && !m_texture_info.mipmaps.empty()) {
+			loadMipmaps2D(m_texture_info.data_type, texture_info.size_offset[0].first, texture_info.size_offset[1].first);
+			// the levels belong to the caller (a BakedTexture usually), not kept past the upload
+			m_texture_info.mipmaps.clear();
+		}
+		else if (m_texture_info.generate_mipmaps) {
 			glGenerateMipmap(m_target);
 		}
 	}
@@ -325,6 +330,24 @@ namespace oe::graphics
 		glTexImage2D(m_target, 0, m_gl_internalformat, width, height, 0, m_gl_format, gl_data_type(data_type), data);
 	}
 
+	void GLTexture::loadMipmaps2D(oe::TextureInfo::data_types data_type, int32_t width, int32_t height) {
+		// baked levels are tightly packed
+		int32_t unpack_alignment;
+		glGetIntegerv(GL_UNPACK_ALIGNMENT, &unpack_alignment);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+		const int32_t levels = static_cast<int32_t>(m_texture_info.mipmaps.size());
+		for (int32_t level = 1; level <= levels; level++)
+		{
+			width = std::max(1, width / 2);
+			height = std::max(1, height / 2);
+			glTexImage2D(m_target, level, m_gl_internalformat, width, height, 0, m_gl_format, gl_data_type(data_type), m_texture_info.mipmaps[level - 1]);
+		}
+		glTexParameteri(m_target, GL_TEXTURE_MAX_LEVEL, levels);
+
+		glPixelStorei(GL_UNPACK_ALIGNMENT, unpack_alignment);
+	}
+
 	void GLTexture::load3D(const void* data, oe::TextureInfo::data_types data_type, int32_t width, int32_t height, int32_t depth) {
 		m_target = GL_TEXTURE_3D;
 		GLTexture::bind();
@@ -25,6 +25,7 @@ namespace oe::graphics
 		void load1D(const void* data, oe::TextureInfo::data_types data_type, int32_t width);
 		void load2D(const void* data, oe::TextureInfo::data_types data_type, int32_t width, int32_t height);
 		void load3D(const void* data, oe::TextureInfo::data_types data_type, int32_t width, int32_t height, int32_t depth);
+		void loadMipmaps2D(oe::TextureInfo::data_types data_type, int32_t width, int32_t height);
 
 		void data1D(const void* data, oe::TextureInfo::data_types data_type, int32_t width, int32_t x_offset);
 		void data2D(const void* data, oe::TextureInfo::data_types data_type, int32_t width, int32_t x_offset, int32_t height, int32_t y_offset);
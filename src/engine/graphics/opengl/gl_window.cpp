@@ -185,9 +185,7 @@ namespace oe::graphics {
 	void GLWindow::updateEvents()
 	{
 		m_processing_events = true;
-		dispatcher_mutex.lock();
-		m_window_gameloop.getDispatcher().update();
-		dispatcher_mutex.unlock();
+		dispatchInputEvents();
 		m_processing_events = false;
 	}
 
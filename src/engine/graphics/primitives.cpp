@@ -42,6 +42,8 @@ namespace oe::graphics
 
 	Quad::~Quad()
 	{
+		if(m_observer)
+			m_observer->on_quad_destroyed(*this);
 		m_renderer.remove(this);
 	}
 
@@ -84,6 +86,15 @@ namespace oe::graphics
 		ref[3] = VertexData(glm::vec3(pointD, m_position.z), sprite_pos + sprite_size * glm::vec2(1.0f, 0.0f), m_color);
 	}
 
+	void Quad::gen_bounds(glm::vec2& min, glm::vec2& max) const
+	{
+		glm::vec2 pointA, pointB, pointC, pointD;
+		gen_points(m_position, m_size, m_rotation_alignment, m_rotation, pointA, pointB, pointC, pointD);
+
+		min = glm::min(glm::min(pointA, pointB), glm::min(pointC, pointD));
+		max = glm::max(glm::max(pointA, pointB), glm::max(pointC, pointD));
+	}
+
 	void Quad::gen_vertices_zero(VertexData* ref)
 	{
 		std::fill(reinterpret_cast<float*>(ref), reinterpret_cast<float*>(ref + 4), 0.0f);
@@ -8,13 +8,27 @@
 namespace oe::graphics
 {
 	class Renderer;
+	class Quad;
+
+	// told when the bounds of a quad change and when it dies, see Quad::setObserver
+	class QuadObserver
+	{
+	public:
+		virtual ~QuadObserver() = default;
+
+		// once until Quad::clearMoved
+		virtual void on_quad_moved(Quad& quad) = 0;
+		virtual void on_quad_destroyed(Quad& quad) = 0;
+	};
 
 	class Quad
 	{
 	private:
 		Renderer& m_renderer;
+		QuadObserver* m_observer       = nullptr;
 		int32_t m_index_in_vbo;
 		bool m_updated                 = false;
+		bool m_moved                   = false;
 		bool m_toggled                 = true;
 		bool m_opacitymode             = false;
 		
@@ -25,10 +39,20 @@ namespace oe::graphics
 		float m_rotation               = 0.0f;
 		Sprite m_sprite;
 
+		inline void markMoved() { if (!m_moved && m_observer) { m_moved = true; m_observer->on_quad_moved(*this); } }
+
 	public:
 		Quad(Renderer& renderer);
 		~Quad();
 
+		inline Renderer& getRenderer() const { return m_renderer; }
+
+		// bounds changes since the last clearMoved, only tracked with an observer
+		inline void setObserver(QuadObserver* observer) { m_observer = observer; m_moved = false; markMoved(); }
+		inline QuadObserver* getObserver() const { return m_observer; }
+		inline bool moved() const { return m_moved; }
+		inline void clearMoved() { m_moved = false; }
+
 		// subrenderer quad render index
 		inline int32_t getQuadIndex() const { return m_index_in_vbo; }
 		inline void setQuadIndex(int32_t index) { if(m_index_in_vbo != index) { m_updated = true; } m_index_in_vbo = index; };
@@ -38,19 +62,19 @@ namespace oe::graphics
 		inline bool toggled() const { return m_toggled; };
 		
 		// positional setters/getters
-		inline void setPosition(const glm::vec3& position) { if (m_position != position) { m_updated = true; } m_position = position; }
-		inline void setPosition(const glm::vec2& position) { if (m_position.x != position.x || m_position.y != position.y) { m_updated = true; } m_position.x = position.x; m_position.y = position.y; }
-		inline void setX(float x) { if (m_position.x != x) { m_updated = true; } m_position.x = x; }
-		inline void setY(float y) { if (m_position.y != y) { m_updated = true; } m_position.y = y; }
+		inline void setPosition(const glm::vec3& position) { if (m_position != position) { m_updated = true; markMoved(); } m_position = position; }
+		inline void setPosition(const glm::vec2& position) { if (m_position.x != position.x || m_position.y != position.y) { m_updated = true; markMoved(); } m_position.x = position.x; m_position.y = position.y; }
+		inline void setX(float x) { if (m_position.x != x) { m_updated = true; markMoved(); } m_position.x = x; }
+		inline void setY(float y) { if (m_position.y != y) { m_updated = true; markMoved(); } m_position.y = y; }
 		inline void setZ(float z) { if (m_position.z != z) { m_updated = true; } m_position.z = z; }
 		inline const glm::vec3& getPosition() const { return m_position; }
 
 		// scale setters/getters
-		inline void setSize(const glm::vec2& size) { if (m_size != size) { m_updated = true; } m_size = size; }
+		inline void setSize(const glm::vec2& size) { if (m_size != size) { m_updated = true; markMoved(); } m_size = size; }
 		inline const glm::vec2& getSize() const { return m_size; }
 
 		// alignment setters/getters
-		inline void setRotationAlignment(const glm::vec2& align) { if (m_rotation_alignment != align) { m_updated = true; } m_rotation_alignment = align; }
+		inline void setRotationAlignment(const glm::vec2& align) { if (m_rotation_alignment != align) { m_updated = true; markMoved(); } m_rotation_alignment = align; }
 		inline const glm::vec2& getRotationAlignment() const { return m_rotation_alignment; }
 
 		// color setters/getters
@@ -64,7 +88,7 @@ namespace oe::graphics
 		inline const Sprite* getSprite() const { return &m_sprite; }
 
 		// rotation setters/getters
-		inline void setRotation(float rotation) { if (m_rotation != rotation) { m_updated = true; } m_rotation = rotation; }
+		inline void setRotation(float rotation) { if (m_rotation != rotation) { m_updated = true; markMoved(); } m_rotation = rotation; }
 		inline float getRotation() const { return m_rotation; }
 
 		void setOpacityMode(/*auto*/);
@@ -86,6 +110,8 @@ namespace oe::graphics
 		
 		// generate vertices, pointer must have room for 4 VertexData obj:s
 		void gen_vertices(VertexData* ref) const;
+		// axis aligned bounds of the rotated quad
+		void gen_bounds(glm::vec2& min, glm::vec2& max) const;
 		static void gen_vertices_zero(VertexData* ref);
 	};
 }
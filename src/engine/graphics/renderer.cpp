@@ -1,6 +1,7 @@
 #include "renderer.hpp"
 
 #include "engine/graphics/interface/texture.hpp"
+#include "engine/utility/profiler.hpp"
 
 
 
@@ -55,6 +56,12 @@ namespace oe::graphics
 			return;
 
 		m_primitive_renderer->vertexCount() -= 4;
+		if(m_cull_source)
+		{
+			const Quad* quad = *iter;
+			m_visible.erase(std::remove(m_visible.begin(), m_visible.end(), quad), m_visible.end());
+			m_previous_visible.erase(std::remove(m_previous_visible.begin(), m_previous_visible.end(), quad), m_previous_visible.end());
+		}
 		m_quads.erase(iter);
 	}
 
@@ -67,6 +74,9 @@ namespace oe::graphics
 	{
 		m_quads.clear();
 		m_forgotten_quads.clear();
+		m_visible.clear();
+		m_previous_visible.clear();
+		m_source_culled = false;
 
 		m_primitive_renderer->clear();
 	}
@@ -74,8 +84,43 @@ namespace oe::graphics
 	constexpr bool debug_renderpasses = false;
 	void Renderer::render()
 	{
+		OE_PROFILE_SCOPE("Renderer::render");
 		if(m_quads.size() == 0)
 			return;
+
+		// the quads to draw: from the cull source, or moved to the front of m_quads
+		quads_t* drawn = &m_quads;
+		auto visible_end = m_quads.end();
+		const bool source_culled = m_culling && m_cull_source;
+		if(source_culled)
+		{
+			OE_PROFILE_SCOPE("Renderer::render cull");
+			std::swap(m_visible, m_previous_visible);
+			m_visible.clear();
+			m_cull_source(m_cull_min, m_cull_max, m_visible);
+			drawn = &m_visible;
+			visible_end = m_visible.end();
+		}
+		else if(m_culling)
+		{
+			OE_PROFILE_SCOPE("Renderer::render cull");
+			visible_end = std::partition(m_quads.begin(), m_quads.end(), [this](const Quad* quad){
+				glm::vec2 min, max;
+				quad->gen_bounds(min, max);
+				return min.x <= m_cull_max.x && max.x >= m_cull_min.x && min.y <= m_cull_max.y && max.y >= m_cull_min.y;
+			});
+
+			// culled quads lose their slot, so they get regenerated when visible again
+			std::for_each(visible_end, m_quads.end(), [](Quad* quad){ quad->setQuadIndex(-1); });
+		}
+		const bool previous_source_culled = m_source_culled;
+		m_source_culled = source_culled;
+		if(visible_end == drawn->begin())
+		{
+			if(source_culled)
+				releaseSlots(previous_source_culled ? m_previous_visible : m_quads, *drawn);
+			return;
+		}
 			
 		attemptMap();
 		auto* vertices = m_primitive_renderer->modifyVertex(m_primitive_renderer->vertexCount(), 0);
@@ -83,28 +128,38 @@ namespace oe::graphics
 		// generate vector of renderpasses
 		std::vector<renderpass> renderpasses;
 		ITexture* latest_texture_ptr = nullptr;
-		renderpasses.reserve(m_quads.size());
+		renderpasses.reserve(std::distance(drawn->begin(), visible_end));
 		int32_t index = 0;
-		std::sort(m_quads.begin(), m_quads.end(), m_comparator);
-		for(const auto& quad : m_quads)
 		{
-			// reorder any possibly moved elements
-			quad->setQuadIndex(index++);
-			quad->update(vertices);
-
-			auto this_texture_ptr = quad->getSprite()->m_owner.get();
-			if(latest_texture_ptr == this_texture_ptr)
-				continue;
-			else
+			OE_PROFILE_SCOPE("Renderer::render sort");
+			std::sort(drawn->begin(), visible_end, m_comparator);
+		}
+		{
+			OE_PROFILE_SCOPE("Renderer::render vertex gen");
+			for(auto iter = drawn->begin(); iter != visible_end; iter++)
 			{
-				if(renderpasses.size() != 0) std::get<1>(renderpasses.back()) = quad->getQuadIndex() - std::get<0>(renderpasses.back());
-				renderpasses.push_back({ quad->getQuadIndex(), 1, this_texture_ptr });
+				auto* quad = *iter;
+
+				// reorder any possibly moved elements
+				quad->setQuadIndex(index++);
+				quad->update(vertices);
+
+				auto this_texture_ptr = quad->getSprite()->m_owner.get();
+				if(latest_texture_ptr == this_texture_ptr)
+					continue;
+				else
+				{
+					if(renderpasses.size() != 0) std::get<1>(renderpasses.back()) = quad->getQuadIndex() - std::get<0>(renderpasses.back());
+					renderpasses.push_back({ quad->getQuadIndex(), 1, this_texture_ptr });
+				}
+
+				latest_texture_ptr = this_texture_ptr;
 			}
-
-			latest_texture_ptr = this_texture_ptr;
+			std::get<1>(renderpasses.back()) = (*std::prev(visible_end))->getQuadIndex() - std::get<0>(renderpasses.back()) + 1;
 		}
-		if(m_quads.size() != 0) std::get<1>(renderpasses.back()) = (*m_quads.rbegin())->getQuadIndex() - std::get<0>(renderpasses.back()) + 1;
-		if constexpr(debug_renderpasses) spdlog::debug("Quads: {}, Vertices: {}, Renderpasses: {}", m_quads.size(), m_primitive_renderer->vertexCount(), renderpasses.size());
+		if(source_culled)
+			releaseSlots(previous_source_culled ? m_previous_visible : m_quads, *drawn);
+		if constexpr(debug_renderpasses) spdlog::debug("Quads: {}, Visible: {}, Vertices: {}, Renderpasses: {}", m_quads.size(), index, m_primitive_renderer->vertexCount(), renderpasses.size());
 		
 		// unmap buffer
 		if(m_mapped)
@@ -112,10 +167,51 @@ namespace oe::graphics
 		m_mapped = false;
 
 		// render using renderpasses
+		OE_PROFILE_SCOPE("Renderer::render draw");
 		std::for_each(renderpasses.cbegin(), renderpasses.cend(), [this](const renderpass& pass){
 			if constexpr(debug_renderpasses) spdlog::debug(" - rp {},{},{:x}", std::get<0>(pass), std::get<1>(pass), (size_t)std::get<2>(pass));
 			std::get<2>(pass)->bind();
 			m_primitive_renderer->render(std::get<0>(pass), std::get<1>(pass));
 		});
 	}
+
+	void Renderer::setCullArea(const glm::vec2& min, const glm::vec2& max)
+	{
+		m_culling = true;
+		m_cull_min = glm::min(min, max);
+		m_cull_max = glm::max(min, max);
+	}
+
+	void Renderer::setCullArea(const glm::mat4& pr_matrix)
+	{
+		// ndc corners back to world space
+		const glm::mat4 inverse = glm::inverse(pr_matrix);
+		const glm::vec2 a = glm::vec2(inverse * glm::vec4(-1.0f, -1.0f, 0.0f, 1.0f));
+		const glm::vec2 b = glm::vec2(inverse * glm::vec4( 1.0f,  1.0f, 0.0f, 1.0f));
+		setCullArea(a, b);
+	}
+
+	void Renderer::disableCulling()
+	{
+		m_culling = false;
+	}
+
+	void Renderer::setCullSource(cull_source_t source)
+	{
+		m_cull_source = std::move(source);
+		m_visible.clear();
+		m_previous_visible.clear();
+		m_source_culled = false;
+	}
+
+	void Renderer::releaseSlots(const quads_t& previous, const quads_t& drawn)
+	{
+		// drawn quads sit at their own index, anything else still holding a slot was drawn before and is culled now
+		for(Quad* quad : previous)
+		{
+			const int32_t index = quad->getQuadIndex();
+			if(index >= 0 && (static_cast<size_t>(index) >= drawn.size() || drawn[index] != quad))
+				quad->setQuadIndex(-1);
+		}
+	}
 }
\ No newline at end of file
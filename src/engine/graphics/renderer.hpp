@@ -60,6 +60,7 @@ namespace oe::graphics
 		using iter_t = quads_t::iterator;
 		using citer_t = quads_t::const_iterator;
 		using renderpass = std::tuple<int32_t, int32_t, ITexture*>; // first = first primitive, second = primitive count, third = texture
+		using cull_source_t = std::function<void(const glm::vec2& min, const glm::vec2& max, quads_t& visible)>; // appends the quads of this renderer in the area
 
 	private:
 		bool m_mapped = false;
@@ -68,6 +69,20 @@ namespace oe::graphics
 		std::vector<std::unique_ptr<Quad>> m_forgotten_quads;
 		comparator_t m_comparator;
 
+		bool m_culling = false;
+		glm::vec2 m_cull_min = { 0.0f, 0.0f };
+		glm::vec2 m_cull_max = { 0.0f, 0.0f };
+
+		// culling through a spatial query instead of testing every quad
+		cull_source_t m_cull_source;
+		quads_t m_visible;
+		quads_t m_previous_visible;
+		bool m_source_culled = false; // last render went through m_cull_source, m_previous_visible has every quad with a slot
+
+	private:
+		// culled quads lose their slot, so they get regenerated when visible again
+		void releaseSlots(const quads_t& previous, const quads_t& drawn);
+
 	public:
 		void attemptMap();
 	
@@ -96,6 +111,15 @@ namespace oe::graphics
 		// render all quads sprites will automatically be bound
 		void render();
 
+		// quads outside of the cull area are not sorted, generated or rendered
+		void setCullArea(const glm::vec2& min, const glm::vec2& max);
+		// cull area is the visible area of this (orthographic) projection matrix
+		void setCullArea(const glm::mat4& pr_matrix);
+		void disableCulling();
+		// with culling enabled only the quads the source gives are sorted, generated and rendered, nothing else is touched
+		// quads the source does not know about are not drawn, an empty function goes back to testing every quad
+		void setCullSource(cull_source_t source);
+
 	public:
 		oe::graphics::PrimitiveRenderer& getPrimitiveRenderer() { return m_primitive_renderer; }
 	};
@@ -2,6 +2,9 @@
 #include "engine/engine.hpp"
 #include "engine/graphics/interface/window.hpp"
 #include "sprite.hpp"
+#include "engine/utility/profiler.hpp"
+
+#include <cstring>
 
 
 
@@ -94,8 +97,9 @@ namespace oe::graphics {
 		return channels * (x + y * width) + c;
 	}
 
-	void SpritePack::constructRepeat(const oe::TextureInfo& texture_settings)
+	oe::utils::image_data SpritePack::pack()
 	{
+		OE_PROFILE_SCOPE("SpritePack::pack");
 		// pack sprites
 		const auto max_side = 10000;
 		const auto discard_step = 1;
@@ -117,7 +121,9 @@ namespace oe::graphics {
 		// create texture and add sprites
 		const size_t pack_width = static_cast<size_t>(std::abs(result_size.w));
 		const size_t pack_height = static_cast<size_t>(std::abs(result_size.h));
-		unsigned char* data = new unsigned char[pack_width * pack_height * 4]();
+		oe::utils::image_data atlas{ oe::formats::rgba, static_cast<int>(pack_width), static_cast<int>(pack_height) };
+		unsigned char* data = atlas.data;
+		std::memset(data, 0, atlas.size);
 		for (size_t i = 0; i < m_usr_data->m_rectangles.size(); i++) {
 			const auto& rectangle = m_usr_data->m_rectangles.at(i);
 			const auto& image = m_usr_data->m_images.at(i);
@@ -169,7 +175,7 @@ namespace oe::graphics {
 						// automatic translucency detector
 						sprite->opacity = 
 							sprite->opacity || 
-							data[coordsToIndex(rect_x, rect_y + y, 3, pack_width, 4)] != 255;
+							data[coordsToIndex(rect_x + x, rect_y + y, 3, pack_width, 4)] != 255;
 					}
 				}
 				break;
@@ -178,10 +184,18 @@ namespace oe::graphics {
 			}
 		}
 
+		return atlas;
+	}
+
+	void SpritePack::constructRepeat(const oe::TextureInfo& texture_settings)
+	{
+		OE_PROFILE_SCOPE("SpritePack::constructRepeat");
+		const oe::utils::image_data atlas = pack();
+
 		// the main texture
 		oe::TextureInfo texture_info = texture_settings;
-		texture_info.data = data;
-		texture_info.size_offset = { { pack_width, 0 }, { pack_height, 0} };
+		texture_info.data = atlas.data;
+		texture_info.size_offset = { { atlas.width, 0 }, { atlas.height, 0} };
 		m_texture = Texture(texture_info);
 
 		// sprite owners
@@ -190,7 +204,6 @@ namespace oe::graphics {
 		
 		// complete
 		m_constructed = true;
-		delete[] data;
 	}
 
 	void SpritePack::construct(const oe::TextureInfo& texture_settings)
@@ -47,11 +47,14 @@ namespace oe::graphics
 
 		
 		
+		// packs the sprites into one rgba image and places them in it, without creating the texture
+		oe::utils::image_data pack();
 		void construct(const oe::TextureInfo& texture_settings = default_texture_settings()); // sprite pack texture needs to be constructed before using it
 		void constructRepeat(const oe::TextureInfo& texture_settings = default_texture_settings()); // may be called multiple times, but will not delete imagedata
 
 		void bind();
 		Texture getTexture() const { return m_texture; }
+		const std::vector<std::unique_ptr<Sprite>>& getSprites() const { return m_sprites; }
 	};
 
 }
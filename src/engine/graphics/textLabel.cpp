@@ -10,6 +10,7 @@
 #include "engine/graphics/interface/framebuffer.hpp"
 #include "engine/graphics/renderer.hpp"
 #include "engine/asset/font_shader/font_shader.hpp"
+#include "engine/utility/profiler.hpp"
 
 
 
@@ -47,6 +48,7 @@ namespace oe::graphics {
 	
 	void TextLabel::regenerate(const text_render_cache& cache)
 	{
+		OE_PROFILE_SCOPE("TextLabel::regenerate");
 		m_cache = cache;
 		m_size = m_cache.size;
 
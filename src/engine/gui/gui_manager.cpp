@@ -6,6 +6,7 @@
 #include "engine/graphics/renderer.hpp"
 #include "engine/utility/connect_guard.hpp"
 #include "engine/utility/connect_guard_additions.hpp"
+#include "engine/utility/profiler.hpp"
 
 
 
@@ -90,6 +91,7 @@ namespace oe::gui
 
 	void GUI::render()
 	{
+		OE_PROFILE_SCOPE("GUI::render");
 		auto& engine = oe::Engine::getSingleton();
 		oe::RasterizerInfo old_rasterizer = engine.getRasterizerInfo();
 		engine.setRasterizerInfo(m_rasterizer);
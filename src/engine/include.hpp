@@ -14,6 +14,7 @@
 
 // Audio
 #include "audio/audio.hpp"
+#include "audio/spatial_audio.hpp"
 
 // ecs
 #include "ecs/components/all.hpp"
@@ -25,12 +26,17 @@
 #include "utility/random.hpp"
 #include "utility/gameloop.hpp"
 #include "utility/fileio.hpp"
+#include "utility/audio_decoder.hpp"
+#include "utility/byte_pool.hpp"
 #include "utility/font_file.hpp"
 #include "utility/formatted_error.hpp"
 #include "utility/extra.hpp"
 #include "utility/connect_guard.hpp"
 #include "utility/connect_guard_additions.hpp"
 #include "utility/ts_queue.hpp"
+#include "utility/spsc_queue.hpp"
+#include "utility/mpmc_queue.hpp"
+#include "utility/profiler.hpp"
 
 // Gui
 #include "gui/gui_manager.hpp"
@@ -57,12 +63,19 @@
 #include "graphics/spritePacker.hpp"
 #include "networking/client.hpp"
 #include "networking/server.hpp"
+#include "networking/replication.hpp"
+#include "networking/message.hpp"
+#include "networking/impairment.hpp"
+#include "networking/prediction.hpp"
 
 // Asset
 #include "asset/default_shader/default_shader.hpp"
 #include "asset/font_shader/font_shader.hpp"
 #include "asset/texture_set/texture_set.hpp"
 #include "asset/fonts.hpp"
+#include "asset/asset_cache.hpp"
+#include "asset/asset_streamer.hpp"
+#include "asset/baked_texture.hpp"
 
 // POSSIBLE DEFINES:
 // - OE_DEBUG_API_CALLS
@@ -80,6 +93,9 @@
 // - OE_TERMINATE_IS_THROW
 //   - fatal errors throw instead of assert
 //   - compiled
+// - OE_PROFILING
+//   - OE_PROFILE_SCOPE zones, dumped with Profiler::dumpChromeTrace
+//   - headers and compiled
 
 #if defined(OE_USING_NAMESPACES)
 namespace oe
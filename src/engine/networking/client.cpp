@@ -1,6 +1,12 @@
 #include "client.hpp"
 #include "enet_wrap.hpp"
+#include "message_batch.hpp"
+#include "compressor.hpp"
+#include "poller.hpp"
 #include "engine/internal_libs.hpp"
+#include "engine/utility/profiler.hpp"
+
+#include <array>
 
 
 
@@ -10,9 +16,17 @@ namespace oe::networking
 	{
 		ENetHostWrapper m_client{};
 		ENetAddress m_address{};
-		ENetCompressor m_compressor{};
+		packet_compressor m_compressor{};
 		ENetPeer* m_peer = nullptr;
 		size_t m_channel_id = 0;
+
+		// sending threads -> service thread
+		send_queue m_send_queue{};
+		host_poller m_poller{};
+
+		// service thread only
+		std::array<message_batch, delivery_count> m_batches;
+		size_t m_batch_limit = batch_limit(ENET_HOST_DEFAULT_MTU);
 	};
 
 
@@ -39,7 +53,8 @@ namespace oe::networking
 				if(!m_data->m_client.m_host)
 					return result{ "Client could not be created" };
 
-				enet_host_compress(m_data->m_client.m_host, &m_data->m_compressor);
+				m_data->m_compressor.attach(m_data->m_client.m_host);
+				m_data->m_batch_limit = batch_limit(m_data->m_client.m_host->mtu);
 			}
 		}
 
@@ -60,9 +75,9 @@ namespace oe::networking
 		// operate until it fails to connect or connects successfully
 		ENetEvent event;
 		const int32_t service_return = m_data->m_client.run_service(mtx, event, timeout);
-		m_running = service_return > 0 && event.type == ENET_EVENT_TYPE_CONNECT;
+		const bool connected = service_return > 0 && event.type == ENET_EVENT_TYPE_CONNECT;
 		
-		if(!m_running)
+		if(!connected)
 		{
 			std::scoped_lock lock(mtx);
 			enet_peer_reset(m_data->m_peer);
@@ -73,6 +88,12 @@ namespace oe::networking
 				return result{ "Connection failed" };
 		}
 
+		// the socket has a port only after the first send
+		{
+			std::scoped_lock lock(mtx);
+			m_data->m_poller.create(m_data->m_client.m_host);
+		}
+		m_running = true;
 		m_thread = std::thread(&Client::operate, this);
 		return result{};
 	}
@@ -84,13 +105,15 @@ namespace oe::networking
 
 		// wait for event service to stop
 		m_running = false;
+		m_data->m_poller.notify();
 		if (m_thread.joinable())
 			m_thread.join();
 
-		// send the disconnect request
+		// send what is still queued and the disconnect request
+		flush_batches();
 		{
 			std::scoped_lock lock(mtx);
-			enet_peer_disconnect(m_data->m_peer, 0);
+			enet_peer_disconnect_later(m_data->m_peer, 0);
 		}
 
 		ENetEvent event;
@@ -131,35 +154,80 @@ namespace oe::networking
 
 		// close the server
 		std::scoped_lock lock(mtx);
+		m_data->m_poller.destroy();
 		m_data->m_client.destroy();
+		m_data->m_compressor.attach(nullptr);
+		m_data->m_send_queue.clear();
 		return result{};
 	}
 
-	result Client::send(const uint8_t* bytes, size_t count)
+	result Client::send(const uint8_t* bytes, size_t count, delivery mode)
 	{
-		const size_t channel = next_channel();
-		ENetPacket*	packet = enet_packet_create(bytes, count, ENET_PACKET_FLAG_RELIABLE);
-		
-		// std::scoped_lock lock(mtx);
-		enet_peer_send(m_data->m_peer, channel, packet);
-		enet_host_flush(m_data->m_client.m_host);
+		if (!m_running)
+			return result{ "Not connected" };
 
+		if (!m_data->m_send_queue.push(bytes, count, 0, mode, false))
+			return result{ "Send queue full" };
+		m_data->m_poller.notify();
 		return result{};
 	}
 
+	void Client::flush_batches()
+	{
+		std::scoped_lock lock(mtx);
+
+		// reset first, sends that race with the drain wake the loop again
+		m_data->m_poller.reset();
+		const bool batching = m_batching;
+		m_data->m_send_queue.drain([&](const outgoing_message& message){
+			if (!batching && m_data->m_peer->channelCount > 1)
+			{
+				enet_peer_send(m_data->m_peer, raw_channel, enet_packet_create(message.data, message.size, packet_flags(message.mode)));
+				return;
+			}
+			m_data->m_batches[static_cast<size_t>(message.mode)].append(message.data, message.size, m_data->m_batch_limit, batching);
+		});
+
+		for (size_t mode = 0; mode < delivery_count; mode++)
+		{
+			const enet_uint32 flags = packet_flags(static_cast<delivery>(mode));
+			m_data->m_batches[mode].drain([&](const uint8_t* data, size_t size){
+				enet_peer_send(m_data->m_peer, next_channel(), enet_packet_create(data, size, flags));
+			});
+		}
+
+		m_data->m_client.flush();
+	}
+
 	void Client::operate()
 	{
 		ENetEvent event{};
 
+		OE_PROFILE_THREAD("Client service");
 		while (m_running)
 		{
-			enet_host_flush(m_data->m_client.m_host);
-			const int32_t r = m_data->m_client.run_service(mtx, event, std::chrono::milliseconds(50));
+			{
+				OE_PROFILE_SCOPE("Client::operate flush");
+				flush_batches();
+			}
+			const bool timed = m_timed_service;
+			const int32_t r = m_data->m_client.run_service(mtx, event, timed ? timed_service_wait : std::chrono::milliseconds(0));
 			if (r < 0)
 				spdlog::warn("Client ENet service error");
-			if (r == 0)
+			if (r <= 0 && timed)
+				continue;
+			if (r <= 0)
+			{
+				// sleeps until a datagram arrives, a send wakes it or an ENet timer is due
+				OE_PROFILE_SCOPE("Client::operate wait");
+				if (!m_data->m_poller.wait())
+					spdlog::warn("Client poll error");
+				continue;
+			}
+			if (ENetWakeup::is_wakeup(event))
 				continue;
 
+			OE_PROFILE_SCOPE("Client::operate event");
 			switch (event.type)
 			{
 			default:/* case ENET_EVENT_TYPE_NONE: */
@@ -170,10 +238,15 @@ namespace oe::networking
 				break;
 			
 			case ENET_EVENT_TYPE_RECEIVE:
-				m_dispatcher.trigger(ClientReceiveEvent{ { event.packet->data, event.packet->dataLength } });
-				enet_packet_destroy(event.packet);
+			{
+				const packet handle{ event.packet };
+				if (is_raw_channel(event.channelID, event.peer->channelCount))
+					m_dispatcher.trigger(ClientReceiveEvent{ { handle.data(), handle.size() }, handle });
+				else if (!unbatch(handle.data(), handle.size(), [&](uint8_t* data, size_t size){ m_dispatcher.trigger(ClientReceiveEvent{ { data, size }, handle }); }))
+					spdlog::warn("Malformed packet from server");
 				break;
 			}
+			}
 		}
 	}
 	
@@ -181,8 +254,9 @@ namespace oe::networking
 	{
 		m_data->m_channel_id++; // overflow (not gonna happen) is just going to make the next step easy
 		
+		// batches skip raw_channel
 		if (m_data->m_channel_id >= m_max_channels)
-			m_data->m_channel_id = 0;
+			m_data->m_channel_id = m_max_channels > 1 ? raw_channel + 1 : raw_channel;
 		
 		return m_data->m_channel_id;
 	}
@@ -200,9 +274,50 @@ namespace oe::networking
 		return m_data->m_address.port;
 	}
 
+	statistics Client::stats()
+	{
+		std::scoped_lock lock(mtx);
+		return host_statistics(m_data->m_client.m_host, m_data->m_client.m_retransmits.m_total);
+	}
+
 	[[nodiscard]] float Client::server_packet_loss() const
 	{
 		return static_cast<float>(m_data->m_peer->packetLoss) / static_cast<float>(ENET_PEER_PACKET_LOSS_SCALE);
 	}
 
+	[[nodiscard]] std::chrono::milliseconds Client::server_round_trip_time() const
+	{
+		return std::chrono::milliseconds{ m_data->m_peer->roundTripTime };
+	}
+
+	result Client::set_compression(compression mode, std::vector<uint8_t> dictionary)
+	{
+		if (m_running)
+			return result{ "Already connected" };
+
+		std::scoped_lock lock(mtx);
+		m_data->m_compressor.configure(mode, std::move(dictionary));
+		return result{};
+	}
+
+	compression Client::get_compression() const noexcept
+	{
+		return m_data->m_compressor.mode();
+	}
+
+	compression_stats Client::compressor_stats() const
+	{
+		return m_data->m_compressor.stats();
+	}
+
+	void Client::capture_traffic(size_t max_bytes)
+	{
+		m_data->m_compressor.capture_traffic(max_bytes);
+	}
+
+	std::vector<std::vector<uint8_t>> Client::captured_traffic()
+	{
+		return m_data->m_compressor.captured_traffic();
+	}
+
 }
\ No newline at end of file
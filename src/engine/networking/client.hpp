@@ -21,10 +21,13 @@ namespace oe::networking
 
 		std::mutex mtx;
 		std::atomic<bool> m_running = false;
+		std::atomic<bool> m_batching = true;
+		std::atomic<bool> m_timed_service = false;
 		std::thread m_thread;
 		size_t m_max_channels;
 
 		void operate();
+		void flush_batches();
 		[[nodiscard]] size_t next_channel();
 
 	public:
@@ -38,20 +41,42 @@ namespace oe::networking
 		result disconnect();
 		result disconnect_force();
 		result close();
-		result send(const uint8_t* bytes, size_t count);
+		// non-blocking, messages go through a lock-free queue and wake the service thread
+		// which coalesces them into MTU sized packets per delivery mode
+		result send(const uint8_t* bytes, size_t count, delivery mode = delivery::reliable);
 		[[nodiscard]] inline bool running() const noexcept { return m_running; }
 
 		/* contiguous_iterator_tag */
 		template<typename Iterator>
-		inline result send(Iterator begin, Iterator end)
+		inline result send(Iterator begin, Iterator end, delivery mode = delivery::reliable)
 		{
 			if (begin == end) return result{};
-			return send(reinterpret_cast<const uint8_t*>(&*begin), std::distance(begin, end) * sizeof(typename std::iterator_traits<Iterator>::value_type));
+			return send(reinterpret_cast<const uint8_t*>(&*begin), std::distance(begin, end) * sizeof(typename std::iterator_traits<Iterator>::value_type), mode);
 		}
 
+		// false sends every message as its own packet (still once per service iteration)
+		// with more than one channel those go out unframed on raw_channel
+		inline void set_batching(bool batching) noexcept { m_batching = batching; }
+		[[nodiscard]] inline bool get_batching() const noexcept { return m_batching; }
+		// true goes back to blocking in enet_host_service for 50 ms at a time without the poller
+		// sends then wait for the next datagram or the timeout, only there to compare against
+		inline void set_timed_service(bool timed) noexcept { m_timed_service = timed; }
+		[[nodiscard]] statistics stats();
+
 		[[nodiscard]] std::string server_address() const;
 		[[nodiscard]] uint16_t server_port() const;
 		[[nodiscard]] float server_packet_loss() const;
+		[[nodiscard]] std::chrono::milliseconds server_round_trip_time() const; // smoothed by ENet
+
+		// before connect(), has to match the server's mode and dictionary
+		// the dictionary is for compression::lz4, see train_dictionary
+		result set_compression(compression mode, std::vector<uint8_t> dictionary = {});
+		[[nodiscard]] compression get_compression() const noexcept;
+		[[nodiscard]] compression_stats compressor_stats() const;
+		// records uncompressed packets (both directions) for train_dictionary, up to max_bytes
+		// needs a compression mode other than none
+		void capture_traffic(size_t max_bytes);
+		[[nodiscard]] std::vector<std::vector<uint8_t>> captured_traffic();
 
 	};
 
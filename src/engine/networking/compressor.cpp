@@ -0,0 +1,321 @@
+#include "compressor.hpp"
+
+#define LZ4_STATIC_LINKING_ONLY
+#include <lz4.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <queue>
+
+
+
+namespace oe::networking
+{
+	static constexpr size_t max_dictionary_size = 64 * 1024;
+
+	[[nodiscard]] static inline uint64_t address_key(const ENetAddress& address) noexcept
+	{
+		return (static_cast<uint64_t>(address.host) << 16) | address.port;
+	}
+
+	[[nodiscard]] static inline uint64_t elapsed_ns(std::chrono::steady_clock::time_point start) noexcept
+	{
+		return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+	}
+
+
+
+	packet_compressor::~packet_compressor()
+	{
+		release();
+	}
+
+	void packet_compressor::release()
+	{
+		if (m_range_coder)
+			enet_range_coder_destroy(m_range_coder);
+		if (m_lz4_stream)
+			LZ4_freeStream(static_cast<LZ4_stream_t*>(m_lz4_stream));
+		if (m_lz4_dictionary)
+			LZ4_freeStream(static_cast<LZ4_stream_t*>(m_lz4_dictionary));
+		m_range_coder = nullptr;
+		m_lz4_stream = nullptr;
+		m_lz4_dictionary = nullptr;
+	}
+
+	void packet_compressor::configure(compression mode, std::vector<uint8_t> dictionary)
+	{
+		release();
+		m_mode = mode;
+		m_dictionary = std::move(dictionary);
+		if (m_dictionary.size() > max_dictionary_size)
+			m_dictionary.erase(m_dictionary.begin(), m_dictionary.end() - max_dictionary_size);
+
+		switch (m_mode)
+		{
+		case compression::none:
+			break;
+
+		case compression::range_coder:
+			m_range_coder = enet_range_coder_create();
+			break;
+
+		case compression::lz4:
+			m_lz4_stream = LZ4_createStream();
+			if (!m_dictionary.empty())
+			{
+				auto dictionary_stream = LZ4_createStream();
+				LZ4_loadDict(dictionary_stream, reinterpret_cast<const char*>(m_dictionary.data()), static_cast<int>(m_dictionary.size()));
+				m_lz4_dictionary = dictionary_stream;
+			}
+			break;
+		}
+
+		attach(m_host);
+	}
+
+	void packet_compressor::attach(ENetHost* host)
+	{
+		m_host = host;
+		if (!m_host)
+			return;
+
+		if (m_mode == compression::none)
+		{
+			enet_host_compress(m_host, nullptr);
+			return;
+		}
+
+		ENetCompressor compressor{};
+		compressor.context = this;
+		compressor.compress = [](void* context, const ENetBuffer* buffers, size_t buffer_count, size_t in_limit, enet_uint8* out, size_t out_limit) {
+			return static_cast<packet_compressor*>(context)->compress(buffers, buffer_count, in_limit, out, out_limit);
+		};
+		compressor.decompress = [](void* context, const enet_uint8* in, size_t in_limit, enet_uint8* out, size_t out_limit) {
+			return static_cast<packet_compressor*>(context)->decompress(in, in_limit, out, out_limit);
+		};
+		compressor.destroy = nullptr; // owned by the Server/Client
+		enet_host_compress(m_host, &compressor);
+	}
+
+	const uint8_t* packet_compressor::gather(const ENetBuffer* buffers, size_t buffer_count, size_t size)
+	{
+		m_gather.resize(size);
+		size_t offset = 0;
+		for (size_t i = 0; i < buffer_count && offset < size; i++)
+		{
+			const size_t count = std::min(buffers[i].dataLength, size - offset);
+			std::memcpy(m_gather.data() + offset, buffers[i].data, count);
+			offset += count;
+		}
+		return m_gather.data();
+	}
+
+	void packet_compressor::capture(const uint8_t* data, size_t size)
+	{
+		if (m_capture_budget < size)
+			return;
+		m_capture_budget -= size;
+		m_captured.emplace_back(data, data + size);
+	}
+
+	size_t packet_compressor::compress(const ENetBuffer* buffers, size_t buffer_count, size_t in_limit, uint8_t* out, size_t out_limit)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		const uint8_t* raw = nullptr;
+
+		size_t size = 0;
+		if (m_mode == compression::range_coder)
+		{
+			size = enet_range_coder_compress(m_range_coder, buffers, buffer_count, in_limit, out, out_limit);
+		}
+		else if (m_mode == compression::lz4)
+		{
+			raw = gather(buffers, buffer_count, in_limit);
+			auto stream = static_cast<LZ4_stream_t*>(m_lz4_stream);
+			int result;
+			if (m_lz4_dictionary)
+			{
+				LZ4_resetStream_fast(stream);
+				LZ4_attach_dictionary(stream, static_cast<LZ4_stream_t*>(m_lz4_dictionary));
+				result = LZ4_compress_fast_continue(stream, reinterpret_cast<const char*>(raw), reinterpret_cast<char*>(out), static_cast<int>(in_limit), static_cast<int>(out_limit), 1);
+			}
+			else
+				result = LZ4_compress_fast_extState_fastReset(stream, reinterpret_cast<const char*>(raw), reinterpret_cast<char*>(out), static_cast<int>(in_limit), static_cast<int>(out_limit), 1);
+			size = result > 0 ? static_cast<size_t>(result) : 0;
+		}
+		const uint64_t ns = elapsed_ns(start);
+
+		std::scoped_lock lock(m_stats_mtx);
+		// ENet sends the original when the result is 0 or not smaller
+		if (size == 0 || size >= in_limit)
+			m_stats.incompressible_packets++;
+		else
+		{
+			m_stats.compressed_packets++;
+			m_stats.compress_raw_bytes += in_limit;
+			m_stats.compress_compressed_bytes += size;
+		}
+		m_stats.compress_ns += ns;
+
+		if (m_capture_budget != 0)
+			capture(raw ? raw : gather(buffers, buffer_count, in_limit), in_limit);
+		return size;
+	}
+
+	size_t packet_compressor::decompress(const uint8_t* in, size_t in_limit, uint8_t* out, size_t out_limit)
+	{
+		const auto start = std::chrono::steady_clock::now();
+
+		size_t size = 0;
+		if (m_mode == compression::range_coder)
+		{
+			size = enet_range_coder_decompress(m_range_coder, in, in_limit, out, out_limit);
+		}
+		else if (m_mode == compression::lz4)
+		{
+			const int result = LZ4_decompress_safe_usingDict(reinterpret_cast<const char*>(in), reinterpret_cast<char*>(out), static_cast<int>(in_limit), static_cast<int>(out_limit),
+				reinterpret_cast<const char*>(m_dictionary.data()), static_cast<int>(m_dictionary.size()));
+			size = result > 0 ? static_cast<size_t>(result) : 0;
+		}
+		const uint64_t ns = elapsed_ns(start);
+
+		// the packet came from the address ENet just received from, anyone can send one so only connected peers get an entry
+		std::scoped_lock lock(m_stats_mtx);
+		const auto peer = m_peer_stats.find(address_key(m_host->receivedAddress));
+		for (auto* stats : { &m_stats, peer != m_peer_stats.end() ? &peer->second : nullptr })
+		{
+			if (!stats)
+				continue;
+			if (size == 0)
+				stats->decompress_failures++;
+			else
+			{
+				stats->decompressed_packets++;
+				stats->decompress_compressed_bytes += in_limit;
+				stats->decompress_raw_bytes += size;
+			}
+			stats->decompress_ns += ns;
+		}
+
+		if (m_capture_budget != 0 && size != 0)
+			capture(out, size);
+		return size;
+	}
+
+	compression_stats packet_compressor::stats() const
+	{
+		std::scoped_lock lock(m_stats_mtx);
+		return m_stats;
+	}
+
+	compression_stats packet_compressor::peer_stats(const ENetAddress& address) const
+	{
+		std::scoped_lock lock(m_stats_mtx);
+		const auto iter = m_peer_stats.find(address_key(address));
+		return iter != m_peer_stats.end() ? iter->second : compression_stats{};
+	}
+
+	void packet_compressor::track_peer(const ENetAddress& address)
+	{
+		std::scoped_lock lock(m_stats_mtx);
+		m_peer_stats.try_emplace(address_key(address));
+	}
+
+	void packet_compressor::forget_peer(const ENetAddress& address)
+	{
+		std::scoped_lock lock(m_stats_mtx);
+		m_peer_stats.erase(address_key(address));
+	}
+
+	void packet_compressor::capture_traffic(size_t max_bytes)
+	{
+		std::scoped_lock lock(m_stats_mtx);
+		m_capture_budget = max_bytes;
+		m_captured.clear();
+	}
+
+	std::vector<std::vector<uint8_t>> packet_compressor::captured_traffic()
+	{
+		std::scoped_lock lock(m_stats_mtx);
+		m_capture_budget = 0;
+		return std::move(m_captured);
+	}
+
+
+
+	std::vector<uint8_t> train_dictionary(const std::vector<std::vector<uint8_t>>& samples, size_t size)
+	{
+		// a simplified COVER: split the samples into segments, greedily pick the segments
+		// covering the most frequent k-grams, a k-gram only counts for the first segment that covers it
+		constexpr size_t k = 8;
+		constexpr size_t segment_size = 64;
+		size = std::min(size, max_dictionary_size);
+
+		const auto kgram = [](const uint8_t* data) {
+			uint64_t value;
+			std::memcpy(&value, data, k);
+			return value;
+		};
+
+		std::unordered_map<uint64_t, uint32_t> frequency;
+		for (const auto& sample : samples)
+			for (size_t i = 0; i + k <= sample.size(); i++)
+				frequency[kgram(sample.data() + i)]++;
+
+		struct segment_t { const uint8_t* data; size_t size; };
+		std::vector<segment_t> segments;
+		for (const auto& sample : samples)
+			for (size_t offset = 0; offset + k <= sample.size(); offset += segment_size)
+				segments.push_back({ sample.data() + offset, std::min(segment_size, sample.size() - offset) });
+
+		// k-grams seen once do not help compressing anything else
+		const auto score = [&](const segment_t& segment) {
+			uint64_t total = 0;
+			for (size_t i = 0; i + k <= segment.size; i++)
+			{
+				const uint32_t count = frequency[kgram(segment.data + i)];
+				total += count > 1 ? count : 0;
+			}
+			return total;
+		};
+
+		// scores only go down as k-grams get covered, so a stale score is an upper bound (lazy greedy)
+		using entry_t = std::pair<uint64_t, size_t>;
+		std::priority_queue<entry_t> queue;
+		for (size_t i = 0; i < segments.size(); i++)
+			queue.emplace(score(segments[i]), i);
+
+		std::vector<const segment_t*> chosen;
+		size_t dictionary_size = 0;
+		while (!queue.empty() && dictionary_size < size)
+		{
+			const auto [stale_score, index] = queue.top();
+			queue.pop();
+			const uint64_t current_score = score(segments[index]);
+			if (current_score == 0)
+				continue;
+			if (!queue.empty() && current_score < queue.top().first && current_score < stale_score)
+			{
+				queue.emplace(current_score, index);
+				continue;
+			}
+
+			const segment_t& segment = segments[index];
+			if (dictionary_size + segment.size > size)
+				continue;
+			for (size_t i = 0; i + k <= segment.size; i++)
+				frequency[kgram(segment.data + i)] = 0;
+			chosen.push_back(&segment);
+			dictionary_size += segment.size;
+		}
+
+		// the most useful segments last, closest to the data being compressed
+		std::vector<uint8_t> dictionary;
+		dictionary.reserve(dictionary_size);
+		for (auto iter = chosen.rbegin(); iter != chosen.rend(); iter++)
+			dictionary.insert(dictionary.end(), (*iter)->data, (*iter)->data + (*iter)->size);
+		return dictionary;
+	}
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "shared.hpp"
+
+#include <enet/enet.h>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+
+
+namespace oe::networking
+{
+	// ENetCompressor with a selectable backend, stats and traffic capture
+	// owned by the Server/Client and installed into its host with attach(), ENet never destroys it
+	class packet_compressor
+	{
+	private:
+		compression m_mode = compression::none;
+		std::vector<uint8_t> m_dictionary;
+		ENetHost* m_host = nullptr;
+
+		// service thread only
+		void* m_range_coder = nullptr;
+		void* m_lz4_stream = nullptr;     // LZ4_stream_t
+		void* m_lz4_dictionary = nullptr; // LZ4_stream_t with m_dictionary loaded, attached to m_lz4_stream per packet
+		std::vector<uint8_t> m_gather;    // ENet hands the packet over in pieces
+
+		mutable std::mutex m_stats_mtx;
+		compression_stats m_stats;
+		std::unordered_map<uint64_t, compression_stats> m_peer_stats; // by address, connected peers only
+		size_t m_capture_budget = 0;
+		std::vector<std::vector<uint8_t>> m_captured;
+
+		void release();
+		const uint8_t* gather(const ENetBuffer* buffers, size_t buffer_count, size_t size);
+		void capture(const uint8_t* data, size_t size);
+
+		size_t compress(const ENetBuffer* buffers, size_t buffer_count, size_t in_limit, uint8_t* out, size_t out_limit);
+		size_t decompress(const uint8_t* in, size_t in_limit, uint8_t* out, size_t out_limit);
+
+	public:
+		packet_compressor() = default;
+		packet_compressor(const packet_compressor&) = delete;
+		~packet_compressor();
+
+		// only while the host is not being serviced
+		// the dictionary is used by lz4 only and trimmed to its last 64 KiB
+		void configure(compression mode, std::vector<uint8_t> dictionary = {});
+		// installs into the host, compression::none removes the compressor
+		void attach(ENetHost* host);
+		[[nodiscard]] inline compression mode() const noexcept { return m_mode; }
+
+		[[nodiscard]] compression_stats stats() const;
+		// only the receive half is per peer, ENet does not tell the compressor which peer it is sending to
+		[[nodiscard]] compression_stats peer_stats(const ENetAddress& address) const;
+		// on connect and disconnect, packets from addresses that are not tracked only count towards stats()
+		void track_peer(const ENetAddress& address);
+		void forget_peer(const ENetAddress& address);
+
+		// keeps copies of the uncompressed packets, sent and received, until max_bytes is reached
+		void capture_traffic(size_t max_bytes);
+		[[nodiscard]] std::vector<std::vector<uint8_t>> captured_traffic();
+	};
+}
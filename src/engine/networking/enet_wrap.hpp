@@ -2,13 +2,219 @@
 
 #include <enet/enet.h>
 
+#include "shared.hpp"
+
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
 
 
 namespace oe::networking
 {
+	[[nodiscard]] constexpr inline enet_uint32 packet_flags(delivery mode) noexcept
+	{
+		switch (mode)
+		{
+		case delivery::reliable: return ENET_PACKET_FLAG_RELIABLE;
+		case delivery::unsequenced: return ENET_PACKET_FLAG_UNSEQUENCED;
+		case delivery::unreliable_fragment: return ENET_PACKET_FLAG_UNRELIABLE_FRAGMENT;
+		default: return 0;
+		}
+	}
+
+	// largest batch that still fits in one datagram with the ENet protocol and command headers
+	[[nodiscard]] constexpr inline size_t batch_limit(enet_uint32 mtu) noexcept
+	{
+		constexpr size_t overhead = sizeof(ENetProtocolHeader) + sizeof(enet_uint32) /* checksum */ + sizeof(ENetProtocolSendFragment);
+		return mtu > overhead ? mtu - overhead : 1;
+	}
+
+	[[nodiscard]] inline statistics host_statistics(const ENetHost* host, uint64_t retransmits = 0) noexcept
+	{
+		if (!host)
+			return { 0, 0, 0, 0, retransmits };
+		return { host->totalSentData, host->totalSentPackets, host->totalReceivedData, host->totalReceivedPackets, retransmits };
+	}
+
+	// ENet counts reliable resends in packetsLost, but clears it every packet loss interval
+	// in the same enet_protocol_send_outgoing_commands that counted the last resends, after counting them
+	// so the resends due in a call that closes an interval are counted before it, the rest from packetsLost after it
+	struct ENetRetransmitCounter
+	{
+		struct peer_sample
+		{
+			enet_uint32 m_lost = 0;
+			enet_uint32 m_epoch = 0;
+			enet_uint32 m_due = 0; // resends due in a call that closes the interval
+		};
+
+		std::vector<peer_sample> m_peers;
+		uint64_t m_total = 0;
+
+		// right before enet_host_flush or enet_host_service
+		inline void prepare(const ENetHost* host)
+		{
+			if (!host)
+				return;
+
+			sample(host);
+			const enet_uint32 now = enet_time_get();
+			for (size_t i = 0; i < host->peerCount; i++)
+			{
+				const ENetPeer& peer = host->peers[i];
+				if (peer.packetLossEpoch == 0 || ENET_TIME_DIFFERENCE(now, peer.packetLossEpoch) < ENET_PEER_PACKET_LOSS_INTERVAL)
+					continue;
+
+				// the same test enet_protocol_check_timeouts does
+				for (ENetListIterator node = enet_list_begin(&peer.sentReliableCommands); node != enet_list_end(&peer.sentReliableCommands); node = enet_list_next(node))
+				{
+					const auto* command = reinterpret_cast<const ENetOutgoingCommand*>(node);
+					if (ENET_TIME_DIFFERENCE(now, command->sentTime) >= command->roundTripTimeout)
+						m_peers[i].m_due++;
+				}
+			}
+		}
+
+		// right after enet_host_flush or enet_host_service
+		inline void sample(const ENetHost* host)
+		{
+			if (!host)
+				return;
+
+			m_peers.resize(host->peerCount);
+			for (size_t i = 0; i < host->peerCount; i++)
+			{
+				const ENetPeer& peer = host->peers[i];
+				peer_sample& last = m_peers[i];
+				if (peer.packetLossEpoch != last.m_epoch)
+					m_total += last.m_due + peer.packetsLost; // a new interval, or the peer was reset
+				else
+					m_total += peer.packetsLost >= last.m_lost ? peer.packetsLost - last.m_lost : peer.packetsLost;
+				last = { peer.packetsLost, peer.packetLossEpoch, 0 };
+			}
+		}
+	};
+
+	// wakes a host blocked in enet_host_service from any thread, host_poller uses it where there is no eventfd
+	// a tiny datagram is sent to the host's own socket and the intercept callback
+	// turns it into a RECEIVE event without a peer or packet, which makes enet_host_service return
+	struct ENetWakeup
+	{
+		static constexpr enet_uint8 magic[8] = { 'o', 'e', '-', 'w', 'a', 'k', 'e', 0 };
+
+		ENetHost* m_host = nullptr;
+		ENetSocket m_socket = ENET_SOCKET_NULL; // guarded by m_socket_mtx, senders may be in notify() while destroy() runs
+		ENetAddress m_target{};
+		std::atomic<bool> m_pending = false;
+		std::mutex m_socket_mtx;
+
+		ENetWakeup() = default;
+		ENetWakeup(const ENetWakeup&) = delete;
+		~ENetWakeup() { destroy(); }
+
+		inline void create(ENetHost* host)
+		{
+			destroy();
+
+			// bound to loopback, so the intercept knows which source the magic may come from
+			ENetAddress source{};
+			enet_address_set_host_ip(&source, "127.0.0.1");
+			source.port = 0;
+			const ENetSocket socket = enet_socket_create(ENET_SOCKET_TYPE_DATAGRAM);
+			if (socket == ENET_SOCKET_NULL)
+				return;
+			if (enet_socket_bind(socket, &source) < 0 || enet_socket_get_address(socket, &source) < 0)
+			{
+				enet_socket_destroy(socket);
+				return;
+			}
+
+			std::scoped_lock lock(m_socket_mtx);
+			enet_socket_get_address(host->socket, &m_target);
+			enet_address_set_host_ip(&m_target, "127.0.0.1");
+			m_socket = socket;
+			m_host = host;
+			m_pending = false;
+			{
+				std::scoped_lock registry_lock(registry_mtx());
+				registry()[host] = source;
+			}
+			host->intercept = &intercept;
+		}
+
+		inline void destroy()
+		{
+			std::scoped_lock lock(m_socket_mtx);
+			if (m_host)
+			{
+				std::scoped_lock registry_lock(registry_mtx());
+				registry().erase(m_host);
+			}
+			if (m_socket != ENET_SOCKET_NULL)
+				enet_socket_destroy(m_socket);
+			m_socket = ENET_SOCKET_NULL;
+			m_host = nullptr;
+		}
+
+		// one datagram until the service thread calls reset()
+		inline void notify()
+		{
+			if (m_pending.exchange(true, std::memory_order_acq_rel))
+				return;
+
+			// only the sender that set pending gets here, once per wakeup
+			std::scoped_lock lock(m_socket_mtx);
+			if (m_socket == ENET_SOCKET_NULL)
+				return;
+
+			ENetBuffer buffer;
+			buffer.data = const_cast<enet_uint8*>(magic);
+			buffer.dataLength = sizeof(magic);
+			enet_socket_send(m_socket, &m_target, &buffer, 1);
+		}
+
+		// service thread, before draining whatever the wakeup was for
+		inline void reset() noexcept { m_pending.store(false, std::memory_order_release); }
+
+		[[nodiscard]] static inline bool is_wakeup(const ENetEvent& event) noexcept { return event.type == ENET_EVENT_TYPE_RECEIVE && !event.packet; }
+
+		static int ENET_CALLBACK intercept(ENetHost* host, ENetEvent* event)
+		{
+			if (host->receivedDataLength != sizeof(magic) || std::memcmp(host->receivedData, magic, sizeof(magic)) != 0)
+				return 0;
+
+			// anyone else sending the magic is left to ENet, which drops it as a malformed command
+			{
+				std::scoped_lock lock(registry_mtx());
+				const auto it = registry().find(host);
+				if (it == registry().end() || it->second.host != host->receivedAddress.host || it->second.port != host->receivedAddress.port)
+					return 0;
+			}
+
+			if (event)
+			{
+				event->type = ENET_EVENT_TYPE_RECEIVE;
+				event->peer = nullptr;
+				event->packet = nullptr;
+				event->channelID = 0;
+				event->data = 0;
+			}
+			return 1;
+		}
+
+	private:
+		// the bound wakeup socket of each host, the intercept callback gets nothing but the host
+		static inline std::mutex& registry_mtx() { static std::mutex mtx; return mtx; }
+		static inline std::unordered_map<const ENetHost*, ENetAddress>& registry() { static std::unordered_map<const ENetHost*, ENetAddress> sources; return sources; }
+	};
+
 	struct ENetHostWrapper
 	{
 		ENetHost* m_host = nullptr;
+		ENetRetransmitCounter m_retransmits; // under the same mutex as run_service
 
 		ENetHostWrapper() = default;
 
@@ -20,6 +226,7 @@ namespace oe::networking
 		ENetHostWrapper(ENetHostWrapper&& move)
 		{
 			m_host = move.m_host;
+			m_retransmits = std::move(move.m_retransmits);
 			move.m_host = nullptr;
 		}
 
@@ -33,6 +240,7 @@ namespace oe::networking
 		ENetHostWrapper& operator=(ENetHostWrapper&& move)
 		{
 			m_host = move.m_host;
+			m_retransmits = std::move(move.m_retransmits);
 			move.m_host = nullptr;
 			return *this;
 		}
@@ -53,7 +261,21 @@ namespace oe::networking
 				return -55555;
 
 			std::scoped_lock lock(mtx);
-			return enet_host_service(m_host, &event, timeout.count());
+			m_retransmits.prepare(m_host);
+			const int32_t result = enet_host_service(m_host, &event, timeout.count());
+			m_retransmits.sample(m_host);
+			return result;
 		};
+
+		// with the host mutex locked
+		inline void flush()
+		{
+			if(!m_host)
+				return;
+
+			m_retransmits.prepare(m_host);
+			enet_host_flush(m_host);
+			m_retransmits.sample(m_host);
+		}
 	};
 }
\ No newline at end of file
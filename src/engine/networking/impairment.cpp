@@ -0,0 +1,345 @@
+#include "impairment.hpp"
+#include "enet_wrap.hpp"
+#include "engine/internal_libs.hpp"
+#include "engine/utility/profiler.hpp"
+
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <vector>
+
+
+
+namespace oe::networking
+{
+	using proxy_clock = std::chrono::steady_clock;
+
+	static constexpr size_t upstream_link = 0;
+	static constexpr size_t downstream_link = 1;
+	static constexpr enet_uint32 max_wait_ms = 10;
+
+	// a free slot has no socket, slots are reused so queued datagrams keep their session index
+	struct proxy_session
+	{
+		ENetAddress m_client{};
+		ENetSocket m_socket = ENET_SOCKET_NULL; // towards the target
+		proxy_clock::time_point m_last_active{};
+		size_t m_in_flight = 0; // datagrams queued in m_pending, the slot is not freed before they are sent
+	};
+
+	struct proxy_datagram
+	{
+		proxy_clock::time_point m_due;
+		uint64_t m_sequence = 0; // datagrams due at the same time leave in arrival order
+		size_t m_session = 0;
+		size_t m_link = upstream_link;
+		std::vector<uint8_t> m_data;
+
+		[[nodiscard]] inline bool operator>(const proxy_datagram& other) const noexcept
+		{
+			return m_due != other.m_due ? m_due > other.m_due : m_sequence > other.m_sequence;
+		}
+	};
+
+	struct proxy_link
+	{
+		impairment m_impairment{};
+		impairment_stats m_stats{};
+		proxy_clock::time_point m_busy_until{}; // bandwidth capped links send one datagram at a time
+	};
+
+	struct impairment_proxy_data
+	{
+		ENetSocket m_socket = ENET_SOCKET_NULL; // towards the clients
+		ENetAddress m_target{};
+
+		mutable std::mutex mtx;
+		std::array<proxy_link, 2> m_links;
+
+		// service thread only
+		std::vector<proxy_session> m_sessions;
+		std::priority_queue<proxy_datagram, std::vector<proxy_datagram>, std::greater<>> m_pending;
+		uint64_t m_sequence = 0;
+		std::mt19937 m_random{ 5489u }; // fixed seed, the same loss pattern every run
+		std::vector<uint8_t> m_buffer = std::vector<uint8_t>(ENET_PROTOCOL_MAXIMUM_MTU);
+	};
+
+	[[nodiscard]] static ENetSocket open_socket(const ENetAddress& address)
+	{
+		ENetSocket socket = enet_socket_create(ENET_SOCKET_TYPE_DATAGRAM);
+		if (socket == ENET_SOCKET_NULL)
+			return socket;
+
+		if (enet_socket_bind(socket, &address) < 0)
+		{
+			enet_socket_destroy(socket);
+			return ENET_SOCKET_NULL;
+		}
+		enet_socket_set_option(socket, ENET_SOCKOPT_NONBLOCK, 1);
+		enet_socket_set_option(socket, ENET_SOCKOPT_RCVBUF, ENET_HOST_RECEIVE_BUFFER_SIZE);
+		enet_socket_set_option(socket, ENET_SOCKOPT_SNDBUF, ENET_HOST_SEND_BUFFER_SIZE);
+		return socket;
+	}
+
+	[[nodiscard]] static inline bool same_address(const ENetAddress& a, const ENetAddress& b) noexcept
+	{
+		return a.host == b.host && a.port == b.port;
+	}
+
+	// decides the fate of one received datagram
+	static void schedule(impairment_proxy_data& data, size_t session, size_t link_index, size_t size, proxy_clock::time_point now)
+	{
+		std::scoped_lock lock(data.mtx);
+		auto& link = data.m_links[link_index];
+		const impairment& config = link.m_impairment;
+		std::uniform_real_distribution<float> chance{ 0.0f, 1.0f };
+
+		if (config.loss > 0.0f && chance(data.m_random) < config.loss)
+		{
+			link.m_stats.lost_packets++;
+			return;
+		}
+
+		size_t copies = 1;
+		if (config.duplicate > 0.0f && chance(data.m_random) < config.duplicate)
+		{
+			link.m_stats.duplicated_packets++;
+			copies = 2;
+		}
+
+		for (size_t i = 0; i < copies; i++)
+		{
+			// the capped link is serial, a datagram leaves once the ones before it are through
+			proxy_clock::time_point sent = now;
+			if (config.bandwidth != 0)
+			{
+				const auto backlog = std::chrono::duration<double>(std::max(link.m_busy_until, now) - now).count();
+				if (backlog * static_cast<double>(config.bandwidth) > static_cast<double>(config.queue_limit))
+				{
+					link.m_stats.overflow_packets++;
+					continue;
+				}
+				const auto transmit = std::chrono::duration<double>(static_cast<double>(size) / static_cast<double>(config.bandwidth));
+				link.m_busy_until = std::max(link.m_busy_until, now) + std::chrono::duration_cast<proxy_clock::duration>(transmit);
+				sent = link.m_busy_until;
+			}
+
+			proxy_clock::time_point due = sent + config.delay;
+			if (config.jitter.count() > 0)
+			{
+				const auto jitter_us = std::chrono::duration_cast<std::chrono::microseconds>(config.jitter).count();
+				std::uniform_int_distribution<int64_t> offset{ -jitter_us, jitter_us };
+				due = std::max(sent, due + std::chrono::microseconds(offset(data.m_random)));
+			}
+
+			data.m_pending.push({ due, data.m_sequence++, session, link_index, { data.m_buffer.begin(), data.m_buffer.begin() + size } });
+			data.m_sessions[session].m_in_flight++;
+		}
+	}
+
+	// every datagram waiting in 'socket', from a client if 'from_clients' else from the target
+	static void receive(impairment_proxy_data& data, ENetSocket socket, size_t session_index, bool from_clients, proxy_clock::time_point now)
+	{
+		while (true)
+		{
+			ENetAddress from{};
+			ENetBuffer buffer;
+			buffer.data = data.m_buffer.data();
+			buffer.dataLength = data.m_buffer.size();
+			const int received = enet_socket_receive(socket, &from, &buffer, 1);
+			if (received <= 0)
+				return;
+
+			if (!from_clients)
+			{
+				data.m_sessions[session_index].m_last_active = now;
+				schedule(data, session_index, downstream_link, static_cast<size_t>(received), now);
+				continue;
+			}
+
+			auto session = std::find_if(data.m_sessions.begin(), data.m_sessions.end(), [&](const proxy_session& s){ return s.m_socket != ENET_SOCKET_NULL && same_address(s.m_client, from); });
+			if (session == data.m_sessions.end())
+			{
+				ENetAddress any{};
+				any.host = ENET_HOST_ANY;
+				any.port = 0;
+				const ENetSocket upstream = open_socket(any);
+				if (upstream == ENET_SOCKET_NULL)
+				{
+					spdlog::warn("Impairment proxy could not open a socket for a new client");
+					continue;
+				}
+
+				session = std::find_if(data.m_sessions.begin(), data.m_sessions.end(), [](const proxy_session& s){ return s.m_socket == ENET_SOCKET_NULL; });
+				if (session == data.m_sessions.end())
+					session = data.m_sessions.emplace(data.m_sessions.end());
+				session->m_client = from;
+				session->m_socket = upstream;
+			}
+			session->m_last_active = now;
+			schedule(data, static_cast<size_t>(std::distance(data.m_sessions.begin(), session)), upstream_link, static_cast<size_t>(received), now);
+		}
+	}
+
+	// closes the sockets of clients that went quiet, their datagrams still queued are sent first
+	static void expire(impairment_proxy_data& data, proxy_clock::time_point now)
+	{
+		for (auto& session : data.m_sessions)
+		{
+			if (session.m_socket == ENET_SOCKET_NULL || session.m_in_flight != 0 || now - session.m_last_active < impairment_proxy::session_timeout)
+				continue;
+
+			enet_socket_destroy(session.m_socket);
+			session = {};
+		}
+	}
+
+
+
+	impairment_proxy::impairment_proxy()
+		: m_data(std::make_unique<impairment_proxy_data>())
+	{
+		init_enet();
+	}
+
+	impairment_proxy::~impairment_proxy()
+	{
+		close();
+	}
+
+	result impairment_proxy::open(uint16_t port, const std::string& target_ip, uint16_t target_port)
+	{
+		if (m_running)
+			return result{ "Already running" };
+
+		if (enet_address_set_host(&m_data->m_target, target_ip.c_str()) < 0)
+			return result{ "Unknown target host" };
+		m_data->m_target.port = target_port;
+
+		ENetAddress address{};
+		address.host = ENET_HOST_ANY;
+		address.port = port;
+		m_data->m_socket = open_socket(address);
+		if (m_data->m_socket == ENET_SOCKET_NULL)
+			return result{ "Proxy socket could not be created" };
+
+		m_running = true;
+		m_thread = std::thread(&impairment_proxy::operate, this);
+		return result{};
+	}
+
+	result impairment_proxy::close()
+	{
+		if (!m_running)
+			return result{ "Not running", false };
+
+		m_running = false;
+		if (m_thread.joinable())
+			m_thread.join();
+
+		// datagrams still in flight are lost, like on a link that went down
+		for (auto& session : m_data->m_sessions)
+			if (session.m_socket != ENET_SOCKET_NULL)
+				enet_socket_destroy(session.m_socket);
+		m_data->m_sessions.clear();
+		m_data->m_pending = {};
+		enet_socket_destroy(m_data->m_socket);
+		m_data->m_socket = ENET_SOCKET_NULL;
+
+		std::scoped_lock lock(m_data->mtx);
+		for (auto& link : m_data->m_links)
+			link.m_busy_until = {};
+		return result{};
+	}
+
+	void impairment_proxy::operate()
+	{
+		auto& data = *m_data;
+
+		OE_PROFILE_THREAD("Impairment proxy");
+		while (m_running)
+		{
+			// send everything that is due
+			auto now = proxy_clock::now();
+			while (!data.m_pending.empty() && data.m_pending.top().m_due <= now)
+			{
+				const proxy_datagram& datagram = data.m_pending.top();
+				proxy_session& session = data.m_sessions[datagram.m_session];
+				session.m_in_flight--;
+				ENetBuffer buffer;
+				buffer.data = const_cast<uint8_t*>(datagram.m_data.data());
+				buffer.dataLength = datagram.m_data.size();
+				if (datagram.m_link == upstream_link)
+					enet_socket_send(session.m_socket, &data.m_target, &buffer, 1);
+				else
+					enet_socket_send(data.m_socket, &session.m_client, &buffer, 1);
+
+				{
+					std::scoped_lock lock(data.mtx);
+					auto& stats = data.m_links[datagram.m_link].m_stats;
+					stats.forwarded_packets++;
+					stats.forwarded_bytes += datagram.m_data.size();
+				}
+				data.m_pending.pop();
+			}
+			expire(data, now);
+
+			// wait for traffic or the next due datagram
+			enet_uint32 timeout = max_wait_ms;
+			if (!data.m_pending.empty())
+			{
+				const auto until_due = std::chrono::ceil<std::chrono::milliseconds>(data.m_pending.top().m_due - now).count();
+				timeout = static_cast<enet_uint32>(std::clamp<int64_t>(until_due, 0, max_wait_ms));
+			}
+
+			ENetSocketSet set;
+			ENET_SOCKETSET_EMPTY(set);
+			ENET_SOCKETSET_ADD(set, data.m_socket);
+			ENetSocket max_socket = data.m_socket;
+			for (const auto& session : data.m_sessions)
+			{
+				if (session.m_socket == ENET_SOCKET_NULL)
+					continue;
+				ENET_SOCKETSET_ADD(set, session.m_socket);
+				max_socket = std::max(max_socket, session.m_socket);
+			}
+			if (enet_socketset_select(max_socket, &set, nullptr, timeout) <= 0)
+				continue;
+
+			now = proxy_clock::now();
+			if (ENET_SOCKETSET_CHECK(set, data.m_socket))
+				receive(data, data.m_socket, 0, true, now);
+			for (size_t i = 0; i < data.m_sessions.size(); i++)
+				if (data.m_sessions[i].m_socket != ENET_SOCKET_NULL && ENET_SOCKETSET_CHECK(set, data.m_sessions[i].m_socket))
+					receive(data, data.m_sessions[i].m_socket, i, false, now);
+		}
+	}
+
+	void impairment_proxy::configure(const impairment& both)
+	{
+		configure(both, both);
+	}
+
+	void impairment_proxy::configure(const impairment& upstream, const impairment& downstream)
+	{
+		std::scoped_lock lock(m_data->mtx);
+		m_data->m_links[upstream_link].m_impairment = upstream;
+		m_data->m_links[downstream_link].m_impairment = downstream;
+	}
+
+	impairment_stats impairment_proxy::upstream_stats() const
+	{
+		std::scoped_lock lock(m_data->mtx);
+		return m_data->m_links[upstream_link].m_stats;
+	}
+
+	impairment_stats impairment_proxy::downstream_stats() const
+	{
+		std::scoped_lock lock(m_data->mtx);
+		return m_data->m_links[downstream_link].m_stats;
+	}
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "shared.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+
+
+
+namespace oe::networking
+{
+	struct impairment_proxy_data;
+
+	// applied to every datagram going one way through an impairment_proxy
+	struct impairment
+	{
+		std::chrono::milliseconds delay{ 0 };
+		std::chrono::milliseconds jitter{ 0 }; // uniform in [-jitter, jitter] on top of delay, reorders datagrams
+		float loss = 0.0f;                      // chance to drop a datagram
+		float duplicate = 0.0f;                 // chance to send a datagram twice
+		size_t bandwidth = 0;                   // bytes per second, 0 for no cap
+		size_t queue_limit = 256 * 1024;        // bytes waiting for the capped link, the rest is tail dropped
+	};
+
+	struct impairment_stats
+	{
+		uint64_t forwarded_packets = 0;
+		uint64_t forwarded_bytes = 0;
+		uint64_t lost_packets = 0;
+		uint64_t duplicated_packets = 0;
+		uint64_t overflow_packets = 0; // dropped because of queue_limit
+	};
+
+	// in-process UDP relay that impairs the traffic between local Clients and a Server
+	// clients connect to the proxy port, each client address gets its own socket towards the target
+	// until nothing went either way for session_timeout
+	//
+	// oe::networking::impairment_proxy proxy;
+	// proxy.configure({ std::chrono::milliseconds(50), std::chrono::milliseconds(10), 0.02f });
+	// proxy.open(13000, "localhost", 12000);
+	// client.connect("localhost", 13000);
+	class impairment_proxy
+	{
+	public:
+		// longer than ENet's own peer timeout, a client quiet for this long is gone
+		static constexpr std::chrono::seconds session_timeout{ 60 };
+
+	private:
+		std::unique_ptr<impairment_proxy_data> m_data;
+
+		std::atomic<bool> m_running = false;
+		std::thread m_thread;
+
+		void operate();
+
+	public:
+		impairment_proxy();
+		~impairment_proxy();
+
+		result open(uint16_t port, const std::string& target_ip, uint16_t target_port);
+		result close();
+		[[nodiscard]] inline bool running() const noexcept { return m_running; }
+
+		// at any time, applies to datagrams received after the call
+		void configure(const impairment& both);
+		void configure(const impairment& upstream, const impairment& downstream); // client -> target, target -> client
+		[[nodiscard]] impairment_stats upstream_stats() const;
+		[[nodiscard]] impairment_stats downstream_stats() const;
+	};
+}
@@ -0,0 +1,194 @@
+#pragma once
+
+#include "serialization.hpp"
+#include "server.hpp"
+#include "client.hpp"
+#include "engine/utility/connect_guard.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+
+namespace oe::networking
+{
+	// first byte of every protocol message, like replication_tag for replication messages
+	static constexpr uint8_t message_tag = 0xed;
+
+	// typed events, views in 'message' point into 'handle'
+	template<typename T>
+	struct ServerMessageEvent
+	{
+		size_t client_id = 0;
+		T message;
+		packet handle;
+	};
+
+	template<typename T>
+	struct ClientMessageEvent
+	{
+		T message;
+		packet handle;
+	};
+
+	// the set of message types both ends agree on, a type's id is its index in Messages
+	// only append types to keep ids stable
+	//
+	// using protocol = oe::networking::message_protocol<PlayerState, Chat>;
+	// protocol::send_to(server, client_id, PlayerState{ ... });
+	// oe::networking::message_dispatch<protocol> dispatch{ client }; // ClientMessageEvent<PlayerState> in client.m_dispatcher
+	template<typename... Messages>
+	class message_protocol
+	{
+	private:
+		template<typename T, size_t I, typename First, typename... Rest>
+		static constexpr size_t index_of()
+		{
+			if constexpr (std::is_same_v<T, First>)
+				return I;
+			else
+			{
+				static_assert(sizeof...(Rest) != 0, "T is not a message of this protocol");
+				return index_of<T, I + 1, Rest...>();
+			}
+		}
+
+		// reused by send, no allocation after the first message
+		static inline std::vector<uint8_t>& scratch()
+		{
+			thread_local std::vector<uint8_t> buffer;
+			buffer.clear();
+			return buffer;
+		}
+
+		template<typename MakeEvent, size_t... I>
+		static bool decode_typed(size_t type, bit_reader& reader, entt::dispatcher& dispatcher, MakeEvent&& make_event, std::index_sequence<I...>)
+		{
+			bool known = false, valid = false;
+			((type == I ? (known = true, valid = decode_one<std::tuple_element_t<I, std::tuple<Messages...>>>(reader, dispatcher, make_event)) : false), ...);
+			return known && valid;
+		}
+
+		template<typename T, typename MakeEvent>
+		static bool decode_one(bit_reader& reader, entt::dispatcher& dispatcher, MakeEvent& make_event)
+		{
+			T message{};
+			if (!decode(reader, message))
+				return false;
+			dispatcher.trigger(make_event(std::move(message)));
+			return true;
+		}
+
+		// tag, type, message
+		[[nodiscard]] static bool read_type(gsl::span<const uint8_t> data, bit_reader& reader, size_t& type)
+		{
+			if (data.empty() || data[0] != message_tag)
+				return false;
+			type = static_cast<size_t>(reader.read_varint());
+			return !reader.failed();
+		}
+
+	public:
+		static_assert((has_schema_v<Messages> && ...), "every message needs a static constexpr schema()");
+
+		template<typename T>
+		static constexpr size_t type_id = index_of<T, 0, Messages...>();
+
+		template<typename T>
+		static void encode(const T& message, std::vector<uint8_t>& out)
+		{
+			out.push_back(message_tag);
+			bit_writer writer{ out };
+			writer.write_varint(type_id<T>);
+			networking::encode(message, writer);
+		}
+
+		template<typename T>
+		static result send_to(Server& server, size_t client_id, const T& message, delivery mode = delivery::reliable)
+		{
+			auto& buffer = scratch();
+			encode(message, buffer);
+			return server.send_to(buffer.data(), buffer.size(), client_id, mode);
+		}
+
+		template<typename T>
+		static result send(Server& server, const T& message, delivery mode = delivery::reliable)
+		{
+			auto& buffer = scratch();
+			encode(message, buffer);
+			return server.send(buffer.data(), buffer.size(), mode);
+		}
+
+		template<typename T>
+		static result send(Client& client, const T& message, delivery mode = delivery::reliable)
+		{
+			auto& buffer = scratch();
+			encode(message, buffer);
+			return client.send(buffer.data(), buffer.size(), mode);
+		}
+
+		// creates the dispatcher's pools for Event<T> of every message up front
+		// a Server's shard threads trigger into one dispatcher concurrently, creating them then would race
+		template<template<typename> typename Event>
+		static void prepare_events(entt::dispatcher& dispatcher)
+		{
+			((void)dispatcher.sink<Event<Messages>>(), ...);
+		}
+
+		// decodes a received message and triggers ServerMessageEvent<T> in 'dispatcher'
+		// false if it is not a message of this protocol or it is malformed
+		static bool dispatch(const ServerReceiveEvent& event, entt::dispatcher& dispatcher)
+		{
+			const gsl::span<const uint8_t> data{ event.data.data(), event.data.size() };
+			bit_reader reader{ data.subspan(data.empty() ? 0 : 1) };
+			size_t type;
+			if (!read_type(data, reader, type))
+				return false;
+			return decode_typed(type, reader, dispatcher, [&](auto&& message) {
+				return ServerMessageEvent<std::decay_t<decltype(message)>>{ event.client_id, std::move(message), event.handle };
+			}, std::index_sequence_for<Messages...>{});
+		}
+
+		// decodes a received message and triggers ClientMessageEvent<T> in 'dispatcher'
+		static bool dispatch(const ClientReceiveEvent& event, entt::dispatcher& dispatcher)
+		{
+			const gsl::span<const uint8_t> data{ event.data.data(), event.data.size() };
+			bit_reader reader{ data.subspan(data.empty() ? 0 : 1) };
+			size_t type;
+			if (!read_type(data, reader, type))
+				return false;
+			return decode_typed(type, reader, dispatcher, [&](auto&& message) {
+				return ClientMessageEvent<std::decay_t<decltype(message)>>{ std::move(message), event.handle };
+			}, std::index_sequence_for<Messages...>{});
+		}
+	};
+
+	// turns every protocol message a Server/Client receives into a typed event in its own m_dispatcher
+	// the typed events are triggered from the service thread, inside the receive event
+	// create it before Server::open, with several shards the receive events come from several threads
+	template<typename Protocol>
+	class message_dispatch
+	{
+	private:
+		oe::utils::connect_guard m_cg_receive;
+
+	public:
+		explicit message_dispatch(Server& server)
+		{
+			Protocol::template prepare_events<ServerMessageEvent>(server.m_dispatcher);
+			m_cg_receive.connect<ServerReceiveEvent>(server.m_dispatcher, [&server](const ServerReceiveEvent& e) {
+				if (!e.data.empty() && e.data[0] == message_tag && !Protocol::dispatch(e, server.m_dispatcher))
+					spdlog::warn("Malformed or unknown message from client {}", e.client_id);
+			});
+		}
+
+		explicit message_dispatch(Client& client)
+		{
+			m_cg_receive.connect<ClientReceiveEvent>(client.m_dispatcher, [&client](const ClientReceiveEvent& e) {
+				if (!e.data.empty() && e.data[0] == message_tag && !Protocol::dispatch(e, client.m_dispatcher))
+					spdlog::warn("Malformed or unknown message from server");
+			});
+		}
+	};
+}
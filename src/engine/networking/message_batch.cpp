@@ -0,0 +1,59 @@
+#include "message_batch.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+
+
+namespace oe::networking
+{
+	std::vector<uint8_t>& message_batch::next_packet()
+	{
+		if (m_used == m_packets.size())
+			m_packets.emplace_back();
+		return m_packets[m_used++];
+	}
+
+	void message_batch::append(const uint8_t* bytes, size_t count, size_t limit, bool batching)
+	{
+		const size_t framed = varint_size(count) + count;
+
+		// start a new packet if this one is full
+		std::vector<uint8_t>* packet = m_used == 0 ? nullptr : &m_packets[m_used - 1];
+		if (!batching || !packet || packet->size() + framed > limit)
+		{
+			packet = &next_packet();
+			packet->reserve(batching ? std::max(limit, framed) : framed);
+		}
+
+		write_varint(*packet, count);
+		packet->insert(packet->end(), bytes, bytes + count);
+		m_messages++;
+	}
+
+
+
+	send_queue::send_queue(size_t capacity)
+		: m_queue(capacity)
+	{}
+
+	send_queue::~send_queue()
+	{
+		clear();
+	}
+
+	bool send_queue::push(const uint8_t* bytes, size_t count, size_t client_id, delivery mode, bool broadcast)
+	{
+		auto& allocator = packet_allocator::getSingleton();
+		auto* data = static_cast<uint8_t*>(allocator.allocate(count));
+		if (!data)
+			return false;
+		std::memcpy(data, bytes, count);
+
+		if (m_queue.try_push({ data, count, client_id, mode, broadcast }))
+			return true;
+
+		allocator.deallocate(data);
+		return false;
+	}
+}
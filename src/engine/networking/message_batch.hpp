@@ -0,0 +1,150 @@
+#pragma once
+
+#include "shared.hpp"
+#include "engine/utility/mpmc_queue.hpp"
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+
+
+namespace oe::networking
+{
+	// LEB128 unsigned varints, 7 bits per byte
+	[[nodiscard]] inline size_t varint_size(uint64_t value) noexcept
+	{
+		size_t size = 1;
+		while (value >>= 7)
+			size++;
+		return size;
+	}
+
+	inline void write_varint(std::vector<uint8_t>& out, uint64_t value)
+	{
+		while (value >= 0x80)
+		{
+			out.push_back(static_cast<uint8_t>(value | 0x80));
+			value >>= 7;
+		}
+		out.push_back(static_cast<uint8_t>(value));
+	}
+
+	// false if the varint is truncated or longer than 64 bits
+	[[nodiscard]] inline bool read_varint(const uint8_t* data, size_t size, size_t& offset, uint64_t& value) noexcept
+	{
+		value = 0;
+		for (size_t shift = 0;; shift += 7)
+		{
+			if (offset >= size || shift >= 64)
+				return false;
+			const uint8_t byte = data[offset++];
+			value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+			if (!(byte & 0x80))
+				return true;
+		}
+	}
+
+	// with more than one channel, unbatched messages go out as they are on raw_channel and batches use the others
+	// so without batching the packets are the messages themselves, no length prefix and no MTU sized buffer
+	static constexpr size_t raw_channel = 0;
+
+	[[nodiscard]] constexpr inline bool is_raw_channel(size_t channel, size_t channel_count) noexcept
+	{
+		return channel_count > 1 && channel == raw_channel;
+	}
+
+	// outgoing messages for one peer and one delivery mode
+	// every message is prefixed with its varint length and packed into packets of at most 'limit' bytes
+	// a message that does not fit in an empty packet gets a packet of its own (ENet fragments it)
+	class message_batch
+	{
+	private:
+		// packets [0, m_used) are in use, the rest keep their capacity for the next tick
+		std::vector<std::vector<uint8_t>> m_packets;
+		size_t m_used = 0;
+		size_t m_messages = 0;
+
+		std::vector<uint8_t>& next_packet();
+
+	public:
+		static constexpr size_t max_header_size = 10;
+
+		// batching = false gives every message its own packet, only used where there is no raw_channel
+		void append(const uint8_t* bytes, size_t count, size_t limit, bool batching);
+
+		// calls fn(const uint8_t* data, size_t size) for every packet and clears the batch
+		template<typename Fn>
+		inline void drain(Fn&& fn)
+		{
+			for (size_t i = 0; i < m_used; i++)
+			{
+				fn(m_packets[i].data(), m_packets[i].size());
+				m_packets[i].clear();
+			}
+			m_used = 0;
+			m_messages = 0;
+		}
+
+		[[nodiscard]] inline bool empty() const noexcept { return m_used == 0; }
+		[[nodiscard]] inline size_t messages() const noexcept { return m_messages; }
+		[[nodiscard]] inline size_t packets() const noexcept { return m_used; }
+	};
+
+	// splits a received packet back into messages, calls fn(uint8_t* data, size_t size) for each
+	// returns false if the packet was truncated or malformed, messages before the error were already delivered
+	template<typename Fn>
+	inline bool unbatch(uint8_t* data, size_t size, Fn&& fn)
+	{
+		size_t offset = 0;
+		while (offset < size)
+		{
+			uint64_t length;
+			if (!read_varint(data, size, offset, length) || length > size - offset)
+				return false;
+			fn(data + offset, static_cast<size_t>(length));
+			offset += static_cast<size_t>(length);
+		}
+		return true;
+	}
+
+	struct outgoing_message
+	{
+		uint8_t* data = nullptr; // from packet_allocator
+		size_t size = 0;
+		size_t client_id = 0;
+		delivery mode = delivery::reliable;
+		bool broadcast = false;
+	};
+
+	// lock-free queue between the sending threads and the service thread
+	// payloads are copied into pooled buffers, so push never blocks and never mallocs in steady state
+	class send_queue
+	{
+	private:
+		oe::utils::mpmc_queue<outgoing_message> m_queue;
+
+	public:
+		explicit send_queue(size_t capacity = 16384);
+		send_queue(const send_queue&) = delete;
+		~send_queue();
+
+		// false if the queue is full or out of memory
+		[[nodiscard]] bool push(const uint8_t* bytes, size_t count, size_t client_id, delivery mode, bool broadcast);
+
+		// service thread: calls fn(const outgoing_message&) for every queued message and frees it
+		template<typename Fn>
+		inline size_t drain(Fn&& fn)
+		{
+			size_t count = 0;
+			while (auto message = m_queue.try_pop())
+			{
+				fn(*message);
+				packet_allocator::getSingleton().deallocate(message->data);
+				count++;
+			}
+			return count;
+		}
+		inline void clear() { drain([](const outgoing_message&){}); }
+	};
+}
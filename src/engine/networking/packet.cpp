@@ -0,0 +1,202 @@
+#include "packet.hpp"
+#include "engine/utility/mpmc_queue.hpp"
+
+#include <enet/enet.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <memory>
+#include <new>
+
+
+
+namespace oe::networking
+{
+	static constexpr size_t class_count = 11; // 64 B ... 64 KiB
+	static_assert((packet_allocator::min_class_size << (class_count - 1)) == packet_allocator::max_pooled_size);
+	static constexpr size_t unpooled = ~size_t(0);
+
+	// keeps the returned memory aligned like malloc
+	static constexpr size_t header_size = alignof(std::max_align_t) > sizeof(size_t) ? alignof(std::max_align_t) : sizeof(size_t);
+
+	[[nodiscard]] static inline size_t class_of(size_t total) noexcept
+	{
+		size_t size_class = 0;
+		while ((packet_allocator::min_class_size << size_class) < total)
+			size_class++;
+		return size_class;
+	}
+
+	struct packet_allocator::pools_t
+	{
+		std::array<std::unique_ptr<oe::utils::mpmc_queue<void*>>, class_count> free_lists;
+
+		pools_t()
+		{
+			for (size_t i = 0; i < class_count; i++)
+			{
+				const size_t block_size = min_class_size << i;
+				free_lists[i] = std::make_unique<oe::utils::mpmc_queue<void*>>(std::max<size_t>(16, max_cached_bytes_per_class / block_size));
+			}
+		}
+
+		~pools_t()
+		{
+			for (auto& free_list : free_lists)
+				while (auto block = free_list->try_pop())
+					std::free(*block);
+		}
+	};
+
+	packet_allocator::packet_allocator()
+		: m_pools(new pools_t())
+	{}
+
+	packet_allocator::~packet_allocator()
+	{
+		delete m_pools;
+	}
+
+	void* packet_allocator::allocate(size_t size) noexcept
+	{
+		m_allocations.fetch_add(1, std::memory_order_relaxed);
+
+		const size_t total = size + header_size;
+		size_t size_class = unpooled;
+		void* block = nullptr;
+		if (total <= max_pooled_size)
+		{
+			size_class = class_of(total);
+			if (auto recycled = m_pools->free_lists[size_class]->try_pop())
+			{
+				block = *recycled;
+				m_pool_hits.fetch_add(1, std::memory_order_relaxed);
+			}
+		}
+
+		if (!block)
+		{
+			block = std::malloc(size_class == unpooled ? total : min_class_size << size_class);
+			if (!block)
+				return nullptr;
+			m_system_allocations.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		*static_cast<size_t*>(block) = size_class;
+		return static_cast<uint8_t*>(block) + header_size;
+	}
+
+	void packet_allocator::deallocate(void* ptr) noexcept
+	{
+		if (!ptr)
+			return;
+
+		void* block = static_cast<uint8_t*>(ptr) - header_size;
+		const size_t size_class = *static_cast<size_t*>(block);
+		if (size_class != unpooled && m_pools->free_lists[size_class]->try_push(block))
+			return;
+
+		m_system_frees.fetch_add(1, std::memory_order_relaxed);
+		std::free(block);
+	}
+
+	packet_allocator::statistics packet_allocator::stats() const noexcept
+	{
+		return {
+			m_allocations.load(std::memory_order_relaxed),
+			m_pool_hits.load(std::memory_order_relaxed),
+			m_system_allocations.load(std::memory_order_relaxed),
+			m_system_frees.load(std::memory_order_relaxed),
+		};
+	}
+
+
+
+	struct packet::control_block
+	{
+		std::atomic<uint32_t> count;
+		ENetPacket* enet_packet;
+	};
+
+	packet::packet(ENetPacket* enet_packet)
+	{
+		if (!enet_packet)
+			return;
+
+		void* memory = packet_allocator::getSingleton().allocate(sizeof(control_block));
+		if (!memory)
+		{
+			enet_packet_destroy(enet_packet);
+			throw std::bad_alloc();
+		}
+		m_block = new (memory) control_block{ { 1 }, enet_packet };
+	}
+
+	packet::packet(const packet& copy) noexcept
+		: m_block(copy.m_block)
+	{
+		if (m_block)
+			m_block->count.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	packet::packet(packet&& move) noexcept
+		: m_block(move.m_block)
+	{
+		move.m_block = nullptr;
+	}
+
+	packet::~packet()
+	{
+		release();
+	}
+
+	packet& packet::operator=(const packet& copy) noexcept
+	{
+		if (copy.m_block)
+			copy.m_block->count.fetch_add(1, std::memory_order_relaxed);
+		release();
+		m_block = copy.m_block;
+		return *this;
+	}
+
+	packet& packet::operator=(packet&& move) noexcept
+	{
+		if (this != &move)
+		{
+			release();
+			m_block = move.m_block;
+			move.m_block = nullptr;
+		}
+		return *this;
+	}
+
+	void packet::release() noexcept
+	{
+		if (!m_block)
+			return;
+
+		if (m_block->count.fetch_sub(1, std::memory_order_acq_rel) == 1)
+		{
+			enet_packet_destroy(m_block->enet_packet);
+			m_block->~control_block();
+			packet_allocator::getSingleton().deallocate(m_block);
+		}
+		m_block = nullptr;
+	}
+
+	uint8_t* packet::data() const noexcept
+	{
+		return m_block ? m_block->enet_packet->data : nullptr;
+	}
+
+	size_t packet::size() const noexcept
+	{
+		return m_block ? m_block->enet_packet->dataLength : 0;
+	}
+
+	size_t packet::use_count() const noexcept
+	{
+		return m_block ? m_block->count.load(std::memory_order_relaxed) : 0;
+	}
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <gsl/span>
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+
+
+struct _ENetPacket;
+
+namespace oe::networking
+{
+	// bounded, size class pooled allocator behind every ENet allocation (packets, commands, fragments)
+	// blocks up to max_pooled_size are recycled through lock-free free lists, anything else goes to malloc
+	// thread safe, packets may be released from any thread
+	class packet_allocator
+	{
+	public:
+		static constexpr size_t min_class_size = 64;
+		static constexpr size_t max_pooled_size = 64 * 1024;
+		static constexpr size_t max_cached_bytes_per_class = 256 * 1024;
+
+		struct statistics
+		{
+			size_t allocations = 0;
+			size_t pool_hits = 0;        // served from a free list
+			size_t system_allocations = 0;
+			size_t system_frees = 0;     // free list full or not poolable
+		};
+
+	private:
+		struct pools_t;
+		pools_t* m_pools;
+
+		std::atomic<size_t> m_allocations{ 0 };
+		std::atomic<size_t> m_pool_hits{ 0 };
+		std::atomic<size_t> m_system_allocations{ 0 };
+		std::atomic<size_t> m_system_frees{ 0 };
+
+		packet_allocator();
+
+	public:
+		packet_allocator(const packet_allocator&) = delete;
+		~packet_allocator();
+
+		// enet callbacks free from any thread, so the first call has to be thread safe
+		// never destroyed, packets may still be released during static destruction
+		static packet_allocator& getSingleton() {
+			static packet_allocator* singleton = new packet_allocator();
+			return *singleton;
+		}
+
+		[[nodiscard]] void* allocate(size_t size) noexcept;
+		void deallocate(void* ptr) noexcept;
+
+		[[nodiscard]] statistics stats() const noexcept;
+	};
+
+	// reference counted handle to a received ENet packet
+	// copies are cheap (one atomic increment), the packet is destroyed when the last handle dies
+	class packet
+	{
+	private:
+		struct control_block;
+		control_block* m_block = nullptr;
+
+		void release() noexcept;
+
+	public:
+		packet() noexcept = default;
+		// takes ownership of an ENet packet
+		explicit packet(_ENetPacket* enet_packet);
+		packet(const packet& copy) noexcept;
+		packet(packet&& move) noexcept;
+		~packet();
+		packet& operator=(const packet& copy) noexcept;
+		packet& operator=(packet&& move) noexcept;
+
+		[[nodiscard]] uint8_t* data() const noexcept;
+		[[nodiscard]] size_t size() const noexcept;
+		[[nodiscard]] inline gsl::span<uint8_t> span() const noexcept { return { data(), size() }; }
+		[[nodiscard]] size_t use_count() const noexcept;
+		[[nodiscard]] inline explicit operator bool() const noexcept { return m_block != nullptr; }
+	};
+}
@@ -0,0 +1,174 @@
+#include "poller.hpp"
+#include "engine/internal_libs.hpp"
+
+#include <algorithm>
+
+#if defined(__linux__)
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+
+
+namespace oe::networking
+{
+	// ms until ENet has to resend an unacknowledged reliable command or ping an idle peer
+	// it does both inside enet_host_service, which only runs when the poller wakes up
+	[[nodiscard]] static enet_uint32 next_timer(const ENetHost* host, enet_uint32 max_wait) noexcept
+	{
+		const enet_uint32 now = enet_time_get();
+		enet_uint32 wait = max_wait;
+		for (size_t i = 0; i < host->peerCount; i++)
+		{
+			const ENetPeer& peer = host->peers[i];
+			if (peer.state == ENET_PEER_STATE_DISCONNECTED || peer.state == ENET_PEER_STATE_ZOMBIE)
+				continue;
+
+			// the earliest resend, or the next ping once nothing is in flight
+			enet_uint32 due = now + wait;
+			if (!enet_list_empty(&peer.sentReliableCommands))
+			{
+				for (ENetListIterator node = enet_list_begin(&peer.sentReliableCommands); node != enet_list_end(&peer.sentReliableCommands); node = enet_list_next(node))
+				{
+					const auto* command = reinterpret_cast<const ENetOutgoingCommand*>(node);
+					if (ENET_TIME_LESS(command->sentTime + command->roundTripTimeout, due))
+						due = command->sentTime + command->roundTripTimeout;
+				}
+			}
+			else if (peer.state == ENET_PEER_STATE_CONNECTED)
+			{
+				due = peer.lastReceiveTime + peer.pingInterval;
+			}
+
+			if (ENET_TIME_LESS_EQUAL(due, now))
+				return 0;
+			wait = std::min(wait, ENET_TIME_DIFFERENCE(due, now));
+		}
+		return wait;
+	}
+
+#if defined(__linux__)
+	bool host_poller::create(ENetHost* host)
+	{
+		destroy();
+		m_host = host;
+		m_pending = false;
+		m_epoll = epoll_create1(EPOLL_CLOEXEC);
+		{
+			std::scoped_lock lock(m_event_mtx);
+			m_event = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+		}
+		if (m_epoll < 0 || m_event < 0)
+		{
+			spdlog::error("Network poller could not be created: {}", errno);
+			destroy();
+			return false;
+		}
+
+		epoll_event socket_event{};
+		socket_event.events = EPOLLIN;
+		socket_event.data.fd = host->socket;
+		epoll_event wakeup_event{};
+		wakeup_event.events = EPOLLIN;
+		wakeup_event.data.fd = m_event;
+		if (epoll_ctl(m_epoll, EPOLL_CTL_ADD, host->socket, &socket_event) < 0 || epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_event, &wakeup_event) < 0)
+		{
+			spdlog::error("Network poller could not watch the socket: {}", errno);
+			destroy();
+			return false;
+		}
+		return true;
+	}
+
+	void host_poller::destroy()
+	{
+		std::scoped_lock lock(m_event_mtx);
+		if (m_epoll >= 0)
+			::close(m_epoll);
+		if (m_event >= 0)
+			::close(m_event);
+		m_epoll = -1;
+		m_event = -1;
+		m_host = nullptr;
+	}
+
+	void host_poller::notify()
+	{
+		if (m_pending.exchange(true, std::memory_order_acq_rel))
+			return;
+
+		// only the sender that set pending gets here, once per wakeup
+		std::scoped_lock lock(m_event_mtx);
+		if (m_event < 0)
+			return;
+
+		const uint64_t one = 1;
+		[[maybe_unused]] const ssize_t written = ::write(m_event, &one, sizeof(one));
+	}
+
+	void host_poller::reset()
+	{
+		if (m_event < 0)
+			return;
+
+		// drained before clearing pending: a notify() in between skips its write, but what it was for
+		// was queued before it and the caller drains the queue after this
+		// the other way around the read could eat the write of a notify() that already set pending again
+		uint64_t count;
+		[[maybe_unused]] const ssize_t read = ::read(m_event, &count, sizeof(count));
+		m_pending.store(false, std::memory_order_release);
+	}
+
+	bool host_poller::wait(std::chrono::milliseconds max_wait)
+	{
+		if (m_epoll < 0)
+			return false;
+
+		const enet_uint32 timeout = next_timer(m_host, static_cast<enet_uint32>(max_wait.count()));
+		if (timeout == 0)
+			return true;
+
+		epoll_event events[2];
+		const int result = epoll_wait(m_epoll, events, 2, static_cast<int>(timeout));
+		return result >= 0 || errno == EINTR;
+	}
+#else
+	bool host_poller::create(ENetHost* host)
+	{
+		m_host = host;
+		m_wakeup.create(host);
+		return true;
+	}
+
+	void host_poller::destroy()
+	{
+		m_wakeup.destroy();
+		m_host = nullptr;
+	}
+
+	void host_poller::notify()
+	{
+		m_wakeup.notify();
+	}
+
+	void host_poller::reset()
+	{
+		m_wakeup.reset();
+	}
+
+	bool host_poller::wait(std::chrono::milliseconds max_wait)
+	{
+		if (!m_host)
+			return false;
+
+		const enet_uint32 timeout = next_timer(m_host, static_cast<enet_uint32>(max_wait.count()));
+		if (timeout == 0)
+			return true;
+
+		enet_uint32 condition = ENET_SOCKET_WAIT_RECEIVE | ENET_SOCKET_WAIT_INTERRUPT;
+		return enet_socket_wait(m_host->socket, &condition, timeout) >= 0;
+	}
+#endif
+}
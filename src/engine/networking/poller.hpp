@@ -0,0 +1,50 @@
+#pragma once
+
+#include "enet_wrap.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+
+
+
+namespace oe::networking
+{
+	// longest sleep of an idle service thread, ENet's own timers usually wake it sooner
+	static constexpr std::chrono::milliseconds max_service_wait{ 1000 };
+	// the fixed enet_host_service timeout of the loop before the poller, see set_timed_service
+	static constexpr std::chrono::milliseconds timed_service_wait{ 50 };
+
+	// puts a service thread to sleep until its host has work: a datagram arrived, notify() was called
+	// or one of ENet's resend or ping timers is due, so the loop neither polls nor adds latency
+	// linux: epoll on the host socket and an eventfd, elsewhere enet_socket_wait woken by an ENetWakeup datagram
+	class host_poller
+	{
+	private:
+		ENetHost* m_host = nullptr;
+#if defined(__linux__)
+		int m_epoll = -1;
+		int m_event = -1; // guarded by m_event_mtx for notify(), senders may be in it while destroy() runs
+		std::atomic<bool> m_pending = false;
+		std::mutex m_event_mtx;
+#else
+		ENetWakeup m_wakeup{};
+#endif
+
+	public:
+		host_poller() = default;
+		host_poller(const host_poller&) = delete;
+		~host_poller() { destroy(); }
+
+		// after the host socket is bound
+		bool create(ENetHost* host);
+		void destroy();
+
+		// any thread, one wakeup until reset()
+		void notify();
+		// service thread, before draining whatever the wakeup was for
+		void reset();
+		// service thread, without holding the host mutex, false on error
+		bool wait(std::chrono::milliseconds max_wait = max_service_wait);
+	};
+}
@@ -0,0 +1,350 @@
+#pragma once
+
+#include "engine/utility/spsc_queue.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <utility>
+
+
+
+/*
+
+	Client-side prediction, server reconciliation and snapshot interpolation on UPS<ups> ticks
+
+	client, every UPS<60>:
+		const uint32_t tick = prediction.predict(input);       // simulated locally right away
+		prediction.for_each_unacked([&](uint32_t t, const Input& i) { ... }); // send every unacked input, unreliable
+	client, when the server's state for an input tick arrives (any one thread):
+		prediction.receive(acked_tick, state);                 // applied and re-simulated by the next predict()
+	client, every frame:
+		player = prediction.render(loop.getUpdateLag<60>(), lerp);
+
+	server, every UPS<60> per client:
+		while (auto input = inputs.next()) { state = simulate(state, input->second); ack = input->first; }
+		send (ack, state)
+
+	remote entities, every UPS<60>: clock.update(); every frame:
+		buffer.sample(clock.render_tick(loop.getUpdateLag<60>()), lerp)
+
+	ticks start at 1, 0 means none
+
+*/
+
+namespace oe::networking
+{
+	// ticks of inputs kept for re-simulation and for the server to buffer
+	static constexpr size_t prediction_history = 128;
+
+	// the value of the latest 'Size' ticks, a tick overwrites the one 'Size' ticks before it
+	template<typename T, size_t Size = prediction_history>
+	class tick_ring
+	{
+	private:
+		std::array<T, Size> m_values{};
+		std::array<uint32_t, Size> m_ticks{};
+
+	public:
+		inline void set(uint32_t tick, const T& value)
+		{
+			m_values[tick % Size] = value;
+			m_ticks[tick % Size] = tick;
+		}
+
+		[[nodiscard]] inline T* find(uint32_t tick) noexcept { return tick != 0 && m_ticks[tick % Size] == tick ? &m_values[tick % Size] : nullptr; }
+		[[nodiscard]] inline const T* find(uint32_t tick) const noexcept { return tick != 0 && m_ticks[tick % Size] == tick ? &m_values[tick % Size] : nullptr; }
+
+		// the oldest stored tick after 'tick', 0 if there is none
+		[[nodiscard]] inline uint32_t next_after(uint32_t tick) const noexcept
+		{
+			uint32_t next = 0;
+			for (const uint32_t t : m_ticks)
+				if (t > tick && (next == 0 || t < next))
+					next = t;
+			return next;
+		}
+
+		// stored ticks after 'tick'
+		[[nodiscard]] inline size_t count_after(uint32_t tick) const noexcept
+		{
+			return static_cast<size_t>(std::count_if(m_ticks.begin(), m_ticks.end(), [tick](uint32_t t) { return t > tick; }));
+		}
+
+		inline void clear() noexcept { m_ticks.fill(0); }
+	};
+
+	// predicts the local player from its own inputs and corrects it with the server's authoritative state
+	// 'simulate' has to be deterministic and the same as on the server, mispredictions are re-simulated from the correction
+	template<typename Input, typename State>
+	class client_prediction
+	{
+	public:
+		using simulate_fn = std::function<State(const State&, const Input&)>;
+		using compare_fn = std::function<bool(const State&, const State&)>; // true if close enough to not correct
+
+	private:
+		struct frame
+		{
+			Input input;
+			State state; // after input
+		};
+
+		simulate_fn m_simulate;
+		compare_fn m_compare;
+		tick_ring<frame> m_history;
+		oe::utils::spsc_queue<std::pair<uint32_t, State>> m_received{ 64 };
+
+		uint32_t m_tick = 0;
+		uint32_t m_acked = 0;
+		State m_previous;
+		State m_current;
+
+		size_t m_corrections = 0;
+		size_t m_resimulated = 0;
+
+	public:
+		client_prediction(simulate_fn simulate, const State& initial, compare_fn compare = std::equal_to<State>{})
+			: m_simulate(std::move(simulate))
+			, m_compare(std::move(compare))
+			, m_previous(initial)
+			, m_current(initial)
+		{}
+
+		// authoritative 'state' after the input of 'tick', from one thread at a time (usually the Client's service thread)
+		// false if the queue is full, the next state will correct things anyway
+		inline bool receive(uint32_t tick, const State& state)
+		{
+			return m_received.try_push({ tick, state });
+		}
+
+		// once per tick: reconciles with the newest received state, then simulates 'input' as the next tick
+		inline uint32_t predict(const Input& input)
+		{
+			std::optional<std::pair<uint32_t, State>> newest;
+			while (auto received = m_received.try_pop())
+				if (!newest || received->first > newest->first)
+					newest = std::move(received);
+			if (newest)
+				reconcile(newest->first, newest->second);
+
+			m_tick++;
+			m_previous = m_current;
+			m_current = m_simulate(m_current, input);
+			m_history.set(m_tick, { input, m_current });
+			return m_tick;
+		}
+
+		// from the thread calling predict, true if the prediction for 'tick' was wrong and the later ticks were re-simulated
+		inline bool reconcile(uint32_t tick, const State& authoritative)
+		{
+			if (tick <= m_acked || tick > m_tick)
+				return false;
+			m_acked = tick;
+
+			// older than the history, the inputs to replay from it are gone and it would snap back in time
+			// dropped, a newer state corrects things
+			frame* predicted = m_history.find(tick);
+			if (!predicted || m_compare(predicted->state, authoritative))
+				return false;
+
+			m_corrections++;
+			State state = authoritative;
+			predicted->state = state;
+			for (uint32_t t = tick + 1; t <= m_tick; t++)
+			{
+				frame* replay = m_history.find(t);
+				if (!replay)
+					break;
+				state = m_simulate(state, replay->input);
+				replay->state = state;
+				m_resimulated++;
+			}
+			m_current = state;
+			return true;
+		}
+
+		// inputs the server has not acknowledged yet, oldest first
+		// sending all of them every tick makes single lost packets harmless
+		template<typename Fn>
+		inline void for_each_unacked(Fn&& fn) const
+		{
+			constexpr uint32_t history = static_cast<uint32_t>(prediction_history);
+			const uint32_t first = std::max(m_acked + 1, m_tick >= history ? m_tick - history + 1 : 1u);
+			for (uint32_t t = first; t <= m_tick; t++)
+				if (const frame* f = m_history.find(t))
+					fn(t, f->input);
+		}
+
+		// between the previous and the current tick, 'update_lag' from GameLoop::getUpdateLag
+		template<typename Lerp>
+		[[nodiscard]] inline State render(float update_lag, Lerp&& lerp) const
+		{
+			return lerp(m_previous, m_current, std::clamp(update_lag, 0.0f, 1.0f));
+		}
+
+		[[nodiscard]] inline const State& current() const noexcept { return m_current; }
+		[[nodiscard]] inline const State& previous() const noexcept { return m_previous; }
+		[[nodiscard]] inline uint32_t tick() const noexcept { return m_tick; }
+		[[nodiscard]] inline uint32_t acked() const noexcept { return m_acked; }
+		[[nodiscard]] inline uint32_t unacked() const noexcept { return m_tick - m_acked; }
+		[[nodiscard]] inline size_t corrections() const noexcept { return m_corrections; }
+		[[nodiscard]] inline size_t resimulated_ticks() const noexcept { return m_resimulated; }
+	};
+
+	// the server side of client_prediction, one per client
+	// every input is handed out once and in tick order, redundant copies are dropped
+	template<typename Input>
+	class input_queue
+	{
+	private:
+		tick_ring<Input> m_inputs;
+		uint32_t m_processed = 0;
+		size_t m_waited = 0;
+		size_t m_skip_after;
+
+	public:
+		// a missing input is given up on after 'skip_after' calls to next() that had later inputs waiting
+		explicit input_queue(size_t skip_after = 8) noexcept
+			: m_skip_after(skip_after)
+		{}
+
+		// before the first next() any tick goes, the client may have been predicting for a while
+		// and resends only its latest prediction_history inputs
+		inline void push(uint32_t tick, const Input& input)
+		{
+			if (tick <= m_processed || (m_processed != 0 && tick > m_processed + prediction_history))
+				return;
+			m_inputs.set(tick, input);
+		}
+
+		// the input after the last one handed out, nothing if it has not arrived yet
+		[[nodiscard]] inline std::optional<std::pair<uint32_t, Input>> next()
+		{
+			uint32_t tick = m_processed + 1;
+			if (!m_inputs.find(tick))
+			{
+				// the first input decides where the client's ticks start
+				const uint32_t later = m_inputs.next_after(m_processed);
+				if (later == 0 || (m_processed != 0 && ++m_waited <= m_skip_after))
+					return std::nullopt;
+				tick = later;
+			}
+
+			m_waited = 0;
+			m_processed = tick;
+			return std::make_pair(tick, *m_inputs.find(tick));
+		}
+
+		[[nodiscard]] inline uint32_t processed() const noexcept { return m_processed; }
+		// inputs that arrived but were not handed out yet
+		[[nodiscard]] inline size_t buffered() const noexcept
+		{
+			return m_inputs.count_after(m_processed);
+		}
+	};
+
+	// states of a remote entity by server tick, sampled somewhat in the past to always have two to interpolate between
+	template<typename State, size_t Size = 32>
+	class interpolation_buffer
+	{
+	private:
+		tick_ring<State, Size> m_states;
+		uint32_t m_latest = 0;
+
+	public:
+		// out of order is fine, states more than Size ticks older than the latest are dropped
+		inline void push(uint32_t tick, const State& state)
+		{
+			if (tick == 0 || tick + Size <= m_latest)
+				return;
+			m_states.set(tick, state);
+			m_latest = std::max(m_latest, tick);
+		}
+
+		// the state at fractional server tick 'tick', between the closest received states around it
+		// clamped to the latest state, nothing before the first state arrived
+		template<typename Lerp>
+		[[nodiscard]] inline std::optional<State> sample(float tick, Lerp&& lerp) const
+		{
+			if (m_latest == 0)
+				return std::nullopt;
+			if (tick >= static_cast<float>(m_latest))
+				return *m_states.find(m_latest);
+
+			const uint32_t base = tick < 1.0f ? 1 : static_cast<uint32_t>(std::floor(tick));
+			uint32_t before = base;
+			while (before + Size > m_latest && before != 0 && !m_states.find(before))
+				before--;
+			uint32_t after = base + 1;
+			while (after < m_latest && !m_states.find(after))
+				after++;
+
+			const State* a = before != 0 ? m_states.find(before) : nullptr;
+			const State* b = m_states.find(after);
+			if (!a)
+				return *b;
+			return lerp(*a, *b, std::clamp((tick - static_cast<float>(before)) / static_cast<float>(after - before), 0.0f, 1.0f));
+		}
+
+		[[nodiscard]] inline uint32_t latest() const noexcept { return m_latest; }
+	};
+
+	// the server tick to render remote entities at, 'delay' ticks behind the newest received one
+	// advanced by update() every local tick and pulled towards the received ticks, so it stays smooth through jitter
+	class interpolation_clock
+	{
+	private:
+		std::atomic<uint32_t> m_received{ 0 };
+		float m_tick = 0.0f;
+		float m_delay;
+
+	public:
+		static constexpr float snap_distance = 8.0f; // ticks, further off than this jumps instead of drifting
+		static constexpr float correction = 0.1f;    // of the error per tick
+
+		explicit interpolation_clock(float delay = 2.0f) noexcept
+			: m_delay(delay)
+		{}
+
+		// the newest server tick, from any one thread
+		inline void received(uint32_t server_tick) noexcept
+		{
+			uint32_t current = m_received.load(std::memory_order_relaxed);
+			while (server_tick > current && !m_received.compare_exchange_weak(current, server_tick, std::memory_order_relaxed));
+		}
+
+		// once per UPS tick
+		inline void update() noexcept
+		{
+			const uint32_t received = m_received.load(std::memory_order_relaxed);
+			if (received == 0)
+				return;
+			if (m_tick == 0.0f)
+			{
+				m_tick = static_cast<float>(received);
+				return;
+			}
+
+			m_tick += 1.0f;
+			const float error = static_cast<float>(received) - m_tick;
+			if (std::abs(error) > snap_distance)
+				m_tick = static_cast<float>(received);
+			else
+				m_tick += error * correction;
+		}
+
+		// 'update_lag' from GameLoop::getUpdateLag
+		[[nodiscard]] inline float render_tick(float update_lag) const noexcept
+		{
+			return std::max(m_tick - m_delay + update_lag, 0.0f);
+		}
+
+		inline void set_delay(float delay) noexcept { m_delay = delay; }
+		[[nodiscard]] inline float delay() const noexcept { return m_delay; }
+	};
+}
@@ -0,0 +1,343 @@
+#include "replication.hpp"
+#include "message_batch.hpp"
+#include "engine/internal_libs.hpp"
+#include "engine/utility/profiler.hpp"
+
+#include <algorithm>
+
+
+
+namespace oe::networking
+{
+	enum message_kind : uint8_t { kind_snapshot = 0, kind_ack = 1 };
+
+	static const snapshot empty_snapshot{};
+
+	[[nodiscard]] static inline uint32_t network_id(entt::entity entity) noexcept
+	{
+		return static_cast<uint32_t>(entt::to_integral(entity));
+	}
+
+	// tag, kind and the varint header fields, false if it is not a replication message of that kind
+	template<size_t N>
+	[[nodiscard]] static bool read_header(gsl::span<const uint8_t> data, message_kind kind, size_t& offset, std::array<uint64_t, N>& fields)
+	{
+		if (data.size() < 2 || data[0] != replication_tag || data[1] != kind)
+			return false;
+
+		offset = 2;
+		for (auto& field : fields)
+			if (!read_varint(data.data(), data.size(), offset, field) || field > ~uint32_t(0))
+				return false;
+		return true;
+	}
+
+
+
+	void replicated_components::read(const entt::registry& registry, entt::entity entity, uint32_t id, snapshot& out)
+	{
+		uint32_t mask = 0;
+		uint8_t* scratch = m_scratch.data();
+		for (size_t type = 0; type < m_components.size(); type++)
+		{
+			if (m_components[type].read(registry, entity, scratch))
+			{
+				mask |= uint32_t(1) << type;
+				scratch += m_sizes[type];
+			}
+		}
+
+		if (mask == 0)
+			return;
+		uint8_t* dst = out.push(id, mask, m_sizes);
+		std::memcpy(dst, m_scratch.data(), static_cast<size_t>(scratch - m_scratch.data()));
+	}
+
+	void replicated_components::apply(entt::registry& registry, entt::entity entity, const snapshot& previous, size_t previous_index, const snapshot& current, size_t index) const
+	{
+		for (size_t type = 0; type < m_components.size(); type++)
+		{
+			const uint8_t* now = current.component(index, type, m_sizes);
+			const uint8_t* then = previous_index != snapshot::npos ? previous.component(previous_index, type, m_sizes) : nullptr;
+			if (now && (!then || std::memcmp(now, then, m_sizes[type]) != 0))
+				m_components[type].write(registry, entity, now);
+			else if (!now && then)
+				m_components[type].remove(registry, entity);
+		}
+	}
+
+
+
+	ReplicationServer::ReplicationServer(Server& server, oe::ecs::World& world)
+		: m_server(server)
+		, m_world(world)
+	{
+		// any shard thread, forwarded to update()
+		const auto push_event = [this](const event_t& event) {
+			if (!m_events.try_push(event))
+				spdlog::warn("Replication event queue full, call ReplicationServer::update more often");
+		};
+		m_cg_connect.connect<ServerConnectEvent>(m_server.m_dispatcher, [push_event](const ServerConnectEvent& e) {
+			push_event({ event_t::connect, e.client_id, 0 });
+		});
+		m_cg_disconnect.connect<ServerDisconnectEvent>(m_server.m_dispatcher, [push_event](const ServerDisconnectEvent& e) {
+			push_event({ event_t::disconnect, e.client_id, 0 });
+		});
+		m_cg_receive.connect<ServerReceiveEvent>(m_server.m_dispatcher, [push_event](const ServerReceiveEvent& e) {
+			size_t offset;
+			std::array<uint64_t, 1> sequence;
+			if (read_header(gsl::span<const uint8_t>{ e.data.data(), e.data.size() }, kind_ack, offset, sequence))
+				push_event({ event_t::ack, e.client_id, static_cast<uint32_t>(sequence[0]) });
+		});
+	}
+
+	void ReplicationServer::process_events()
+	{
+		while (auto event = m_events.try_pop())
+		{
+			switch (event->kind)
+			{
+			case event_t::connect:
+				m_clients[event->client_id].connected = true;
+				break;
+
+			case event_t::disconnect:
+				m_clients.erase(event->client_id);
+				break;
+
+			case event_t::ack:
+			{
+				const auto iter = m_clients.find(event->client_id);
+				if (iter != m_clients.end() && event->sequence <= m_sequence)
+					iter->second.acked = std::max(iter->second.acked, event->sequence);
+				break;
+			}
+			}
+		}
+	}
+
+	void ReplicationServer::build(snapshot& out)
+	{
+		m_candidates.clear();
+		m_world.m_scene.each([this](const entt::entity entity) {
+			m_candidates.emplace_back(network_id(entity), entity);
+		});
+		std::sort(m_candidates.begin(), m_candidates.end());
+
+		out.clear();
+		for (const auto& [id, entity] : m_candidates)
+			m_components.read(m_world.m_scene, entity, id, out);
+	}
+
+	std::shared_ptr<snapshot> ReplicationServer::unused_everything()
+	{
+		// only the pool holds it, no client history points to it anymore
+		for (const auto& everything : m_everything)
+			if (everything.use_count() == 1)
+				return everything;
+		return m_everything.emplace_back(std::make_shared<snapshot>());
+	}
+
+	void ReplicationServer::find_unlocated()
+	{
+		m_world.updateSpatialIndex();
+		m_unlocated.clear();
+		if (m_world.m_spatial_index.size() >= m_world.m_scene.alive())
+			return;
+
+		m_world.m_scene.each([this](const entt::entity entity) {
+			if (!m_world.m_spatial_index.contains(entity))
+				m_unlocated.push_back(entity);
+		});
+	}
+
+	void ReplicationServer::build(snapshot& out, const glm::vec2& center, float radius)
+	{
+		m_candidates.clear();
+		m_world.m_spatial_index.query(center, radius, [this](const entt::entity entity) {
+			m_candidates.emplace_back(network_id(entity), entity);
+		});
+		for (const entt::entity entity : m_unlocated)
+			m_candidates.emplace_back(network_id(entity), entity);
+		std::sort(m_candidates.begin(), m_candidates.end());
+
+		out.clear();
+		for (const auto& [id, entity] : m_candidates)
+			if (m_world.m_scene.valid(entity))
+				m_components.read(m_world.m_scene, entity, id, out);
+	}
+
+	void ReplicationServer::set_interest(size_t client_id, const glm::vec2& center, float radius)
+	{
+		auto& client = m_clients[client_id];
+		client.center = center;
+		client.radius = std::max(radius, 0.0f);
+	}
+
+	void ReplicationServer::clear_interest(size_t client_id)
+	{
+		const auto iter = m_clients.find(client_id);
+		if (iter != m_clients.end())
+			iter->second.radius = -1.0f;
+	}
+
+	void ReplicationServer::update()
+	{
+		OE_PROFILE_SCOPE("ReplicationServer::update");
+		process_events();
+		m_sequence++;
+
+		std::shared_ptr<snapshot> everything;
+		bool unlocated_found = false;
+		for (auto& [client_id, client] : m_clients)
+		{
+			if (!client.connected)
+				continue;
+
+			// the baseline slot gets reused once the ack is older than the history
+			const auto& acked = client.history[client.acked % replication_history];
+			const bool has_baseline = client.acked != 0 && acked && acked->sequence == client.acked && client.acked % replication_history != m_sequence % replication_history;
+			const snapshot& baseline = has_baseline ? *acked : empty_snapshot;
+
+			auto& current = client.history[m_sequence % replication_history];
+			if (client.radius < 0.0f)
+			{
+				if (!everything)
+				{
+					everything = unused_everything();
+					build(*everything);
+					everything->sequence = m_sequence;
+				}
+				current = everything;
+			}
+			else
+			{
+				if (!unlocated_found)
+					find_unlocated();
+				unlocated_found = true;
+
+				// its own from an earlier tick can be built into, one shared with the others is replaced
+				if (!current || current.use_count() != 1)
+					current = std::make_shared<snapshot>();
+				build(*current, client.center, client.radius);
+				current->sequence = m_sequence;
+			}
+
+			m_message.clear();
+			m_message.push_back(replication_tag);
+			m_message.push_back(kind_snapshot);
+			write_varint(m_message, m_sequence);
+			write_varint(m_message, baseline.sequence);
+			encode_delta(baseline, *current, m_components.sizes(), m_message);
+
+			client.last_size = m_message.size();
+			const auto result = m_server.send_to(m_message.begin(), m_message.end(), client_id, delivery::unreliable_fragment);
+			if (result.failed())
+				spdlog::warn("Replication snapshot to {} failed: {}", client_id, result.message());
+		}
+	}
+
+	size_t ReplicationServer::last_snapshot_size(size_t client_id) const
+	{
+		const auto iter = m_clients.find(client_id);
+		return iter != m_clients.end() ? iter->second.last_size : 0;
+	}
+
+
+
+	ReplicationClient::ReplicationClient(Client& client, oe::ecs::World& world)
+		: m_client(client)
+		, m_world(world)
+	{
+		// service thread, the packet handle keeps the data alive until update()
+		m_cg_receive.connect<ClientReceiveEvent>(m_client.m_dispatcher, [this](const ClientReceiveEvent& e) {
+			if (e.data.size() < 2 || e.data[0] != replication_tag)
+				return;
+			if (!m_received.try_push(e))
+				spdlog::warn("Replication receive queue full, call ReplicationClient::update more often");
+		});
+	}
+
+	void ReplicationClient::apply(const snapshot& previous, const snapshot& current)
+	{
+		auto& registry = m_world.m_scene;
+		size_t p = 0, c = 0;
+		while (p < previous.size() || c < current.size())
+		{
+			// gone
+			if (c == current.size() || (p < previous.size() && previous.ids[p] < current.ids[c]))
+			{
+				const auto iter = m_entities.find(previous.ids[p++]);
+				if (iter == m_entities.end())
+					continue;
+				if (registry.valid(iter->second))
+					registry.destroy(iter->second);
+				m_entities.erase(iter);
+				continue;
+			}
+
+			const bool existed = p < previous.size() && previous.ids[p] == current.ids[c];
+			auto& entity = m_entities.try_emplace(current.ids[c], entt::null).first->second;
+			if (entity == entt::null || !registry.valid(entity))
+				entity = registry.create();
+			m_components.apply(registry, entity, previous, existed ? p : snapshot::npos, current, c);
+
+			if (existed)
+				p++;
+			c++;
+		}
+	}
+
+	void ReplicationClient::update()
+	{
+		OE_PROFILE_SCOPE("ReplicationClient::update");
+		const uint32_t latest_before = m_latest;
+		while (auto event = m_received.try_pop())
+		{
+			size_t offset;
+			std::array<uint64_t, 2> header; // sequence, baseline
+			const gsl::span<const uint8_t> data{ event->data.data(), event->data.size() };
+			if (!read_header(data, kind_snapshot, offset, header))
+				continue;
+
+			// late or duplicate
+			const uint32_t sequence = static_cast<uint32_t>(header[0]);
+			const uint32_t baseline_sequence = static_cast<uint32_t>(header[1]);
+			if (sequence <= m_latest)
+				continue;
+
+			// a baseline we no longer have, the server moves on once it sees a newer ack
+			const snapshot& baseline = baseline_sequence == 0 ? empty_snapshot : m_history[baseline_sequence % replication_history];
+			if (baseline.sequence != baseline_sequence)
+				continue;
+
+			if (!decode_delta(baseline, data.data() + offset, data.size() - offset, m_components.sizes(), m_decoded))
+			{
+				spdlog::warn("Malformed replication snapshot {}", sequence);
+				continue;
+			}
+			m_decoded.sequence = sequence;
+
+			apply(m_latest == 0 ? empty_snapshot : m_history[m_latest % replication_history], m_decoded);
+			std::swap(m_history[sequence % replication_history], m_decoded);
+			m_latest = sequence;
+		}
+
+		if (m_latest == latest_before)
+			return;
+
+		m_message.clear();
+		m_message.push_back(replication_tag);
+		m_message.push_back(kind_ack);
+		write_varint(m_message, m_latest);
+		const auto result = m_client.send(m_message.begin(), m_message.end(), delivery::unreliable);
+		if (result.failed())
+			spdlog::warn("Replication ack failed: {}", result.message());
+	}
+
+	entt::entity ReplicationClient::local_entity(uint32_t network_id) const
+	{
+		const auto iter = m_entities.find(network_id);
+		return iter != m_entities.end() ? iter->second : entt::entity{ entt::null };
+	}
+}
@@ -0,0 +1,191 @@
+#pragma once
+
+#include "server.hpp"
+#include "client.hpp"
+#include "snapshot.hpp"
+#include "engine/ecs/world.hpp"
+#include "engine/utility/connect_guard.hpp"
+#include "engine/utility/spsc_queue.hpp"
+#include "engine/utility/mpmc_queue.hpp"
+
+#include <array>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+
+
+namespace oe::networking
+{
+	// first byte of every replication message
+	// replication ignores user messages that do not start with it, user handlers should ignore the ones that do
+	static constexpr uint8_t replication_tag = 0xec;
+	// snapshots kept for delta baselines, a client that has not acked within this many ticks gets a full snapshot
+	static constexpr size_t replication_history = 32;
+
+	// the component types to replicate, registered in the same order on the server and the client
+	// components are sent as raw bytes, so they have to be trivially copyable, non-empty and have the same layout on both ends
+	class replicated_components
+	{
+	private:
+		struct component_t
+		{
+			bool (*read)(const entt::registry& registry, entt::entity entity, uint8_t* out);
+			void (*write)(entt::registry& registry, entt::entity entity, const uint8_t* in);
+			void (*remove)(entt::registry& registry, entt::entity entity);
+		};
+
+		std::vector<component_t> m_components;
+		std::vector<size_t> m_sizes;
+		std::vector<uint8_t> m_scratch;
+
+	public:
+		template<typename T>
+		void add()
+		{
+			static_assert(std::is_trivially_copyable_v<T> && std::is_default_constructible_v<T> && !std::is_empty_v<T>, "replicated components are sent as raw bytes");
+			if (m_components.size() >= snapshot::max_components)
+				throw std::runtime_error("Too many replicated component types");
+
+			m_components.push_back({
+				[](const entt::registry& registry, entt::entity entity, uint8_t* out) {
+					const T* component = registry.try_get<T>(entity);
+					if (!component)
+						return false;
+					std::memcpy(out, component, sizeof(T));
+					return true;
+				},
+				[](entt::registry& registry, entt::entity entity, const uint8_t* in) {
+					T component;
+					std::memcpy(&component, in, sizeof(T));
+					registry.emplace_or_replace<T>(entity, component);
+				},
+				[](entt::registry& registry, entt::entity entity) {
+					registry.remove_if_exists<T>(entity);
+				},
+			});
+			m_sizes.push_back(sizeof(T));
+			m_scratch.resize(m_scratch.size() + sizeof(T));
+		}
+
+		[[nodiscard]] inline const std::vector<size_t>& sizes() const noexcept { return m_sizes; }
+		[[nodiscard]] inline size_t count() const noexcept { return m_components.size(); }
+
+		// appends the entity to the snapshot, skipped if it has none of the replicated components
+		void read(const entt::registry& registry, entt::entity entity, uint32_t id, snapshot& out);
+		// makes the components of 'entity' match entity 'index' of 'current', 'previous_index' is npos for a new entity
+		void apply(entt::registry& registry, entt::entity entity, const snapshot& previous, size_t previous_index, const snapshot& current, size_t index) const;
+	};
+
+	// sends the replicated components of a World to every connected client
+	// once per update(): a delta against the last snapshot the client acknowledged, over the unreliable channel
+	class ReplicationServer
+	{
+	private:
+		struct client_state
+		{
+			bool connected = false;
+			uint32_t acked = 0;
+			// never written while another client points to the same snapshot
+			std::array<std::shared_ptr<snapshot>, replication_history> history;
+			size_t last_size = 0;
+
+			// interest area, everything if radius < 0
+			glm::vec2 center{ 0.0f };
+			float radius = -1.0f;
+		};
+
+		// from the service thread
+		struct event_t
+		{
+			enum kind_t : uint8_t { connect, disconnect, ack } kind;
+			size_t client_id;
+			uint32_t sequence;
+		};
+
+		Server& m_server;
+		oe::ecs::World& m_world;
+		replicated_components m_components;
+
+		std::unordered_map<size_t, client_state> m_clients;
+		oe::utils::mpmc_queue<event_t> m_events{ 4096 }; // every shard thread of the server pushes, update() pops
+		uint32_t m_sequence = 0;
+
+		// full snapshots, one per tick is shared by all the clients without an interest area
+		// a pool, so the ones every client has moved past are built into again
+		std::vector<std::shared_ptr<snapshot>> m_everything;
+		std::vector<entt::entity> m_unlocated; // not in the spatial index, in every interest area
+		std::vector<std::pair<uint32_t, entt::entity>> m_candidates;
+		std::vector<uint8_t> m_message;
+
+		oe::utils::connect_guard m_cg_connect;
+		oe::utils::connect_guard m_cg_disconnect;
+		oe::utils::connect_guard m_cg_receive;
+
+		void process_events();
+		[[nodiscard]] std::shared_ptr<snapshot> unused_everything();
+		void find_unlocated();
+		void build(snapshot& out);
+		void build(snapshot& out, const glm::vec2& center, float radius);
+
+	public:
+		ReplicationServer(Server& server, oe::ecs::World& world);
+		ReplicationServer(const ReplicationServer&) = delete;
+
+		template<typename T>
+		inline void replicate() { m_components.add<T>(); }
+
+		// only entities within 'radius' of 'center' are sent to this client
+		// uses World::m_spatial_index: QuadComponents are placed by World::updateSpatialIndex before each update
+		// other entities have to be put in the index by hand, the ones that are not in it are always sent
+		void set_interest(size_t client_id, const glm::vec2& center, float radius);
+		void clear_interest(size_t client_id);
+
+		// call once per network tick from the thread that owns the World
+		void update();
+
+		// bytes of the latest snapshot message sent to the client
+		[[nodiscard]] size_t last_snapshot_size(size_t client_id) const;
+		[[nodiscard]] inline uint32_t sequence() const noexcept { return m_sequence; }
+	};
+
+	// applies snapshots from a ReplicationServer to a World
+	// replicated entities are created and destroyed by update(), network ids are mapped to local entities
+	class ReplicationClient
+	{
+	private:
+		Client& m_client;
+		oe::ecs::World& m_world;
+		replicated_components m_components;
+
+		oe::utils::spsc_queue<ClientReceiveEvent> m_received{ 256 };
+		std::array<snapshot, replication_history> m_history;
+		snapshot m_decoded;
+		uint32_t m_latest = 0;
+		std::unordered_map<uint32_t, entt::entity> m_entities;
+		std::vector<uint8_t> m_message;
+
+		oe::utils::connect_guard m_cg_receive;
+
+		void apply(const snapshot& previous, const snapshot& current);
+
+	public:
+		ReplicationClient(Client& client, oe::ecs::World& world);
+		ReplicationClient(const ReplicationClient&) = delete;
+
+		template<typename T>
+		inline void replicate() { m_components.add<T>(); }
+
+		// applies every snapshot received since the last call and acks the newest
+		// call from the thread that owns the World
+		void update();
+
+		// entt::null if the entity is not replicated (anymore)
+		[[nodiscard]] entt::entity local_entity(uint32_t network_id) const;
+		[[nodiscard]] inline uint32_t latest_sequence() const noexcept { return m_latest; }
+		[[nodiscard]] inline size_t entity_count() const noexcept { return m_entities.size(); }
+	};
+}
@@ -0,0 +1,400 @@
+#pragma once
+
+#include "engine/internal_libs.hpp"
+
+#include <gsl/span>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+
+
+/*
+
+	Schema-driven bit-packed serialization
+
+	struct PlayerState
+	{
+		uint32_t entity;
+		glm::vec2 position;
+		float rotation;
+		int16_t health;
+		std::string_view name;
+
+		static constexpr auto schema()
+		{
+			using namespace oe::networking;
+			return std::make_tuple(
+				field(&PlayerState::entity),
+				field(&PlayerState::position, quantize{ -1000.0f, 1000.0f, 20 }),
+				field(&PlayerState::rotation, quantize{ 0.0f, 6.2832f, 10 }),
+				field(&PlayerState::health),
+				field(&PlayerState::name));
+		}
+	};
+
+	integers are varints (signed ones zigzagged), bools are one bit, floats are raw unless quantized,
+	glm vectors apply the option to every component, nested types with a schema() are inlined,
+	std::string_view and gsl::span<const uint8_t> are byte aligned and decode as views into the input
+
+	messages are written with their field count, so appending fields to a schema stays compatible both ways:
+	old readers skip the new fields and new readers leave missing fields default initialized
+	nested types are inlined without a count, only the top level can grow
+
+*/
+
+namespace oe::networking
+{
+	class bit_writer
+	{
+	private:
+		std::vector<uint8_t>& m_out;
+		uint64_t m_bits = 0;
+		size_t m_count = 0;
+
+	public:
+		// appends to 'out'
+		explicit bit_writer(std::vector<uint8_t>& out) noexcept : m_out(out) {}
+		~bit_writer() { flush(); }
+
+		// low 'bits' bits of value, at most 32
+		inline void write(uint32_t value, size_t bits)
+		{
+			m_bits |= static_cast<uint64_t>(value & (bits >= 32 ? ~uint32_t(0) : (uint32_t(1) << bits) - 1)) << m_count;
+			m_count += bits;
+			while (m_count >= 8)
+			{
+				m_out.push_back(static_cast<uint8_t>(m_bits));
+				m_bits >>= 8;
+				m_count -= 8;
+			}
+		}
+
+		inline void write_varint(uint64_t value)
+		{
+			while (value >= 0x80)
+			{
+				write(static_cast<uint32_t>(value & 0x7f) | 0x80, 8);
+				value >>= 7;
+			}
+			write(static_cast<uint32_t>(value), 8);
+		}
+
+		// pads to the next byte and appends raw bytes
+		inline void write_bytes(const uint8_t* data, size_t size)
+		{
+			flush();
+			m_out.insert(m_out.end(), data, data + size);
+		}
+
+		// pads the last partial byte with zeros
+		inline void flush()
+		{
+			if (m_count == 0)
+				return;
+			m_out.push_back(static_cast<uint8_t>(m_bits));
+			m_bits = 0;
+			m_count = 0;
+		}
+	};
+
+	// reads from a span without copying, reading past the end sets failed() and returns zeros
+	class bit_reader
+	{
+	private:
+		gsl::span<const uint8_t> m_data;
+		size_t m_byte = 0;
+		uint64_t m_bits = 0;
+		size_t m_count = 0;
+		bool m_failed = false;
+
+	public:
+		explicit bit_reader(gsl::span<const uint8_t> data) noexcept : m_data(data) {}
+
+		inline uint32_t read(size_t bits) noexcept
+		{
+			while (m_count < bits)
+			{
+				if (m_byte >= m_data.size())
+				{
+					m_failed = true;
+					return 0;
+				}
+				m_bits |= static_cast<uint64_t>(m_data[m_byte++]) << m_count;
+				m_count += 8;
+			}
+			const uint32_t value = static_cast<uint32_t>(m_bits & (bits >= 32 ? ~uint32_t(0) : (uint32_t(1) << bits) - 1));
+			m_bits >>= bits;
+			m_count -= bits;
+			return value;
+		}
+
+		inline uint64_t read_varint() noexcept
+		{
+			uint64_t value = 0;
+			for (size_t shift = 0; shift < 64; shift += 7)
+			{
+				const uint32_t byte = read(8);
+				value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+				if (!(byte & 0x80))
+					return value;
+			}
+			m_failed = true;
+			return 0;
+		}
+
+		// skips to the next byte and returns a view of the next 'size' bytes
+		inline gsl::span<const uint8_t> read_bytes(size_t size) noexcept
+		{
+			align();
+			if (size > m_data.size() - m_byte)
+			{
+				m_failed = true;
+				return {};
+			}
+			const auto bytes = m_data.subspan(m_byte, size);
+			m_byte += size;
+			return bytes;
+		}
+
+		inline void align() noexcept
+		{
+			m_bits = 0;
+			m_count = 0;
+		}
+
+		// no complete field left
+		[[nodiscard]] inline bool at_end() const noexcept { return m_byte >= m_data.size() && m_count < 8; }
+		[[nodiscard]] inline bool failed() const noexcept { return m_failed; }
+		[[nodiscard]] inline size_t bytes_read() const noexcept { return m_byte; }
+	};
+
+
+
+	// field options
+	struct raw {};
+	// maps [min, max] to a 'bits' wide integer, values outside are clamped
+	// throws if bits is not in [1, 32] or the range is empty, a compile error when schema() is constant evaluated
+	struct quantize
+	{
+		float min;
+		float max;
+		uint32_t bits;
+
+		constexpr quantize(float range_min, float range_max, uint32_t bit_count)
+			: min(range_min), max(range_max), bits(bit_count)
+		{
+			if (bits < 1 || bits > 32)
+				throw std::invalid_argument("quantize bits must be in [1, 32]");
+			if (!(min < max))
+				throw std::invalid_argument("quantize needs min < max");
+		}
+	};
+
+	template<typename Class, typename T, typename Options>
+	struct field_t
+	{
+		T Class::* member;
+		Options options;
+	};
+
+	template<typename Class, typename T>
+	constexpr inline auto field(T Class::* member) noexcept { return field_t<Class, T, raw>{ member, {} }; }
+	template<typename Class, typename T, typename Options>
+	constexpr inline auto field(T Class::* member, Options options) noexcept { return field_t<Class, T, Options>{ member, options }; }
+
+	template<typename T, typename = void>
+	struct has_schema : std::false_type {};
+	template<typename T>
+	struct has_schema<T, std::void_t<decltype(T::schema())>> : std::true_type {};
+	template<typename T>
+	static constexpr bool has_schema_v = has_schema<T>::value;
+
+	template<typename T>
+	static constexpr size_t field_count_v = std::tuple_size_v<decltype(T::schema())>;
+
+
+
+	namespace detail
+	{
+		template<typename T> void write_value(bit_writer& writer, const T& value, raw);
+		template<typename T> void read_value(bit_reader& reader, T& value, raw);
+		template<typename T> void write_value(bit_writer& writer, const T& value, const quantize& q);
+		template<typename T> void read_value(bit_reader& reader, T& value, const quantize& q);
+
+		[[nodiscard]] constexpr inline uint64_t zigzag(int64_t value) noexcept { return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63); }
+		[[nodiscard]] constexpr inline int64_t unzigzag(uint64_t value) noexcept { return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1); }
+
+		template<typename T>
+		inline void write_value(bit_writer& writer, const T& value, raw)
+		{
+			if constexpr (has_schema_v<T>)
+			{
+				std::apply([&](const auto&... fields) { (write_value(writer, value.*(fields.member), fields.options), ...); }, T::schema());
+			}
+			else if constexpr (std::is_same_v<T, bool>)
+			{
+				writer.write(value ? 1 : 0, 1);
+			}
+			else if constexpr (std::is_enum_v<T>)
+			{
+				write_value(writer, static_cast<std::underlying_type_t<T>>(value), raw{});
+			}
+			else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>)
+			{
+				writer.write_varint(zigzag(value));
+			}
+			else if constexpr (std::is_integral_v<T>)
+			{
+				writer.write_varint(value);
+			}
+			else if constexpr (std::is_same_v<T, float>)
+			{
+				uint32_t bits;
+				std::memcpy(&bits, &value, sizeof(bits));
+				writer.write(bits, 32);
+			}
+			else if constexpr (std::is_same_v<T, double>)
+			{
+				uint64_t bits;
+				std::memcpy(&bits, &value, sizeof(bits));
+				writer.write(static_cast<uint32_t>(bits), 32);
+				writer.write(static_cast<uint32_t>(bits >> 32), 32);
+			}
+			else if constexpr (std::is_same_v<T, std::string_view>)
+			{
+				writer.write_varint(value.size());
+				writer.write_bytes(reinterpret_cast<const uint8_t*>(value.data()), value.size());
+			}
+			else if constexpr (std::is_same_v<T, gsl::span<const uint8_t>>)
+			{
+				writer.write_varint(value.size());
+				writer.write_bytes(value.data(), value.size());
+			}
+			else
+			{
+				// glm vectors
+				for (glm::length_t i = 0; i < T::length(); i++)
+					write_value(writer, value[i], raw{});
+			}
+		}
+
+		template<typename T>
+		inline void read_value(bit_reader& reader, T& value, raw)
+		{
+			if constexpr (has_schema_v<T>)
+			{
+				std::apply([&](const auto&... fields) { (read_value(reader, value.*(fields.member), fields.options), ...); }, T::schema());
+			}
+			else if constexpr (std::is_same_v<T, bool>)
+			{
+				value = reader.read(1) != 0;
+			}
+			else if constexpr (std::is_enum_v<T>)
+			{
+				std::underlying_type_t<T> underlying{};
+				read_value(reader, underlying, raw{});
+				value = static_cast<T>(underlying);
+			}
+			else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>)
+			{
+				value = static_cast<T>(unzigzag(reader.read_varint()));
+			}
+			else if constexpr (std::is_integral_v<T>)
+			{
+				value = static_cast<T>(reader.read_varint());
+			}
+			else if constexpr (std::is_same_v<T, float>)
+			{
+				const uint32_t bits = reader.read(32);
+				std::memcpy(&value, &bits, sizeof(value));
+			}
+			else if constexpr (std::is_same_v<T, double>)
+			{
+				uint64_t bits = reader.read(32);
+				bits |= static_cast<uint64_t>(reader.read(32)) << 32;
+				std::memcpy(&value, &bits, sizeof(value));
+			}
+			else if constexpr (std::is_same_v<T, std::string_view>)
+			{
+				const auto bytes = reader.read_bytes(static_cast<size_t>(reader.read_varint()));
+				value = std::string_view{ reinterpret_cast<const char*>(bytes.data()), bytes.size() };
+			}
+			else if constexpr (std::is_same_v<T, gsl::span<const uint8_t>>)
+			{
+				value = reader.read_bytes(static_cast<size_t>(reader.read_varint()));
+			}
+			else
+			{
+				for (glm::length_t i = 0; i < T::length(); i++)
+					read_value(reader, value[i], raw{});
+			}
+		}
+
+		template<typename T>
+		inline void write_value(bit_writer& writer, const T& value, const quantize& q)
+		{
+			if constexpr (std::is_floating_point_v<T>)
+			{
+				const uint32_t steps = q.bits >= 32 ? ~uint32_t(0) : (uint32_t(1) << q.bits) - 1;
+				const double normalized = std::clamp((static_cast<double>(value) - q.min) / (static_cast<double>(q.max) - q.min), 0.0, 1.0);
+				writer.write(static_cast<uint32_t>(std::lround(normalized * steps)), q.bits);
+			}
+			else
+			{
+				static_assert(std::is_floating_point_v<typename T::value_type>, "quantize is for floats and float vectors");
+				for (glm::length_t i = 0; i < T::length(); i++)
+					write_value(writer, value[i], q);
+			}
+		}
+
+		template<typename T>
+		inline void read_value(bit_reader& reader, T& value, const quantize& q)
+		{
+			if constexpr (std::is_floating_point_v<T>)
+			{
+				const uint32_t steps = q.bits >= 32 ? ~uint32_t(0) : (uint32_t(1) << q.bits) - 1;
+				const double normalized = static_cast<double>(reader.read(q.bits)) / steps;
+				value = static_cast<T>(q.min + normalized * (static_cast<double>(q.max) - q.min));
+			}
+			else
+			{
+				for (glm::length_t i = 0; i < T::length(); i++)
+					read_value(reader, value[i], q);
+			}
+		}
+	}
+
+
+
+	// field count, then the fields
+	template<typename T>
+	inline void encode(const T& message, bit_writer& writer)
+	{
+		static_assert(has_schema_v<T>, "T needs a static constexpr schema()");
+		writer.write_varint(field_count_v<T>);
+		detail::write_value(writer, message, raw{});
+	}
+
+	// fields the sender did not have keep their current value, fields the reader does not know are skipped
+	// views (string_view, span) point into 'data'
+	// false if the data ends before the fields it claims to contain
+	template<typename T>
+	[[nodiscard]] inline bool decode(bit_reader& reader, T& message)
+	{
+		static_assert(has_schema_v<T>, "T needs a static constexpr schema()");
+		const uint64_t count = reader.read_varint();
+		size_t index = 0;
+		std::apply([&](const auto&... fields) {
+			((index++ < count ? detail::read_value(reader, message.*(fields.member), fields.options) : void()), ...);
+		}, T::schema());
+		return !reader.failed();
+	}
+}
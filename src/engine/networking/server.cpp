@@ -1,6 +1,14 @@
 #include "server.hpp"
 #include "enet_wrap.hpp"
+#include "message_batch.hpp"
+#include "compressor.hpp"
+#include "poller.hpp"
 #include "engine/internal_libs.hpp"
+#include "engine/utility/profiler.hpp"
+
+#include <array>
+#include <iterator>
+#include <stdexcept>
 
 
 
@@ -12,7 +20,12 @@ namespace oe::networking
 		if(!initialized)
 		{
 			initialized = true;
-			if(enet_initialize() < 0)
+
+			// every ENet allocation goes through the pooled packet allocator
+			ENetCallbacks callbacks{};
+			callbacks.malloc = [](size_t size) { return packet_allocator::getSingleton().allocate(size); };
+			callbacks.free = [](void* ptr) { packet_allocator::getSingleton().deallocate(ptr); };
+			if(enet_initialize_with_callbacks(ENET_VERSION, &callbacks) < 0)
 				spdlog::error("ENet init failed");
 			spdlog::info("ENet initialized");
 		}
@@ -20,14 +33,61 @@ namespace oe::networking
 
 
 
-	struct server_enet_data
+	static constexpr size_t invalid_client = ~size_t(0);
+
+	[[nodiscard]] static constexpr inline size_t make_client_id(size_t generation, size_t shard, size_t slot) noexcept
 	{
+		return (generation << (Server::slot_bits + Server::shard_bits)) | (shard << Server::slot_bits) | slot;
+	}
+
+	[[nodiscard]] static constexpr inline size_t client_slot(size_t client_id) noexcept
+	{
+		return client_id & ((size_t(1) << Server::slot_bits) - 1);
+	}
+
+	// one per ENet peer, indexed by its incomingPeerID
+	struct peer_slot
+	{
+		ENetPeer* m_peer = nullptr;
+		std::atomic<size_t> m_client_id = invalid_client; // written by the service thread after m_peer, read by any thread
+		size_t m_generation = 1; // ids are never 0
+
+		// service thread only
+		std::array<message_batch, delivery_count> m_batches;
+		bool m_dirty = false;
+	};
+
+	struct server_shard
+	{
+		size_t m_index = 0;
 		ENetHostWrapper m_server{};
 		ENetAddress m_address{};
-		ENetCompressor m_compressor{};
-		std::unordered_map<size_t, ENetPeer*> m_peers;
+		packet_compressor m_compressor{};
+		std::vector<peer_slot> m_peers;
+		std::atomic<size_t> m_client_count = 0;
 		size_t m_channel_id = 0;
-		size_t m_client_id_gen = 0;
+
+		std::mutex mtx;
+		std::thread m_thread;
+
+		// sending threads -> service thread
+		send_queue m_send_queue{};
+		host_poller m_poller{};
+
+		// service thread only
+		std::vector<size_t> m_dirty; // slots with batched messages
+		std::array<message_batch, delivery_count> m_broadcast;
+		size_t m_batch_limit = batch_limit(ENET_HOST_DEFAULT_MTU);
+	};
+
+	struct server_enet_data
+	{
+		std::vector<std::unique_ptr<server_shard>> m_shards;
+
+		// applied to the shards on open
+		compression m_compression = compression::none;
+		std::vector<uint8_t> m_dictionary;
+		size_t m_capture_bytes = 0;
 	};
 
 
@@ -38,6 +98,11 @@ namespace oe::networking
 		, m_max_channels(max_channels)
 	{
 		init_enet();
+
+		// the shard threads trigger concurrently, the dispatcher must not create these pools while they do
+		(void)m_dispatcher.sink<ServerConnectEvent>();
+		(void)m_dispatcher.sink<ServerDisconnectEvent>();
+		(void)m_dispatcher.sink<ServerReceiveEvent>();
 	}
 
 	Server::~Server()
@@ -45,132 +110,416 @@ namespace oe::networking
 		close();
 	}
 
-	result Server::open(uint16_t port)
+	result Server::open(uint16_t port, size_t shards)
 	{
-		// address
-		m_data->m_address.port = port;
-		m_data->m_address.host = ENET_HOST_ANY;
-		
-		// server
-		std::scoped_lock lock(mtx);
-		m_data->m_server = { &m_data->m_address, m_max_clients, m_max_channels };
-		m_running = m_data->m_server.m_host != nullptr;
-		if (!m_running)
-			return result{ "Server could not be created" };
+		if (m_running)
+			return result{ "Already running" };
+		if (shards == 0 || shards > max_shards || static_cast<size_t>(port) + shards > 65536)
+			return result{ "Invalid shard count" };
+		if (m_max_clients > max_clients_per_shard)
+			return result{ "Too many clients per shard" };
+
+		m_data->m_shards.clear();
+		for (size_t i = 0; i < shards; i++)
+		{
+			auto& shard = *m_data->m_shards.emplace_back(std::make_unique<server_shard>());
+			shard.m_index = i;
 
-		enet_host_compress(m_data->m_server.m_host, &m_data->m_compressor);
-		m_thread = std::thread(&Server::operate, this);
+			// address
+			shard.m_address.port = static_cast<uint16_t>(port + i);
+			shard.m_address.host = ENET_HOST_ANY;
+
+			// server
+			std::scoped_lock lock(shard.mtx);
+			shard.m_server = { &shard.m_address, m_max_clients, m_max_channels };
+			if (!shard.m_server.m_host)
+			{
+				m_data->m_shards.clear();
+				return result{ "Server could not be created" };
+			}
+
+			shard.m_compressor.configure(m_data->m_compression, m_data->m_dictionary);
+			shard.m_compressor.attach(shard.m_server.m_host);
+			if (m_data->m_capture_bytes != 0)
+				shard.m_compressor.capture_traffic(m_data->m_capture_bytes / shards);
+			shard.m_peers = std::vector<peer_slot>(m_max_clients);
+			shard.m_batch_limit = batch_limit(shard.m_server.m_host->mtu);
+			shard.m_poller.create(shard.m_server.m_host);
+		}
+
+		m_running = true;
+		for (auto& shard : m_data->m_shards)
+			shard->m_thread = std::thread(&Server::operate, this, std::ref(*shard));
 
 		return result{};
 	}
-	
+
 	result Server::close()
 	{
 		if (!m_running)
 			return result{ "Not running", false };
 
-		// wait for event service to stop
+		// wait for event services to stop
 		m_running = false;
-		if (m_thread.joinable())
-			m_thread.join();
+		for (auto& shard : m_data->m_shards)
+			shard->m_poller.notify();
+		for (auto& shard : m_data->m_shards)
+			if (shard->m_thread.joinable())
+				shard->m_thread.join();
 
-		// close the server
-		std::scoped_lock lock(mtx);
-		m_data->m_server.destroy();
+		// close the shards, keep them around for the stats
+		for (auto& shard : m_data->m_shards)
+		{
+			std::scoped_lock lock(shard->mtx);
+			shard->m_poller.destroy();
+			shard->m_server.destroy();
+			shard->m_compressor.attach(nullptr);
+			shard->m_send_queue.clear();
+			for (auto& slot : shard->m_peers)
+			{
+				slot.m_client_id = invalid_client;
+				slot.m_peer = nullptr;
+				for (auto& batch : slot.m_batches)
+					batch.drain([](const uint8_t*, size_t){});
+			}
+			shard->m_dirty.clear();
+			shard->m_client_count = 0;
+			for (auto& batch : shard->m_broadcast)
+				batch.drain([](const uint8_t*, size_t){});
+		}
 		return result{};
 	}
 
-	result Server::send_to(const unsigned char* bytes, size_t count, size_t client_id)
+	server_shard* Server::find_shard(size_t client_id) const noexcept
 	{
-		const size_t channel = next_channel();
-		ENetPacket*	packet = enet_packet_create(bytes, count, ENET_PACKET_FLAG_RELIABLE);
-		
-		// std::scoped_lock lock(mtx);
-		enet_peer_send(m_data->m_peers.at(client_id), channel, packet);
-		enet_host_flush(m_data->m_server.m_host);
-		
+		const size_t shard = client_shard(client_id);
+		return shard < m_data->m_shards.size() ? m_data->m_shards[shard].get() : nullptr;
+	}
+
+	// ENet updates the peer inside enet_host_service, which runs with the shard mutex locked
+	// a disconnect clears the id after that, so a peer that just left may still be read, but not one torn down by close()
+	template<typename Fn>
+	auto Server::with_peer(size_t client_id, Fn&& fn) const
+	{
+		server_shard* shard = find_shard(client_id);
+		const size_t slot = client_slot(client_id);
+		if (!shard)
+			throw std::out_of_range("Unknown client");
+
+		std::scoped_lock lock(shard->mtx);
+		if (slot >= shard->m_peers.size() || shard->m_peers[slot].m_client_id.load(std::memory_order_acquire) != client_id || !shard->m_peers[slot].m_peer)
+			throw std::out_of_range("Unknown client");
+		return fn(*shard->m_peers[slot].m_peer);
+	}
+
+	result Server::send_to(const unsigned char* bytes, size_t count, size_t client_id, delivery mode)
+	{
+		if (!m_running)
+			return result{ "Not running" };
+
+		server_shard* shard = find_shard(client_id);
+		if (!shard)
+			return result{ "Unknown client" };
+		if (!shard->m_send_queue.push(bytes, count, client_id, mode, false))
+			return result{ "Send queue full" };
+		shard->m_poller.notify();
 		return result{};
 	}
 
-	result Server::send(const unsigned char* bytes, size_t count)
+	result Server::send(const unsigned char* bytes, size_t count, delivery mode)
 	{
-		const size_t channel = next_channel();
-		ENetPacket*	packet = enet_packet_create(bytes, count, ENET_PACKET_FLAG_RELIABLE);
-		
-		// std::scoped_lock lock(mtx);
-		enet_host_broadcast(m_data->m_server.m_host, channel, packet);
-		enet_host_flush(m_data->m_server.m_host);
+		if (!m_running)
+			return result{ "Not running" };
 
+		size_t full = 0;
+		for (auto& shard : m_data->m_shards)
+		{
+			if (!shard->m_send_queue.push(bytes, count, 0, mode, true))
+			{
+				full++;
+				continue;
+			}
+			shard->m_poller.notify();
+		}
+
+		// the clients of the other shards still get it
+		if (full == m_data->m_shards.size())
+			return result{ "Send queue full" };
+		if (full != 0)
+			return result{ fmt::format("Send queue full on {} of {} shards", full, m_data->m_shards.size()), false };
 		return result{};
 	}
 
-	void Server::operate()
+	void Server::flush_batches(server_shard& shard)
+	{
+		std::scoped_lock lock(shard.mtx);
+		ENetHost* host = shard.m_server.m_host;
+
+		// reset first, sends that race with the drain wake the loop again
+		shard.m_poller.reset();
+		const bool batching = m_batching;
+		size_t dropped = 0;
+		shard.m_send_queue.drain([&](const outgoing_message& message){
+			if (message.broadcast)
+			{
+				shard.m_broadcast[static_cast<size_t>(message.mode)].append(message.data, message.size, shard.m_batch_limit, batching);
+				return;
+			}
+
+			// disconnected or never existed
+			const size_t slot_index = client_slot(message.client_id);
+			if (slot_index >= shard.m_peers.size() || shard.m_peers[slot_index].m_client_id.load(std::memory_order_relaxed) != message.client_id)
+			{
+				dropped++;
+				return;
+			}
+
+			auto& slot = shard.m_peers[slot_index];
+			if (!batching && slot.m_peer->channelCount > 1)
+			{
+				enet_peer_send(slot.m_peer, raw_channel, enet_packet_create(message.data, message.size, packet_flags(message.mode)));
+				return;
+			}
+			slot.m_batches[static_cast<size_t>(message.mode)].append(message.data, message.size, shard.m_batch_limit, batching);
+			if (!slot.m_dirty)
+				shard.m_dirty.push_back(slot_index);
+			slot.m_dirty = true;
+		});
+		if (dropped != 0)
+			spdlog::warn("Dropped {} messages to unknown clients", dropped);
+
+		for (size_t mode = 0; mode < delivery_count; mode++)
+		{
+			const enet_uint32 flags = packet_flags(static_cast<delivery>(mode));
+			shard.m_broadcast[mode].drain([&](const uint8_t* data, size_t size){
+				enet_host_broadcast(host, next_channel(shard), enet_packet_create(data, size, flags));
+			});
+		}
+
+		for (const size_t slot_index : shard.m_dirty)
+		{
+			auto& slot = shard.m_peers[slot_index];
+			slot.m_dirty = false;
+			for (size_t mode = 0; mode < delivery_count; mode++)
+			{
+				const enet_uint32 flags = packet_flags(static_cast<delivery>(mode));
+				slot.m_batches[mode].drain([&](const uint8_t* data, size_t size){
+					enet_peer_send(slot.m_peer, next_channel(shard), enet_packet_create(data, size, flags));
+				});
+			}
+		}
+		shard.m_dirty.clear();
+
+		shard.m_server.flush();
+	}
+
+	void Server::operate(server_shard& shard)
 	{
 		ENetEvent event{};
 		size_t client_id;
 
+		OE_PROFILE_THREAD(fmt::format("Server service {}", shard.m_index));
 		while (m_running)
 		{
-			enet_host_flush(m_data->m_server.m_host);
-			const int32_t r = m_data->m_server.run_service(mtx, event, std::chrono::milliseconds(50));
+			{
+				OE_PROFILE_SCOPE("Server::operate flush");
+				flush_batches(shard);
+			}
+			const bool timed = m_timed_service;
+			const int32_t r = shard.m_server.run_service(shard.mtx, event, timed ? timed_service_wait : std::chrono::milliseconds(0));
 			if (r < 0)
 				spdlog::warn("Server ENet service error");
-			if (r == 0)
+			if (r <= 0 && timed)
+				continue;
+			if (r <= 0)
+			{
+				// sleeps until a datagram arrives, a send wakes it or an ENet timer is due
+				OE_PROFILE_SCOPE("Server::operate wait");
+				if (!shard.m_poller.wait())
+					spdlog::warn("Server poll error");
+				continue;
+			}
+			if (ENetWakeup::is_wakeup(event))
 				continue;
 
+			OE_PROFILE_SCOPE("Server::operate event");
 			switch (event.type)
 			{
 			default:/* case ENET_EVENT_TYPE_NONE: */
 				break;
-			
+
 			case ENET_EVENT_TYPE_CONNECT:
-				client_id = m_data->m_client_id_gen++;
+			{
+				auto& slot = shard.m_peers[event.peer->incomingPeerID];
+				client_id = make_client_id(slot.m_generation++, shard.m_index, event.peer->incomingPeerID);
 				event.peer->data = reinterpret_cast<void*>(client_id);
-				m_data->m_peers.insert(std::make_pair(client_id, event.peer));
+				slot.m_peer = event.peer;
+				slot.m_client_id.store(client_id, std::memory_order_release);
+				shard.m_client_count++;
+				shard.m_compressor.track_peer(event.peer->address);
 				m_dispatcher.trigger(ServerConnectEvent{ client_id });
 				break;
-			
+			}
+
 			case ENET_EVENT_TYPE_DISCONNECT:
+			{
+				// peers that timed out before connecting have no id
 				client_id = reinterpret_cast<size_t>(event.peer->data);
-				m_data->m_peers.erase(client_id);
-				m_dispatcher.trigger(ServerDisconnectEvent{ client_id });		
+				auto& slot = shard.m_peers[event.peer->incomingPeerID];
+				if (client_id == 0 || slot.m_client_id.load(std::memory_order_relaxed) != client_id)
+					break;
+
+				event.peer->data = nullptr;
+				slot.m_client_id.store(invalid_client, std::memory_order_release);
+				for (auto& batch : slot.m_batches)
+					batch.drain([](const uint8_t*, size_t){});
+				shard.m_client_count--;
+				shard.m_compressor.forget_peer(event.peer->address);
+				m_dispatcher.trigger(ServerDisconnectEvent{ client_id });
 				break;
-			
+			}
+
 			case ENET_EVENT_TYPE_RECEIVE:
+			{
 				client_id = reinterpret_cast<size_t>(event.peer->data);
-				m_dispatcher.trigger(ServerReceiveEvent{ client_id, { event.packet->data, event.packet->dataLength } });
-				enet_packet_destroy(event.packet);
+				const packet handle{ event.packet };
+				if (is_raw_channel(event.channelID, event.peer->channelCount))
+					m_dispatcher.trigger(ServerReceiveEvent{ client_id, { handle.data(), handle.size() }, handle });
+				else if (!unbatch(handle.data(), handle.size(), [&](uint8_t* data, size_t size){ m_dispatcher.trigger(ServerReceiveEvent{ client_id, { data, size }, handle }); }))
+					spdlog::warn("Malformed packet from client {}", client_id);
 				break;
 			}
+			}
 		}
 	}
-	
-	[[nodiscard]] size_t Server::next_channel()
+
+	[[nodiscard]] size_t Server::next_channel(server_shard& shard)
 	{
-		m_data->m_channel_id++; // overflow (not gonna happen) is just going to make the next step easy
-		
-		if (m_data->m_channel_id >= m_max_channels)
-			m_data->m_channel_id = 0;
-		
-		return m_data->m_channel_id;
+		shard.m_channel_id++; // overflow (not gonna happen) is just going to make the next step easy
+
+		// batches skip raw_channel
+		if (shard.m_channel_id >= m_max_channels)
+			shard.m_channel_id = m_max_channels > 1 ? raw_channel + 1 : raw_channel;
+
+		return shard.m_channel_id;
+	}
+
+	size_t Server::shard_count() const noexcept
+	{
+		return m_data->m_shards.size();
+	}
+
+	uint16_t Server::shard_port(size_t shard) const
+	{
+		return m_data->m_shards.at(shard)->m_address.port;
+	}
+
+	size_t Server::client_count() const noexcept
+	{
+		size_t count = 0;
+		for (const auto& shard : m_data->m_shards)
+			count += shard->m_client_count;
+		return count;
 	}
 
 	std::string Server::client_address(size_t client_id) const
 	{
+		const ENetAddress address = with_peer(client_id, [](const ENetPeer& peer){ return peer.address; });
 		std::string ip{ 100, '\0' };
-		enet_address_get_host_ip(&m_data->m_peers.at(client_id)->address, ip.data(), 100);
+		enet_address_get_host_ip(&address, ip.data(), 100);
 		ip.erase(0, ip.find_first_not_of('\0'));
 		return ip;
 	}
 
 	uint16_t Server::client_port(size_t client_id) const
 	{
-		return m_data->m_peers.at(client_id)->address.port;
+		return with_peer(client_id, [](const ENetPeer& peer){ return peer.address.port; });
+	}
+
+	statistics Server::stats()
+	{
+		statistics total{};
+		for (auto& shard : m_data->m_shards)
+		{
+			std::scoped_lock lock(shard->mtx);
+			const statistics s = host_statistics(shard->m_server.m_host, shard->m_server.m_retransmits.m_total);
+			total.sent_bytes += s.sent_bytes;
+			total.sent_packets += s.sent_packets;
+			total.received_bytes += s.received_bytes;
+			total.received_packets += s.received_packets;
+			total.retransmits += s.retransmits;
+		}
+		return total;
 	}
 
 	float Server::client_packet_loss(size_t client_id) const
 	{
-		return static_cast<float>(m_data->m_peers.at(client_id)->packetLoss) / static_cast<float>(ENET_PEER_PACKET_LOSS_SCALE);
+		return with_peer(client_id, [](const ENetPeer& peer){ return static_cast<float>(peer.packetLoss) / static_cast<float>(ENET_PEER_PACKET_LOSS_SCALE); });
+	}
+
+	std::chrono::milliseconds Server::client_round_trip_time(size_t client_id) const
+	{
+		return with_peer(client_id, [](const ENetPeer& peer){ return std::chrono::milliseconds{ peer.roundTripTime }; });
+	}
+
+	result Server::set_compression(compression mode, std::vector<uint8_t> dictionary)
+	{
+		if (m_running)
+			return result{ "Already running" };
+
+		m_data->m_compression = mode;
+		m_data->m_dictionary = std::move(dictionary);
+		return result{};
+	}
+
+	compression Server::get_compression() const noexcept
+	{
+		return m_data->m_compression;
+	}
+
+	compression_stats Server::compressor_stats() const
+	{
+		compression_stats total{};
+		for (const auto& shard : m_data->m_shards)
+		{
+			const compression_stats s = shard->m_compressor.stats();
+			total.compressed_packets += s.compressed_packets;
+			total.incompressible_packets += s.incompressible_packets;
+			total.compress_raw_bytes += s.compress_raw_bytes;
+			total.compress_compressed_bytes += s.compress_compressed_bytes;
+			total.compress_ns += s.compress_ns;
+			total.decompressed_packets += s.decompressed_packets;
+			total.decompress_failures += s.decompress_failures;
+			total.decompress_compressed_bytes += s.decompress_compressed_bytes;
+			total.decompress_raw_bytes += s.decompress_raw_bytes;
+			total.decompress_ns += s.decompress_ns;
+		}
+		return total;
+	}
+
+	compression_stats Server::client_compressor_stats(size_t client_id)
+	{
+		return with_peer(client_id, [&](const ENetPeer& peer){ return find_shard(client_id)->m_compressor.peer_stats(peer.address); });
+	}
+
+	void Server::capture_traffic(size_t max_bytes)
+	{
+		// split evenly, the shards see similar traffic
+		m_data->m_capture_bytes = max_bytes;
+		for (auto& shard : m_data->m_shards)
+			shard->m_compressor.capture_traffic(max_bytes / m_data->m_shards.size());
+	}
+
+	std::vector<std::vector<uint8_t>> Server::captured_traffic()
+	{
+		m_data->m_capture_bytes = 0;
+		std::vector<std::vector<uint8_t>> captured;
+		for (auto& shard : m_data->m_shards)
+		{
+			auto shard_captured = shard->m_compressor.captured_traffic();
+			std::move(shard_captured.begin(), shard_captured.end(), std::back_inserter(captured));
+		}
+		return captured;
 	}
 
-}
\ No newline at end of file
+}
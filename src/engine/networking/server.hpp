@@ -12,10 +12,13 @@
 
 
 
+struct _ENetPeer;
+
 namespace oe::networking
 {
 	void init_enet();
 	struct server_enet_data;
+	struct server_shard;
 
 	
 	
@@ -24,45 +27,90 @@ namespace oe::networking
 	private:
 		std::unique_ptr<server_enet_data> m_data;
 
-		std::mutex mtx;
 		std::atomic<bool> m_running = false;
-		std::thread m_thread;
+		std::atomic<bool> m_batching = true;
+		std::atomic<bool> m_timed_service = false;
 		size_t m_max_clients;
 		size_t m_max_channels;
 
-		void operate();
-		[[nodiscard]] size_t next_channel();
+		void operate(server_shard& shard);
+		void flush_batches(server_shard& shard);
+		[[nodiscard]] size_t next_channel(server_shard& shard);
+		[[nodiscard]] server_shard* find_shard(size_t client_id) const noexcept;
+		// calls fn(const ENetPeer&) with the shard locked, throws std::out_of_range for unknown clients
+		template<typename Fn>
+		auto with_peer(size_t client_id, Fn&& fn) const;
 
 	public:
+		// client ids: | generation | shard (8 bits) | peer slot (12 bits) |
+		// a slot gets a new generation for every connection, so ids are not reused while the server is open
+		static constexpr size_t slot_bits = 12;
+		static constexpr size_t shard_bits = 8;
+		static constexpr size_t max_shards = size_t(1) << shard_bits;
+		static constexpr size_t max_clients_per_shard = (size_t(1) << slot_bits) - 1; // ENet peer id limit
+
 		entt::dispatcher m_dispatcher;
 		
+		// max_clients per shard
 		Server(size_t max_clients = 32, size_t max_channels = 32);
 		~Server();
 
-		result open(uint16_t port);
+		// 'shards' ENet hosts on ports [port, port + shards), each serviced by its own thread
+		// clients pick the port, event handlers are called from the shard threads
+		// one at a time per shard, so concurrently with more than one
+		result open(uint16_t port, size_t shards = 1);
 		result close();
-		result send_to(const uint8_t* bytes, size_t count, size_t client_id); // send to specific client
-		result send(const uint8_t* bytes, size_t count); // send to all clients
+		// non-blocking, messages go through a lock-free queue and wake the service thread
+		// which coalesces them into MTU sized packets per client and delivery mode
+		result send_to(const uint8_t* bytes, size_t count, size_t client_id, delivery mode = delivery::reliable); // send to specific client
+		result send(const uint8_t* bytes, size_t count, delivery mode = delivery::reliable); // send to all clients, fails only if no shard could queue it
 		[[nodiscard]] inline bool running() const noexcept { return m_running; }
+		[[nodiscard]] size_t shard_count() const noexcept;
+		[[nodiscard]] uint16_t shard_port(size_t shard) const;
+		[[nodiscard]] static inline size_t client_shard(size_t client_id) noexcept { return (client_id >> slot_bits) & (max_shards - 1); }
+		[[nodiscard]] size_t client_count() const noexcept;
 		
 		/* contiguous_iterator_tag */
 		template<typename Iterator>
-		inline result send_to(Iterator begin, Iterator end, size_t client_id)
+		inline result send_to(Iterator begin, Iterator end, size_t client_id, delivery mode = delivery::reliable)
 		{
 			if (begin == end) return result{};
-			return send_to(reinterpret_cast<const uint8_t*>(&*begin), std::distance(begin, end) * sizeof(typename std::iterator_traits<Iterator>::value_type), client_id);
+			return send_to(reinterpret_cast<const uint8_t*>(&*begin), std::distance(begin, end) * sizeof(typename std::iterator_traits<Iterator>::value_type), client_id, mode);
 		}
 		/* contiguous_iterator_tag */
 		template<typename Iterator>
-		inline result send(Iterator begin, Iterator end)
+		inline result send(Iterator begin, Iterator end, delivery mode = delivery::reliable)
 		{
 			if (begin == end) return result{};
-			return send(reinterpret_cast<const uint8_t*>(&*begin), std::distance(begin, end) * sizeof(typename std::iterator_traits<Iterator>::value_type));
+			return send(reinterpret_cast<const uint8_t*>(&*begin), std::distance(begin, end) * sizeof(typename std::iterator_traits<Iterator>::value_type), mode);
 		}
 
+		// false sends every message as its own packet (still once per service iteration)
+		// with more than one channel those go out unframed on raw_channel, broadcasts keep the length prefix
+		inline void set_batching(bool batching) noexcept { m_batching = batching; }
+		[[nodiscard]] inline bool get_batching() const noexcept { return m_batching; }
+		// true goes back to blocking in enet_host_service for 50 ms at a time without the poller
+		// sends then wait for the next datagram or the timeout, only there to compare against
+		inline void set_timed_service(bool timed) noexcept { m_timed_service = timed; }
+		[[nodiscard]] statistics stats();
+
+		// these throw std::out_of_range for unknown clients
 		[[nodiscard]] std::string client_address(size_t client_id) const;
 		[[nodiscard]] uint16_t client_port(size_t client_id) const;
 		[[nodiscard]] float client_packet_loss(size_t client_id) const;
+		[[nodiscard]] std::chrono::milliseconds client_round_trip_time(size_t client_id) const; // smoothed by ENet
+
+		// before open(), clients have to use the same mode and dictionary
+		// the dictionary is for compression::lz4, see train_dictionary
+		result set_compression(compression mode, std::vector<uint8_t> dictionary = {});
+		[[nodiscard]] compression get_compression() const noexcept;
+		[[nodiscard]] compression_stats compressor_stats() const;
+		// received from the client only, the send half is in compressor_stats
+		[[nodiscard]] compression_stats client_compressor_stats(size_t client_id);
+		// records uncompressed packets (both directions) for train_dictionary, up to max_bytes
+		// needs a compression mode other than none
+		void capture_traffic(size_t max_bytes);
+		[[nodiscard]] std::vector<std::vector<uint8_t>> captured_traffic();
 
 	};
 
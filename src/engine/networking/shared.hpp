@@ -1,7 +1,9 @@
 #pragma once
 
 #include <gsl/span>
+#include <vector>
 #include "engine/engine.hpp"
+#include "packet.hpp"
 
 
 
@@ -30,6 +32,53 @@ namespace oe::networking
 		inline const std::string& message() const { return m_message; }
 	};
 
+	enum class delivery
+	{
+		reliable,            // resent until acknowledged, in order per channel
+		unreliable,          // may be lost, late packets are dropped
+		unsequenced,         // may be lost, duplicated or arrive in any order
+		unreliable_fragment, // unreliable, but larger than MTU packets are fragmented unreliably too
+	};
+	static constexpr size_t delivery_count = 4;
+
+	// ENet host totals, bytes are counted on the wire (after compression)
+	struct statistics
+	{
+		uint64_t sent_bytes = 0;
+		uint64_t sent_packets = 0;
+		uint64_t received_bytes = 0;
+		uint64_t received_packets = 0;
+		uint64_t retransmits = 0; // reliable packets sent again after their ack timed out
+	};
+
+	// ENetCompressor backends, both ends of a connection have to use the same one
+	enum class compression
+	{
+		none,
+		range_coder, // ENet's adaptive range coder, smaller output, more CPU
+		lz4,         // fast, optionally with a dictionary trained on captured traffic
+	};
+
+	// 'raw' is before compression and 'compressed' on the wire, time is CPU time spent in the compressor
+	struct compression_stats
+	{
+		uint64_t compressed_packets = 0;
+		uint64_t incompressible_packets = 0; // did not get smaller, sent as is
+		uint64_t compress_raw_bytes = 0;
+		uint64_t compress_compressed_bytes = 0;
+		uint64_t compress_ns = 0;
+
+		uint64_t decompressed_packets = 0;
+		uint64_t decompress_failures = 0;
+		uint64_t decompress_compressed_bytes = 0;
+		uint64_t decompress_raw_bytes = 0;
+		uint64_t decompress_ns = 0;
+	};
+
+	// picks the most common byte sequences of captured traffic into a dictionary for compression::lz4
+	// at most 64 KiB, the samples are typically from Server/Client::captured_traffic
+	[[nodiscard]] std::vector<uint8_t> train_dictionary(const std::vector<std::vector<uint8_t>>& samples, size_t size = 16 * 1024);
+
 	
 
 	struct ServerConnectEvent
@@ -42,17 +91,21 @@ namespace oe::networking
 		size_t client_id = 0;
 	};
 
+	// data points into handle, keep a copy of handle to use data after the event
 	struct ServerReceiveEvent
 	{
 		size_t client_id = 0;
 		gsl::span<uint8_t> data;
+		packet handle;
 	};
 
 	struct ClientDisconnectEvent
 	{};
 
+	// data points into handle, keep a copy of handle to use data after the event
 	struct ClientReceiveEvent
 	{
 		gsl::span<uint8_t> data;
+		packet handle;
 	};
 }
\ No newline at end of file
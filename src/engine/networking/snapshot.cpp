@@ -0,0 +1,253 @@
+#include "snapshot.hpp"
+#include "message_batch.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+
+
+namespace oe::networking
+{
+	[[nodiscard]] static inline size_t components_size(uint32_t mask, const std::vector<size_t>& component_sizes) noexcept
+	{
+		size_t size = 0;
+		for (size_t type = 0; type < component_sizes.size(); type++)
+			if (mask & (uint32_t(1) << type))
+				size += component_sizes[type];
+		return size;
+	}
+
+	[[nodiscard]] static inline uint32_t valid_mask(const std::vector<size_t>& component_sizes) noexcept
+	{
+		return component_sizes.size() >= 32 ? ~uint32_t(0) : (uint32_t(1) << component_sizes.size()) - 1;
+	}
+
+
+
+	void snapshot::clear() noexcept
+	{
+		sequence = 0;
+		ids.clear();
+		masks.clear();
+		offsets.clear();
+		data.clear();
+	}
+
+	size_t snapshot::find(uint32_t id) const noexcept
+	{
+		const auto iter = std::lower_bound(ids.begin(), ids.end(), id);
+		if (iter == ids.end() || *iter != id)
+			return npos;
+		return static_cast<size_t>(std::distance(ids.begin(), iter));
+	}
+
+	uint8_t* snapshot::push(uint32_t id, uint32_t mask, const std::vector<size_t>& component_sizes)
+	{
+		const size_t offset = data.size();
+		ids.push_back(id);
+		masks.push_back(mask);
+		offsets.push_back(static_cast<uint32_t>(offset));
+		data.resize(offset + components_size(mask, component_sizes));
+		return data.data() + offset;
+	}
+
+	const uint8_t* snapshot::component(size_t index, size_t type, const std::vector<size_t>& component_sizes) const noexcept
+	{
+		const uint32_t mask = masks[index];
+		if (!(mask & (uint32_t(1) << type)))
+			return nullptr;
+
+		const uint32_t below = mask & ((uint32_t(1) << type) - 1);
+		return data.data() + offsets[index] + components_size(below, component_sizes);
+	}
+
+
+
+	enum record_op : uint8_t { op_remove = 0, op_update = 1 };
+
+	static void write_xor(std::vector<uint8_t>& out, const uint8_t* baseline, const uint8_t* current, size_t size)
+	{
+		const size_t mask_offset = out.size();
+		out.resize(mask_offset + (size + 7) / 8, 0);
+		for (size_t i = 0; i < size; i++)
+		{
+			const uint8_t x = baseline[i] ^ current[i];
+			if (!x)
+				continue;
+			out[mask_offset + i / 8] |= static_cast<uint8_t>(1 << (i % 8));
+			out.push_back(x);
+		}
+	}
+
+	[[nodiscard]] static bool read_xor(const uint8_t* data, size_t size, size_t& offset, const uint8_t* baseline, uint8_t* current, size_t component_size)
+	{
+		const size_t mask_size = (component_size + 7) / 8;
+		if (size - offset < mask_size)
+			return false;
+
+		const uint8_t* mask = data + offset;
+		offset += mask_size;
+		for (size_t i = 0; i < component_size; i++)
+		{
+			current[i] = baseline[i];
+			if (!(mask[i / 8] & (1 << (i % 8))))
+				continue;
+			if (offset >= size)
+				return false;
+			current[i] ^= data[offset++];
+		}
+		return true;
+	}
+
+	void encode_delta(const snapshot& baseline, const snapshot& current, const std::vector<size_t>& component_sizes, std::vector<uint8_t>& out)
+	{
+		uint32_t previous_id = 0;
+		const auto write_header = [&](uint32_t id, record_op op) {
+			write_varint(out, id - previous_id);
+			out.push_back(op);
+			previous_id = id;
+		};
+
+		size_t b = 0, c = 0;
+		while (b < baseline.size() || c < current.size())
+		{
+			// removed since the baseline
+			if (c == current.size() || (b < baseline.size() && baseline.ids[b] < current.ids[c]))
+			{
+				write_header(baseline.ids[b++], op_remove);
+				continue;
+			}
+
+			const uint32_t id = current.ids[c];
+			const uint32_t mask = current.masks[c];
+			const bool in_baseline = b < baseline.size() && baseline.ids[b] == id;
+
+			// changed components, everything if the entity is new
+			uint32_t changed = mask;
+			if (in_baseline)
+			{
+				changed = 0;
+				for (size_t type = 0; type < component_sizes.size(); type++)
+				{
+					const uint8_t* now = current.component(c, type, component_sizes);
+					const uint8_t* then = baseline.component(b, type, component_sizes);
+					if (now && (!then || std::memcmp(now, then, component_sizes[type]) != 0))
+						changed |= uint32_t(1) << type;
+				}
+
+				if (changed == 0 && mask == baseline.masks[b])
+				{
+					b++; c++;
+					continue;
+				}
+			}
+
+			write_header(id, op_update);
+			write_varint(out, mask);
+			write_varint(out, changed);
+			for (size_t type = 0; type < component_sizes.size(); type++)
+			{
+				if (!(changed & (uint32_t(1) << type)))
+					continue;
+
+				const uint8_t* now = current.component(c, type, component_sizes);
+				const uint8_t* then = in_baseline ? baseline.component(b, type, component_sizes) : nullptr;
+				if (then)
+					write_xor(out, then, now, component_sizes[type]);
+				else
+					out.insert(out.end(), now, now + component_sizes[type]);
+			}
+
+			if (in_baseline)
+				b++;
+			c++;
+		}
+	}
+
+	bool decode_delta(const snapshot& baseline, const uint8_t* data, size_t size, const std::vector<size_t>& component_sizes, snapshot& current)
+	{
+		current.clear();
+		const uint32_t valid = valid_mask(component_sizes);
+
+		size_t b = 0;
+		const auto copy_baseline_until = [&](uint64_t id) {
+			for (; b < baseline.size() && baseline.ids[b] < id; b++)
+			{
+				uint8_t* dst = current.push(baseline.ids[b], baseline.masks[b], component_sizes);
+				const size_t count = components_size(baseline.masks[b], component_sizes);
+				std::memcpy(dst, baseline.data.data() + baseline.offsets[b], count);
+			}
+		};
+
+		size_t offset = 0;
+		uint64_t previous_id = 0;
+		bool first = true;
+		while (offset < size)
+		{
+			uint64_t id_delta;
+			if (!read_varint(data, size, offset, id_delta) || (!first && id_delta == 0) || offset >= size)
+				return false;
+			const uint64_t id = previous_id + id_delta;
+			if (id > ~uint32_t(0))
+				return false;
+			previous_id = id;
+			first = false;
+
+			copy_baseline_until(id);
+			const bool in_baseline = b < baseline.size() && baseline.ids[b] == id;
+
+			const uint8_t op = data[offset++];
+			if (op == op_remove)
+			{
+				if (!in_baseline)
+					return false;
+				b++;
+				continue;
+			}
+
+			uint64_t mask, changed;
+			if (op != op_update || !read_varint(data, size, offset, mask) || !read_varint(data, size, offset, changed))
+				return false;
+			if ((mask & ~uint64_t(valid)) || (changed & ~mask))
+				return false;
+
+			uint8_t* dst = current.push(static_cast<uint32_t>(id), static_cast<uint32_t>(mask), component_sizes);
+			for (size_t type = 0; type < component_sizes.size(); type++)
+			{
+				if (!(mask & (uint64_t(1) << type)))
+					continue;
+
+				const size_t component_size = component_sizes[type];
+				const uint8_t* then = in_baseline ? baseline.component(b, type, component_sizes) : nullptr;
+				if (changed & (uint64_t(1) << type))
+				{
+					if (then)
+					{
+						if (!read_xor(data, size, offset, then, dst, component_size))
+							return false;
+					}
+					else
+					{
+						if (size - offset < component_size)
+							return false;
+						std::memcpy(dst, data + offset, component_size);
+						offset += component_size;
+					}
+				}
+				else
+				{
+					if (!then)
+						return false;
+					std::memcpy(dst, then, component_size);
+				}
+				dst += component_size;
+			}
+
+			if (in_baseline)
+				b++;
+		}
+
+		copy_baseline_until(uint64_t(~uint32_t(0)) + 1);
+		return true;
+	}
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+
+
+namespace oe::networking
+{
+	// replicated state of a set of entities at one tick
+	// entities are sorted by network id, each has a presence mask of component types
+	// and the raw bytes of its present components packed back to back in type order
+	struct snapshot
+	{
+		static constexpr size_t npos = ~size_t(0);
+		static constexpr size_t max_components = 32;
+
+		uint32_t sequence = 0; // 0 = empty / no snapshot
+		std::vector<uint32_t> ids;
+		std::vector<uint32_t> masks;
+		std::vector<uint32_t> offsets; // into data, one per entity
+		std::vector<uint8_t> data;
+
+		void clear() noexcept;
+		[[nodiscard]] size_t find(uint32_t id) const noexcept; // index or npos
+		[[nodiscard]] inline size_t size() const noexcept { return ids.size(); }
+
+		// appends an entity, ids must be added in increasing order
+		// returns where its components go, sized for 'mask'
+		uint8_t* push(uint32_t id, uint32_t mask, const std::vector<size_t>& component_sizes);
+		// pointer to the component 'type' of entity 'index', nullptr if not present
+		[[nodiscard]] const uint8_t* component(size_t index, size_t type, const std::vector<size_t>& component_sizes) const noexcept;
+	};
+
+	// delta between two snapshots of the same entity set
+	// unchanged entities are skipped, changed components are XORed against the baseline and bitpacked:
+	// a bitmask of the changed bytes followed by only those bytes
+	// baseline may be empty (sequence 0), everything is sent in full then
+	void encode_delta(const snapshot& baseline, const snapshot& current, const std::vector<size_t>& component_sizes, std::vector<uint8_t>& out);
+	// rebuilds 'current' from the baseline and a delta produced by encode_delta
+	// returns false on malformed data
+	[[nodiscard]] bool decode_delta(const snapshot& baseline, const uint8_t* data, size_t size, const std::vector<size_t>& component_sizes, snapshot& current);
+}
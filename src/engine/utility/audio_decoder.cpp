@@ -0,0 +1,483 @@
+#include "audio_decoder.hpp"
+
+#include "engine/internal_libs.hpp"
+#include "engine/utility/fileio.hpp"
+#include "engine/utility/formatted_error.hpp"
+
+#include <algorithm>
+#include <array>
+#include <climits>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+
+
+// ignore external warnings
+#ifdef __clang__
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wunused-parameter"
+#pragma clang diagnostic ignored "-Wsign-compare"
+#pragma clang diagnostic ignored "-Wunused-value"
+#elif __GNUC__
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+#pragma GCC diagnostic ignored "-Wsign-compare"
+#pragma GCC diagnostic ignored "-Wunused-value"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#pragma GCC diagnostic ignored "-Wimplicit-fallthrough"
+#elif _MSC_VER
+#pragma warning( push )
+#endif
+
+#define MINIMP3_IMPLEMENTATION
+#include <minimp3_ex.h>
+
+// the implementation is in audio.cpp
+#include <miniaudio.h>
+
+// the implementation is at the end
+#define STB_VORBIS_HEADER_ONLY
+#include <stb_vorbis.c>
+
+// ignore external warnings
+#ifdef __clang__
+#pragma clang diagnostic pop
+#elif __GNUC__
+#pragma GCC diagnostic pop
+#elif _MSC_VER
+#pragma warning( pop )
+#endif
+
+
+
+namespace oe::utils
+{
+	class mp3_decoder final : public audio_decoder
+	{
+	private:
+		mapped_file m_file;
+		mp3dec_ex_t m_decoder;
+
+	public:
+		mp3_decoder(gsl::span<const uint8_t> bytes, mapped_file&& file)
+			: m_file(std::move(file))
+		{
+			std::memset(&m_decoder, 0, sizeof(m_decoder));
+			// only scans the frame headers, decoding starts with the first read
+			if (mp3dec_ex_open_buf(&m_decoder, bytes.data(), bytes.size(), MP3D_SEEK_TO_SAMPLE) || m_decoder.info.channels <= 0 || m_decoder.info.hz <= 0)
+			{
+				mp3dec_ex_close(&m_decoder);
+				throw oe::utils::formatted_error("Not a valid mp3 file");
+			}
+		}
+
+		~mp3_decoder() override
+		{
+			mp3dec_ex_close(&m_decoder);
+		}
+
+		int channels() const noexcept override { return m_decoder.info.channels; }
+		int sample_rate() const noexcept override { return m_decoder.info.hz; }
+		uint64_t length() const noexcept override { return m_decoder.samples / static_cast<uint64_t>(channels()); }
+		uint64_t tell() const noexcept override { return m_decoder.cur_sample / static_cast<uint64_t>(channels()); }
+
+		size_t read(int16_t* frames, size_t frame_count) override
+		{
+			return mp3dec_ex_read(&m_decoder, frames, frame_count * static_cast<size_t>(channels())) / static_cast<size_t>(channels());
+		}
+
+		bool seek(uint64_t frame) override
+		{
+			return frame <= length() && mp3dec_ex_seek(&m_decoder, frame * static_cast<uint64_t>(channels())) == 0;
+		}
+	};
+
+	class wav_decoder final : public audio_decoder
+	{
+	private:
+		mapped_file m_file;
+		ma_decoder m_decoder;
+		uint64_t m_length = 0;
+		uint64_t m_position = 0;
+
+	public:
+		wav_decoder(gsl::span<const uint8_t> bytes, mapped_file&& file)
+			: m_file(std::move(file))
+		{
+			// any sample format in the file comes out as int16, at its own rate and channel count
+			const ma_decoder_config config = ma_decoder_config_init(ma_format_s16, 0, 0);
+			if (ma_decoder_init_memory_wav(bytes.data(), bytes.size(), &config, &m_decoder) != MA_SUCCESS)
+				throw oe::utils::formatted_error("Not a valid wav file");
+			m_length = ma_decoder_get_length_in_pcm_frames(&m_decoder);
+		}
+
+		~wav_decoder() override
+		{
+			ma_decoder_uninit(&m_decoder);
+		}
+
+		int channels() const noexcept override { return static_cast<int>(m_decoder.outputChannels); }
+		int sample_rate() const noexcept override { return static_cast<int>(m_decoder.outputSampleRate); }
+		uint64_t length() const noexcept override { return m_length; }
+		uint64_t tell() const noexcept override { return m_position; }
+
+		size_t read(int16_t* frames, size_t frame_count) override
+		{
+			const auto read = static_cast<size_t>(ma_decoder_read_pcm_frames(&m_decoder, frames, frame_count));
+			m_position += read;
+			return read;
+		}
+
+		bool seek(uint64_t frame) override
+		{
+			if (frame > m_length || ma_decoder_seek_to_pcm_frame(&m_decoder, frame) != MA_SUCCESS)
+				return false;
+			m_position = frame;
+			return true;
+		}
+	};
+
+	class ogg_decoder final : public audio_decoder
+	{
+	private:
+		mapped_file m_file;
+		stb_vorbis* m_vorbis = nullptr;
+		stb_vorbis_info m_info;
+		uint64_t m_length = 0;
+		uint64_t m_position = 0;
+
+	public:
+		ogg_decoder(gsl::span<const uint8_t> bytes, mapped_file&& file)
+			: m_file(std::move(file))
+		{
+			if (bytes.size() > static_cast<size_t>(INT_MAX))
+				throw oe::utils::formatted_error("Ogg file too large: {} bytes", bytes.size());
+
+			int error = 0;
+			m_vorbis = stb_vorbis_open_memory(bytes.data(), static_cast<int>(bytes.size()), &error, nullptr);
+			if (!m_vorbis)
+				throw oe::utils::formatted_error("Not a valid ogg vorbis file, stb_vorbis error {}", error);
+			m_info = stb_vorbis_get_info(m_vorbis);
+			// from the last page, not by decoding
+			m_length = stb_vorbis_stream_length_in_samples(m_vorbis);
+		}
+
+		~ogg_decoder() override
+		{
+			stb_vorbis_close(m_vorbis);
+		}
+
+		int channels() const noexcept override { return m_info.channels; }
+		int sample_rate() const noexcept override { return static_cast<int>(m_info.sample_rate); }
+		uint64_t length() const noexcept override { return m_length; }
+		uint64_t tell() const noexcept override { return m_position; }
+
+		size_t read(int16_t* frames, size_t frame_count) override
+		{
+			const size_t channels = static_cast<size_t>(m_info.channels);
+			size_t read = 0;
+			while (read < frame_count)
+			{
+				// one vorbis packet at most per call
+				const size_t samples = std::min((frame_count - read) * channels, static_cast<size_t>(INT_MAX) / channels * channels);
+				const int got = stb_vorbis_get_samples_short_interleaved(m_vorbis, m_info.channels, frames + read * channels, static_cast<int>(samples));
+				if (got <= 0)
+					break;
+				read += static_cast<size_t>(got);
+			}
+			m_position += read;
+			return read;
+		}
+
+		bool seek(uint64_t frame) override
+		{
+			if (frame > m_length || !stb_vorbis_seek(m_vorbis, static_cast<unsigned int>(frame)))
+				return false;
+			m_position = frame;
+			return true;
+		}
+	};
+
+	audio_format audio_decoder::detect(gsl::span<const uint8_t> bytes) noexcept
+	{
+		const auto starts_with = [&](size_t offset, std::string_view magic){
+			return bytes.size() >= offset + magic.size() && std::memcmp(bytes.data() + offset, magic.data(), magic.size()) == 0;
+		};
+
+		if ((starts_with(0, "RIFF") || starts_with(0, "RF64")) && starts_with(8, "WAVE"))
+			return audio_format::wav;
+		if (starts_with(0, "OggS"))
+			return audio_format::ogg;
+		// an id3 tag or the sync word of the first frame
+		if (starts_with(0, "ID3") || (bytes.size() >= 2 && bytes[0] == 0xFF && (bytes[1] & 0xE0) == 0xE0))
+			return audio_format::mp3;
+		return audio_format::unknown;
+	}
+
+	template<typename Decoder>
+	static std::unique_ptr<audio_decoder> make_decoder(gsl::span<const uint8_t> bytes, mapped_file&& file)
+	{
+		return std::make_unique<Decoder>(bytes, std::move(file));
+	}
+
+	static std::unique_ptr<audio_decoder> open_decoder(gsl::span<const uint8_t> bytes, mapped_file&& file)
+	{
+		switch (audio_decoder::detect(bytes))
+		{
+		case audio_format::mp3:
+			return make_decoder<mp3_decoder>(bytes, std::move(file));
+		case audio_format::wav:
+			return make_decoder<wav_decoder>(bytes, std::move(file));
+		case audio_format::ogg:
+			return make_decoder<ogg_decoder>(bytes, std::move(file));
+		default:
+			throw oe::utils::formatted_error("Unknown audio format, expected mp3, wav or ogg");
+		}
+	}
+
+	std::unique_ptr<audio_decoder> audio_decoder::open(gsl::span<const uint8_t> bytes)
+	{
+		return open_decoder(bytes, {});
+	}
+
+	std::unique_ptr<audio_decoder> audio_decoder::open(mapped_file&& file)
+	{
+		// the span stays valid when the mapping is moved into the decoder
+		const auto bytes = file.span();
+		return open_decoder(bytes, std::move(file));
+	}
+
+	std::unique_ptr<audio_decoder> audio_decoder::open(const FileIO& path)
+	{
+		try
+		{
+			return open(path.map());
+		}
+		catch (const std::exception& e)
+		{
+			throw oe::utils::formatted_error("Failed to open audiofile \"{}\": {}", path.getPath().generic_string(), e.what());
+		}
+	}
+
+	std::unique_ptr<decode_ahead> audio_decoder::open_ahead(const FileIO& path, size_t buffer_frames)
+	{
+		return std::make_unique<decode_ahead>(open(path), buffer_frames);
+	}
+
+
+
+	// the one thread decoding ahead for every decode_ahead
+	class decode_worker
+	{
+	private:
+		using state_ptr = std::shared_ptr<detail::decode_ahead_state>;
+		static constexpr size_t chunk_frames = 4096;
+
+		std::mutex m_mtx;
+		std::vector<state_ptr> m_states;
+		bool m_added = false;
+		event_count m_wake;
+
+	public:
+		static decode_worker& get()
+		{
+			// never destroyed, a decode_ahead in a static may outlive it
+			static decode_worker* singleton = new decode_worker();
+			return *singleton;
+		}
+
+		void add(state_ptr state)
+		{
+			{
+				std::scoped_lock lock(m_mtx);
+				m_states.push_back(std::move(state));
+				m_added = true;
+			}
+			m_wake.notify();
+		}
+
+		inline void wake() noexcept { m_wake.notify(); }
+
+		// a ring less than half full, or a closed one to drop
+		[[nodiscard]] static bool wants_work(const detail::decode_ahead_state& state) noexcept
+		{
+			return state.closed.load(std::memory_order_relaxed) || (!state.ended.load(std::memory_order_relaxed) && state.ring.size() * 2 < state.ring.capacity());
+		}
+
+	private:
+		decode_worker()
+		{
+			std::thread(&decode_worker::work, this).detach();
+		}
+
+		void work()
+		{
+			std::vector<state_ptr> states;
+			std::vector<int16_t> buffer;
+			while (true)
+			{
+				{
+					std::scoped_lock lock(m_mtx);
+					m_states.erase(std::remove_if(m_states.begin(), m_states.end(), [](const state_ptr& state){ return state->closed.load(std::memory_order_relaxed); }), m_states.end());
+					states = m_states;
+					m_added = false;
+				}
+
+				for (const auto& state : states)
+					fill(*state, buffer);
+				states.clear();
+
+				m_wake.wait([this](){
+					std::scoped_lock lock(m_mtx);
+					return m_added || std::any_of(m_states.begin(), m_states.end(), [](const state_ptr& state){ return wants_work(*state); });
+				});
+			}
+		}
+
+		static void fill(detail::decode_ahead_state& state, std::vector<int16_t>& buffer)
+		{
+			while (!state.closed.load(std::memory_order_relaxed))
+			{
+				// seek() takes the decoder between chunks
+				std::scoped_lock lock(state.decoder_mtx);
+				if (state.ended.load(std::memory_order_relaxed))
+					return;
+
+				// the only producer, so this much will fit
+				const size_t count = std::min((state.ring.capacity() - state.ring.size()) / state.channels, chunk_frames);
+				if (count == 0)
+					return;
+
+				size_t read = 0;
+				buffer.resize(count * state.channels);
+				try
+				{
+					read = state.decoder->read(buffer.data(), count);
+				}
+				catch (const std::exception& e)
+				{
+					spdlog::warn("Decoding ahead failed: {}", e.what());
+				}
+
+				(void)state.ring.try_push(buffer.begin(), buffer.begin() + static_cast<std::ptrdiff_t>(read * state.channels));
+				if (read < count)
+					state.ended.store(true, std::memory_order_release);
+				state.readable.notify();
+			}
+		}
+	};
+
+	namespace detail
+	{
+		decode_ahead_state::decode_ahead_state(std::unique_ptr<audio_decoder>&& _decoder, size_t buffer_frames)
+			: decoder(std::move(_decoder))
+			, ring(std::max<size_t>(buffer_frames, 1024) * static_cast<size_t>(decoder->channels()))
+			, channels(static_cast<size_t>(decoder->channels()))
+			, position(decoder->tell())
+		{}
+	}
+
+	decode_ahead::decode_ahead(std::unique_ptr<audio_decoder>&& decoder, size_t buffer_frames)
+		: m_channels(decoder ? decoder->channels() : 0)
+		, m_sample_rate(decoder ? decoder->sample_rate() : 0)
+		, m_length(decoder ? decoder->length() : 0)
+	{
+		if (!decoder || m_channels <= 0)
+			throw oe::utils::formatted_error("Nothing to decode ahead");
+
+		m_state = std::make_shared<detail::decode_ahead_state>(std::move(decoder), buffer_frames);
+		decode_worker::get().add(m_state);
+	}
+
+	decode_ahead::~decode_ahead()
+	{
+		m_state->closed = true;
+		decode_worker::get().wake();
+	}
+
+	size_t decode_ahead::try_read(int16_t* frames, size_t frame_count)
+	{
+		auto& state = *m_state;
+		const size_t read = state.ring.try_pop(frames, frame_count * state.channels) / state.channels;
+		state.position.fetch_add(read, std::memory_order_relaxed);
+		if (read && decode_worker::wants_work(state))
+			decode_worker::get().wake();
+		return read;
+	}
+
+	size_t decode_ahead::read(int16_t* frames, size_t frame_count)
+	{
+		auto& state = *m_state;
+		size_t read = 0;
+		while (true)
+		{
+			// ended first, then whatever is left in the ring is the last of it
+			const bool ended = state.ended.load(std::memory_order_acquire);
+			read += try_read(frames + read * state.channels, frame_count - read);
+			if (read == frame_count || (ended && state.ring.empty()))
+				return read;
+
+			state.readable.wait([&state](){ return !state.ring.empty() || state.ended.load(std::memory_order_acquire); });
+		}
+	}
+
+	bool decode_ahead::seek(uint64_t frame)
+	{
+		auto& state = *m_state;
+		bool sought;
+		{
+			// the worker can't push while this holds the decoder, and this is the only consumer
+			std::scoped_lock lock(state.decoder_mtx);
+			std::array<int16_t, 4096> discarded;
+			while (state.ring.try_pop(discarded.begin(), discarded.size()) != 0) {}
+
+			sought = state.decoder->seek(frame);
+			state.position = state.decoder->tell();
+			state.ended = false;
+		}
+		decode_worker::get().wake();
+		return sought;
+	}
+
+	size_t decode_ahead::buffered() const noexcept
+	{
+		return m_state->ring.size() / m_state->channels;
+	}
+
+	bool decode_ahead::ended() const noexcept
+	{
+		return m_state->ended.load(std::memory_order_acquire) && m_state->ring.empty();
+	}
+}
+
+
+
+// ignore external warnings
+#ifdef __clang__
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wunused-parameter"
+#pragma clang diagnostic ignored "-Wsign-compare"
+#pragma clang diagnostic ignored "-Wunused-value"
+#elif __GNUC__
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+#pragma GCC diagnostic ignored "-Wsign-compare"
+#pragma GCC diagnostic ignored "-Wunused-value"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#pragma GCC diagnostic ignored "-Wimplicit-fallthrough"
+#elif _MSC_VER
+#pragma warning( push )
+#endif
+
+#undef STB_VORBIS_HEADER_ONLY
+#include <stb_vorbis.c>
+
+// ignore external warnings
+#ifdef __clang__
+#pragma clang diagnostic pop
+#elif __GNUC__
+#pragma GCC diagnostic pop
+#elif _MSC_VER
+#pragma warning( pop )
+#endif
@@ -0,0 +1,122 @@
+#pragma once
+
+#include "engine/utility/event_count.hpp"
+#include "engine/utility/mapped_file.hpp"
+#include "engine/utility/spsc_queue.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+
+
+/*
+
+	Audio files decoded a chunk at a time instead of all at once
+
+		auto decoder = oe::utils::audio_decoder::open("res/music.ogg");
+		std::vector<int16_t> chunk(4096 * decoder->channels());
+		while (size_t frames = decoder->read(chunk.data(), 4096))
+			use(chunk.data(), frames);
+		decoder->seek(decoder->sample_rate() * 30); // 30 s in
+
+	or with a worker thread keeping 'buffer_frames' decoded ahead:
+		auto music = oe::utils::audio_decoder::open_ahead("res/music.mp3");
+		music->try_read(chunk.data(), 4096); // what is decoded already, never waits
+
+	mp3 (minimp3), wav (dr_wav in miniaudio) and ogg vorbis (stb_vorbis), told apart by their first bytes
+
+*/
+
+namespace oe::utils
+{
+	class FileIO;
+	class decode_ahead;
+
+	enum class audio_format : uint8_t
+	{
+		unknown, mp3, wav, ogg
+	};
+
+	class audio_decoder
+	{
+	public:
+		static constexpr size_t default_ahead_frames = 48000; // about a second
+
+		virtual ~audio_decoder() = default;
+
+		[[nodiscard]] virtual int channels() const noexcept = 0;
+		[[nodiscard]] virtual int sample_rate() const noexcept = 0;
+		// in frames, 0 if unknown
+		[[nodiscard]] virtual uint64_t length() const noexcept = 0;
+		// the next frame read() gives
+		[[nodiscard]] virtual uint64_t tell() const noexcept = 0;
+
+		// frame_count interleaved frames, fewer only at the end
+		virtual size_t read(int16_t* frames, size_t frame_count) = 0;
+		// false if the frame is past the end or the format can't seek
+		virtual bool seek(uint64_t frame) = 0;
+
+		// throws if the format isn't recognized or the file is broken
+		// the bytes have to stay valid for as long as the decoder lives
+		[[nodiscard]] static std::unique_ptr<audio_decoder> open(gsl::span<const uint8_t> bytes);
+		// keeps the mapping
+		[[nodiscard]] static std::unique_ptr<audio_decoder> open(mapped_file&& file);
+		[[nodiscard]] static std::unique_ptr<audio_decoder> open(const FileIO& path);
+		// open() behind a decode_ahead
+		[[nodiscard]] static std::unique_ptr<decode_ahead> open_ahead(const FileIO& path, size_t buffer_frames = default_ahead_frames);
+
+		[[nodiscard]] static audio_format detect(gsl::span<const uint8_t> bytes) noexcept;
+	};
+
+	namespace detail
+	{
+		struct decode_ahead_state
+		{
+			std::mutex decoder_mtx; // the worker while decoding a chunk, seek()
+			std::unique_ptr<audio_decoder> decoder;
+			spsc_queue<int16_t> ring; // whole frames only
+			const size_t channels;
+			std::atomic<bool> ended{ false };
+			std::atomic<bool> closed{ false };
+			std::atomic<uint64_t> position{ 0 }; // the next frame read() gives
+			event_count readable;
+
+			decode_ahead_state(std::unique_ptr<audio_decoder>&& _decoder, size_t buffer_frames);
+		};
+	}
+
+	// another decoder decoded ahead on a shared worker thread, at most buffer_frames at a time
+	// one thread at a time may read and seek
+	class decode_ahead : public audio_decoder
+	{
+	private:
+		std::shared_ptr<detail::decode_ahead_state> m_state;
+		int m_channels;
+		int m_sample_rate;
+		uint64_t m_length;
+
+	public:
+		explicit decode_ahead(std::unique_ptr<audio_decoder>&& decoder, size_t buffer_frames = default_ahead_frames);
+		decode_ahead(const decode_ahead&) = delete;
+		~decode_ahead() override;
+
+		[[nodiscard]] int channels() const noexcept override { return m_channels; }
+		[[nodiscard]] int sample_rate() const noexcept override { return m_sample_rate; }
+		[[nodiscard]] uint64_t length() const noexcept override { return m_length; }
+		[[nodiscard]] uint64_t tell() const noexcept override { return m_state->position.load(std::memory_order_relaxed); }
+
+		// waits for the worker if it hasn't decoded that far yet
+		size_t read(int16_t* frames, size_t frame_count) override;
+		// never waits, fewer than frame_count if the worker is behind
+		size_t try_read(int16_t* frames, size_t frame_count);
+		// drops what was decoded ahead
+		bool seek(uint64_t frame) override;
+
+		// decoded and waiting
+		[[nodiscard]] size_t buffered() const noexcept;
+		// nothing left to read
+		[[nodiscard]] bool ended() const noexcept;
+	};
+}
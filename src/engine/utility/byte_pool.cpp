@@ -0,0 +1,191 @@
+#include "byte_pool.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+
+
+namespace oe::utils
+{
+	byte_pool& byte_pool::get()
+	{
+		// never destroyed, images in other statics may outlive it
+		static byte_pool* singleton = new byte_pool();
+		return *singleton;
+	}
+
+	byte_pool::~byte_pool()
+	{
+		trim();
+	}
+
+	size_t byte_pool::class_of(size_t size) noexcept
+	{
+		size_t index = 0;
+		size_t capacity = min_block_size;
+		for (; capacity < size && index < power_class_count - 1; capacity <<= 1)
+			index++;
+		if (size <= capacity)
+			return index;
+
+		// quarters of the power of two above capacity
+		for (index = power_class_count; index < class_count; index++)
+			if (size <= capacity_of(index))
+				return index;
+		return class_count; // too large to pool
+	}
+
+	size_t byte_pool::capacity_of(size_t index) noexcept
+	{
+		if (index < power_class_count)
+			return min_block_size << index;
+
+		const size_t octave = max_power_class_size << ((index - power_class_count) / 4);
+		const size_t quarters = (index - power_class_count) % 4 + 1;
+		return octave + octave / 4 * quarters;
+	}
+
+	void* byte_pool::allocate(size_t size)
+	{
+		const size_t index = class_of(size);
+		header* block = nullptr;
+		if (index < class_count)
+		{
+			size_class& pool_class = m_classes[index];
+			std::scoped_lock lock(pool_class.mtx);
+			if (!pool_class.free_blocks.empty())
+			{
+				block = pool_class.free_blocks.back();
+				pool_class.free_blocks.pop_back();
+			}
+		}
+
+		if (block)
+		{
+			m_bytes_retained -= block->capacity;
+			m_reused++;
+		}
+		else
+		{
+			const size_t capacity = index < class_count ? capacity_of(index) : size;
+			block = static_cast<header*>(std::malloc(sizeof(header) + capacity));
+			if (!block)
+				throw std::bad_alloc();
+			block->capacity = capacity;
+		}
+
+		block->size = size;
+		m_allocations++;
+		m_bytes_allocated += size;
+		m_bytes_in_use += block->capacity;
+		m_frame_allocations++;
+		m_frame_bytes += size;
+		return block + 1;
+	}
+
+	void* byte_pool::reallocate(void* ptr, size_t size)
+	{
+		if (!ptr)
+			return allocate(size);
+
+		header* block = static_cast<header*>(ptr) - 1;
+		if (size <= block->capacity)
+		{
+			block->size = size;
+			return ptr;
+		}
+
+		void* grown = allocate(size);
+		std::memcpy(grown, ptr, block->size);
+		free(ptr);
+		return grown;
+	}
+
+	void byte_pool::free(void* ptr) noexcept
+	{
+		if (!ptr)
+			return;
+
+		header* block = static_cast<header*>(ptr) - 1;
+		m_bytes_in_use -= block->capacity;
+
+		const size_t index = class_of(block->capacity);
+		if (index >= class_count)
+		{
+			std::free(block);
+			return;
+		}
+
+		// reserve the bytes first, concurrent frees can not both squeeze under the limit
+		const size_t limit = m_retain_limit;
+		size_t retained = m_bytes_retained.load(std::memory_order_relaxed);
+		do
+		{
+			if (retained + block->capacity > limit)
+			{
+				std::free(block);
+				return;
+			}
+		} while (!m_bytes_retained.compare_exchange_weak(retained, retained + block->capacity, std::memory_order_relaxed));
+
+		size_class& pool_class = m_classes[index];
+		std::scoped_lock lock(pool_class.mtx);
+		try
+		{
+			pool_class.free_blocks.push_back(block);
+		}
+		catch (const std::bad_alloc&)
+		{
+			// no room to remember it, given back instead of terminating in a free hook
+			m_bytes_retained -= block->capacity;
+			std::free(block);
+		}
+	}
+
+	size_t byte_pool::size_of(const void* ptr) noexcept
+	{
+		return ptr ? (static_cast<const header*>(ptr) - 1)->size : 0;
+	}
+
+	void byte_pool::next_frame() noexcept
+	{
+		m_last_frame_allocations = m_frame_allocations.exchange(0);
+		m_last_frame_bytes = m_frame_bytes.exchange(0);
+	}
+
+	void byte_pool::trim() noexcept
+	{
+		for (size_class& pool_class : m_classes)
+		{
+			std::scoped_lock lock(pool_class.mtx);
+			for (header* block : pool_class.free_blocks)
+			{
+				m_bytes_retained -= block->capacity;
+				std::free(block);
+			}
+			pool_class.free_blocks.clear();
+			pool_class.free_blocks.shrink_to_fit();
+		}
+	}
+
+	void byte_pool::set_retain_limit(size_t bytes) noexcept
+	{
+		m_retain_limit = bytes;
+		if (m_bytes_retained > bytes)
+			trim();
+	}
+
+	byte_pool_stats byte_pool::stats() const noexcept
+	{
+		byte_pool_stats stats;
+		stats.allocations = m_allocations;
+		stats.reused = m_reused;
+		stats.bytes_allocated = m_bytes_allocated;
+		stats.bytes_in_use = m_bytes_in_use;
+		stats.bytes_retained = m_bytes_retained;
+		stats.frame_allocations = m_last_frame_allocations;
+		stats.frame_bytes = m_last_frame_bytes;
+		return stats;
+	}
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+
+
+namespace oe::utils
+{
+	struct byte_pool_stats
+	{
+		size_t allocations = 0;    // everything since the start
+		size_t reused = 0;         // of those, served from a recycled block
+		size_t bytes_allocated = 0;
+		size_t bytes_in_use = 0;   // block capacities, not the requested sizes
+		size_t bytes_retained = 0; // freed blocks kept for reuse
+
+		// the last finished frame, see next_frame
+		size_t frame_allocations = 0;
+		size_t frame_bytes = 0;
+	};
+
+	// pixel and glyph buffers: stb_image, stb_truetype and image_data allocate from here
+	// blocks come in power of two size classes up to 1 MiB and in quarter steps (1.25, 1.5, 1.75, 2x) above that,
+	// so a large image wastes at most a fifth of its block
+	// freed blocks are kept for the next allocation of the same class,
+	// nothing is zero filled and reallocate grows in place while the block has room
+	// thread safe, one lock per size class
+	class byte_pool
+	{
+	public:
+		static constexpr size_t min_block_size = 64;
+		static constexpr size_t power_class_count = 15; // 64 B - 1 MiB
+		static constexpr size_t max_power_class_size = min_block_size << (power_class_count - 1);
+		static constexpr size_t quarter_class_count = 7 * 4; // 1.25 MiB - 128 MiB
+		static constexpr size_t class_count = power_class_count + quarter_class_count; // larger ones go straight to the system
+		static constexpr size_t default_retain_limit = 256 * 1024 * 1024;
+
+	private:
+		// in front of every block, keeps the block aligned like malloc
+		struct alignas(std::max_align_t) header
+		{
+			size_t capacity; // usable bytes after the header
+			size_t size;     // last requested size
+		};
+
+		struct size_class
+		{
+			std::mutex mtx;
+			std::vector<header*> free_blocks;
+		};
+
+		std::array<size_class, class_count> m_classes;
+		std::atomic<size_t> m_retain_limit{ default_retain_limit };
+
+		std::atomic<size_t> m_allocations{ 0 };
+		std::atomic<size_t> m_reused{ 0 };
+		std::atomic<size_t> m_bytes_allocated{ 0 };
+		std::atomic<size_t> m_bytes_in_use{ 0 };
+		std::atomic<size_t> m_bytes_retained{ 0 };
+
+		std::atomic<size_t> m_frame_allocations{ 0 };
+		std::atomic<size_t> m_frame_bytes{ 0 };
+		std::atomic<size_t> m_last_frame_allocations{ 0 };
+		std::atomic<size_t> m_last_frame_bytes{ 0 };
+
+	public:
+		static byte_pool& get();
+
+		byte_pool() = default;
+		byte_pool(const byte_pool&) = delete;
+		~byte_pool();
+
+		// uninitialized, never nullptr, throws std::bad_alloc
+		[[nodiscard]] void* allocate(size_t size);
+		// keeps the first min(old size, size) bytes, nullptr allocates
+		[[nodiscard]] void* reallocate(void* ptr, size_t size);
+		// nullptr is ignored
+		void free(void* ptr) noexcept;
+
+		// the size ptr was last (re)allocated with
+		[[nodiscard]] static size_t size_of(const void* ptr) noexcept;
+
+		// ends the frame for the frame_* stats, GameLoop calls it after every frame
+		void next_frame() noexcept;
+		// gives every retained block back to the system
+		void trim() noexcept;
+		// freed blocks over this are given back to the system right away
+		void set_retain_limit(size_t bytes) noexcept;
+
+		[[nodiscard]] byte_pool_stats stats() const noexcept;
+
+	private:
+		static size_t class_of(size_t size) noexcept;
+		static size_t capacity_of(size_t index) noexcept;
+		void release(header* block) noexcept;
+	};
+}
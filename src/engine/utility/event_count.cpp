@@ -0,0 +1,89 @@
+#include "event_count.hpp"
+
+#include <algorithm>
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <ctime>
+#include <cerrno>
+#include <climits>
+#elif defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <mutex>
+#include <condition_variable>
+#endif
+
+
+
+namespace oe::utils
+{
+#if defined(__linux__)
+	bool atomic_wait(std::atomic<uint32_t>& word, uint32_t expected, std::optional<std::chrono::nanoseconds> timeout)
+	{
+		static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "futex needs a plain 32 bit word");
+
+		timespec ts{};
+		timespec* ts_ptr = nullptr;
+		if (timeout)
+		{
+			const auto ns = std::max(timeout->count(), std::chrono::nanoseconds::rep{ 0 });
+			ts.tv_sec = static_cast<time_t>(ns / 1'000'000'000);
+			ts.tv_nsec = static_cast<long>(ns % 1'000'000'000);
+			ts_ptr = &ts;
+		}
+
+		const long result = syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT_PRIVATE, expected, ts_ptr, nullptr, 0);
+		return !(result == -1 && errno == ETIMEDOUT);
+	}
+
+	void atomic_notify_all(std::atomic<uint32_t>& word)
+	{
+		syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+	}
+#elif defined(_WIN32)
+	bool atomic_wait(std::atomic<uint32_t>& word, uint32_t expected, std::optional<std::chrono::nanoseconds> timeout)
+	{
+		DWORD ms = INFINITE;
+		if (timeout)
+			ms = static_cast<DWORD>(std::chrono::ceil<std::chrono::milliseconds>(std::max(*timeout, std::chrono::nanoseconds::zero())).count());
+
+		if (WaitOnAddress(reinterpret_cast<volatile VOID*>(&word), &expected, sizeof(uint32_t), ms))
+			return true;
+		return GetLastError() != ERROR_TIMEOUT;
+	}
+
+	void atomic_notify_all(std::atomic<uint32_t>& word)
+	{
+		WakeByAddressAll(reinterpret_cast<PVOID>(&word));
+	}
+#else
+	// shared by every waiter, only used on platforms without an address wait
+	static std::mutex fallback_mutex;
+	static std::condition_variable fallback_cv;
+
+	bool atomic_wait(std::atomic<uint32_t>& word, uint32_t expected, std::optional<std::chrono::nanoseconds> timeout)
+	{
+		std::unique_lock lock(fallback_mutex);
+		auto changed = [&](){ return word.load(std::memory_order_acquire) != expected; };
+		if (!timeout)
+		{
+			fallback_cv.wait(lock, changed);
+			return true;
+		}
+		return fallback_cv.wait_for(lock, *timeout, changed);
+	}
+
+	void atomic_notify_all(std::atomic<uint32_t>& /* word */)
+	{
+		{
+			std::scoped_lock lock(fallback_mutex);
+		}
+		fallback_cv.notify_all();
+	}
+#endif
+}
\ No newline at end of file
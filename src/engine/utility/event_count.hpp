@@ -0,0 +1,102 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <thread>
+
+
+
+namespace oe::utils
+{
+	// futex (linux) / WaitOnAddress (windows) on a 32 bit atomic
+	// falls back to a condition variable elsewhere
+	// returns false on timeout, spurious wakeups are possible
+	bool atomic_wait(std::atomic<uint32_t>& word, uint32_t expected, std::optional<std::chrono::nanoseconds> timeout = std::nullopt);
+	void atomic_notify_all(std::atomic<uint32_t>& word);
+
+	// event_count: lets lock-free structures block without a mutex
+	// notify() is a single fence when nobody is waiting
+	class event_count
+	{
+	private:
+		std::atomic<uint32_t> m_epoch{ 0 };
+		std::atomic<uint32_t> m_waiters{ 0 };
+
+	public:
+		// call after publishing the state that ready() checks
+		inline void notify() noexcept
+		{
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			if (m_waiters.load(std::memory_order_relaxed) == 0)
+				return;
+
+			m_epoch.fetch_add(1, std::memory_order_release);
+			atomic_notify_all(m_epoch);
+		}
+
+		template<typename Pred>
+		inline void wait(Pred&& ready)
+		{
+			if (spin(ready))
+				return;
+
+			while (!ready())
+			{
+				const uint32_t epoch = prepare_wait();
+				if (!ready())
+					atomic_wait(m_epoch, epoch);
+				m_waiters.fetch_sub(1, std::memory_order_relaxed);
+			}
+		}
+
+		template<typename Pred, typename Clock, typename Duration>
+		inline bool wait_until(Pred&& ready, const std::chrono::time_point<Clock, Duration>& atime)
+		{
+			if (spin(ready))
+				return true;
+
+			while (!ready())
+			{
+				const auto now = Clock::now();
+				if (now >= atime)
+					return false;
+
+				const uint32_t epoch = prepare_wait();
+				if (!ready())
+					atomic_wait(m_epoch, epoch, std::chrono::duration_cast<std::chrono::nanoseconds>(atime - now));
+				m_waiters.fetch_sub(1, std::memory_order_relaxed);
+			}
+			return true;
+		}
+
+		template<typename Pred, typename Rep, typename Period>
+		inline bool wait_for(Pred&& ready, const std::chrono::duration<Rep, Period>& duration)
+		{
+			return wait_until(std::forward<Pred>(ready), std::chrono::steady_clock::now() + duration);
+		}
+
+	private:
+		// most waits are short, yield a few times before going to sleep
+		template<typename Pred>
+		static inline bool spin(Pred& ready)
+		{
+			for (size_t i = 0; i < 16; i++)
+			{
+				if (ready())
+					return true;
+				std::this_thread::yield();
+			}
+			return false;
+		}
+
+		inline uint32_t prepare_wait() noexcept
+		{
+			// pairs with the fence in notify()
+			m_waiters.fetch_add(1, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			return m_epoch.load(std::memory_order_acquire);
+		}
+	};
+}
\ No newline at end of file
@@ -1,13 +1,19 @@
 #include "fileio.hpp"
 
+#include <algorithm>
+#include <climits>
+#include <cstring>
 #include <fstream>
 #include <iostream>
 #include <string>
 #include <sstream>
+#include <thread>
 
 #include "engine/internal_libs.hpp"
 #include "engine/utility/formatted_error.hpp"
 #include "engine/utility/font_file.hpp"
+#include "engine/utility/byte_pool.hpp"
+#include "engine/utility/audio_decoder.hpp"
 #include "engine/engine.hpp"
 #include "engine/asset/fonts.hpp"
 
@@ -25,31 +31,21 @@
 // #include <miniz/miniz_zip.h>
 #include <zip.h>
 
-static void* stbi_realloc_impl(void* ptr, size_t oldsize, size_t newsize)
-{
-	uint8_t* data = new uint8_t[newsize]{};
-	if(ptr != nullptr)
-	{
-		memcpy(data, ptr, oldsize);
-		delete[] reinterpret_cast<uint8_t*>(ptr);
-	}
-	return data;
-}
+// decoded images end up owned by image_data, which gives them back to the same pool
+// the pool knows every block's size, so the unsized realloc the gif loader uses is fine too
+#define STBI_MALLOC(size)                            (oe::utils::byte_pool::get().allocate(size))
+#define STBI_REALLOC(ptr, newsize)                   (oe::utils::byte_pool::get().reallocate(ptr, newsize))
+#define STBI_FREE(ptr)                               (oe::utils::byte_pool::get().free(ptr))
 
-#define STBI_MALLOC(size)                            (new uint8_t[size]{})
-#define STBI_REALLOC_SIZED(ptr, oldsize, newsize)    (stbi_realloc_impl(ptr, oldsize, newsize))
-#define STBI_FREE(ptr)                               (delete[] reinterpret_cast<uint8_t*>(ptr))
-// gif loader bug workaround
-#define STBI_REALLOC(ptr, newsize)                   (STBI_REALLOC_SIZED(ptr, 0, newsize))
+#define STBIW_MALLOC(size)                           (oe::utils::byte_pool::get().allocate(size))
+#define STBIW_REALLOC(ptr, newsize)                  (oe::utils::byte_pool::get().reallocate(ptr, newsize))
+#define STBIW_FREE(ptr)                              (oe::utils::byte_pool::get().free(ptr))
 
 #define STB_IMAGE_IMPLEMENTATION
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #include <stb_image.h>
 #include <stb_image_write.h>
 
-#define MINIMP3_IMPLEMENTATION
-#include <minimp3_ex.h>
-
 // ignore external warnings
 #ifdef __clang__
 #pragma clang diagnostic pop
@@ -93,7 +89,7 @@ namespace oe::utils
 	{
 		if(_format == oe::formats::none)
 			std::runtime_error(invalid_format.data());
-		data = new uint8_t[size];
+		data = static_cast<uint8_t*>(byte_pool::get().allocate(size));
 	}
 
 	image_data::image_data(fs::path path, oe::formats _format)
@@ -134,14 +130,14 @@ namespace oe::utils
 		if(_format == oe::formats::none)
 			std::runtime_error(invalid_format.data());
 
-		data = new uint8_t[size];
+		data = static_cast<uint8_t*>(byte_pool::get().allocate(size));
 		std::memcpy(data, _data, size);
 	}
 
 	image_data::image_data(const image_data_base& _copied)
 		: image_data_base(nullptr, _copied.format, _copied.width, _copied.height)
 	{
-		data = new uint8_t[size];
+		data = static_cast<uint8_t*>(byte_pool::get().allocate(size));
 		std::memcpy(data, _copied.data, size);
 	}
 
@@ -156,8 +152,7 @@ namespace oe::utils
 
 	image_data::~image_data()
 	{
-		if(data)
-			delete[] data;
+		byte_pool::get().free(data);
 	}
 	
 	image_data& image_data::operator=(const image_data_base& copy_assign)
@@ -167,7 +162,7 @@ namespace oe::utils
 		format = copy_assign.format;
 		width = copy_assign.width; height = copy_assign.height;
 		size = copy_assign.size;
-		data = new uint8_t[size];
+		data = static_cast<uint8_t*>(byte_pool::get().allocate(size));
 		std::memcpy(data, copy_assign.data, size);
 
 		return *this;
@@ -190,72 +185,274 @@ namespace oe::utils
 		return *this;
 	}
 
-	image_data image_data_base::cast(oe::formats new_format, int new_width, int new_height) const
+	// cast() kernels, one instantiation per format pair and filter so nothing is decided per pixel
+	// plain fixed-width byte loops, the compiler vectorizes them on every target (including wasm)
+	namespace image_kernels
+	{
+		// same rules as to_rgba, to_rgb and to_mono
+		template<int From, int To>
+		inline void convert(const uint8_t* src, uint8_t* dst) noexcept
+		{
+			if constexpr (From == To)
+			{
+				for (int c = 0; c < To; c++)
+					dst[c] = src[c];
+			}
+			else if constexpr (To == 4)
+			{
+				dst[0] = src[0];
+				dst[1] = src[From == 1 ? 0 : 1];
+				dst[2] = src[From == 1 ? 0 : 2];
+				dst[3] = 255;
+			}
+			else if constexpr (To == 3)
+			{
+				if constexpr (From == 4)
+				{
+					dst[0] = oe::utils::mul_u8(src[0], src[3]);
+					dst[1] = oe::utils::mul_u8(src[1], src[3]);
+					dst[2] = oe::utils::mul_u8(src[2], src[3]);
+				}
+				else
+				{
+					dst[0] = dst[1] = dst[2] = src[0];
+				}
+			}
+			else // To == 1
+			{
+				if constexpr (From == 4)
+					dst[0] = oe::utils::mul_u8(oe::utils::luma(src[0], src[1], src[2]), src[3]);
+				else
+					dst[0] = oe::utils::luma(src[0], src[1], src[2]);
+			}
+		}
+
+		struct image_view
+		{
+			const uint8_t* data;
+			int width, height;
+		};
+
+		// same size, only the format changes
+		template<int From, int To>
+		void convert_rows(const image_view& src, uint8_t* dst, int first_row, int last_row) noexcept
+		{
+			const size_t pixels = static_cast<size_t>(last_row - first_row) * static_cast<size_t>(src.width);
+			const uint8_t* in = src.data + static_cast<size_t>(first_row) * src.width * From;
+			uint8_t* out = dst + static_cast<size_t>(first_row) * src.width * To;
+			if constexpr (From == To)
+			{
+				std::memcpy(out, in, pixels * To);
+				return;
+			}
+			for (size_t i = 0; i < pixels; i++)
+				convert<From, To>(in + i * From, out + i * To);
+		}
+
+		// the source pixel under each new one, like the original per pixel cast
+		template<int From, int To>
+		void nearest_rows(const image_view& src, uint8_t* dst, int dst_width, int dst_height, int first_row, int last_row)
+		{
+			const float ratio_x = static_cast<float>(src.width) / static_cast<float>(dst_width);
+			const float ratio_y = static_cast<float>(src.height) / static_cast<float>(dst_height);
+			std::vector<size_t> columns(dst_width);
+			for (int x = 0; x < dst_width; x++)
+				columns[x] = static_cast<size_t>(std::min(static_cast<int>(x * ratio_x), src.width - 1)) * From;
+
+			for (int y = first_row; y < last_row; y++)
+			{
+				const uint8_t* in = src.data + static_cast<size_t>(std::min(static_cast<int>(y * ratio_y), src.height - 1)) * src.width * From;
+				uint8_t* out = dst + static_cast<size_t>(y) * dst_width * To;
+				for (int x = 0; x < dst_width; x++)
+					convert<From, To>(in + columns[x], out + static_cast<size_t>(x) * To);
+			}
+		}
+
+		// sample positions and 8 bit weights between two neighbouring source pixels, pixel centers aligned
+		struct bilinear_tap
+		{
+			int first, second;
+			uint32_t weight; // of the second, 0-256
+		};
+
+		inline std::vector<bilinear_tap> bilinear_taps(int src_size, int dst_size)
+		{
+			std::vector<bilinear_tap> taps(dst_size);
+			const float ratio = static_cast<float>(src_size) / static_cast<float>(dst_size);
+			for (int i = 0; i < dst_size; i++)
+			{
+				const float position = std::clamp((i + 0.5f) * ratio - 0.5f, 0.0f, static_cast<float>(src_size - 1));
+				const int first = static_cast<int>(position);
+				taps[i] = { first, std::min(first + 1, src_size - 1), static_cast<uint32_t>((position - first) * 256.0f) };
+			}
+			return taps;
+		}
+
+		template<int From, int To>
+		void bilinear_rows(const image_view& src, uint8_t* dst, int dst_width, int dst_height, int first_row, int last_row)
+		{
+			const auto columns = bilinear_taps(src.width, dst_width);
+			const auto rows = bilinear_taps(src.height, dst_height);
+
+			for (int y = first_row; y < last_row; y++)
+			{
+				const bilinear_tap& row = rows[y];
+				const uint8_t* top = src.data + static_cast<size_t>(row.first) * src.width * From;
+				const uint8_t* bottom = src.data + static_cast<size_t>(row.second) * src.width * From;
+				uint8_t* out = dst + static_cast<size_t>(y) * dst_width * To;
+				for (int x = 0; x < dst_width; x++)
+				{
+					const bilinear_tap& column = columns[x];
+					const uint8_t* a = top + static_cast<size_t>(column.first) * From;
+					const uint8_t* b = top + static_cast<size_t>(column.second) * From;
+					const uint8_t* c = bottom + static_cast<size_t>(column.first) * From;
+					const uint8_t* d = bottom + static_cast<size_t>(column.second) * From;
+
+					uint8_t blended[From];
+					for (int ch = 0; ch < From; ch++)
+					{
+						const uint32_t upper = a[ch] * (256 - column.weight) + b[ch] * column.weight;
+						const uint32_t lower = c[ch] * (256 - column.weight) + d[ch] * column.weight;
+						blended[ch] = static_cast<uint8_t>((upper * (256 - row.weight) + lower * row.weight + (1 << 15)) >> 16);
+					}
+					convert<From, To>(blended, out + static_cast<size_t>(x) * To);
+				}
+			}
+		}
+
+		// the source pixels each new pixel covers, at least one
+		inline std::vector<std::pair<int, int>> box_spans(int src_size, int dst_size)
+		{
+			std::vector<std::pair<int, int>> spans(dst_size);
+			for (int i = 0; i < dst_size; i++)
+			{
+				const int first = std::min(static_cast<int>(static_cast<int64_t>(i) * src_size / dst_size), src_size - 1);
+				const int last = std::max(static_cast<int>(static_cast<int64_t>(i + 1) * src_size / dst_size), first + 1);
+				spans[i] = { first, std::min(last, src_size) };
+			}
+			return spans;
+		}
+
+		template<int From, int To>
+		void box_rows(const image_view& src, uint8_t* dst, int dst_width, int dst_height, int first_row, int last_row)
+		{
+			const auto columns = box_spans(src.width, dst_width);
+			const auto rows = box_spans(src.height, dst_height);
+			std::vector<uint32_t> sums(static_cast<size_t>(dst_width) * From);
+
+			for (int y = first_row; y < last_row; y++)
+			{
+				// sum the covered source rows first, then each new pixel's columns out of them
+				std::fill(sums.begin(), sums.end(), 0u);
+				for (int sy = rows[y].first; sy < rows[y].second; sy++)
+				{
+					const uint8_t* in = src.data + static_cast<size_t>(sy) * src.width * From;
+					for (int x = 0; x < dst_width; x++)
+						for (int sx = columns[x].first; sx < columns[x].second; sx++)
+							for (int ch = 0; ch < From; ch++)
+								sums[static_cast<size_t>(x) * From + ch] += in[static_cast<size_t>(sx) * From + ch];
+				}
+
+				uint8_t* out = dst + static_cast<size_t>(y) * dst_width * To;
+				const uint32_t row_count = static_cast<uint32_t>(rows[y].second - rows[y].first);
+				for (int x = 0; x < dst_width; x++)
+				{
+					const uint32_t count = row_count * static_cast<uint32_t>(columns[x].second - columns[x].first);
+					uint8_t averaged[From];
+					for (int ch = 0; ch < From; ch++)
+						averaged[ch] = static_cast<uint8_t>((sums[static_cast<size_t>(x) * From + ch] + count / 2) / count);
+					convert<From, To>(averaged, out + static_cast<size_t>(x) * To);
+				}
+			}
+		}
+
+		// splits the rows over threads when the image is big enough to be worth it
+		template<typename Fn>
+		void parallel_rows(int rows, size_t work, Fn&& fn)
+		{
+			constexpr size_t min_work_per_thread = 256 * 1024;
+			const size_t hardware = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+			const size_t thread_count = std::min({ hardware, work / min_work_per_thread + 1, static_cast<size_t>(std::max(rows, 1)) });
+			if (thread_count <= 1)
+			{
+				fn(0, rows);
+				return;
+			}
+
+			std::vector<std::thread> threads;
+			threads.reserve(thread_count - 1);
+			const auto row_at = [&](size_t i) { return static_cast<int>(static_cast<size_t>(rows) * i / thread_count); };
+			for (size_t i = 1; i < thread_count; i++)
+				threads.emplace_back([&fn, first = row_at(i), last = row_at(i + 1)](){ fn(first, last); });
+			fn(0, row_at(1));
+			for (auto& thread : threads)
+				thread.join();
+		}
+
+		template<int From, int To>
+		void cast(const image_view& src, image_data& dst, image_filter filter)
+		{
+			const size_t work = static_cast<size_t>(dst.width) * static_cast<size_t>(dst.height) * (filter == image_filter::box ? std::max<size_t>(static_cast<size_t>(src.width) * src.height / std::max<size_t>(static_cast<size_t>(dst.width) * dst.height, 1), 1) : 1);
+			parallel_rows(dst.height, work, [&](int first_row, int last_row) {
+				if (src.width == dst.width && src.height == dst.height)
+					convert_rows<From, To>(src, dst.data, first_row, last_row);
+				else if (filter == image_filter::bilinear)
+					bilinear_rows<From, To>(src, dst.data, dst.width, dst.height, first_row, last_row);
+				else if (filter == image_filter::box)
+					box_rows<From, To>(src, dst.data, dst.width, dst.height, first_row, last_row);
+				else
+					nearest_rows<From, To>(src, dst.data, dst.width, dst.height, first_row, last_row);
+			});
+		}
+
+		template<int From>
+		void cast_from(const image_view& src, image_data& dst, image_filter filter)
+		{
+			switch (dst.format)
+			{
+			case oe::formats::rgba:
+				return cast<From, 4>(src, dst, filter);
+			case oe::formats::rgb:
+				return cast<From, 3>(src, dst, filter);
+			case oe::formats::mono:
+				return cast<From, 1>(src, dst, filter);
+			case oe::formats::none:
+				break;
+			}
+		}
+	}
+
+	image_data image_data_base::cast(oe::formats new_format, int new_width, int new_height, image_filter filter) const
 	{
+		if(new_format == oe::formats::none)
+			new_format = format;
 		if(new_width == -1)
 			new_width = width;
 		if(new_height == -1)
-			new_height = width;
+			new_height = height;
 
 		if(new_format == format && new_width == width && new_height == height)
 			return *this;
 		
-		if(new_format == oe::formats::none || format == oe::formats::none)
-			std::runtime_error(invalid_format.data());
+		if(format == oe::formats::none || new_width <= 0 || new_height <= 0 || width <= 0 || height <= 0)
+			throw std::runtime_error(invalid_format.data());
 		
-		const glm::vec2 ratio = {
-			static_cast<float>(width) / static_cast<float>(new_width),
-			static_cast<float>(height) / static_cast<float>(new_height)
-		};
 		image_data new_image{ new_format, new_width, new_height };
-
-		for (int y = 0; y < new_height; y++)
-			for (int x = 0; x < new_width; x++)
-			{
-				const size_t new_data_pos =
-					x + y * new_width;
-				const size_t old_data_pos =
-					std::clamp<int>(int(x * ratio.x), 0, width) +
-					std::clamp<int>(int(y * ratio.y), 0, height) * width;
-				
-				auto* new_data = &new_image.data[std::clamp<size_t>(new_data_pos * stb_i_channels(new_format), 0, new_image.size - stb_i_channels(new_format))];
-				auto* old_data = &data[std::clamp<size_t>(old_data_pos * stb_i_channels(format), 0, size - stb_i_channels(format))];
-
-				constexpr auto shift = sizeof(oe::formats) / 2;
-				switch (static_cast<size_t>(new_format) | static_cast<size_t>(format) << shift)
-				{
-				case static_cast<size_t>(oe::formats::rgba) | static_cast<size_t>(oe::formats::rgba) << shift:
-					*reinterpret_cast<glm::vec<4, uint8_t>*>(new_data) = to_rgba(*reinterpret_cast<glm::vec<4, uint8_t>*>(old_data));
-					break;
-				case static_cast<size_t>(oe::formats::rgba) | static_cast<size_t>(oe::formats::rgb) << shift:
-					*reinterpret_cast<glm::vec<4, uint8_t>*>(new_data) = to_rgba(*reinterpret_cast<glm::vec<3, uint8_t>*>(old_data));
-					break;
-				case static_cast<size_t>(oe::formats::rgba) | static_cast<size_t>(oe::formats::mono) << shift:
-					*reinterpret_cast<glm::vec<4, uint8_t>*>(new_data) = to_rgba(*reinterpret_cast<glm::vec<1, uint8_t>*>(old_data));
-					break;
-				case static_cast<size_t>(oe::formats::rgb) | static_cast<size_t>(oe::formats::rgba) << shift:
-					*reinterpret_cast<glm::vec<3, uint8_t>*>(new_data) = to_rgb(*reinterpret_cast<glm::vec<4, uint8_t>*>(old_data));
-					break;
-				case static_cast<size_t>(oe::formats::rgb) | static_cast<size_t>(oe::formats::rgb) << shift:
-					*reinterpret_cast<glm::vec<3, uint8_t>*>(new_data) = to_rgb(*reinterpret_cast<glm::vec<3, uint8_t>*>(old_data));
-					break;
-				case static_cast<size_t>(oe::formats::rgb) | static_cast<size_t>(oe::formats::mono) << shift:
-					*reinterpret_cast<glm::vec<3, uint8_t>*>(new_data) = to_rgb(*reinterpret_cast<glm::vec<1, uint8_t>*>(old_data));
-					break;
-				case static_cast<size_t>(oe::formats::mono) | static_cast<size_t>(oe::formats::rgba) << shift:
-					*reinterpret_cast<glm::vec<1, uint8_t>*>(new_data) = to_mono(*reinterpret_cast<glm::vec<4, uint8_t>*>(old_data));
-					break;
-				case static_cast<size_t>(oe::formats::mono) | static_cast<size_t>(oe::formats::rgb) << shift:
-					*reinterpret_cast<glm::vec<1, uint8_t>*>(new_data) = to_mono(*reinterpret_cast<glm::vec<3, uint8_t>*>(old_data));
-					break;
-				case static_cast<size_t>(oe::formats::mono) | static_cast<size_t>(oe::formats::mono) << shift:
-					*reinterpret_cast<glm::vec<1, uint8_t>*>(new_data) = to_mono(*reinterpret_cast<glm::vec<1, uint8_t>*>(old_data));
-					break;
-				
-				default:
-					break;
-				}
-			}
+		const image_kernels::image_view src{ data, width, height };
+		switch (format)
+		{
+		case oe::formats::rgba:
+			image_kernels::cast_from<4>(src, new_image, filter);
+			break;
+		case oe::formats::rgb:
+			image_kernels::cast_from<3>(src, new_image, filter);
+			break;
+		case oe::formats::mono:
+			image_kernels::cast_from<1>(src, new_image, filter);
+			break;
+		case oe::formats::none:
+			break;
+		}
 		
 		return new_image;
 	}
@@ -265,20 +462,20 @@ namespace oe::utils
 		if(new_width == -1)
 			new_width = width;
 		if(new_height == -1)
-			new_height = width;
+			new_height = height;
 
-		offset_x = std::max(offset_x, 0);
-		offset_y = std::max(offset_y, 0);
-		new_width = std::min(width, offset_x + new_width) - offset_x;
-		new_height = std::min(height, offset_y + new_height) - offset_y;
-		const int bytes_per_pixel = stb_i_channels(format);
+		offset_x = std::clamp(offset_x, 0, width);
+		offset_y = std::clamp(offset_y, 0, height);
+		new_width = std::max(std::min(width, offset_x + new_width) - offset_x, 0);
+		new_height = std::max(std::min(height, offset_y + new_height) - offset_y, 0);
+		const size_t bytes_per_pixel = static_cast<size_t>(stb_i_channels(format));
 		image_data new_image{ format, new_width, new_height };
 
-		for (int y = offset_y; y < offset_y + new_height; y++)
-			for (int x = offset_x; x < offset_x + new_width; x++)
-				for (int b = 0; b < bytes_per_pixel; b++)
-					new_image.data[(x - offset_x) * bytes_per_pixel + (y - offset_y) * new_width * bytes_per_pixel + b]
-						= data[x * bytes_per_pixel + y * width * bytes_per_pixel + b];
+		const size_t row_bytes = static_cast<size_t>(new_width) * bytes_per_pixel;
+		const size_t src_stride = static_cast<size_t>(width) * bytes_per_pixel;
+		const uint8_t* src = data + static_cast<size_t>(offset_y) * src_stride + static_cast<size_t>(offset_x) * bytes_per_pixel;
+		for (int y = 0; y < new_height && row_bytes > 0; y++)
+			std::memcpy(new_image.data + y * row_bytes, src + y * src_stride, row_bytes);
 
 		return new_image;
 	}
@@ -287,9 +484,13 @@ namespace oe::utils
 	{
 		int channels = stb_i_channels(format);
 		int size;
-		std::unique_ptr<uint8_t[]> data_out(stbi_write_png_to_mem(data, width * channels, width, height, channels, &size));
+		uint8_t* data_out = stbi_write_png_to_mem(data, width * channels, width, height, channels, &size);
+		if (!data_out)
+			throw oe::utils::formatted_error("Failed to encode a {}x{} image", width, height);
 
-		return { data_out.get(), data_out.get() + size };
+		byte_string encoded{ data_out, data_out + size };
+		byte_pool::get().free(data_out);
+		return encoded;
 	}
 
 	audio_data::audio_data(int _format, int _size, int _channels, int _sample_rate)
@@ -298,53 +499,75 @@ namespace oe::utils
 		, channels(_channels)
 		, sample_rate(_sample_rate)
 	{
-		data = new int16_t[size];
+		data = new int16_t[size / sizeof(int16_t)];
 	}
 
 	audio_data::audio_data(fs::path path)
 	{
-		mp3dec_t mp3d;
-		mp3dec_file_info_t info;
-		if (mp3dec_load(&mp3d, path.string().c_str(), &info, NULL, NULL))
-			throw oe::utils::formatted_error("Failed to load audiofile \"{}\"", std::string(path.string().c_str()));
-
-		size = info.samples * sizeof(int16_t);
-		data = info.buffer;
-		channels = info.channels;
-		sample_rate = info.hz;
-
-		// Format
-		format = -1;
-		if (info.channels == 1) {
-			format = -1/* mono16 */;
+		std::unique_ptr<audio_decoder> decoder;
+		try
+		{
+			decoder = audio_decoder::open(mapped_file{ path });
 		}
-		else if (info.channels == 2) {
-			format = -1/* stereo16 */;
+		catch (const std::exception& e)
+		{
+			throw oe::utils::formatted_error("Failed to load audiofile \"{}\": {}", path.generic_string(), e.what());
 		}
+		*this = audio_data{ *decoder };
 	}
 
 	audio_data::audio_data(const uint8_t* _data, size_t data_size)
 	{
-		mp3dec_t mp3d;
-		mp3dec_file_info_t info;
-		mp3dec_load_buf(&mp3d, _data, data_size, &info, NULL, NULL);
-		if (!info.buffer)
-			throw oe::utils::formatted_error("Failed to load audiodata {}:{}", (size_t)_data, data_size);
-		
+		std::unique_ptr<audio_decoder> decoder;
+		try
+		{
+			decoder = audio_decoder::open(gsl::span<const uint8_t>{ _data, data_size });
+		}
+		catch (const std::exception& e)
+		{
+			throw oe::utils::formatted_error("Failed to load audiodata {}:{}: {}", (size_t)_data, data_size, e.what());
+		}
+		*this = audio_data{ *decoder };
+	}
 
-		size = info.samples * sizeof(int16_t);
-		data = info.buffer;
-		channels = info.channels;
-		sample_rate = info.hz;
+	audio_data::audio_data(audio_decoder& decoder)
+		: format(-1/* mono16 or stereo16 */)
+		, channels(decoder.channels())
+		, sample_rate(decoder.sample_rate())
+	{
+		const size_t frame_bytes = static_cast<size_t>(channels) * sizeof(int16_t);
+		const uint64_t length = decoder.length();
+		const uint64_t left = length > decoder.tell() ? length - decoder.tell() : 0;
 
-		// Format
-		format = -1;
-		if (info.channels == 1) {
-			format = -1/* mono16 */;
+		if (left != 0)
+		{
+			// the length is known, decoded straight into the one allocation
+			if (left > static_cast<uint64_t>(INT_MAX) / frame_bytes)
+				throw oe::utils::formatted_error("Audio too long: {} frames", left);
+			data = new int16_t[static_cast<size_t>(left) * static_cast<size_t>(channels)];
+			size = static_cast<int>(decoder.read(data, static_cast<size_t>(left)) * frame_bytes);
+			return;
 		}
-		else if (info.channels == 2) {
-			format = -1/* stereo16 */;
+
+		// unknown length, chunk by chunk
+		constexpr size_t chunk_frames = 16384;
+		std::vector<int16_t> samples;
+		while (true)
+		{
+			const size_t first = samples.size();
+			samples.resize(first + chunk_frames * static_cast<size_t>(channels));
+			const size_t read = decoder.read(samples.data() + first, chunk_frames);
+			samples.resize(first + read * static_cast<size_t>(channels));
+			if (samples.size() * sizeof(int16_t) > static_cast<size_t>(INT_MAX))
+				throw oe::utils::formatted_error("Audio too long: over {} bytes", INT_MAX);
+			if (read < chunk_frames)
+				break;
 		}
+
+		size = static_cast<int>(samples.size() * sizeof(int16_t));
+		data = new int16_t[samples.size()];
+		if (!samples.empty())
+			std::memcpy(data, samples.data(), samples.size() * sizeof(int16_t));
 	}
 
 	audio_data::audio_data(const int16_t* _data, int _format, int _size, int _channels, int _sample_rate)
@@ -353,8 +576,9 @@ namespace oe::utils
 		, channels(_channels)
 		, sample_rate(_sample_rate)
 	{
-		data = new int16_t[size];
-		std::memcpy(data, _data, size);
+		data = new int16_t[size / sizeof(int16_t)];
+		if (size > 0)
+			std::memcpy(data, _data, size);
 	}
 
 	audio_data::audio_data(const audio_data& _copied)
@@ -363,8 +587,9 @@ namespace oe::utils
 		, channels(_copied.channels)
 		, sample_rate(_copied.sample_rate)
 	{
-		data = new int16_t[size];
-		std::memcpy(data, _copied.data, size);
+		data = new int16_t[size / sizeof(int16_t)];
+		if (size > 0)
+			std::memcpy(data, _copied.data, size);
 	}
 
 	audio_data::audio_data(audio_data&& move)
@@ -395,8 +620,9 @@ namespace oe::utils
 		size = copy_assign.size;
 		channels = copy_assign.channels;
 		sample_rate = copy_assign.sample_rate;
-		data = new int16_t[size];
-		std::memcpy(data, copy_assign.data, size);
+		data = new int16_t[size / sizeof(int16_t)];
+		if (size > 0)
+			std::memcpy(data, copy_assign.data, size);
 
 		return *this;
 	}
@@ -500,6 +726,9 @@ namespace oe::utils
 		auto generic_to_zip = path_to_zip.generic_string();
 		auto generic_in_zip = path_in_zip.generic_string();
 
+		// cached read handles would keep the old archive open and its index would be wrong afterwards
+		zip_archive_cache::get().invalidate(path_to_zip);
+
 		int error;
 		auto zipper = zip_open(generic_to_zip.c_str(), ZIP_CREATE, &error);
 		if (!zipper)
@@ -532,47 +761,17 @@ namespace oe::utils
 		catch (const std::exception& e)
 		{
 			zip_close(zipper);
+			zip_archive_cache::get().invalidate(path_to_zip);
 			throw e;
 		}
 
 		zip_close(zipper);
+		zip_archive_cache::get().invalidate(path_to_zip);
 	}
 
 	void read_from_zip(const fs::path& path_to_zip, const fs::path& path_in_zip, byte_string& data)
 	{
-		auto generic_to_zip = path_to_zip.generic_string();
-		auto generic_in_zip = path_in_zip.generic_string();
-
-		int error;
-		auto zipper = zip_open(generic_to_zip.c_str(), 0, &error);
-		if (!zipper)
-			throw oe::utils::formatted_error("Failed to open {}, {}", path_to_zip, zip_open_error(error));
-
-		try
-		{
-			zip_stat_t stats;
-			zip_stat(zipper, generic_in_zip.c_str(), 0, &stats);
-
-			auto file = zip_fopen(zipper, generic_in_zip.c_str(), 0);
-			if (!file)
-				throw oe::utils::formatted_error("Failed to open file {} from zip, {}", generic_in_zip.c_str(), zip_strerror(zipper));
-
-			data.resize(stats.size);
-			auto read_size = zip_fread(file, data.data(), data.size());
-			if (read_size < 0)
-			{
-				zip_fclose(file);
-				throw oe::utils::formatted_error("Failed to read file {} from zip, {}", generic_in_zip.c_str(), zip_strerror(zipper));
-			}
-			zip_fclose(file);
-		}
-		catch (const std::exception& e)
-		{
-			zip_close(zipper);
-			throw e;
-		}
-
-		zip_close(zipper);
+		zip_archive_cache::get().acquire(path_to_zip)->read(path_in_zip.generic_string(), data);
 	}
 
 	void zip_paths(const std::vector<fs::path::const_iterator>& iter, const fs::path& current_path, fs::path& path_to_zip, fs::path& path_in_zip)
@@ -621,30 +820,12 @@ namespace oe::utils
 			fs::path path_to_zip, path_in_zip;
 			zip_paths(iter, m_current_path, path_to_zip, path_in_zip);
 
-			auto generic_to_zip = path_to_zip.generic_string();
-			auto generic_in_zip = path_in_zip.generic_string();
-
-			int error;
-			auto zipper = zip_open(generic_to_zip.c_str(), 0, &error);
-			if (!zipper)
-				throw oe::utils::formatted_error("Failed to open {}, {}", path_to_zip, zip_open_error(error));
-
-			auto n = zip_get_num_entries(zipper, 0);
-			std::string last_folder;
-			for(decltype(n) ni = 0; ni < n; ni++)
+			const auto archive = zip_archive_cache::get().acquire(path_to_zip);
+			if (const auto* children = archive->directory(path_in_zip.generic_string()))
 			{
-				zip_stat_t stats;
-				zip_stat_index(zipper, ni, 0, &stats);
-				
-				fs::path parent_path = fs::path(stats.name).parent_path();
-				if(path_in_zip == parent_path)
-					items.push_back(path_to_zip / fs::path(stats.name));
-
-				if(last_folder != parent_path && parent_path.parent_path() == path_in_zip)
-				{
-					last_folder = parent_path.generic_string();
-					items.push_back(path_to_zip / last_folder);
-				}
+				items.reserve(children->size());
+				for (const auto& child : *children)
+					items.push_back(path_to_zip / child);
 			}
 		}
 		else
@@ -680,6 +861,21 @@ namespace oe::utils
 		fs::remove_all(m_current_path);
 	}
 
+	void FileIO::setZipCacheSize(size_t archives)
+	{
+		zip_archive_cache::get().set_capacity(archives);
+	}
+
+	void FileIO::clearZipCache()
+	{
+		zip_archive_cache::get().clear();
+	}
+
+	zip_cache_stats FileIO::zipCacheStats()
+	{
+		return zip_archive_cache::get().stats();
+	}
+
 	byte_string FileIOInternal<byte_string>::read(const FileIO& path)
 	{
 		auto iter = first_zip_loc(path);
@@ -694,14 +890,34 @@ namespace oe::utils
 		}
 		else
 		{
-			std::ifstream input_stream(path.getPath(), std::ios_base::binary);
-			if (!input_stream.is_open())
-				throw oe::utils::formatted_error("Could not open file: '{}'", path.getPath().generic_string());
+			const mapped_file file{ path.getPath() };
+			return { file.begin(), file.end() };
+		}
+	}
+
+	mapped_file FileIOInternal<mapped_file>::read(const FileIO& path)
+	{
+		auto iter = first_zip_loc(path);
+		if (!iter.empty())
+		{
+			fs::path path_to_zip, path_in_zip;
+			zip_paths(iter, path.getPath(), path_to_zip, path_in_zip);
 
-			return { std::istreambuf_iterator<char>(input_stream), {} };
+			byte_string data;
+			read_from_zip(path_to_zip, path_in_zip, data);
+			return mapped_file{ std::move(data) };
+		}
+		else
+		{
+			return mapped_file{ path.getPath() };
 		}
 	}
 
+	void FileIOInternal<mapped_file>::write(const FileIO& path, const mapped_file& data)
+	{
+		FileIOInternal<byte_string>::write(path, { data.begin(), data.end() });
+	}
+
 	void FileIOInternal<byte_string>::write(const FileIO& path, const byte_string& string)
 	{
 		auto iter = first_zip_loc(path);
@@ -720,11 +936,34 @@ namespace oe::utils
 			if (!path.exists())
 				fs::create_directories(path.getPath().parent_path());
 
-			std::ofstream output_stream(path.getPath());
-			if (!output_stream.is_open())
-				throw oe::utils::formatted_error("Could not open file: '{}'", path.getPath().generic_string());
-			
-    		std::copy(string.begin(), string.end(), std::ostreambuf_iterator<char>(output_stream));
+			// written next to it and renamed over it, truncating in place would SIGBUS whoever still has it mapped
+			// (BakedTexture, AudioStream, decoders), those keep reading the old content until they map it again
+			const fs::path& target = path.getPath();
+			fs::path temporary = target;
+			temporary += fmt::format(".{}.tmp", std::hash<std::thread::id>{}(std::this_thread::get_id()));
+			{
+				std::ofstream output_stream(temporary, std::ios::binary | std::ios::trunc);
+				if (!output_stream.is_open())
+					throw oe::utils::formatted_error("Could not open file: '{}'", temporary.generic_string());
+
+				std::copy(string.begin(), string.end(), std::ostreambuf_iterator<char>(output_stream));
+				output_stream.close();
+				if (!output_stream)
+				{
+					std::error_code ec;
+					fs::remove(temporary, ec);
+					throw oe::utils::formatted_error("Could not write file: '{}'", temporary.generic_string());
+				}
+			}
+
+			std::error_code ec;
+			fs::rename(temporary, target, ec);
+			if (ec)
+			{
+				std::error_code ignored;
+				fs::remove(temporary, ignored);
+				throw oe::utils::formatted_error("Could not replace file: '{}', {}", target.generic_string(), ec.message());
+			}
 		}
 	}
 }
\ No newline at end of file
@@ -7,6 +7,8 @@
 
 #include "engine/enum.hpp"
 #include "engine/engine.hpp"
+#include "engine/utility/mapped_file.hpp"
+#include "engine/utility/zip_cache.hpp"
 
 
 
@@ -36,6 +38,12 @@ namespace oe::utils
 	static constexpr inline uint8_t u8max = std::numeric_limits<uint8_t>::max();
 	inline float to_float(uint8_t byte)
 	{ return static_cast<float>(byte) / static_cast<float>(u8max); }
+	// x * y / 255, rounded
+	inline uint8_t mul_u8(uint32_t x, uint32_t y)
+	{ const uint32_t product = x * y + 128; return static_cast<uint8_t>((product + (product >> 8)) >> 8); }
+	// Rec. 601 luma in 8 bit fixed point
+	inline uint8_t luma(uint32_t r, uint32_t g, uint32_t b)
+	{ return static_cast<uint8_t>((r * 77 + g * 150 + b * 29) >> 8); }
 
 	inline glm::vec<4, uint8_t> to_rgba(const glm::vec<4, uint8_t>& rgba)
 	{ return rgba; }
@@ -45,20 +53,28 @@ namespace oe::utils
 	{ return { mono, mono, mono, u8max }; }
 	
 	inline glm::vec<3, uint8_t> to_rgb(const glm::vec<4, uint8_t>& rgba)
-	{ return { rgba.r * to_float(rgba.a), rgba.g * to_float(rgba.a), rgba.b * to_float(rgba.a) }; }
+	{ return { mul_u8(rgba.r, rgba.a), mul_u8(rgba.g, rgba.a), mul_u8(rgba.b, rgba.a) }; }
 	inline glm::vec<3, uint8_t> to_rgb(const glm::vec<3, uint8_t>& rgb)
 	{ return rgb; }
 	inline glm::vec<3, uint8_t> to_rgb(const glm::vec<1, uint8_t>& mono)
 	{ return { mono, mono, mono }; }
 	
 	inline glm::vec<1, uint8_t> to_mono(const glm::vec<4, uint8_t>& rgba)
-	{ return glm::vec<1, uint8_t>{ static_cast<uint8_t>(glm::length(static_cast<glm::vec<4, float>>(rgba)) * to_float(rgba.a)) }; }
+	{ return glm::vec<1, uint8_t>{ mul_u8(luma(rgba.r, rgba.g, rgba.b), rgba.a) }; }
 	inline glm::vec<1, uint8_t> to_mono(const glm::vec<3, uint8_t>& rgb)
-	{ return glm::vec<1, uint8_t>{ static_cast<uint8_t>(glm::length(static_cast<glm::vec<3, float>>(rgb))) }; }
+	{ return glm::vec<1, uint8_t>{ luma(rgb.r, rgb.g, rgb.b) }; }
 	inline glm::vec<1, uint8_t> to_mono(const glm::vec<1, uint8_t>& mono)
 	{ return mono; }
 
 
+	// how cast() picks the new pixels when the size changes
+	enum class image_filter
+	{
+		nearest,  // the source pixel under the new one
+		bilinear, // the 4 source pixels around it, blended
+		box       // average of every source pixel it covers, for downscaling
+	};
+
 	struct image_data_base;
 	template<oe::formats _format, int _width, int _height>
 	struct image_datac;
@@ -75,7 +91,8 @@ namespace oe::utils
 		constexpr image_data_base(uint8_t* _data, oe::formats _format, int _width, int _height)
 			: data(_data), format(_format), width(_width), height(_height), size(width * height * stb_i_channels(format))
 		{}
-		image_data cast(oe::formats format = oe::formats::none, int width = -1, int height = -1) const;
+		// none and -1 keep the current format and size
+		image_data cast(oe::formats format = oe::formats::none, int width = -1, int height = -1, image_filter filter = image_filter::nearest) const;
 		image_data crop(int x = 0, int y = 0, int width = -1, int height = -1) const;
 		byte_string save() const;
 	};
@@ -86,6 +103,7 @@ namespace oe::utils
 		image_data(oe::formats format, int width, int height); // allocates space for uint8_t*data
 		image_data(fs::path path, oe::formats format = oe::formats::rgba); // load from file
 		image_data(const uint8_t* data, size_t data_size, oe::formats format = oe::formats::rgba); // load from memory
+		image_data(gsl::span<const uint8_t> encoded, oe::formats format = oe::formats::rgba) : image_data(encoded.data(), encoded.size(), format) {} // load from memory
 		image_data(const uint8_t* data, oe::formats format, int width, int height);
 		image_data(const image_data_base& copied);
 		image_data(const image_data& copied) : image_data(static_cast<const image_data_base&>(copied)) {}
@@ -128,6 +146,9 @@ namespace oe::utils
 		}
 	};
 
+	class audio_decoder;
+
+	// interleaved int16 samples, size in bytes
 	struct audio_data
 	{
 		int16_t* data = nullptr;
@@ -135,8 +156,10 @@ namespace oe::utils
 		
 		constexpr audio_data() = default;
 		audio_data(int format, int size, int channels, int sample_rate); // allocates space for uint16_t*data
-		audio_data(fs::path path); // load from file
+		audio_data(fs::path path); // load from file, mp3, wav or ogg
 		audio_data(const uint8_t* data, size_t data_size); // load from memory
+		explicit audio_data(audio_decoder& decoder); // whatever the decoder has left
+		audio_data(gsl::span<const uint8_t> encoded) : audio_data(encoded.data(), encoded.size()) {} // load from memory
 		audio_data(const int16_t* data, int format, int size, int channels, int sample_rate);
 		audio_data(const audio_data& copied);
 		audio_data(audio_data&& move);
@@ -144,6 +167,8 @@ namespace oe::utils
 
 		audio_data& operator=(const audio_data& copy_assign);
 		audio_data& operator=(audio_data&& move_assign);
+
+		[[nodiscard]] inline size_t frames() const noexcept { return channels > 0 ? static_cast<size_t>(size) / sizeof(int16_t) / static_cast<size_t>(channels) : 0; }
 	};
 
 
@@ -163,12 +188,18 @@ namespace oe::utils
 		static void write(const FileIO& path, const byte_string& data);
 	};
 	template<>
+	struct FileIOInternal<mapped_file>
+	{
+		static mapped_file read(const FileIO& path);
+		static void write(const FileIO& path, const mapped_file& data);
+	};
+	// decoded straight from the mapping
+	template<>
 	struct FileIOInternal<image_data>
 	{
 		static image_data read(const FileIO& path, const oe::formats& format = oe::formats::rgba)
 		{
-			auto data = FileIOInternal<byte_string>::read(path);
-			return { data.data(), data.size(), format };
+			return { FileIOInternal<mapped_file>::read(path).span(), format };
 		};
 
 		static void write(const FileIO& path, const image_data& data)
@@ -181,8 +212,7 @@ namespace oe::utils
 	{
 		static audio_data read(const FileIO& path)
 		{
-			auto data = FileIOInternal<byte_string>::read(path);
-			return { data.data(), data.size() };
+			return { FileIOInternal<mapped_file>::read(path).span() };
 		};
 
 		static void write(const FileIO&, const audio_data&)
@@ -195,8 +225,8 @@ namespace oe::utils
 	{
 		static std::string read(const FileIO& path)
 		{
-			auto data = FileIOInternal<byte_string>::read(path);
-			return { data.data(), data.data() + data.size() };
+			const auto data = FileIOInternal<mapped_file>::read(path);
+			return { data.begin(), data.end() };
 		};
 
 		static void write(const FileIO& path, const std::string& data)
@@ -254,6 +284,14 @@ namespace oe::utils
 
 		void remove() const;
 
+		// read-only view of the whole file without copying it, see mapped_file
+		inline mapped_file map() const { return FileIOInternal<mapped_file>::read(*this); }
+
+		// .zip archives stay open with their entries indexed, up to 'archives' of the most recently used ones
+		static void setZipCacheSize(size_t archives = zip_archive_cache::default_capacity);
+		static void clearZipCache();
+		[[nodiscard]] static zip_cache_stats zipCacheStats();
+
 		// read/write any
 		template<typename T, typename ... Args> inline T read(const Args&& ... args) const { return FileIOInternal<T>::read(m_current_path, args...); }
 		template<typename T, typename ... Args> inline void write(const T& d, const Args&& ... args) const { return FileIOInternal<T>::write(m_current_path, d, args...); }
@@ -1,6 +1,7 @@
 #include "gameloop.hpp"
 #include "engine/engine.hpp"
 #include "engine/graphics/interface/window.hpp"
+#include "engine/utility/byte_pool.hpp"
 
 
 
@@ -72,6 +73,7 @@ namespace oe::utils
 		if (m_host_window->shouldClose()) stop();
 
 		m_render_perf_logger.log(frame_time);
+		byte_pool::get().next_frame();
 
 		// counters
 		auto frame_counter_now = std::chrono::high_resolution_clock::now();
@@ -8,51 +8,15 @@
 #include <atomic>
 #include "engine/enum.hpp"
 #include "engine/utility/formatted_error.hpp"
+#include "engine/utility/perf_logger.hpp"
 #include "engine/internal_libs.hpp"
 
 
 namespace oe::graphics { class IWindow; }
 namespace oe::utils
 {
-	static const size_t mc_average_size = 200;
-	static_assert(mc_average_size, "mc_average_size cannot be zero");
-
 	class GameLoop;
 
-	struct PerfLogger
-	{
-		// performance logger
-		std::array<std::chrono::nanoseconds, mc_average_size> m_average_time;
-		std::chrono::nanoseconds m_cached_average_time = std::chrono::nanoseconds::zero();
-		size_t m_total_count = 0;
-		size_t m_periodical_count = 0;
-		size_t m_per_second = 0;
-		
-		std::chrono::nanoseconds m_min_time = std::chrono::nanoseconds::zero();
-		std::chrono::nanoseconds m_max_time = std::chrono::nanoseconds::zero();
-
-		constexpr PerfLogger() : m_average_time({}) {}
-		constexpr void log(std::chrono::nanoseconds duration) noexcept
-		{
-			m_total_count++;
-			m_periodical_count++;
-
-			m_average_time[m_total_count % mc_average_size] = duration;
-
-			
-			m_cached_average_time = std::chrono::nanoseconds::zero();
-			m_max_time = std::chrono::nanoseconds::min();
-			m_min_time = std::chrono::nanoseconds::max();
-			for(size_t i = 0; i < mc_average_size; i++) 
-			{
-				m_cached_average_time += m_average_time[i];
-				m_max_time = std::max(m_max_time, m_average_time[i]);
-				m_min_time = std::min(m_min_time, m_average_time[i]);
-			}
-			m_cached_average_time /= mc_average_size;
-		}
-	};
-
 	struct UpdateSystemBase
 	{
 		PerfLogger m_perf_logger;
@@ -184,6 +148,20 @@ namespace oe::utils
 			return m_update_systems.at(ups)->m_perf_logger;
 		}
 
+		// number of frames/updates the averages and percentiles are calculated from
+		inline void setFramePerfWindow(size_t window)
+		{
+			m_render_perf_logger.setWindow(window);
+		}
+		template<size_t ups>
+		inline void setUpdatePerfWindow(size_t window)
+		{
+			auto iter = m_update_systems.find(ups);
+			if(iter == m_update_systems.end())
+				throw oe::utils::formatted_error("No PerfLogger for {}ups was found", ups);
+			iter->second->m_perf_logger.setWindow(window);
+		}
+
 		template<size_t ups> // for smooth animations when ups is low < 0.0f - 1.0f >
 		[[nodiscard]] inline float getUpdateLag() const
 		{
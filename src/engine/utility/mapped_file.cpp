@@ -0,0 +1,187 @@
+#include "mapped_file.hpp"
+
+#include "engine/utility/formatted_error.hpp"
+
+#include <utility>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
+
+
+namespace oe::utils
+{
+#if defined(_WIN32)
+	mapped_file::mapped_file(const fs::path& path)
+	{
+		HANDLE file = CreateFileW(path.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+			throw oe::utils::formatted_error("Could not open file: '{}', error {}", path.generic_string(), GetLastError());
+
+		// pipes and devices have no size to map, read until the end instead
+		if (GetFileType(file) != FILE_TYPE_DISK)
+		{
+			uint8_t chunk[4096];
+			while (true)
+			{
+				DWORD count = 0;
+				if (!ReadFile(file, chunk, sizeof(chunk), &count, nullptr))
+				{
+					// the writer closed the pipe
+					const DWORD error = GetLastError();
+					if (error == ERROR_BROKEN_PIPE || error == ERROR_HANDLE_EOF)
+						break;
+					CloseHandle(file);
+					throw oe::utils::formatted_error("Could not read file: '{}', error {}", path.generic_string(), error);
+				}
+				if (count == 0)
+					break;
+				m_owned.insert(m_owned.end(), chunk, chunk + count);
+			}
+			CloseHandle(file);
+			m_data = m_owned.data();
+			m_size = m_owned.size();
+			return;
+		}
+
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(file, &size))
+		{
+			const DWORD error = GetLastError();
+			CloseHandle(file);
+			throw oe::utils::formatted_error("Could not read the size of file: '{}', error {}", path.generic_string(), error);
+		}
+
+		// a mapping can't be empty
+		if (size.QuadPart == 0)
+		{
+			CloseHandle(file);
+			return;
+		}
+
+		// the view keeps the mapping and the file alive by itself
+		HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		const void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+		const DWORD error = GetLastError();
+		if (mapping)
+			CloseHandle(mapping);
+		CloseHandle(file);
+		if (!view)
+			throw oe::utils::formatted_error("Could not map file: '{}', error {}", path.generic_string(), error);
+
+		m_data = static_cast<const uint8_t*>(view);
+		m_size = static_cast<size_t>(size.QuadPart);
+		m_mapped = true;
+	}
+
+	void mapped_file::unmap() noexcept
+	{
+		if (m_mapped)
+			UnmapViewOfFile(m_data);
+	}
+#else
+	mapped_file::mapped_file(const fs::path& path)
+	{
+		const int file = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+		if (file < 0)
+			throw oe::utils::formatted_error("Could not open file: '{}', {}", path.generic_string(), std::strerror(errno));
+
+		struct stat stats;
+		if (::fstat(file, &stats) != 0)
+		{
+			const int error = errno;
+			::close(file);
+			throw oe::utils::formatted_error("Could not read the size of file: '{}', {}", path.generic_string(), std::strerror(error));
+		}
+
+		// /proc entries, pipes and devices have no size to map, read until the end instead
+		// /proc reports regular files of size 0, an empty file is read in one call too
+		if (!S_ISREG(stats.st_mode) || stats.st_size == 0)
+		{
+			uint8_t chunk[4096];
+			while (true)
+			{
+				const ssize_t count = ::read(file, chunk, sizeof(chunk));
+				if (count == 0)
+					break;
+				if (count < 0 && errno == EINTR)
+					continue;
+				if (count < 0)
+				{
+					const int error = errno;
+					::close(file);
+					throw oe::utils::formatted_error("Could not read file: '{}', {}", path.generic_string(), std::strerror(error));
+				}
+				m_owned.insert(m_owned.end(), chunk, chunk + count);
+			}
+			::close(file);
+			m_data = m_owned.data();
+			m_size = m_owned.size();
+			return;
+		}
+
+		// the mapping keeps the file alive by itself
+		void* view = ::mmap(nullptr, static_cast<size_t>(stats.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+		const int error = errno;
+		::close(file);
+		if (view == MAP_FAILED)
+			throw oe::utils::formatted_error("Could not map file: '{}', {}", path.generic_string(), std::strerror(error));
+
+		// decoders go through it front to back once
+		::posix_madvise(view, static_cast<size_t>(stats.st_size), POSIX_MADV_SEQUENTIAL);
+		::posix_madvise(view, static_cast<size_t>(stats.st_size), POSIX_MADV_WILLNEED);
+
+		m_data = static_cast<const uint8_t*>(view);
+		m_size = static_cast<size_t>(stats.st_size);
+		m_mapped = true;
+	}
+
+	void mapped_file::unmap() noexcept
+	{
+		if (m_mapped)
+			::munmap(const_cast<uint8_t*>(m_data), m_size);
+	}
+#endif
+
+	mapped_file::mapped_file(std::vector<uint8_t>&& owned) noexcept
+		: m_owned(std::move(owned))
+	{
+		m_data = m_owned.data();
+		m_size = m_owned.size();
+	}
+
+	mapped_file::mapped_file(mapped_file&& move) noexcept
+		: m_data(std::exchange(move.m_data, nullptr))
+		, m_size(std::exchange(move.m_size, 0))
+		, m_mapped(std::exchange(move.m_mapped, false))
+		, m_owned(std::move(move.m_owned))
+	{}
+
+	mapped_file::~mapped_file()
+	{
+		unmap();
+	}
+
+	mapped_file& mapped_file::operator=(mapped_file&& move_assign) noexcept
+	{
+		if (this == &move_assign)
+			return *this;
+
+		unmap();
+		m_data = std::exchange(move_assign.m_data, nullptr);
+		m_size = std::exchange(move_assign.m_size, 0);
+		m_mapped = std::exchange(move_assign.m_mapped, false);
+		m_owned = std::move(move_assign.m_owned);
+		return *this;
+	}
+}
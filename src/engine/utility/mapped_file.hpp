@@ -0,0 +1,49 @@
+#pragma once
+
+#include "engine/engine.hpp"
+
+#include <cstdint>
+#include <vector>
+#include <gsl/span>
+
+
+
+namespace oe::utils
+{
+	// a whole file read-only, straight from the page cache and unmapped when destroyed
+	// files inside a .zip are compressed, those are decompressed into a buffer it owns instead
+	// so are files that are not regular files (/proc, pipes, devices), those are read until the end
+	// FileIO::write replaces a file instead of rewriting it, so a mapping keeps the old content until it is mapped again
+	class mapped_file
+	{
+	private:
+		const uint8_t* m_data = nullptr;
+		size_t m_size = 0;
+		bool m_mapped = false;
+		std::vector<uint8_t> m_owned;
+
+	public:
+		mapped_file() = default;
+		// throws if the file can't be opened or mapped
+		explicit mapped_file(const fs::path& path);
+		explicit mapped_file(std::vector<uint8_t>&& owned) noexcept;
+		mapped_file(const mapped_file&) = delete;
+		mapped_file(mapped_file&& move) noexcept;
+		~mapped_file();
+
+		mapped_file& operator=(const mapped_file&) = delete;
+		mapped_file& operator=(mapped_file&& move_assign) noexcept;
+
+		[[nodiscard]] inline gsl::span<const uint8_t> span() const noexcept { return { m_data, m_size }; }
+		[[nodiscard]] inline const uint8_t* data() const noexcept { return m_data; }
+		[[nodiscard]] inline size_t size() const noexcept { return m_size; }
+		[[nodiscard]] inline bool empty() const noexcept { return m_size == 0; }
+		[[nodiscard]] inline const uint8_t* begin() const noexcept { return m_data; }
+		[[nodiscard]] inline const uint8_t* end() const noexcept { return m_data + m_size; }
+		// false if the content was copied into memory
+		[[nodiscard]] inline bool mapped() const noexcept { return m_mapped; }
+
+	private:
+		void unmap() noexcept;
+	};
+}
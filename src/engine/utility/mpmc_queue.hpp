@@ -0,0 +1,252 @@
+#pragma once
+
+#include "spsc_queue.hpp"
+
+
+
+namespace oe::utils
+{
+	// mpmc_queue: bounded lock-free multi-producer/multi-consumer ring buffer
+	// every slot carries a sequence number telling whose turn it is (Vyukov)
+	template<typename T>
+	class mpmc_queue
+	{
+	public:
+		using value_type = T;
+		using size_type = size_t;
+
+	private:
+		struct cell_t
+		{
+			std::atomic<size_type> sequence;
+			std::aligned_storage_t<sizeof(T), alignof(T)> storage;
+
+			[[nodiscard]] inline T* get() noexcept { return std::launder(reinterpret_cast<T*>(&storage)); }
+		};
+
+		const size_type m_capacity;
+		const size_type m_mask;
+		std::unique_ptr<cell_t[]> m_cells;
+
+		alignas(cache_line_size) std::atomic<size_type> m_enqueue_pos{ 0 };
+		alignas(cache_line_size) std::atomic<size_type> m_dequeue_pos{ 0 };
+
+		alignas(cache_line_size) event_count m_readable{};
+		event_count m_writable{};
+
+	private:
+		// claims a slot for writing, nullptr if full
+		[[nodiscard]] inline cell_t* claim_push(size_type& pos) noexcept
+		{
+			pos = m_enqueue_pos.load(std::memory_order_relaxed);
+			while (true)
+			{
+				cell_t* cell = &m_cells[pos & m_mask];
+				const size_type sequence = cell->sequence.load(std::memory_order_acquire);
+				const auto diff = static_cast<std::make_signed_t<size_type>>(sequence - pos);
+				if (diff == 0)
+				{
+					if (m_enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+						return cell;
+				}
+				else if (diff < 0)
+					return nullptr;
+				else
+					pos = m_enqueue_pos.load(std::memory_order_relaxed);
+			}
+		}
+
+		// claims a slot for reading, nullptr if empty
+		[[nodiscard]] inline cell_t* claim_pop(size_type& pos) noexcept
+		{
+			pos = m_dequeue_pos.load(std::memory_order_relaxed);
+			while (true)
+			{
+				cell_t* cell = &m_cells[pos & m_mask];
+				const size_type sequence = cell->sequence.load(std::memory_order_acquire);
+				const auto diff = static_cast<std::make_signed_t<size_type>>(sequence - (pos + 1));
+				if (diff == 0)
+				{
+					if (m_dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+						return cell;
+				}
+				else if (diff < 0)
+					return nullptr;
+				else
+					pos = m_dequeue_pos.load(std::memory_order_relaxed);
+			}
+		}
+
+		// the slot at the front is published, a claimed slot still being written or read does not count
+		// so waiters sleep on the event_count instead of spinning on a producer or consumer that got preempted mid copy
+		[[nodiscard]] inline bool readable() const noexcept
+		{
+			const size_type pos = m_dequeue_pos.load(std::memory_order_relaxed);
+			return m_cells[pos & m_mask].sequence.load(std::memory_order_acquire) == pos + 1;
+		}
+		[[nodiscard]] inline bool writable() const noexcept
+		{
+			const size_type pos = m_enqueue_pos.load(std::memory_order_relaxed);
+			return m_cells[pos & m_mask].sequence.load(std::memory_order_acquire) == pos;
+		}
+
+		template<class ... Args>
+		[[nodiscard]] inline bool emplace_silent(Args&& ... args)
+		{
+			size_type pos;
+			cell_t* cell = claim_push(pos);
+			if (!cell)
+				return false;
+
+			new (cell->get()) T(std::forward<Args>(args)...);
+			cell->sequence.store(pos + 1, std::memory_order_release);
+			return true;
+		}
+
+		[[nodiscard]] inline std::optional<value_type> pop_silent()
+		{
+			size_type pos;
+			cell_t* cell = claim_pop(pos);
+			if (!cell)
+				return std::nullopt;
+
+			std::optional<value_type> value{ std::move(*cell->get()) };
+			cell->get()->~T();
+			cell->sequence.store(pos + m_capacity, std::memory_order_release);
+			return value;
+		}
+
+	public:
+		// ------------
+		// constructors
+		// ------------
+
+		inline explicit mpmc_queue(size_type capacity = 1024)
+			: m_capacity(std::max<size_type>(ring_capacity(capacity), 2))
+			, m_mask(m_capacity - 1)
+			, m_cells(std::make_unique<cell_t[]>(m_capacity))
+		{
+			for (size_type i = 0; i < m_capacity; i++)
+				m_cells[i].sequence.store(i, std::memory_order_relaxed);
+		}
+		mpmc_queue(const mpmc_queue&) = delete;
+		mpmc_queue& operator=(const mpmc_queue&) = delete;
+
+		inline ~mpmc_queue()
+		{
+			if constexpr (!std::is_trivially_destructible_v<T>)
+				while (pop_silent()) {}
+		}
+
+		// ---------
+		// modifiers
+		// ---------
+
+		template<class ... Args>
+		[[nodiscard]] inline bool try_emplace(Args&& ... args)
+		{
+			if (!emplace_silent(std::forward<Args>(args)...))
+				return false;
+			m_readable.notify();
+			return true;
+		}
+		[[nodiscard]] inline bool try_push(const value_type& value) { return try_emplace(value); }
+		[[nodiscard]] inline bool try_push(value_type&& value) { return try_emplace(std::move(value)); }
+
+		// blocks while full
+		inline void push(const value_type& value) { while (!try_emplace(value)) wait_writable(); }
+		inline void push(value_type&& value) { while (!try_emplace(std::move(value))) wait_writable(); }
+
+		// pushes as many as fit, returns the iterator to the first element not pushed
+		// consumers are woken up once per batch
+		template<typename InputIt>
+		inline InputIt try_push(InputIt first, InputIt last)
+		{
+			bool pushed = false;
+			for (; first != last && emplace_silent(*first); ++first)
+				pushed = true;
+
+			if (pushed)
+				m_readable.notify();
+			return first;
+		}
+
+		[[nodiscard]] inline std::optional<value_type> try_pop()
+		{
+			auto value = pop_silent();
+			if (value)
+				m_writable.notify();
+			return value;
+		}
+
+		// pops up to max_count elements into out, returns the number of elements popped
+		template<typename OutputIt>
+		inline size_type try_pop(OutputIt out, size_type max_count)
+		{
+			size_type count = 0;
+			for (; count < max_count; count++, ++out)
+			{
+				auto value = pop_silent();
+				if (!value)
+					break;
+				*out = std::move(*value);
+			}
+
+			if (count != 0)
+				m_writable.notify();
+			return count;
+		}
+
+		// --------
+		// capacity
+		// --------
+
+		// approximate, other threads might be mid push or pop
+		[[nodiscard]] inline size_type size() const noexcept
+		{
+			const size_type enqueue_pos = m_enqueue_pos.load(std::memory_order_acquire);
+			const size_type dequeue_pos = m_dequeue_pos.load(std::memory_order_acquire);
+			return enqueue_pos > dequeue_pos ? enqueue_pos - dequeue_pos : 0;
+		}
+		[[nodiscard]] inline bool empty() const noexcept { return size() == 0; }
+		[[nodiscard]] inline bool full() const noexcept { return size() >= m_capacity; }
+		[[nodiscard]] inline size_type capacity() const noexcept { return m_capacity; }
+
+		// ----
+		// wait
+		// ----
+
+		// until the front element is published, a few yields then a sleep
+		inline void wait() { m_readable.wait([this](){ return readable(); }); }
+		template<typename Rep, typename Period>
+		inline bool wait_for(const std::chrono::duration<Rep, Period>& duration) { return m_readable.wait_for([this](){ return readable(); }, duration); }
+		template<typename Clock, typename Duration>
+		inline bool wait_until(const std::chrono::time_point<Clock, Duration>& atime) { return m_readable.wait_until([this](){ return readable(); }, atime); }
+
+		// another consumer might win the race, so these retry until they get a value
+		[[nodiscard]] inline value_type wait_pop()
+		{
+			while (true)
+			{
+				wait();
+				if (auto value = try_pop())
+					return std::move(*value);
+			}
+		}
+		template<typename Rep, typename Period>
+		[[nodiscard]] inline std::optional<value_type> wait_for_pop(const std::chrono::duration<Rep, Period>& duration)
+		{
+			return wait_until_pop(std::chrono::steady_clock::now() + duration);
+		}
+		template<typename Clock, typename Duration>
+		[[nodiscard]] inline std::optional<value_type> wait_until_pop(const std::chrono::time_point<Clock, Duration>& atime)
+		{
+			while (wait_until(atime))
+				if (auto value = try_pop())
+					return value;
+			return std::nullopt;
+		}
+
+		inline void wait_writable() { m_writable.wait([this](){ return writable(); }); }
+	};
+}
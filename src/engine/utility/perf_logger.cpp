@@ -0,0 +1,147 @@
+#include "perf_logger.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+
+
+namespace oe::utils
+{
+	static inline size_t most_significant_bit(uint64_t value) noexcept
+	{
+#if defined(__GNUC__) || defined(__clang__)
+		return 63 - static_cast<size_t>(__builtin_clzll(value));
+#elif defined(_MSC_VER) && defined(_WIN64)
+		unsigned long index;
+		_BitScanReverse64(&index, value);
+		return static_cast<size_t>(index);
+#else
+		size_t index = 0;
+		while (value >>= 1)
+			index++;
+		return index;
+#endif
+	}
+
+
+
+	size_t latency_histogram::index_of(uint64_t value) noexcept
+	{
+		if (value < sub_bucket_count)
+			return static_cast<size_t>(value);
+
+		// bucket by the highest bit, sub bucket by the next sub_bucket_bits bits
+		const size_t exponent = most_significant_bit(value);
+		const size_t shift = exponent - sub_bucket_bits;
+		const size_t mantissa = static_cast<size_t>(value >> shift) - sub_bucket_count;
+		return (shift + 1) * sub_bucket_count + mantissa;
+	}
+
+	uint64_t latency_histogram::value_of(size_t index) noexcept
+	{
+		if (index < sub_bucket_count)
+			return index;
+
+		const size_t shift = index / sub_bucket_count - 1;
+		const uint64_t mantissa = index % sub_bucket_count + sub_bucket_count;
+		const uint64_t lower = mantissa << shift;
+		return lower + ((uint64_t(1) << shift) >> 1);
+	}
+
+	void latency_histogram::clear() noexcept
+	{
+		m_counts.fill(0);
+		m_octave_counts.fill(0);
+		m_total = 0;
+	}
+
+	std::chrono::nanoseconds latency_histogram::percentile(double percent) const noexcept
+	{
+		if (m_total == 0)
+			return std::chrono::nanoseconds::zero();
+
+		const double fraction = std::clamp(percent, 0.0, 100.0) / 100.0;
+		const size_t target = std::max<size_t>(1, static_cast<size_t>(std::ceil(fraction * static_cast<double>(m_total))));
+
+		// whole octaves first, then the buckets of the one the target is in
+		size_t cumulative = 0;
+		for (size_t octave = 0; octave < octave_count; octave++)
+		{
+			if (cumulative + m_octave_counts[octave] < target)
+			{
+				cumulative += m_octave_counts[octave];
+				continue;
+			}
+
+			for (size_t i = octave * sub_bucket_count; i < (octave + 1) * sub_bucket_count; i++)
+			{
+				cumulative += m_counts[i];
+				if (cumulative >= target)
+					return std::chrono::nanoseconds{ static_cast<std::chrono::nanoseconds::rep>(value_of(i)) };
+			}
+		}
+		return std::chrono::nanoseconds{ static_cast<std::chrono::nanoseconds::rep>(value_of(bucket_count - 1)) };
+	}
+
+
+
+	PerfLogger::PerfLogger(size_t window)
+	{
+		setWindow(window);
+	}
+
+	void PerfLogger::setWindow(size_t window)
+	{
+		if (window == 0)
+			throw std::invalid_argument("PerfLogger window cannot be zero");
+
+		m_average_time.assign(window, std::chrono::nanoseconds::zero());
+		m_min_deque = { std::vector<size_t>(window), 0, 0 };
+		m_max_deque = { std::vector<size_t>(window), 0, 0 };
+		m_histogram.clear();
+		m_window_sum = std::chrono::nanoseconds::zero();
+		m_cached_average_time = std::chrono::nanoseconds::zero();
+		m_min_time = std::chrono::nanoseconds::zero();
+		m_max_time = std::chrono::nanoseconds::zero();
+	}
+
+	void PerfLogger::log(std::chrono::nanoseconds duration) noexcept
+	{
+		const size_t window = m_average_time.size();
+		m_total_count++;
+		m_periodical_count++;
+
+		// the sample that falls out of the window
+		const size_t sequence = m_total_count;
+		auto& slot = m_average_time[sequence % window];
+		if (m_histogram.count() == window)
+		{
+			m_window_sum -= slot;
+			m_histogram.remove(slot);
+		}
+		slot = duration;
+		m_window_sum += duration;
+		m_histogram.add(duration);
+
+		// monotonic deques, front is always the min/max of the window
+		const size_t oldest = sequence >= window ? sequence - window + 1 : 0;
+		for (auto* deque : { &m_min_deque, &m_max_deque })
+			while (!deque->empty() && deque->front() < oldest)
+				deque->pop_front();
+		while (!m_min_deque.empty() && sample(m_min_deque.back()) >= duration)
+			m_min_deque.pop_back();
+		while (!m_max_deque.empty() && sample(m_max_deque.back()) <= duration)
+			m_max_deque.pop_back();
+		m_min_deque.push_back(sequence);
+		m_max_deque.push_back(sequence);
+
+		m_cached_average_time = m_window_sum / static_cast<std::chrono::nanoseconds::rep>(m_histogram.count());
+		m_min_time = sample(m_min_deque.front());
+		m_max_time = sample(m_max_deque.front());
+	}
+}
\ No newline at end of file
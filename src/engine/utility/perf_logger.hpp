@@ -0,0 +1,117 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+
+
+namespace oe::utils
+{
+	static const size_t mc_average_size = 200;
+	static_assert(mc_average_size, "mc_average_size cannot be zero");
+
+	// log-linear (HDR style) histogram of nanosecond durations
+	// 32 linear sub buckets per power of two, so values are within ~3% of the real value
+	class latency_histogram
+	{
+	public:
+		static constexpr size_t sub_bucket_bits = 5;
+		static constexpr size_t sub_bucket_count = size_t(1) << sub_bucket_bits;
+		static constexpr size_t bucket_count = (64 - sub_bucket_bits + 1) * sub_bucket_count;
+		static constexpr size_t octave_count = bucket_count / sub_bucket_count;
+
+	private:
+		std::array<uint32_t, bucket_count> m_counts{};
+		// sum of each run of sub_bucket_count buckets, percentile() skips empty octaves with these
+		std::array<uint32_t, octave_count> m_octave_counts{};
+		size_t m_total = 0;
+
+	public:
+		[[nodiscard]] static size_t index_of(uint64_t value) noexcept;
+		[[nodiscard]] static uint64_t value_of(size_t index) noexcept; // middle of the bucket
+
+		inline void add(std::chrono::nanoseconds duration) noexcept
+		{
+			const size_t index = index_of(clamp(duration));
+			m_counts[index]++;
+			m_octave_counts[index / sub_bucket_count]++;
+			m_total++;
+		}
+		inline void remove(std::chrono::nanoseconds duration) noexcept
+		{
+			const size_t index = index_of(clamp(duration));
+			m_counts[index]--;
+			m_octave_counts[index / sub_bucket_count]--;
+			m_total--;
+		}
+		void clear() noexcept;
+
+		// percentile in range [0, 100]
+		[[nodiscard]] std::chrono::nanoseconds percentile(double percent) const noexcept;
+		[[nodiscard]] inline size_t count() const noexcept { return m_total; }
+
+	private:
+		[[nodiscard]] static inline uint64_t clamp(std::chrono::nanoseconds duration) noexcept { return static_cast<uint64_t>(std::max(duration.count(), std::chrono::nanoseconds::rep{ 0 })); }
+	};
+
+	// performance logger
+	// rolling average, min, max and percentiles over the latest 'window' samples
+	// log() is O(1): running sum, monotonic deques for min/max and a windowed histogram
+	struct PerfLogger
+	{
+		// ring buffer of the latest samples, newest at [m_total_count % window]
+		std::vector<std::chrono::nanoseconds> m_average_time;
+		std::chrono::nanoseconds m_cached_average_time = std::chrono::nanoseconds::zero();
+		size_t m_total_count = 0;
+		size_t m_periodical_count = 0;
+		size_t m_per_second = 0;
+
+		std::chrono::nanoseconds m_min_time = std::chrono::nanoseconds::zero();
+		std::chrono::nanoseconds m_max_time = std::chrono::nanoseconds::zero();
+
+	private:
+		// sample sequence numbers, values are looked up from the ring buffer
+		struct monotonic_deque
+		{
+			std::vector<size_t> m_sequence;
+			size_t m_head = 0;
+			size_t m_size = 0;
+
+			[[nodiscard]] inline size_t front() const noexcept { return m_sequence[m_head]; }
+			[[nodiscard]] inline size_t back() const noexcept { return m_sequence[(m_head + m_size - 1) % m_sequence.size()]; }
+			inline void pop_front() noexcept { m_head = (m_head + 1) % m_sequence.size(); m_size--; }
+			inline void pop_back() noexcept { m_size--; }
+			inline void push_back(size_t sequence) noexcept { m_sequence[(m_head + m_size) % m_sequence.size()] = sequence; m_size++; }
+			[[nodiscard]] inline bool empty() const noexcept { return m_size == 0; }
+		};
+
+		std::chrono::nanoseconds m_window_sum = std::chrono::nanoseconds::zero();
+		monotonic_deque m_min_deque;
+		monotonic_deque m_max_deque;
+		latency_histogram m_histogram;
+
+		[[nodiscard]] inline std::chrono::nanoseconds sample(size_t sequence) const noexcept { return m_average_time[sequence % m_average_time.size()]; }
+
+	public:
+		PerfLogger(size_t window = mc_average_size);
+
+		void log(std::chrono::nanoseconds duration) noexcept;
+
+		// clears the samples and changes the number of samples the statistics are calculated from
+		void setWindow(size_t window);
+		[[nodiscard]] inline size_t getWindow() const noexcept { return m_average_time.size(); }
+		// samples currently in the window
+		[[nodiscard]] inline size_t getSampleCount() const noexcept { return m_histogram.count(); }
+
+		// percentile in range [0, 100] over the window
+		[[nodiscard]] inline std::chrono::nanoseconds percentile(double percent) const noexcept { return m_histogram.percentile(percent); }
+		[[nodiscard]] inline std::chrono::nanoseconds p50() const noexcept { return percentile(50.0); }
+		[[nodiscard]] inline std::chrono::nanoseconds p95() const noexcept { return percentile(95.0); }
+		[[nodiscard]] inline std::chrono::nanoseconds p99() const noexcept { return percentile(99.0); }
+		[[nodiscard]] inline std::chrono::nanoseconds p999() const noexcept { return percentile(99.9); }
+		[[nodiscard]] inline const latency_histogram& getHistogram() const noexcept { return m_histogram; }
+	};
+}
\ No newline at end of file
@@ -0,0 +1,155 @@
+#include "profiler.hpp"
+#include "spsc_queue.hpp"
+
+#include "engine/internal_libs.hpp"
+
+#include <algorithm>
+#include <fstream>
+
+
+
+namespace oe::utils
+{
+	profile_ring::profile_ring(size_t capacity, uint32_t thread_id)
+		: m_mask(ring_capacity(std::max<size_t>(capacity, 2)) - 1)
+		, m_slots(std::make_unique<slot[]>(m_mask + 1))
+		, m_thread_id(thread_id)
+		, m_thread_name(fmt::format("thread {}", thread_id))
+	{}
+
+	void profile_ring::snapshot(std::vector<profile_event>& out) const
+	{
+		const size_t capacity = m_mask + 1;
+		const size_t head = m_head.load(std::memory_order_acquire);
+		const size_t first = std::max(m_cleared.load(std::memory_order_acquire), head > capacity ? head - capacity : 0);
+
+		for (size_t i = first; i < head; i++)
+		{
+			// skipped if the writer already reused the slot, or was reusing it while it was copied
+			const slot& s = m_slots[i & m_mask];
+			const size_t sequence = s.m_sequence.load(std::memory_order_acquire);
+			if (sequence != i * 2 + 2)
+				continue;
+
+			const profile_event event{ s.m_name.load(std::memory_order_relaxed), s.m_begin.load(std::memory_order_relaxed), s.m_end.load(std::memory_order_relaxed) };
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (s.m_sequence.load(std::memory_order_relaxed) == sequence)
+				out.push_back(event);
+		}
+	}
+
+
+
+	Profiler::Profiler()
+		: m_epoch(std::chrono::steady_clock::now())
+	{}
+
+	profile_ring& Profiler::create_ring()
+	{
+		std::scoped_lock lock(m_rings_mutex);
+		m_rings.push_back(std::make_unique<profile_ring>(m_ring_capacity, static_cast<uint32_t>(m_rings.size())));
+		return *m_rings.back();
+	}
+
+	void Profiler::setRingCapacity(size_t capacity)
+	{
+		std::scoped_lock lock(m_rings_mutex);
+		m_ring_capacity = capacity;
+	}
+
+	void Profiler::setThreadName(std::string name)
+	{
+		profile_ring* ring = local_ring();
+		if (!ring)
+			return;
+		std::scoped_lock lock(m_rings_mutex);
+		ring->m_thread_name = std::move(name);
+	}
+
+	void Profiler::clear()
+	{
+		std::scoped_lock lock(m_rings_mutex);
+		for (auto& ring : m_rings)
+			ring->clear();
+	}
+
+	static void append_json_string(std::string& out, std::string_view str)
+	{
+		out += '"';
+		for (const char c : str)
+		{
+			switch (c)
+			{
+			case '"': out += "\\\""; break;
+			case '\\': out += "\\\\"; break;
+			case '\n': out += "\\n"; break;
+			case '\t': out += "\\t"; break;
+			default:
+				if (static_cast<unsigned char>(c) < 0x20)
+					out += fmt::format("\\u{:04x}", static_cast<int>(c));
+				else
+					out += c;
+			}
+		}
+		out += '"';
+	}
+
+	// trace event timestamps are in microseconds, keep the nanoseconds as the fraction
+	static void append_microseconds(std::string& out, uint64_t ns)
+	{
+		out += fmt::format("{}.{:03}", ns / 1000, ns % 1000);
+	}
+
+	std::string Profiler::chromeTrace()
+	{
+		std::string out = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+		bool first = true;
+		const auto separator = [&]() {
+			if (!first)
+				out += ",\n";
+			first = false;
+		};
+
+		std::vector<profile_event> events;
+		std::scoped_lock lock(m_rings_mutex);
+		for (const auto& ring : m_rings)
+		{
+			separator();
+			out += fmt::format("{{\"ph\":\"M\",\"pid\":0,\"tid\":{},\"name\":\"thread_name\",\"args\":{{\"name\":", ring->m_thread_id);
+			append_json_string(out, ring->m_thread_name);
+			out += "}}";
+
+			events.clear();
+			ring->snapshot(events);
+			for (const auto& event : events)
+			{
+				separator();
+				out += "{\"ph\":\"X\",\"pid\":0,\"tid\":";
+				out += std::to_string(ring->m_thread_id);
+				out += ",\"name\":";
+				append_json_string(out, event.name);
+				out += ",\"ts\":";
+				append_microseconds(out, event.begin_ns);
+				out += ",\"dur\":";
+				append_microseconds(out, event.end_ns - event.begin_ns);
+				out += '}';
+			}
+		}
+		out += "]}\n";
+		return out;
+	}
+
+	bool Profiler::dumpChromeTrace(const std::string& path)
+	{
+		std::ofstream file(path, std::ios::binary);
+		if (!file)
+		{
+			spdlog::warn("Could not open trace file: {}", path);
+			return false;
+		}
+
+		const std::string trace = chromeTrace();
+		file.write(trace.data(), static_cast<std::streamsize>(trace.size()));
+		return static_cast<bool>(file);
+	}
+}
@@ -0,0 +1,173 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+
+
+// OE_PROFILE_SCOPE("name") records a CPU zone from here to the end of the scope
+// name must be a string literal (or otherwise outlive the profiler)
+// compiled out unless OE_PROFILING is defined
+#define OE_PROFILE_CONCAT_IMPL(a, b) a##b
+#define OE_PROFILE_CONCAT(a, b) OE_PROFILE_CONCAT_IMPL(a, b)
+#if defined(OE_PROFILING)
+#define OE_PROFILE_SCOPE(name) const oe::utils::profile_zone OE_PROFILE_CONCAT(oe_profile_zone_, __LINE__){ name }
+#define OE_PROFILE_FUNCTION() OE_PROFILE_SCOPE(__func__)
+#define OE_PROFILE_THREAD(name) oe::utils::Profiler::getSingleton().setThreadName(name)
+#else
+#define OE_PROFILE_SCOPE(name) ((void)0)
+#define OE_PROFILE_FUNCTION() ((void)0)
+#define OE_PROFILE_THREAD(name) ((void)0)
+#endif
+
+
+
+namespace oe::utils
+{
+	struct profile_event
+	{
+		const char* name;
+		uint64_t begin_ns;
+		uint64_t end_ns;
+	};
+
+	// per thread ring of the latest zones
+	// only the owning thread writes, the exporter reads the published range and skips
+	// the slots the writer was rewriting while it copied them
+	class profile_ring
+	{
+	private:
+		// a seqlock per slot: odd while the writer is in it, 2 * (event index + 1) once it holds that event
+		struct slot
+		{
+			std::atomic<size_t> m_sequence{ 0 };
+			std::atomic<const char*> m_name{ nullptr };
+			std::atomic<uint64_t> m_begin{ 0 };
+			std::atomic<uint64_t> m_end{ 0 };
+		};
+
+		const size_t m_mask;
+		std::unique_ptr<slot[]> m_slots;
+		std::atomic<size_t> m_head{ 0 }; // total events written
+		std::atomic<size_t> m_cleared{ 0 }; // events before this were cleared
+
+	public:
+		const uint32_t m_thread_id;
+		std::string m_thread_name;
+
+	public:
+		profile_ring(size_t capacity, uint32_t thread_id);
+
+		inline void push(const profile_event& event) noexcept
+		{
+			const size_t head = m_head.load(std::memory_order_relaxed);
+			slot& s = m_slots[head & m_mask];
+			s.m_sequence.store(head * 2 + 1, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+			s.m_name.store(event.name, std::memory_order_relaxed);
+			s.m_begin.store(event.begin_ns, std::memory_order_relaxed);
+			s.m_end.store(event.end_ns, std::memory_order_relaxed);
+			s.m_sequence.store(head * 2 + 2, std::memory_order_release);
+			m_head.store(head + 1, std::memory_order_release);
+		}
+
+		// copies the events still in the ring, oldest first
+		void snapshot(std::vector<profile_event>& out) const;
+		inline void clear() noexcept { m_cleared.store(m_head.load(std::memory_order_acquire), std::memory_order_release); }
+		[[nodiscard]] inline size_t capacity() const noexcept { return m_mask + 1; }
+	};
+
+	class Profiler
+	{
+	private:
+		Profiler();
+
+		std::chrono::steady_clock::time_point m_epoch;
+		std::atomic<bool> m_enabled{ true };
+		size_t m_ring_capacity = 1 << 16;
+
+		// rings are never freed, a thread that exits keeps its zones for the next dump
+		std::mutex m_rings_mutex;
+		std::vector<std::unique_ptr<profile_ring>> m_rings;
+
+		profile_ring& create_ring();
+
+	public:
+		// the calling thread's ring, created on first use, null if that failed
+		inline profile_ring* local_ring() noexcept
+		{
+			thread_local profile_ring* ring = nullptr;
+			if (!ring)
+			{
+				try
+				{
+					ring = &create_ring();
+				}
+				catch (...)
+				{
+					return nullptr;
+				}
+			}
+			return ring;
+		}
+
+	public:
+		Profiler(const Profiler&) = delete;
+		// zones are recorded from any thread, so the first call has to be thread safe
+		static Profiler& getSingleton() {
+			static Profiler singleton;
+			return singleton;
+		}
+
+		[[nodiscard]] inline uint64_t now() const noexcept
+		{
+			return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_epoch).count());
+		}
+
+		inline void record(const char* name, uint64_t begin_ns, uint64_t end_ns) noexcept
+		{
+			if (profile_ring* ring = local_ring())
+				ring->push({ name, begin_ns, end_ns });
+		}
+
+		// runtime toggle on top of OE_PROFILING
+		inline void setEnabled(bool enabled) noexcept { m_enabled.store(enabled, std::memory_order_relaxed); }
+		[[nodiscard]] inline bool getEnabled() const noexcept { return m_enabled.load(std::memory_order_relaxed); }
+		// applies to rings created after this call
+		void setRingCapacity(size_t capacity);
+		void setThreadName(std::string name);
+		void clear();
+
+		// Chrome trace event format, open in Perfetto (ui.perfetto.dev) or chrome://tracing
+		[[nodiscard]] std::string chromeTrace();
+		bool dumpChromeTrace(const std::string& path);
+	};
+
+	// the ring is looked up when the zone starts, ending it only writes a slot
+	struct profile_zone
+	{
+		profile_ring* m_ring;
+		const char* m_name;
+		uint64_t m_begin;
+
+		inline explicit profile_zone(const char* name) noexcept
+			: m_ring(Profiler::getSingleton().getEnabled() ? Profiler::getSingleton().local_ring() : nullptr)
+			, m_name(name)
+			, m_begin(m_ring ? Profiler::getSingleton().now() : 0)
+		{}
+
+		inline ~profile_zone() noexcept
+		{
+			if (m_ring)
+				m_ring->push({ m_name, m_begin, Profiler::getSingleton().now() });
+		}
+
+		profile_zone(const profile_zone&) = delete;
+		profile_zone& operator=(const profile_zone&) = delete;
+	};
+}
@@ -0,0 +1,223 @@
+#pragma once
+
+#include "event_count.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <new>
+#include <optional>
+#include <type_traits>
+#include <iterator>
+
+
+
+namespace oe::utils
+{
+	static constexpr size_t cache_line_size = 64;
+
+	// round up to the next power of two, ring buffer indices are masked with (capacity - 1)
+	[[nodiscard]] constexpr size_t ring_capacity(size_t requested) noexcept
+	{
+		size_t capacity = 1;
+		while (capacity < requested)
+			capacity <<= 1;
+		return capacity;
+	}
+
+	// spsc_queue: bounded lock-free single-producer/single-consumer ring buffer
+	// exactly one thread may push and exactly one thread may pop at a time
+	template<typename T>
+	class spsc_queue
+	{
+	public:
+		using value_type = T;
+		using size_type = size_t;
+
+	private:
+		using storage_type = std::aligned_storage_t<sizeof(T), alignof(T)>;
+
+		const size_type m_capacity;
+		const size_type m_mask;
+		std::unique_ptr<storage_type[]> m_storage;
+
+		// consumer side
+		alignas(cache_line_size) std::atomic<size_type> m_head{ 0 };
+		size_type m_cached_tail = 0;
+
+		// producer side
+		alignas(cache_line_size) std::atomic<size_type> m_tail{ 0 };
+		size_type m_cached_head = 0;
+
+		alignas(cache_line_size) event_count m_readable{};
+		event_count m_writable{};
+
+	private:
+		[[nodiscard]] inline T* slot(size_type index) noexcept { return std::launder(reinterpret_cast<T*>(&m_storage[index & m_mask])); }
+
+		// producer: free slots, refreshes the cached head only when it looks full
+		[[nodiscard]] inline size_type free_slots(size_type tail) noexcept
+		{
+			size_type free = m_capacity - (tail - m_cached_head);
+			if (free == 0)
+			{
+				m_cached_head = m_head.load(std::memory_order_acquire);
+				free = m_capacity - (tail - m_cached_head);
+			}
+			return free;
+		}
+
+		// consumer: readable slots, refreshes the cached tail only when it looks empty
+		[[nodiscard]] inline size_type used_slots(size_type head) noexcept
+		{
+			size_type used = m_cached_tail - head;
+			if (used == 0)
+			{
+				m_cached_tail = m_tail.load(std::memory_order_acquire);
+				used = m_cached_tail - head;
+			}
+			return used;
+		}
+
+	public:
+		// ------------
+		// constructors
+		// ------------
+
+		inline explicit spsc_queue(size_type capacity = 1024)
+			: m_capacity(ring_capacity(capacity))
+			, m_mask(m_capacity - 1)
+			, m_storage(std::make_unique<storage_type[]>(m_capacity))
+		{}
+		spsc_queue(const spsc_queue&) = delete;
+		spsc_queue& operator=(const spsc_queue&) = delete;
+
+		inline ~spsc_queue()
+		{
+			if constexpr (!std::is_trivially_destructible_v<T>)
+				for (size_type i = m_head.load(std::memory_order_relaxed), last = m_tail.load(std::memory_order_relaxed); i != last; i++)
+					slot(i)->~T();
+		}
+
+		// ---------
+		// modifiers
+		// ---------
+
+		template<class ... Args>
+		[[nodiscard]] inline bool try_emplace(Args&& ... args)
+		{
+			const size_type tail = m_tail.load(std::memory_order_relaxed);
+			if (free_slots(tail) == 0)
+				return false;
+
+			new (slot(tail)) T(std::forward<Args>(args)...);
+			m_tail.store(tail + 1, std::memory_order_release);
+			m_readable.notify();
+			return true;
+		}
+		[[nodiscard]] inline bool try_push(const value_type& value) { return try_emplace(value); }
+		[[nodiscard]] inline bool try_push(value_type&& value) { return try_emplace(std::move(value)); }
+
+		// blocks while full
+		inline void push(const value_type& value) { wait_writable(); (void)try_emplace(value); }
+		inline void push(value_type&& value) { wait_writable(); (void)try_emplace(std::move(value)); }
+
+		// pushes as many as fit, returns the iterator to the first element not pushed
+		// consumers are woken up once per batch
+		template<typename InputIt>
+		inline InputIt try_push(InputIt first, InputIt last)
+		{
+			const size_type tail = m_tail.load(std::memory_order_relaxed);
+			const size_type free = free_slots(tail);
+
+			size_type count = 0;
+			for (; first != last && count < free; ++first, ++count)
+				new (slot(tail + count)) T(*first);
+
+			if (count == 0)
+				return first;
+
+			m_tail.store(tail + count, std::memory_order_release);
+			m_readable.notify();
+			return first;
+		}
+
+		[[nodiscard]] inline std::optional<value_type> try_pop()
+		{
+			const size_type head = m_head.load(std::memory_order_relaxed);
+			if (used_slots(head) == 0)
+				return std::nullopt;
+
+			T* ptr = slot(head);
+			std::optional<value_type> value{ std::move(*ptr) };
+			ptr->~T();
+			m_head.store(head + 1, std::memory_order_release);
+			m_writable.notify();
+			return value;
+		}
+
+		// pops up to max_count elements into out, returns the number of elements popped
+		template<typename OutputIt>
+		inline size_type try_pop(OutputIt out, size_type max_count)
+		{
+			const size_type head = m_head.load(std::memory_order_relaxed);
+			const size_type count = std::min(used_slots(head), max_count);
+
+			for (size_type i = 0; i < count; i++, ++out)
+			{
+				T* ptr = slot(head + i);
+				*out = std::move(*ptr);
+				ptr->~T();
+			}
+
+			if (count == 0)
+				return 0;
+
+			m_head.store(head + count, std::memory_order_release);
+			m_writable.notify();
+			return count;
+		}
+
+		// --------
+		// capacity
+		// --------
+
+		// approximate when called from neither the producer nor the consumer
+		[[nodiscard]] inline bool empty() const noexcept { return size() == 0; }
+		[[nodiscard]] inline bool full() const noexcept { return size() >= m_capacity; }
+		[[nodiscard]] inline size_type size() const noexcept { return m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire); }
+		[[nodiscard]] inline size_type capacity() const noexcept { return m_capacity; }
+
+		// ----
+		// wait
+		// ----
+
+		inline void wait() { m_readable.wait([this](){ return !empty(); }); }
+		template<typename Rep, typename Period>
+		inline bool wait_for(const std::chrono::duration<Rep, Period>& duration) { return m_readable.wait_for([this](){ return !empty(); }, duration); }
+		template<typename Clock, typename Duration>
+		inline bool wait_until(const std::chrono::time_point<Clock, Duration>& atime) { return m_readable.wait_until([this](){ return !empty(); }, atime); }
+
+		[[nodiscard]] inline value_type wait_pop()
+		{
+			wait();
+			return std::move(*try_pop());
+		}
+		template<typename Rep, typename Period>
+		[[nodiscard]] inline std::optional<value_type> wait_for_pop(const std::chrono::duration<Rep, Period>& duration)
+		{
+			if (!wait_for(duration))
+				return std::nullopt;
+			return try_pop();
+		}
+		template<typename Clock, typename Duration>
+		[[nodiscard]] inline std::optional<value_type> wait_until_pop(const std::chrono::time_point<Clock, Duration>& atime)
+		{
+			if (!wait_until(atime))
+				return std::nullopt;
+			return try_pop();
+		}
+
+		inline void wait_writable() { m_writable.wait([this](){ return !full(); }); }
+	};
+}
\ No newline at end of file
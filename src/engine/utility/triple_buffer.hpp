@@ -0,0 +1,42 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <optional>
+
+
+
+namespace oe::utils
+{
+	// triple_buffer: lock-free single-producer/single-consumer latest value
+	// write() never blocks and overwrites the value that has not been read yet
+	// read() returns only the newest value written since the previous read()
+	template<typename T>
+	class triple_buffer
+	{
+	private:
+		static constexpr uint8_t dirty_bit = 0b100;
+		static constexpr uint8_t index_mask = 0b011;
+
+		std::array<T, 3> m_buffers{};
+		std::atomic<uint8_t> m_middle{ 1 };
+		uint8_t m_back = 0; // producer
+		uint8_t m_front = 2; // consumer
+
+	public:
+		inline void write(const T& value)
+		{
+			m_buffers[m_back] = value;
+			m_back = m_middle.exchange(m_back | dirty_bit, std::memory_order_acq_rel) & index_mask;
+		}
+
+		[[nodiscard]] inline std::optional<T> read()
+		{
+			if (!(m_middle.load(std::memory_order_relaxed) & dirty_bit))
+				return std::nullopt;
+
+			m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & index_mask;
+			return m_buffers[m_front];
+		}
+	};
+}
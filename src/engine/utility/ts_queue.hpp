@@ -11,6 +11,7 @@
 namespace oe::utils
 {
 	// ts_queue: extended std::queue with wait_x, wait_for_x and wait_until_x
+	// see spsc_queue and mpmc_queue for bounded lock-free alternatives
 	template<typename T>
 	class ts_queue
 	{
@@ -34,15 +35,15 @@ namespace oe::utils
 		{
 			std::scoped_lock lock(m_mtx, copy.m_mtx);
 			m_container = copy.m_container;
-			m_empty = copy.m_empty;
-			m_size = copy.m_size;
+			m_empty = copy.m_empty.load();
+			m_size = copy.m_size.load();
 		}
 		inline ts_queue(ts_queue&& move)
 		{
 			std::scoped_lock lock(m_mtx, move.m_mtx);
 			m_container = std::move(move.m_container);
-			m_empty = move.m_empty;
-			m_size = move.m_size;
+			m_empty = move.m_empty.load();
+			m_size = move.m_size.load();
 		}
 		
 		template<class Alloc>
@@ -53,32 +54,34 @@ namespace oe::utils
 		inline ts_queue(const ts_queue& copy, const Alloc& alloc)
 		{
 			std::scoped_lock lock(m_mtx, copy.m_mtx);
-			m_container = { copy, alloc };
-			m_empty = copy.m_empty;
-			m_size = copy.m_size;
+			m_container = { copy.m_container, alloc };
+			m_empty = copy.m_empty.load();
+			m_size = copy.m_size.load();
 		}
 		template<class Alloc>
 		inline ts_queue(ts_queue&& move, const Alloc& alloc)
 		{
 			std::scoped_lock lock(m_mtx, move.m_mtx);
-			m_container = { move, alloc };
-			m_empty = move.m_empty;
-			m_size = move.m_size;
+			m_container = { std::move(move.m_container), alloc };
+			m_empty = move.m_empty.load();
+			m_size = move.m_size.load();
 		}
 
 		inline ts_queue& operator=(const ts_queue& copy)
 		{
 			std::scoped_lock lock(m_mtx, copy.m_mtx);
-			m_container = { copy };
-			m_empty = copy.m_empty;
-			m_size = copy.m_size;
+			m_container = copy.m_container;
+			m_empty = copy.m_empty.load();
+			m_size = copy.m_size.load();
+			return *this;
 		}
 		inline ts_queue& operator=(ts_queue&& move)
 		{
 			std::scoped_lock lock(m_mtx, move.m_mtx);
-			m_container = { move };
-			m_empty = move.m_empty;
-			m_size = move.m_size;
+			m_container = std::move(move.m_container);
+			m_empty = move.m_empty.load();
+			m_size = move.m_size.load();
+			return *this;
 		}
 
 		// --------------
@@ -256,7 +259,7 @@ namespace oe::utils
 		inline void push(value_type&& value)
 		{
 			std::scoped_lock lock(m_mtx);
-			m_container.push(value);
+			m_container.push(std::move(value));
 			m_size = m_container.size();
 			m_empty = m_container.empty();
 			m_cv.notify_one();
@@ -292,7 +295,7 @@ namespace oe::utils
 
 	private:
 		container_type m_container{};
-		std::mutex m_mtx{};
+		mutable std::mutex m_mtx{};
 		std::atomic<bool> m_empty{ true };
 		std::atomic<size_type> m_size{ 0 };
 
@@ -0,0 +1,326 @@
+#include "zip_cache.hpp"
+
+#include "engine/utility/formatted_error.hpp"
+
+#include <system_error>
+
+
+
+// ignore external warnings
+#ifdef __clang__
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wnullability-extension"
+#elif __GNUC__
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wdelete-incomplete"
+#endif
+
+#include <zip.h>
+
+// ignore external warnings
+#ifdef __clang__
+#pragma clang diagnostic pop
+#elif __GNUC__
+#pragma GCC diagnostic pop
+#endif
+
+
+
+namespace oe::utils
+{
+	static std::string open_error(int error)
+	{
+		zip_error_t ziperror;
+		zip_error_init_with_code(&ziperror, error);
+		std::string message = zip_error_strerror(&ziperror);
+		zip_error_fini(&ziperror);
+		return message;
+	}
+
+	// "a/b/" and "a/b" are the same directory
+	static std::string trim_slash(std::string path)
+	{
+		while (!path.empty() && path.back() == '/')
+			path.pop_back();
+		return path;
+	}
+
+	static std::string parent_of(const std::string& path)
+	{
+		const size_t slash = path.find_last_of('/');
+		return slash == std::string::npos ? std::string{} : path.substr(0, slash);
+	}
+
+
+
+	zip_archive::zip_archive(const fs::path& path_to_zip)
+		: m_path(path_to_zip)
+	{
+		std::error_code ec;
+		m_modified = fs::last_write_time(m_path, ec);
+		m_file_size = fs::file_size(m_path, ec);
+
+		int error;
+		const auto generic_to_zip = m_path.generic_string();
+		zip* handle = zip_open(generic_to_zip.c_str(), ZIP_RDONLY, &error);
+		if (!handle)
+			throw oe::utils::formatted_error("Failed to open {}, {}", generic_to_zip, open_error(error));
+
+		index(handle);
+		m_idle_handles.push_back(handle);
+	}
+
+	zip_archive::~zip_archive()
+	{
+		for (zip* handle : m_idle_handles)
+			zip_discard(handle);
+	}
+
+	void zip_archive::index(zip* handle)
+	{
+		m_entry_count = zip_get_num_entries(handle, 0);
+		m_files.reserve(static_cast<size_t>(m_entry_count));
+		m_directories[{}];
+
+		for (zip_int64_t i = 0; i < m_entry_count; i++)
+		{
+			zip_stat_t stats;
+			if (zip_stat_index(handle, static_cast<zip_uint64_t>(i), 0, &stats) != 0 || !(stats.valid & ZIP_STAT_NAME))
+				continue;
+
+			const std::string name = stats.name;
+			if (name.empty())
+				continue;
+
+			// folder entries end with a slash, folders are also implied by the paths of the files in them
+			if (name.back() == '/')
+			{
+				add_directory(trim_slash(name));
+				continue;
+			}
+
+			const std::string parent = parent_of(name);
+			add_directory(parent);
+			if (m_files.try_emplace(name, entry{ static_cast<uint64_t>(i), stats.valid & ZIP_STAT_SIZE ? stats.size : 0 }).second)
+				m_directories[parent].push_back(name);
+		}
+	}
+
+	void zip_archive::add_directory(const std::string& directory)
+	{
+		if (m_directories.find(directory) != m_directories.end())
+			return;
+
+		m_directories.emplace(directory, std::vector<std::string>{});
+		if (directory.empty())
+			return;
+
+		const std::string parent = parent_of(directory);
+		add_directory(parent);
+		m_directories[parent].push_back(directory);
+	}
+
+	bool zip_archive::stale() const
+	{
+		std::error_code ec;
+		const auto modified = fs::last_write_time(m_path, ec);
+		if (ec)
+			return true;
+		const auto file_size = fs::file_size(m_path, ec);
+		return ec || modified != m_modified || file_size != m_file_size;
+	}
+
+	const zip_archive::entry* zip_archive::find(const std::string& path_in_zip) const
+	{
+		const auto iter = m_files.find(path_in_zip);
+		return iter == m_files.end() ? nullptr : &iter->second;
+	}
+
+	const std::vector<std::string>* zip_archive::directory(const std::string& path_in_zip) const
+	{
+		const auto iter = m_directories.find(trim_slash(path_in_zip));
+		return iter == m_directories.end() ? nullptr : &iter->second;
+	}
+
+	zip* zip_archive::borrow()
+	{
+		{
+			std::scoped_lock lock(m_handle_mtx);
+			if (!m_idle_handles.empty())
+			{
+				zip* handle = m_idle_handles.back();
+				m_idle_handles.pop_back();
+				return handle;
+			}
+		}
+
+		int error;
+		const auto generic_to_zip = m_path.generic_string();
+		zip* handle = zip_open(generic_to_zip.c_str(), ZIP_RDONLY, &error);
+		if (!handle)
+			throw oe::utils::formatted_error("Failed to open {}, {}", generic_to_zip, open_error(error));
+
+		// rewritten since it was indexed, the entry indices would be wrong
+		if (zip_get_num_entries(handle, 0) != m_entry_count)
+		{
+			zip_discard(handle);
+			throw oe::utils::formatted_error("{} changed while it was being read", generic_to_zip);
+		}
+		return handle;
+	}
+
+	void zip_archive::give_back(zip* handle)
+	{
+		{
+			std::scoped_lock lock(m_handle_mtx);
+			if (m_idle_handles.size() < max_idle_handles)
+			{
+				m_idle_handles.push_back(handle);
+				return;
+			}
+		}
+		zip_discard(handle);
+	}
+
+	void zip_archive::read(const std::string& path_in_zip, std::vector<uint8_t>& data)
+	{
+		const entry* file = find(path_in_zip);
+		if (!file)
+			throw oe::utils::formatted_error("Failed to open file {} from zip, no such file", path_in_zip);
+
+		zip* handle = borrow();
+		zip_file_t* zip_file = zip_fopen_index(handle, file->index, 0);
+		if (!zip_file)
+		{
+			const std::string message = zip_strerror(handle);
+			give_back(handle);
+			throw oe::utils::formatted_error("Failed to open file {} from zip, {}", path_in_zip, message);
+		}
+
+		data.resize(static_cast<size_t>(file->size));
+		const zip_int64_t read_size = zip_fread(zip_file, data.data(), data.size());
+		zip_fclose(zip_file);
+		if (read_size < 0 || static_cast<uint64_t>(read_size) != file->size)
+		{
+			const std::string message = zip_strerror(handle);
+			give_back(handle);
+			throw oe::utils::formatted_error("Failed to read file {} from zip, {}", path_in_zip, message);
+		}
+		give_back(handle);
+	}
+
+
+
+	zip_archive_cache& zip_archive_cache::get()
+	{
+		static zip_archive_cache cache;
+		return cache;
+	}
+
+	std::shared_ptr<zip_archive> zip_archive_cache::acquire(const fs::path& path_to_zip)
+	{
+		const std::string key = path_to_zip.lexically_normal().generic_string();
+		const auto now = std::chrono::steady_clock::now();
+		std::shared_ptr<zip_archive> checking;
+		{
+			std::scoped_lock lock(m_mtx);
+			const auto iter = m_lookup.find(key);
+			if (iter != m_lookup.end())
+			{
+				if (now - iter->second->checked < stamp_interval)
+				{
+					m_lru.splice(m_lru.begin(), m_lru, iter->second);
+					m_stats.hits++;
+					return iter->second->archive;
+				}
+				checking = iter->second->archive;
+			}
+		}
+
+		// stat'ed without holding the lock
+		const bool stale = checking && checking->stale();
+		{
+			std::scoped_lock lock(m_mtx);
+			const auto iter = m_lookup.find(key);
+			if (iter != m_lookup.end())
+			{
+				// still fresh, or another thread reopened it meanwhile
+				if (iter->second->archive != checking || !stale)
+				{
+					if (iter->second->archive == checking)
+						iter->second->checked = now;
+					m_lru.splice(m_lru.begin(), m_lru, iter->second);
+					m_stats.hits++;
+					return iter->second->archive;
+				}
+
+				m_lru.erase(iter->second);
+				m_lookup.erase(iter);
+				m_stats.evictions++;
+			}
+			m_stats.misses++;
+		}
+
+		// opened and indexed without holding the lock, other archives stay readable meanwhile
+		auto archive = std::make_shared<zip_archive>(path_to_zip);
+
+		std::scoped_lock lock(m_mtx);
+		const auto iter = m_lookup.find(key);
+		if (iter != m_lookup.end())
+		{
+			// another thread opened it first
+			m_lru.splice(m_lru.begin(), m_lru, iter->second);
+			return iter->second->archive;
+		}
+
+		m_lru.push_front({ archive, now });
+		m_lookup.emplace(key, m_lru.begin());
+		evict_over_capacity();
+		return archive;
+	}
+
+	void zip_archive_cache::invalidate(const fs::path& path_to_zip)
+	{
+		std::scoped_lock lock(m_mtx);
+		const auto iter = m_lookup.find(path_to_zip.lexically_normal().generic_string());
+		if (iter == m_lookup.end())
+			return;
+
+		m_lru.erase(iter->second);
+		m_lookup.erase(iter);
+		m_stats.evictions++;
+	}
+
+	void zip_archive_cache::clear()
+	{
+		std::scoped_lock lock(m_mtx);
+		m_stats.evictions += m_lru.size();
+		m_lookup.clear();
+		m_lru.clear();
+	}
+
+	void zip_archive_cache::set_capacity(size_t archives)
+	{
+		std::scoped_lock lock(m_mtx);
+		m_capacity = archives;
+		evict_over_capacity();
+	}
+
+	zip_cache_stats zip_archive_cache::stats()
+	{
+		std::scoped_lock lock(m_mtx);
+		zip_cache_stats stats = m_stats;
+		stats.open_archives = m_lru.size();
+		return stats;
+	}
+
+	void zip_archive_cache::evict_over_capacity()
+	{
+		while (m_lru.size() > m_capacity)
+		{
+			m_lookup.erase(m_lru.back().archive->path().lexically_normal().generic_string());
+			m_lru.pop_back();
+			m_stats.evictions++;
+		}
+	}
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include "engine/engine.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+
+
+struct zip;
+
+namespace oe::utils
+{
+	struct zip_cache_stats
+	{
+		size_t open_archives = 0;
+		size_t hits = 0;
+		size_t misses = 0;      // opened and indexed
+		size_t evictions = 0;   // least recently used or changed on disk
+	};
+
+	// an opened .zip with its central directory indexed once
+	// libzip handles are not thread safe, every reader borrows one of its own from a small pool
+	class zip_archive
+	{
+	public:
+		struct entry
+		{
+			uint64_t index;
+			uint64_t size;
+		};
+
+		static constexpr size_t max_idle_handles = 4;
+
+	private:
+		fs::path m_path;
+		fs::file_time_type m_modified;
+		uintmax_t m_file_size;
+		int64_t m_entry_count = 0;
+
+		std::unordered_map<std::string, entry> m_files;                        // "dir/file.png"
+		std::unordered_map<std::string, std::vector<std::string>> m_directories; // "dir" -> { "dir/file.png", "dir/sub" }, "" is the root
+
+		std::mutex m_handle_mtx;
+		std::vector<zip*> m_idle_handles;
+
+	public:
+		// throws if the archive can't be opened
+		zip_archive(const fs::path& path_to_zip);
+		zip_archive(const zip_archive&) = delete;
+		~zip_archive();
+
+		// the file was modified or removed after it was indexed
+		[[nodiscard]] bool stale() const;
+
+		[[nodiscard]] const entry* find(const std::string& path_in_zip) const;
+		// direct children of a directory as full paths inside the archive, nullptr if there is no such directory
+		[[nodiscard]] const std::vector<std::string>* directory(const std::string& path_in_zip) const;
+
+		// any thread
+		void read(const std::string& path_in_zip, std::vector<uint8_t>& data);
+
+		[[nodiscard]] const fs::path& path() const noexcept { return m_path; }
+
+	private:
+		void index(zip* handle);
+		void add_directory(const std::string& directory);
+		[[nodiscard]] zip* borrow();
+		void give_back(zip* handle);
+	};
+
+	// keeps the most recently read archives open, so reads and listings inside them skip zip_open and the central directory scan
+	// changes by other processes are noticed within stamp_interval, writes through fileio invalidate right away
+	class zip_archive_cache
+	{
+	public:
+		static constexpr size_t default_capacity = 16;
+		// a cached archive is stat'ed again on acquire only after this long
+		static constexpr std::chrono::milliseconds stamp_interval{ 500 };
+
+	private:
+		struct cached
+		{
+			std::shared_ptr<zip_archive> archive;
+			std::chrono::steady_clock::time_point checked;
+		};
+		using lru_list = std::list<cached>;
+
+		std::mutex m_mtx;
+		lru_list m_lru; // most recent first
+		std::unordered_map<std::string, lru_list::iterator> m_lookup;
+		size_t m_capacity = default_capacity;
+		zip_cache_stats m_stats;
+
+	public:
+		static zip_archive_cache& get();
+
+		// opens and indexes the archive on a miss or if it changed on disk, throws if it can't be opened
+		// the archive stays usable after eviction until the last reader lets it go
+		[[nodiscard]] std::shared_ptr<zip_archive> acquire(const fs::path& path_to_zip);
+		// before and after writing to the archive
+		void invalidate(const fs::path& path_to_zip);
+		void clear();
+
+		void set_capacity(size_t archives);
+		[[nodiscard]] zip_cache_stats stats();
+
+	private:
+		void evict_over_capacity();
+	};
+}
@@ -0,0 +1,130 @@
+#include <engine/include.hpp>
+
+#include <atomic>
+#include <thread>
+
+
+
+/*
+
+	Repeated loads, duplicate content and what it counts for, the memory budget and hot reloading
+	first load vs cached load of the same images, and the built in assets AssetLoader reads
+
+*/
+
+constexpr size_t image_count = 8;
+constexpr int image_size = 512;
+
+using clock_type = std::chrono::high_resolution_clock;
+
+oe::utils::image_data make_image(size_t seed)
+{
+	oe::utils::image_data image{ oe::formats::rgba, image_size, image_size };
+	for (size_t i = 0; i < image.size; i++)
+		image.data[i] = static_cast<uint8_t>(i * 7 + seed * 31);
+	return image;
+}
+
+template<typename fn_t>
+float time_ms(fn_t&& fn)
+{
+	const auto start = clock_type::now();
+	fn();
+	return std::chrono::duration<float, std::milli>(clock_type::now() - start).count();
+}
+
+int main()
+{
+	oe::Engine::getSingleton().init({});
+	auto& cache = oe::asset::AssetCache::get();
+	bool ok = true;
+
+	const oe::utils::FileIO folder = oe::utils::FileIO{ fs::temp_directory_path() } / "oe_asset_cache";
+	std::vector<oe::utils::FileIO> paths;
+	for (size_t i = 0; i < image_count; i++)
+	{
+		paths.push_back(folder / fmt::format("image_{}.png", i));
+		paths.back().write(make_image(i).save());
+	}
+
+	// decoded once, the same object after that
+	std::vector<std::shared_ptr<const oe::utils::image_data>> first;
+	const float decode_time = time_ms([&]{ for (const auto& path : paths) first.push_back(cache.load<oe::utils::image_data>(path)); });
+	const float cached_time = time_ms([&]{ for (size_t i = 0; i < paths.size(); i++) ok &= cache.load<oe::utils::image_data>(paths[i]) == first[i]; });
+	spdlog::info("{} {}x{} images, decoded: {:.3f} ms, cached: {:.3f} ms", image_count, image_size, image_size, decode_time, cached_time);
+	ok &= cache.stats().hits == image_count && cache.stats().misses == image_count;
+
+	// same bytes under another name
+	const oe::utils::FileIO copy = folder / "copy.png";
+	copy.write(paths.front().read<oe::utils::byte_string>());
+	ok &= cache.load<oe::utils::image_data>(copy) == first.front();
+	ok &= cache.stats().deduplicated == 1;
+
+	// many threads, one decode
+	{
+		const size_t misses = cache.stats().misses;
+		std::atomic<bool> same = true;
+		std::vector<std::thread> threads;
+		for (size_t t = 0; t < 8; t++)
+			threads.emplace_back([&, t]{ for (size_t i = 0; i < 1000; i++) if (cache.load<oe::utils::image_data>(paths[(i + t) % paths.size()]) != first[(i + t) % paths.size()]) same = false; });
+		for (auto& thread : threads)
+			thread.join();
+		ok &= same && cache.stats().misses == misses;
+	}
+
+	// changed on disk
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(50));
+		paths.back().write(make_image(100).save());
+		const auto changed = cache.check_for_changes();
+		ok &= changed.size() == 1 && changed.front() == paths.back().getPath().generic_string();
+
+		const auto reloaded = cache.load<oe::utils::image_data>(paths.back());
+		ok &= reloaded != first.back() && reloaded->data[0] == make_image(100).data[0];
+		ok &= first.back()->data[0] == make_image(image_count - 1).data[0]; // old handles stay valid
+		spdlog::info("reloaded: {}", changed.front().generic_string());
+	}
+
+	// a shared asset counts once, for as long as any path holding it is cached
+	{
+		const size_t bytes = cache.stats().bytes;
+		cache.invalidate(paths.front());
+		ok &= cache.stats().bytes == bytes; // copy.png still holds it
+		ok &= cache.load<oe::utils::image_data>(paths.front()) == first.front() && cache.stats().bytes == bytes;
+		cache.invalidate(paths.front());
+		cache.invalidate(copy);
+		ok &= cache.stats().bytes == bytes - make_image(0).size;
+	}
+
+	// least recently used ones go first
+	{
+		const size_t one_image = make_image(0).size;
+		cache.set_budget(one_image * 2);
+		const auto stats = cache.stats();
+		ok &= stats.bytes <= one_image * 2 && stats.evictions > 0;
+		spdlog::info("budget {} bytes: {} entries, {} evictions", stats.budget, stats.entries, stats.evictions);
+		cache.set_budget(oe::asset::AssetCache::default_budget);
+	}
+
+	// built in assets
+	{
+		const size_t hits = cache.stats().hits;
+		const auto a = oe::asset::AssetLoader::resource_string("shader/default_shader/shader.vert.glsl");
+		const auto b = oe::asset::AssetLoader::resource_string("shader/default_shader/shader.vert.glsl");
+		ok &= !a.empty() && a == b && cache.stats().hits > hits;
+	}
+
+	// missing files throw and aren't cached
+	try
+	{
+		(void)cache.load<oe::utils::image_data>(folder / "missing.png");
+		ok = false;
+	}
+	catch (const std::exception&) {}
+
+	cache.clear();
+	ok &= cache.stats().entries == 0 && cache.stats().bytes == 0;
+
+	folder.remove();
+	return ok ? 0 : -1;
+}
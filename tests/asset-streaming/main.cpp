@@ -0,0 +1,195 @@
+#include <engine/include.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+
+/*
+
+	Asset streaming
+	decoding a "level" of PNGs on the calling thread vs on the AssetStreamer workers
+	priority order, cancellation, and the per frame upload budget with a simulated GPU copy
+
+*/
+
+constexpr size_t image_count = 48;
+constexpr int image_size = 512;
+constexpr auto frame_budget = std::chrono::microseconds(2000);
+constexpr auto simulated_upload = std::chrono::microseconds(700);
+
+using clock_type = std::chrono::high_resolution_clock;
+using oe::asset::load_priority;
+using oe::asset::load_status;
+
+oe::utils::image_data make_image(size_t seed)
+{
+	oe::utils::image_data image{ oe::formats::rgba, image_size, image_size };
+	for (int y = 0; y < image_size; y++)
+		for (int x = 0; x < image_size; x++)
+		{
+			uint8_t* pixel = image.data + (static_cast<size_t>(y) * image_size + x) * 4;
+			pixel[0] = static_cast<uint8_t>(x + seed);
+			pixel[1] = static_cast<uint8_t>(y ^ seed);
+			pixel[2] = static_cast<uint8_t>((x * y) >> 6);
+			pixel[3] = 255;
+		}
+	return image;
+}
+
+bool same(const oe::utils::image_data& a, const oe::utils::image_data& b)
+{
+	return a.width == b.width && a.height == b.height && a.size == b.size && std::memcmp(a.data, b.data, a.size) == 0;
+}
+
+// a worker that only finishes after release(), so the jobs behind it stay queued
+struct gate
+{
+	std::atomic<bool> open{ false };
+	oe::asset::asset_handle<int> job;
+
+	void close(oe::asset::AssetStreamer& streamer)
+	{
+		open = false;
+		job = streamer.submit<int>([this](){ while (!open) std::this_thread::yield(); return 0; }, load_priority::critical);
+		while (job.status() == load_status::queued)
+			std::this_thread::yield();
+	}
+
+	void release() { open = true; job.wait(); }
+};
+
+int main()
+{
+	oe::Engine::getSingleton().init({});
+	bool ok = true;
+
+	const oe::utils::FileIO folder = oe::utils::FileIO{ fs::temp_directory_path() } / "oe_asset_streaming";
+	std::vector<oe::utils::image_data> originals;
+	std::vector<oe::utils::FileIO> paths;
+	for (size_t i = 0; i < image_count; i++)
+	{
+		originals.push_back(make_image(i));
+		paths.push_back(folder / fmt::format("image_{}.png", i));
+		paths.back().write(originals.back());
+	}
+
+	// the whole level on this thread
+	auto start = clock_type::now();
+	for (size_t i = 0; i < image_count; i++)
+		ok &= same(paths[i].read<oe::utils::image_data>(), originals[i]);
+	const std::chrono::duration<float, std::milli> sync_time = clock_type::now() - start;
+
+	// the whole level on the workers
+	{
+		oe::asset::AssetStreamer streamer;
+		start = clock_type::now();
+		std::vector<oe::asset::asset_handle<oe::utils::image_data>> handles;
+		for (const auto& path : paths)
+			handles.push_back(streamer.load<oe::utils::image_data>(path));
+		for (size_t i = 0; i < image_count; i++)
+			ok &= same(handles[i].get(), originals[i]);
+		const std::chrono::duration<float, std::milli> async_time = clock_type::now() - start;
+
+		spdlog::info("{} {}x{} PNGs, this thread: {:8.3f} ms, {} workers: {:8.3f} ms ({:.2f}x)",
+			image_count, image_size, image_size, sync_time.count(), oe::asset::AssetStreamer::default_worker_count(), async_time.count(), sync_time / async_time);
+	}
+
+	oe::asset::AssetStreamer streamer{ 1 };
+	gate blocker;
+
+	// priorities, submission order within one
+	{
+		std::mutex order_mtx;
+		std::vector<int> order;
+		const auto record = [&](int value) { return [&, value](){ std::scoped_lock lock(order_mtx); order.push_back(value); return value; }; };
+
+		blocker.close(streamer);
+		auto background = streamer.submit<int>(record(0), load_priority::background);
+		auto normal_a = streamer.submit<int>(record(1), load_priority::normal);
+		auto high = streamer.submit<int>(record(2), load_priority::high);
+		auto normal_b = streamer.submit<int>(record(3), load_priority::normal);
+		blocker.release();
+		background.wait();
+
+		const bool in_order = order == std::vector<int>{ 2, 1, 3, 0 };
+		ok &= in_order;
+		spdlog::info("priority order: {}", in_order ? "ok" : "wrong");
+	}
+
+	// cancellation: never decoded, get() throws
+	{
+		std::atomic<size_t> decoded{ 0 };
+		std::vector<oe::asset::asset_handle<oe::utils::image_data>> handles;
+		blocker.close(streamer);
+		for (size_t i = 0; i < 8; i++)
+			handles.push_back(streamer.submit<oe::utils::image_data>([&, i](){ decoded++; return paths[i].read<oe::utils::image_data>(); }));
+		for (size_t i = 0; i < handles.size(); i += 2)
+			ok &= handles[i].cancel();
+		blocker.release();
+
+		size_t cancelled = 0;
+		for (size_t i = 0; i < handles.size(); i++)
+		{
+			try
+			{
+				ok &= same(handles[i].get(), originals[i]) && i % 2 == 1;
+			}
+			catch (const std::exception&)
+			{
+				cancelled++;
+				ok &= handles[i].status() == load_status::cancelled;
+			}
+		}
+		ok &= decoded == 4 && cancelled == 4;
+		spdlog::info("cancelled: {}, decoded: {}", cancelled, decoded.load());
+
+		auto missing = streamer.load<oe::utils::image_data>(folder / "missing.png");
+		missing.wait();
+		ok &= missing.status() == load_status::failed;
+	}
+
+	// uploads spread over frames, like textures on the GL thread
+	{
+		std::vector<std::vector<uint8_t>> gpu(image_count);
+		std::vector<oe::asset::asset_handle<size_t>> handles;
+		for (size_t i = 0; i < image_count; i++)
+		{
+			handles.push_back(streamer.submit<size_t>(
+				[path = paths[i]](){ return path.read<oe::utils::image_data>(); },
+				[&gpu, i](oe::utils::image_data& image){
+					const auto upload_start = clock_type::now();
+					gpu[i].assign(image.data, image.data + image.size);
+					while (clock_type::now() - upload_start < simulated_upload);
+					return i;
+				}));
+		}
+
+		size_t frames = 0, uploads = 0, most_uploads = 0;
+		std::chrono::nanoseconds longest{ 0 };
+		while (!std::all_of(handles.begin(), handles.end(), [](const auto& h){ return h.finished(); }))
+		{
+			const auto frame_start = clock_type::now();
+			const size_t uploaded = streamer.upload(frame_budget);
+			uploads += uploaded;
+			most_uploads = std::max(most_uploads, uploaded);
+			longest = std::max<std::chrono::nanoseconds>(longest, clock_type::now() - frame_start);
+			frames++;
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+
+		for (size_t i = 0; i < image_count; i++)
+			ok &= handles[i].ready() && handles[i].get() == i && gpu[i].size() == originals[i].size && std::memcmp(gpu[i].data(), originals[i].data, gpu[i].size()) == 0;
+		// each upload takes at least simulated_upload, the one that started inside the budget still runs
+		ok &= uploads == image_count && most_uploads <= static_cast<size_t>(frame_budget / simulated_upload) + 1;
+		spdlog::info("{} uploads over {} frames, at most {} per frame, longest frame {:.3f} ms with a {:.3f} ms budget",
+			image_count, frames, most_uploads, std::chrono::duration<float, std::milli>(longest).count(), std::chrono::duration<float, std::milli>(frame_budget).count());
+	}
+
+	folder.remove();
+	return ok ? 0 : -1;
+}
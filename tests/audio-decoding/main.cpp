@@ -0,0 +1,159 @@
+#include <engine/include.hpp>
+
+#include <cmath>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+
+
+/*
+
+	A wav built in memory decoded in chunks, seeked, decoded ahead on the worker and decoded whole,
+	time to the first sample against decoding everything, and files that aren't audio
+
+*/
+
+constexpr int sample_rate = 44100;
+constexpr int channels = 2;
+constexpr size_t frames = sample_rate * 3;
+
+std::vector<int16_t> make_samples()
+{
+	std::vector<int16_t> samples(frames * channels);
+	for (size_t i = 0; i < frames; i++)
+	{
+		samples[i * 2 + 0] = static_cast<int16_t>(std::sin(static_cast<float>(i) * 0.05f) * 16000.0f);
+		samples[i * 2 + 1] = static_cast<int16_t>(i % 30000);
+	}
+	return samples;
+}
+
+std::vector<uint8_t> make_wav(const std::vector<int16_t>& samples)
+{
+	std::vector<uint8_t> wav;
+	const auto put = [&](const void* data, size_t size){ wav.insert(wav.end(), static_cast<const uint8_t*>(data), static_cast<const uint8_t*>(data) + size); };
+	const auto put32 = [&](uint32_t value){ put(&value, 4); };
+	const auto put16 = [&](uint16_t value){ put(&value, 2); };
+
+	const uint32_t data_size = static_cast<uint32_t>(samples.size() * sizeof(int16_t));
+	put("RIFF", 4); put32(36 + data_size); put("WAVE", 4);
+	put("fmt ", 4); put32(16); put16(1); put16(channels); put32(sample_rate); put32(sample_rate * channels * 2); put16(channels * 2); put16(16);
+	put("data", 4); put32(data_size); put(samples.data(), data_size);
+	return wav;
+}
+
+bool same(const int16_t* a, const int16_t* b, size_t frame_count)
+{
+	return std::memcmp(a, b, frame_count * channels * sizeof(int16_t)) == 0;
+}
+
+int main()
+{
+	oe::Engine::getSingleton().init({});
+	bool ok = true;
+
+	const auto samples = make_samples();
+	const auto wav = make_wav(samples);
+	ok &= oe::utils::audio_decoder::detect(wav) == oe::utils::audio_format::wav;
+
+	// chunk by chunk
+	{
+		auto decoder = oe::utils::audio_decoder::open(wav);
+		ok &= decoder->channels() == channels && decoder->sample_rate() == sample_rate && decoder->length() == frames;
+
+		std::vector<int16_t> chunk(1000 * channels);
+		size_t read = 0;
+		while (size_t got = decoder->read(chunk.data(), 1000))
+		{
+			ok &= same(chunk.data(), samples.data() + read * channels, got);
+			read += got;
+		}
+		ok &= read == frames && decoder->tell() == frames;
+
+		// two seconds in
+		ok &= decoder->seek(sample_rate * 2) && decoder->tell() == sample_rate * 2;
+		ok &= decoder->read(chunk.data(), 1000) == 1000 && same(chunk.data(), samples.data() + sample_rate * 2 * channels, 1000);
+		ok &= !decoder->seek(frames + 1);
+	}
+
+	// decoded ahead on the worker
+	{
+		oe::utils::decode_ahead ahead{ oe::utils::audio_decoder::open(wav), 8192 };
+		std::vector<int16_t> decoded(frames * channels);
+		ok &= ahead.read(decoded.data(), frames / 2) == frames / 2;
+
+		// whatever the worker got to, without waiting
+		size_t read = frames / 2;
+		const auto start = std::chrono::steady_clock::now();
+		while (!ahead.ended() && std::chrono::steady_clock::now() - start < std::chrono::seconds(5))
+		{
+			read += ahead.try_read(decoded.data() + read * channels, frames - read);
+			std::this_thread::yield();
+		}
+		ok &= read == frames && ahead.ended() && ahead.tell() == frames && same(decoded.data(), samples.data(), frames);
+
+		// back to the start, what was buffered is dropped
+		ok &= ahead.seek(100) && ahead.tell() == 100;
+		ok &= ahead.read(decoded.data(), 500) == 500 && same(decoded.data(), samples.data() + 100 * channels, 500);
+	}
+
+	// decoded whole
+	{
+		const oe::utils::audio_data audio{ wav };
+		ok &= audio.channels == channels && audio.sample_rate == sample_rate && audio.frames() == frames;
+		ok &= audio.size == static_cast<int>(samples.size() * sizeof(int16_t)) && same(audio.data, samples.data(), frames);
+
+		// the rest of it
+		auto decoder = oe::utils::audio_decoder::open(wav);
+		decoder->seek(frames - 1000);
+		const oe::utils::audio_data rest{ *decoder };
+		ok &= rest.frames() == 1000 && same(rest.data, samples.data() + (frames - 1000) * channels, 1000);
+	}
+
+	// time to the first sample
+	{
+		std::vector<int16_t> chunk(1024 * channels);
+		auto start = std::chrono::high_resolution_clock::now();
+		auto decoder = oe::utils::audio_decoder::open(wav);
+		decoder->read(chunk.data(), 1024);
+		const std::chrono::duration<float, std::milli> first = std::chrono::high_resolution_clock::now() - start;
+
+		start = std::chrono::high_resolution_clock::now();
+		const oe::utils::audio_data audio{ wav };
+		const std::chrono::duration<float, std::milli> whole = std::chrono::high_resolution_clock::now() - start;
+		spdlog::info("first 1024 frames in {:.3f} ms, all {} frames in {:.3f} ms", first.count(), audio.frames(), whole.count());
+	}
+
+	// streamed through the mixer
+	{
+		oe::audio::device_settings settings;
+		settings.backend = oe::audio::audio_backend::none;
+		oe::audio::AudioDevice device{ settings };
+		const auto voice = device.play(oe::audio::AudioStream::open(oe::utils::audio_decoder::open(wav)));
+		std::vector<float> out(oe::audio::AudioDevice::block_frames * 2);
+		size_t audible = 0;
+		for (size_t i = 0; i < 200; i++)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			device.render(out.data(), oe::audio::AudioDevice::block_frames);
+			for (size_t j = 0; j < oe::audio::AudioDevice::block_frames; j++)
+				audible += out[j * 2] != 0.0f;
+		}
+		ok &= voice.playing() && audible > 0;
+	}
+
+	// not audio, or broken
+	const auto throws = [](std::vector<uint8_t> bytes){
+		try { (void)oe::utils::audio_decoder::open(bytes); }
+		catch (const std::exception&) { return true; }
+		return false;
+	};
+	ok &= throws({ 'n', 'o', 't', ' ', 'a', 'u', 'd', 'i', 'o' });
+	ok &= throws({ 'O', 'g', 'g', 'S', 0, 0, 0, 0, 0, 0, 0, 0 });
+	ok &= throws({ 0xFF, 0xFB, 0x00, 0x00 });
+	ok &= throws({ 'R', 'I', 'F', 'F', 0, 0, 0, 0, 'W', 'A', 'V', 'E' });
+	ok &= throws({});
+
+	return ok ? 0 : -1;
+}
@@ -0,0 +1,182 @@
+#include <engine/include.hpp>
+
+#include <cmath>
+#include <thread>
+#include <vector>
+
+
+
+/*
+
+	Mixer output rendered by hand, gain/pan/pitch/loop/pause/stop, a stream, mix cost with every voice in use
+	and a clip played through miniaudio's null backend, no sound card needed
+
+*/
+
+constexpr uint32_t sample_rate = 48000;
+
+std::shared_ptr<const oe::utils::audio_data> make_clip(int frames, int channels, int rate, float amplitude)
+{
+	std::vector<int16_t> samples(static_cast<size_t>(frames) * channels);
+	for (int i = 0; i < frames; i++)
+		for (int c = 0; c < channels; c++)
+			samples[static_cast<size_t>(i) * channels + c] = static_cast<int16_t>(std::sin(static_cast<float>(i) * 0.0576f) * amplitude * 32767.0f);
+	// size in bytes, like the decoders give it
+	return std::make_shared<const oe::utils::audio_data>(samples.data(), 0, static_cast<int>(samples.size() * sizeof(int16_t)), channels, rate);
+}
+
+// a sine decoded on the stream thread, 'frames' long
+class SineStream : public oe::audio::AudioStream
+{
+private:
+	size_t m_left;
+	size_t m_time = 0;
+
+public:
+	SineStream(size_t frames) : m_left(frames) {}
+
+	int channels() const noexcept override { return 2; }
+	int sample_rate() const noexcept override { return 44100; }
+
+	size_t read(float* frames, size_t frame_count) override
+	{
+		frame_count = std::min(frame_count, m_left);
+		for (size_t i = 0; i < frame_count; i++, m_time++)
+			frames[i * 2 + 0] = frames[i * 2 + 1] = 0.25f * std::sin(static_cast<float>(m_time) * 0.05f);
+		m_left -= frame_count;
+		return frame_count;
+	}
+
+	bool rewind() override { return false; }
+};
+
+float peak(const std::vector<float>& samples, size_t first, size_t last, size_t channel)
+{
+	float peak = 0.0f;
+	for (size_t i = first; i < last; i++)
+		peak = std::max(peak, std::abs(samples[i * 2 + channel]));
+	return peak;
+}
+
+int main()
+{
+	oe::Engine::getSingleton().init({});
+	bool ok = true;
+
+	oe::audio::device_settings settings;
+	settings.backend = oe::audio::audio_backend::none;
+	settings.sample_rate = sample_rate;
+	settings.max_voices = 4;
+	oe::audio::AudioDevice device{ settings };
+
+	const auto clip = make_clip(4800, 1, sample_rate, 0.5f);
+	std::vector<float> out(sample_rate * 2);
+
+	// centered, the first block fades in
+	auto voice = device.play(clip);
+	device.render(out.data(), 5000);
+	ok &= !voice.playing() && std::abs(peak(out, 256, 4800, 0) - 0.5f) < 0.01f && std::abs(peak(out, 256, 4800, 1) - 0.5f) < 0.01f && peak(out, 4800, 5000, 0) == 0.0f;
+
+	// hard left
+	device.play(clip, { 1.0f, -1.0f });
+	device.render(out.data(), 5000);
+	ok &= peak(out, 256, 4800, 0) > 0.5f && peak(out, 256, 4800, 1) < 1e-4f;
+
+	// twice as fast, half as long
+	voice = device.play(clip, { 1.0f, 0.0f, 2.0f });
+	device.render(out.data(), 2400 + oe::audio::AudioDevice::block_frames);
+	ok &= !voice.playing();
+
+	// a 44.1 kHz clip takes as long at 48 kHz
+	voice = device.play(make_clip(44100, 2, 44100, 0.5f));
+	device.render(out.data(), 47900);
+	ok &= voice.playing();
+	device.render(out.data(), oe::audio::AudioDevice::block_frames);
+	ok &= !voice.playing();
+
+	// looping until stopped, stopping fades out within a block
+	voice = device.play(clip, { 1.0f, 0.0f, 1.0f, true });
+	device.render(out.data(), 20000);
+	ok &= voice.playing();
+	voice.stop();
+	device.render(out.data(), oe::audio::AudioDevice::block_frames);
+	ok &= !voice.playing();
+
+	// paused voices keep their place
+	voice = device.play(clip);
+	voice.pause();
+	device.render(out.data(), 10000);
+	ok &= voice.paused();
+	voice.resume();
+	device.render(out.data(), 5000);
+	ok &= !voice.playing();
+
+	// muted bus
+	device.set_bus_gain(oe::audio::bus::effects, 0.0f);
+	device.render(out.data(), oe::audio::AudioDevice::block_frames);
+	device.play(clip);
+	device.render(out.data(), 2000);
+	ok &= peak(out, 0, 2000, 0) == 0.0f;
+	device.set_bus_gain(oe::audio::bus::effects, 1.0f);
+	device.render(out.data(), 5000);
+
+	// every voice in use
+	std::vector<oe::audio::AudioPlayer> voices;
+	for (size_t i = 0; i <= device.max_voices(); i++)
+		voices.push_back(device.play(clip));
+	ok &= !voices.back().valid() && device.stats().rejected == 1;
+	device.render(out.data(), 5000);
+	device.update();
+
+	// streamed, a second of 44.1 kHz is a second of 48 kHz
+	{
+		voice = device.play(std::make_unique<SineStream>(44100));
+		size_t frames = 0, audible = 0;
+		while (voice.playing() && frames < sample_rate * 4)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			device.render(out.data(), oe::audio::AudioDevice::block_frames);
+			frames += oe::audio::AudioDevice::block_frames;
+			for (size_t i = 0; i < oe::audio::AudioDevice::block_frames; i++)
+				audible += out[i * 2] != 0.0f;
+		}
+		const auto stats = device.stats();
+		ok &= !voice.playing() && stats.underruns == 0 && audible > 47000 && audible <= sample_rate;
+		spdlog::info("stream: {} frames audible, {} underruns", audible, stats.underruns);
+	}
+
+	// mix cost
+	{
+		oe::audio::device_settings bench_settings = settings;
+		bench_settings.max_voices = 64;
+		oe::audio::AudioDevice bench{ bench_settings };
+		const auto music = make_clip(44100 * 4, 2, 44100, 0.1f);
+		for (size_t i = 0; i < bench.max_voices(); i++)
+			bench.play(music, { 0.5f, static_cast<float>(i % 9) / 4.0f - 1.0f, 0.8f + static_cast<float>(i) * 0.01f, true });
+
+		const auto start = std::chrono::high_resolution_clock::now();
+		for (size_t i = 0; i < sample_rate * 2 / oe::audio::AudioDevice::block_frames; i++)
+			bench.render(out.data(), oe::audio::AudioDevice::block_frames);
+		const std::chrono::duration<float, std::milli> time = std::chrono::high_resolution_clock::now() - start;
+		const auto stats = bench.stats();
+		spdlog::info("{} voices, 2 s mixed in {:.2f} ms ({:.0f}x real time), {:.4f} ms per {} frame block", stats.voices, time.count(), 2000.0f / time.count(), stats.mix_ms_average, oe::audio::AudioDevice::block_frames);
+		ok &= stats.voices == bench.max_voices();
+	}
+
+	// played in real time without a sound card
+	{
+		oe::audio::device_settings null_settings;
+		null_settings.backend = oe::audio::audio_backend::null;
+		oe::audio::AudioDevice null_device{ null_settings };
+		const auto played = null_device.play(make_clip(9600, 1, sample_rate, 0.5f));
+
+		const auto start = std::chrono::steady_clock::now();
+		while (played.playing() && std::chrono::steady_clock::now() - start < std::chrono::seconds(5))
+			std::this_thread::sleep_for(std::chrono::milliseconds(5));
+		const auto stats = null_device.stats();
+		ok &= !played.playing() && stats.callbacks > 0;
+		spdlog::info("null backend: {} callbacks, {} frames", stats.callbacks, stats.frames);
+	}
+
+	return ok ? 0 : -1;
+}
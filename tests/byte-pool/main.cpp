@@ -0,0 +1,92 @@
+#include <engine/include.hpp>
+
+#include <cstring>
+#include <vector>
+
+
+
+/*
+
+	Batch decoding out of the byte pool
+	the first pass gets its blocks from the system, the ones after that reuse them
+	and the pool's own guarantees: in place reallocation, recycled blocks and per frame counters
+
+*/
+
+constexpr size_t image_count = 32;
+constexpr int image_size = 1024;
+constexpr size_t passes = 4;
+
+using clock_type = std::chrono::high_resolution_clock;
+
+oe::utils::image_data make_image(size_t seed)
+{
+	oe::utils::image_data image{ oe::formats::rgba, image_size, image_size };
+	for (size_t i = 0; i < image.size; i++)
+		image.data[i] = static_cast<uint8_t>((i >> 2) * (seed + 1) + (i >> 14));
+	return image;
+}
+
+int main()
+{
+	oe::Engine::getSingleton().init({});
+	auto& pool = oe::utils::byte_pool::get();
+	bool ok = true;
+
+	// the pool itself
+	{
+		auto* block = static_cast<uint8_t*>(pool.allocate(100));
+		std::memset(block, 42, 100);
+		ok &= pool.reallocate(block, 64) == block && pool.reallocate(block, 128) == block;
+		auto* grown = static_cast<uint8_t*>(pool.reallocate(block, 4096));
+		ok &= grown[0] == 42 && grown[63] == 42 && oe::utils::byte_pool::size_of(grown) == 4096;
+		pool.free(grown);
+		void* recycled = pool.allocate(3000);
+		ok &= recycled == grown;
+		pool.free(recycled);
+
+		// quarter steps above 1 MiB, 1.3 MiB gets a 1.5 MiB block
+		constexpr size_t mib = 1024 * 1024;
+		const size_t in_use = pool.stats().bytes_in_use;
+		void* large = pool.allocate(mib + 300 * 1024);
+		ok &= pool.stats().bytes_in_use - in_use == mib + mib / 2;
+		ok &= pool.reallocate(large, mib + mib / 2) == large;
+		large = pool.reallocate(large, mib + mib / 2 + 1);
+		ok &= pool.stats().bytes_in_use - in_use == mib + mib * 3 / 4;
+		pool.free(large);
+	}
+
+	std::vector<oe::utils::byte_string> encoded;
+	for (size_t i = 0; i < image_count; i++)
+		encoded.push_back(make_image(i).save());
+
+	for (size_t pass = 0; pass < passes; pass++)
+	{
+		pool.next_frame();
+		const auto before = pool.stats();
+		const auto start = clock_type::now();
+
+		std::vector<oe::utils::image_data> decoded;
+		decoded.reserve(image_count);
+		for (const auto& png : encoded)
+			decoded.emplace_back(png.data(), png.size());
+		const std::chrono::duration<float, std::milli> time = clock_type::now() - start;
+
+		ok &= decoded.front().size == static_cast<size_t>(image_size) * image_size * 4;
+		pool.next_frame();
+		const auto after = pool.stats();
+		spdlog::info("pass {}: {} {}x{} PNGs in {:8.3f} ms, {} allocations ({} recycled), {:.1f} MiB this frame",
+			pass, image_count, image_size, image_size, time.count(),
+			after.allocations - before.allocations, after.reused - before.reused, after.frame_bytes / (1024.0f * 1024.0f));
+		if (pass > 0)
+			ok &= after.reused - before.reused >= image_count;
+	}
+
+	// everything decoded is back in the pool
+	const auto stats = pool.stats();
+	spdlog::info("in use: {} B, retained: {:.1f} MiB", stats.bytes_in_use, stats.bytes_retained / (1024.0f * 1024.0f));
+	pool.trim();
+	ok &= pool.stats().bytes_retained == 0;
+
+	return ok ? 0 : -1;
+}
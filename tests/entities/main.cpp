@@ -234,6 +234,7 @@ void resize(const oe::ResizeEvent& event)
 {
 	glm::mat4 pr_matrix = glm::ortho(-20.0f * event.aspect, 20.0f * event.aspect, 20.0f, -20.0f);
 	shader->setProjectionMatrix(pr_matrix);
+	world->m_renderer.setCullArea(pr_matrix);
 }
 
 // update event 30 times per second
@@ -0,0 +1,146 @@
+#include <engine/include.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+
+
+/*
+
+	Reads and listings inside a .zip
+	every read opening the archive and scanning its central directory vs the archive cache
+	and a few threads reading from the same archive at once
+	a large file copied into memory vs mapped
+
+*/
+
+constexpr size_t folder_count = 16;
+constexpr size_t files_per_folder = 32;
+constexpr size_t file_size = 256;
+constexpr size_t read_threads = 4;
+constexpr size_t large_file_size = 64 * 1024 * 1024;
+
+using clock_type = std::chrono::high_resolution_clock;
+
+oe::utils::byte_string file_content(size_t folder, size_t file)
+{
+	oe::utils::byte_string data(file_size);
+	for (size_t i = 0; i < data.size(); i++)
+		data[i] = static_cast<uint8_t>(folder * 31 + file * 7 + i);
+	return data;
+}
+
+oe::utils::FileIO file_path(const oe::utils::FileIO& zip, size_t folder, size_t file)
+{
+	return zip / fmt::format("folder_{}", folder) / fmt::format("file_{}.bin", file);
+}
+
+// every file once, false if any of them has the wrong content
+bool read_all(const oe::utils::FileIO& zip, bool cached)
+{
+	bool ok = true;
+	for (size_t folder = 0; folder < folder_count; folder++)
+	{
+		for (size_t file = 0; file < files_per_folder; file++)
+		{
+			if (!cached)
+				oe::utils::FileIO::clearZipCache();
+			ok &= file_path(zip, folder, file).read<oe::utils::byte_string>() == file_content(folder, file);
+		}
+	}
+	return ok;
+}
+
+int main()
+{
+	oe::Engine::getSingleton().init({});
+
+	const oe::utils::FileIO zip = oe::utils::FileIO{ fs::temp_directory_path() } / "oe_fileio_test.zip";
+	zip.remove();
+	for (size_t folder = 0; folder < folder_count; folder++)
+		for (size_t file = 0; file < files_per_folder; file++)
+			file_path(zip, folder, file).write(file_content(folder, file));
+
+	bool ok = true;
+
+	// listings
+	const auto root = zip.items();
+	const auto folder = (zip / "folder_3").items();
+	ok &= root.size() == folder_count && folder.size() == files_per_folder;
+	spdlog::info("root: {} items, folder_3: {} items", root.size(), folder.size());
+
+	// sequential reads
+	auto start = clock_type::now();
+	ok &= read_all(zip, false);
+	const std::chrono::duration<float, std::milli> uncached = clock_type::now() - start;
+
+	read_all(zip, true);
+	start = clock_type::now();
+	ok &= read_all(zip, true);
+	const std::chrono::duration<float, std::milli> cached = clock_type::now() - start;
+
+	constexpr size_t total = folder_count * files_per_folder;
+	spdlog::info("{} reads, reopened every time: {:8.3f} ms, {:6.2f} us/read", total, uncached.count(), uncached.count() * 1000.0f / total);
+	spdlog::info("{} reads, cached archive:      {:8.3f} ms, {:6.2f} us/read", total, cached.count(), cached.count() * 1000.0f / total);
+
+	// concurrent reads from the same archive
+	std::atomic<bool> threads_ok{ true };
+	std::vector<std::thread> threads;
+	start = clock_type::now();
+	for (size_t i = 0; i < read_threads; i++)
+		threads.emplace_back([&](){ if (!read_all(zip, true)) threads_ok = false; });
+	for (auto& thread : threads)
+		thread.join();
+	const std::chrono::duration<float, std::milli> concurrent = clock_type::now() - start;
+	ok &= threads_ok;
+	spdlog::info("{} reads on {} threads:        {:8.3f} ms", total * read_threads, read_threads, concurrent.count());
+
+	// writing invalidates the cached index
+	const auto extra = zip / "folder_0" / "extra.bin";
+	extra.write(file_content(1, 1));
+	ok &= (zip / "folder_0").items().size() == files_per_folder + 1 && extra.read<oe::utils::byte_string>() == file_content(1, 1);
+
+	// mapped reads, zip entries end up in an owned buffer
+	const auto mapped_entry = file_path(zip, 2, 5).map();
+	ok &= !mapped_entry.mapped() && oe::utils::byte_string(mapped_entry.begin(), mapped_entry.end()) == file_content(2, 5);
+
+	const oe::utils::FileIO large = oe::utils::FileIO{ fs::temp_directory_path() } / "oe_fileio_test.bin";
+	oe::utils::byte_string large_content(large_file_size);
+	for (size_t i = 0; i < large_content.size(); i++)
+		large_content[i] = static_cast<uint8_t>(i * 13 + (i >> 12));
+	large.write(large_content);
+
+	// touching every page, like a decoder would
+	const auto page_sum = [](const uint8_t* begin, const uint8_t* end) {
+		uint64_t sum = 0;
+		for (const uint8_t* page = begin; page < end; page += 4096)
+			sum += *page;
+		return sum;
+	};
+
+	start = clock_type::now();
+	const auto copied = large.read<oe::utils::byte_string>();
+	const uint64_t copied_sum = page_sum(copied.data(), copied.data() + copied.size());
+	const std::chrono::duration<float, std::milli> copy_time = clock_type::now() - start;
+
+	start = clock_type::now();
+	std::chrono::duration<float, std::milli> map_time;
+	{
+		const auto mapped = large.map();
+		const uint64_t mapped_sum = page_sum(mapped.begin(), mapped.end());
+		map_time = clock_type::now() - start;
+		ok &= mapped.mapped() && copied_sum == mapped_sum && std::equal(mapped.begin(), mapped.end(), large_content.begin(), large_content.end());
+	}
+	ok &= copied == large_content;
+	spdlog::info("{} MiB file, read into memory: {:8.3f} ms, mapped: {:8.3f} ms", large_file_size / (1024 * 1024), copy_time.count(), map_time.count());
+
+	const auto stats = oe::utils::FileIO::zipCacheStats();
+	spdlog::info("zip cache: {} open, {} hits, {} misses, {} evictions", stats.open_archives, stats.hits, stats.misses, stats.evictions);
+
+	oe::utils::FileIO::clearZipCache();
+	zip.remove();
+	large.remove();
+	return ok ? 0 : -1;
+}
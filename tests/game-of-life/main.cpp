@@ -481,7 +481,7 @@ void Application::on_key(const oe::KeyboardEvent& e)
 			std::bitset<w * h> bits;
 
 			oe::utils::FileIO file(savePath);
-			auto bytes = file.read<oe::utils::byte_string>();
+			const auto bytes = file.map();
 			std::memcpy(&bits, bytes.data(), std::min(sizeof(bits), bytes.size()));
 
 			free(savePath);
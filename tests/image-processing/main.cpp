@@ -0,0 +1,139 @@
+#include <engine/include.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <limits>
+
+
+
+/*
+
+	image_data::cast and crop on a 4K texture
+	format conversions, downscaling with every filter, an upscale and a crop
+	checked against a plain per pixel version of the same math
+
+*/
+
+constexpr int width = 3840;
+constexpr int height = 2160;
+constexpr size_t repeats = 5;
+
+using clock_type = std::chrono::high_resolution_clock;
+
+oe::utils::image_data make_image()
+{
+	oe::utils::image_data image{ oe::formats::rgba, width, height };
+	for (int y = 0; y < height; y++)
+		for (int x = 0; x < width; x++)
+		{
+			uint8_t* pixel = image.data + (static_cast<size_t>(y) * width + x) * 4;
+			pixel[0] = static_cast<uint8_t>(x);
+			pixel[1] = static_cast<uint8_t>(y);
+			pixel[2] = static_cast<uint8_t>((x * y) >> 8);
+			pixel[3] = static_cast<uint8_t>(x ^ y);
+		}
+	return image;
+}
+
+// the best of a few runs
+float time_ms(const std::function<oe::utils::image_data()>& fn, oe::utils::image_data& result)
+{
+	std::chrono::duration<float, std::milli> best{ std::numeric_limits<float>::max() };
+	for (size_t i = 0; i < repeats; i++)
+	{
+		const auto start = clock_type::now();
+		result = fn();
+		best = std::min<std::chrono::duration<float, std::milli>>(best, clock_type::now() - start);
+	}
+	return best.count();
+}
+
+// nearest filtering and the to_* conversions, one pixel at a time
+template<int Channels>
+bool matches_reference(const oe::utils::image_data& source, const oe::utils::image_data& result)
+{
+	const float ratio_x = static_cast<float>(source.width) / static_cast<float>(result.width);
+	const float ratio_y = static_cast<float>(source.height) / static_cast<float>(result.height);
+	for (int y = 0; y < result.height; y++)
+		for (int x = 0; x < result.width; x++)
+		{
+			const uint8_t* in = source.data + (static_cast<size_t>(y * ratio_y) * source.width + static_cast<size_t>(x * ratio_x)) * 4;
+			const uint8_t* out = result.data + (static_cast<size_t>(y) * result.width + x) * Channels;
+			const glm::vec<4, uint8_t> rgba{ in[0], in[1], in[2], in[3] };
+
+			if constexpr (Channels == 4)
+			{
+				if (std::memcmp(out, in, 4) != 0)
+					return false;
+			}
+			else if constexpr (Channels == 3)
+			{
+				const auto expected = oe::utils::to_rgb(rgba);
+				if (out[0] != expected.r || out[1] != expected.g || out[2] != expected.b)
+					return false;
+			}
+			else
+			{
+				if (out[0] != oe::utils::to_mono(rgba).x)
+					return false;
+			}
+		}
+	return true;
+}
+
+bool is_flat(const oe::utils::image_data& image, uint8_t value)
+{
+	return std::all_of(image.data, image.data + image.size, [value](uint8_t byte){ return byte == value; });
+}
+
+int main()
+{
+	oe::Engine::getSingleton().init({});
+	bool ok = true;
+
+	const oe::utils::image_data image = make_image();
+	oe::utils::image_data result;
+	const auto report = [&](std::string_view name, float ms) {
+		spdlog::info("{:<28} {:4}x{:<4} {:8.3f} ms", name, result.width, result.height, ms);
+	};
+
+	report("rgba -> rgb", time_ms([&](){ return image.cast(oe::formats::rgb); }, result));
+	ok &= matches_reference<3>(image, result);
+	report("rgba -> mono", time_ms([&](){ return image.cast(oe::formats::mono); }, result));
+	ok &= matches_reference<1>(image, result);
+
+	report("1080p nearest", time_ms([&](){ return image.cast(oe::formats::none, 1920, 1080); }, result));
+	ok &= matches_reference<4>(image, result);
+	report("1080p nearest, rgb", time_ms([&](){ return image.cast(oe::formats::rgb, 1920, 1080); }, result));
+	ok &= matches_reference<3>(image, result);
+	report("1080p bilinear", time_ms([&](){ return image.cast(oe::formats::none, 1920, 1080, oe::utils::image_filter::bilinear); }, result));
+	report("1080p box", time_ms([&](){ return image.cast(oe::formats::none, 1920, 1080, oe::utils::image_filter::box); }, result));
+	report("256x256 box", time_ms([&](){ return image.cast(oe::formats::none, 256, 256, oe::utils::image_filter::box); }, result));
+
+	const oe::utils::image_data small = image.cast(oe::formats::none, 1280, 720);
+	oe::utils::image_data upscaled;
+	const float upscale_ms = time_ms([&](){ return small.cast(oe::formats::none, width, height, oe::utils::image_filter::bilinear); }, upscaled);
+	result = upscaled;
+	report("720p -> 4K bilinear", upscale_ms);
+
+	report("crop 2048x2048", time_ms([&](){ return image.crop(896, 56, 2048, 2048); }, result));
+	for (int y = 0; y < result.height; y++)
+		ok &= std::memcmp(result.data + static_cast<size_t>(y) * 2048 * 4, image.data + (static_cast<size_t>(y + 56) * width + 896) * 4, 2048 * 4) == 0;
+
+	// filters never move a flat color
+	oe::utils::image_data flat{ oe::formats::rgb, 1001, 777 };
+	std::memset(flat.data, 200, flat.size);
+	for (const auto filter : { oe::utils::image_filter::nearest, oe::utils::image_filter::bilinear, oe::utils::image_filter::box })
+	{
+		ok &= is_flat(flat.cast(oe::formats::none, 333, 250, filter), 200);
+		ok &= is_flat(flat.cast(oe::formats::none, 2000, 1600, filter), 200);
+		ok &= is_flat(flat.cast(oe::formats::none, 1, 1, filter), 200);
+	}
+
+	// cropping past the edges
+	const auto edge = image.crop(width - 10, height - 10, 100, 100);
+	ok &= edge.width == 10 && edge.height == 10;
+
+	return ok ? 0 : -1;
+}
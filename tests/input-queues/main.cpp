@@ -0,0 +1,106 @@
+#include <engine/enum.hpp>
+#include <engine/utility/spsc_queue.hpp>
+#include <engine/utility/triple_buffer.hpp>
+#include <engine/internal_libs.hpp>
+
+#include <thread>
+
+
+
+/*
+
+	Window input delivery without a window
+	a glfw callback thread producing into the per type queues and the latest cursor buffer,
+	the gameloop thread draining them into a dispatcher like IWindow::dispatchInputEvents
+
+*/
+
+constexpr size_t event_count = 200'000;
+constexpr size_t queue_size = 1024;
+constexpr size_t key_range = 2048; // IWindow::max_number_of_keys
+
+struct consumer_t
+{
+	size_t keys = 0;
+	size_t cursors = 0;
+	bool in_order = true;
+	int last_key = -1;
+	int last_cursor = -1;
+
+	void on_key(const oe::KeyboardEvent& event)
+	{
+		in_order &= static_cast<int>(event.key) == (last_key + 1) % static_cast<int>(key_range);
+		last_key = static_cast<int>(event.key);
+		keys++;
+	}
+
+	void on_cursor(const oe::CursorPosEvent& event)
+	{
+		// coalesced: never the same or an older position twice
+		in_order &= event.cursor_windowspace.x > last_cursor;
+		last_cursor = event.cursor_windowspace.x;
+		cursors++;
+	}
+};
+
+int main()
+{
+	oe::utils::spsc_queue<oe::KeyboardEvent> key_events{ queue_size };
+	oe::utils::triple_buffer<oe::CursorPosEvent> latest_cursor_event{};
+	std::atomic<bool> produced = false;
+	bool ok = true;
+
+	consumer_t consumer;
+	entt::dispatcher dispatcher;
+	dispatcher.sink<oe::KeyboardEvent>().connect<&consumer_t::on_key>(consumer);
+	dispatcher.sink<oe::CursorPosEvent>().connect<&consumer_t::on_cursor>(consumer);
+
+	// callback thread, waits instead of dropping to check that nothing gets lost
+	std::thread producer([&](){
+		for (size_t i = 0; i < event_count; i++)
+		{
+			oe::KeyboardEvent key;
+			key.key = static_cast<oe::keys>(i % key_range);
+			key.timestamp = std::chrono::steady_clock::now();
+			while (!key_events.try_push(key))
+				key_events.wait_writable();
+
+			oe::CursorPosEvent cursor;
+			cursor.cursor_windowspace = { static_cast<int>(i), 0 };
+			cursor.timestamp = key.timestamp;
+			latest_cursor_event.write(cursor);
+		}
+		produced = true;
+	});
+
+	// gameloop thread
+	std::chrono::steady_clock::duration max_latency{ 0 };
+	while (true)
+	{
+		const bool last_drain = produced;
+		const auto now = std::chrono::steady_clock::now();
+		auto dispatch = [&](const auto& event)
+		{
+			max_latency = std::max(max_latency, now - event.timestamp);
+			dispatcher.trigger(event);
+		};
+
+		if (auto event = latest_cursor_event.read())
+			dispatch(*event);
+		while (auto event = key_events.try_pop())
+			dispatch(*event);
+
+		if (last_drain)
+			break;
+		std::this_thread::yield();
+	}
+	producer.join();
+
+	ok &= consumer.in_order && consumer.keys == event_count;
+	ok &= consumer.cursors > 0 && consumer.cursors <= event_count && consumer.last_cursor == static_cast<int>(event_count - 1);
+	ok &= !latest_cursor_event.read() && !key_events.try_pop();
+	spdlog::info("{} key events in order: {}, {} of {} cursor events after coalescing, max latency {:.3f} ms",
+		consumer.keys, consumer.in_order, consumer.cursors, event_count, std::chrono::duration<float, std::milli>(max_latency).count());
+
+	return ok ? 0 : -1;
+}
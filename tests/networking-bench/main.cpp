@@ -0,0 +1,262 @@
+#include <engine/include.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <ctime>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+
+
+/*
+
+	Loopback networking benchmark
+	client -> server messages per delivery mode, one packet per message vs batched
+	and bytes vs CPU time for every compression mode, with game-like messages
+	and the round trip of a single reliable message between idle service threads
+	with the poller and with the old 50 ms enet_host_service loop
+
+*/
+
+constexpr uint16_t port = 12222;
+constexpr size_t message_size = 32;
+constexpr size_t messages_per_tick = 100;
+constexpr size_t tick_count = 200;
+constexpr auto tick_interval = std::chrono::milliseconds(1);
+constexpr auto drain_timeout = std::chrono::seconds(10);
+
+struct result_t
+{
+	size_t received;
+	std::chrono::duration<float> time;
+	oe::networking::statistics wire;
+};
+
+result_t run(oe::networking::Client& client, std::atomic<size_t>& received, oe::networking::delivery mode)
+{
+	constexpr size_t message_count = messages_per_tick * tick_count;
+	const std::vector<uint8_t> message(message_size, 0x5a);
+
+	received = 0;
+	const auto stats_before = client.stats();
+	const auto start = std::chrono::high_resolution_clock::now();
+
+	// a game sending a handful of small messages every tick
+	for (size_t tick = 0; tick < tick_count; tick++)
+	{
+		for (size_t i = 0; i < messages_per_tick; i++)
+			client.send(message.begin(), message.end(), mode);
+		std::this_thread::sleep_for(tick_interval);
+	}
+
+	// unreliable modes may lose some, stop waiting once nothing has arrived for a while
+	auto last_progress = std::chrono::high_resolution_clock::now();
+	size_t last_received = 0;
+	while (received < message_count && std::chrono::high_resolution_clock::now() - last_progress < drain_timeout / 10)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		if (received != last_received)
+		{
+			last_received = received;
+			last_progress = std::chrono::high_resolution_clock::now();
+		}
+	}
+	const auto end = received == message_count ? std::chrono::high_resolution_clock::now() : last_progress;
+
+	const auto stats_after = client.stats();
+	return { received, end - start, { stats_after.sent_bytes - stats_before.sent_bytes, stats_after.sent_packets - stats_before.sent_packets } };
+}
+
+// entity updates: a type, an entity id, a position and a health byte, enough repetition to compress
+std::vector<uint8_t> game_message(oe::utils::Random& random, uint32_t entity)
+{
+	std::vector<uint8_t> message(message_size, 0);
+	const uint16_t type = static_cast<uint16_t>(random.randomi(1, 4));
+	const glm::vec2 position = random.randomVec2(-100.0f, 100.0f);
+	const uint8_t health = static_cast<uint8_t>(random.randomi(90, 100));
+	std::memcpy(message.data(), &type, sizeof(type));
+	std::memcpy(message.data() + 2, &entity, sizeof(entity));
+	std::memcpy(message.data() + 6, &position, sizeof(position));
+	message[14] = health;
+	return message;
+}
+
+// a fresh connection per mode, both ends have to agree on it
+bool run_compression(oe::networking::compression mode, const std::vector<uint8_t>& dictionary, std::string_view name, std::vector<std::vector<uint8_t>>* capture)
+{
+	constexpr size_t message_count = messages_per_tick * tick_count;
+	auto& random = oe::utils::Random::getSingleton();
+	std::atomic<size_t> received{ 0 };
+	std::atomic<size_t> client_id{ 0 };
+
+	oe::networking::Server server;
+	oe::utils::connect_guard cg_server_connect, cg_server_receive;
+	cg_server_connect.connect<oe::networking::ServerConnectEvent>(server.m_dispatcher, [&client_id](const oe::networking::ServerConnectEvent& e) {
+		client_id = e.client_id;
+	});
+	cg_server_receive.connect<oe::networking::ServerReceiveEvent>(server.m_dispatcher, [&received](const oe::networking::ServerReceiveEvent&) {
+		received++;
+	});
+	oe::networking::Client client;
+	server.set_compression(mode, dictionary);
+	client.set_compression(mode, dictionary);
+	if (capture)
+		client.capture_traffic(256 * 1024);
+
+	if (server.open(port + 1).failed() || client.connect("localhost", port + 1).failed())
+	{
+		spdlog::critical("Compression {} connection failed", name);
+		return false;
+	}
+
+	for (size_t tick = 0; tick < tick_count; tick++)
+	{
+		for (size_t i = 0; i < messages_per_tick; i++)
+		{
+			const auto message = game_message(random, static_cast<uint32_t>(i));
+			client.send(message.begin(), message.end(), oe::networking::delivery::reliable);
+		}
+		std::this_thread::sleep_for(tick_interval);
+	}
+	const auto start = std::chrono::high_resolution_clock::now();
+	while (received < message_count && std::chrono::high_resolution_clock::now() - start < drain_timeout)
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+	const auto wire = client.stats();
+	const auto sent = client.compressor_stats();
+	const auto peer = server.client_compressor_stats(client_id);
+	const size_t packets = std::max<size_t>(sent.compressed_packets + sent.incompressible_packets, 1);
+	spdlog::info("{:<16} received {:6}/{} wire: {:8} bytes, ratio: {:5.3f}, compress: {:6.0f} ns/packet ({} of {} packets compressed), server decompress: {:6.0f} ns/packet",
+		name, received.load(), message_count, wire.sent_bytes,
+		sent.compress_raw_bytes ? static_cast<float>(sent.compress_compressed_bytes) / sent.compress_raw_bytes : 1.0f,
+		static_cast<float>(sent.compress_ns) / packets, sent.compressed_packets, packets,
+		peer.decompressed_packets ? static_cast<float>(peer.decompress_ns) / peer.decompressed_packets : 0.0f);
+
+	if (capture)
+		*capture = client.captured_traffic();
+	client.close();
+	server.close();
+	return true;
+}
+
+// one message at a time, echoed back, the service threads go idle between the pings
+// timed: the old loop blocking in enet_host_service for 50 ms, for comparison
+bool run_latency(bool timed)
+{
+	constexpr size_t ping_count = 1000;
+	const uint16_t latency_port = timed ? port + 3 : port + 2;
+	std::atomic<size_t> pongs{ 0 };
+
+	oe::networking::Server server;
+	server.set_timed_service(timed);
+	oe::utils::connect_guard cg_server_receive, cg_client_receive;
+	cg_server_receive.connect<oe::networking::ServerReceiveEvent>(server.m_dispatcher, [&server](const oe::networking::ServerReceiveEvent& e) {
+		server.send_to(e.data.begin(), e.data.end(), e.client_id);
+	});
+	oe::networking::Client client;
+	client.set_timed_service(timed);
+	cg_client_receive.connect<oe::networking::ClientReceiveEvent>(client.m_dispatcher, [&pongs](const oe::networking::ClientReceiveEvent&) {
+		pongs++;
+	});
+	if (server.open(latency_port).failed() || client.connect("localhost", latency_port).failed())
+	{
+		spdlog::critical("Latency connection failed");
+		return false;
+	}
+
+	const std::vector<uint8_t> message(message_size, 0x5a);
+	std::vector<float> rtt_us;
+	rtt_us.reserve(ping_count);
+	for (size_t i = 0; i < ping_count; i++)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		const auto start = std::chrono::high_resolution_clock::now();
+		client.send(message.begin(), message.end());
+		while (pongs == i && std::chrono::high_resolution_clock::now() - start < drain_timeout)
+			std::this_thread::yield();
+		rtt_us.push_back(std::chrono::duration<float, std::micro>(std::chrono::high_resolution_clock::now() - start).count());
+	}
+	std::sort(rtt_us.begin(), rtt_us.end());
+	const auto at = [&](float p) { return rtt_us[std::min(rtt_us.size() - 1, static_cast<size_t>(p * rtt_us.size()))]; };
+	const char* name = timed ? "timed 50 ms" : "poller";
+	spdlog::info("{:<11} reliable round trip: p50 {:.0f} us, p90 {:.0f} us, p99 {:.0f} us, max {:.0f} us ({}/{} pongs)",
+		name, at(0.5f), at(0.9f), at(0.99f), rtt_us.back(), pongs.load(), ping_count);
+
+	// both service threads idle, connected
+	const std::clock_t cpu_start = std::clock();
+	std::this_thread::sleep_for(std::chrono::seconds(1));
+	spdlog::info("{:<11} idle connection: {:.1f} ms CPU per second", name, 1000.0f * static_cast<float>(std::clock() - cpu_start) / CLOCKS_PER_SEC);
+
+	client.close();
+	server.close();
+	return pongs == ping_count;
+}
+
+int main()
+{
+	oe::Engine::getSingleton().init({});
+	std::atomic<size_t> received{ 0 };
+
+	oe::networking::Server server;
+	oe::utils::connect_guard cg_server_receive;
+	cg_server_receive.connect<oe::networking::ServerReceiveEvent>(server.m_dispatcher, [&received](const oe::networking::ServerReceiveEvent&) {
+		received++;
+	});
+	auto result = server.open(port);
+	if (result.failed())
+	{
+		spdlog::critical("Server open failed: {}", result.message());
+		return -1;
+	}
+
+	oe::networking::Client client;
+	result = client.connect("localhost", port);
+	if (result.failed())
+	{
+		spdlog::critical("Client connect failed: {}", result.message());
+		return -1;
+	}
+
+	constexpr std::pair<oe::networking::delivery, std::string_view> modes[] = {
+		{ oe::networking::delivery::reliable, "reliable" },
+		{ oe::networking::delivery::unreliable, "unreliable" },
+		{ oe::networking::delivery::unsequenced, "unsequenced" },
+		{ oe::networking::delivery::unreliable_fragment, "unreliable_fragment" },
+	};
+	constexpr size_t message_count = messages_per_tick * tick_count;
+	spdlog::info("{} messages of {} bytes, {} per tick", message_count, message_size, messages_per_tick);
+	for (const auto& [mode, name] : modes)
+	{
+		for (const bool batching : { false, true })
+		{
+			client.set_batching(batching);
+			const auto r = run(client, received, mode);
+			spdlog::info("{:<20} {:<9} received {:6}/{} {:10.0f} msg/s, wire: {:8} bytes {:6} packets {:6.1f} bytes/msg",
+				name, batching ? "batched" : "unbatched", r.received, message_count, r.received / r.time.count(),
+				r.wire.sent_bytes, r.wire.sent_packets, static_cast<float>(r.wire.sent_bytes) / message_count);
+		}
+	}
+
+	client.close();
+	server.close();
+
+	if (!run_latency(false) || !run_latency(true))
+		return -1;
+
+	// lz4 first, its capture trains the dictionary
+	std::vector<std::vector<uint8_t>> captured;
+	const std::vector<uint8_t> no_dictionary;
+	if (!run_compression(oe::networking::compression::none, no_dictionary, "none", nullptr) ||
+		!run_compression(oe::networking::compression::lz4, no_dictionary, "lz4", &captured))
+		return -1;
+	const auto dictionary = oe::networking::train_dictionary(captured);
+	spdlog::info("dictionary: {} bytes from {} captured packets", dictionary.size(), captured.size());
+	if (!run_compression(oe::networking::compression::lz4, dictionary, "lz4 + dictionary", nullptr) ||
+		!run_compression(oe::networking::compression::range_coder, no_dictionary, "range coder", nullptr))
+		return -1;
+
+	const auto allocator = oe::networking::packet_allocator::getSingleton().stats();
+	spdlog::info("ENet allocations: {}, pooled: {}, malloc: {}, free: {}", allocator.allocations, allocator.pool_hits, allocator.system_allocations, allocator.system_frees);
+	return 0;
+}
@@ -0,0 +1,168 @@
+#include <engine/include.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+
+
+/*
+
+	Networking under impaired conditions
+	client -> proxy -> server on loopback, the proxy adds delay, jitter, loss, duplication and a bandwidth cap
+	reports RTT percentiles of echoed reliable pings, reliable throughput, retransmits and packet loss per scenario
+
+*/
+
+constexpr uint16_t server_port = 12226;
+constexpr uint16_t proxy_port = 12227;
+constexpr size_t ping_count = 100;
+constexpr auto ping_interval = std::chrono::milliseconds(10);
+constexpr size_t bulk_bytes = 256 * 1024;
+constexpr size_t bulk_message_size = 1024;
+constexpr size_t bulk_messages_per_tick = 16;
+constexpr auto drain_timeout = std::chrono::seconds(30);
+
+constexpr uint8_t ping_kind = 'p';
+constexpr uint8_t bulk_kind = 'b';
+
+using clock_type = std::chrono::high_resolution_clock;
+using namespace std::chrono_literals;
+
+struct scenario
+{
+	std::string_view name;
+	oe::networking::impairment impairment;
+};
+
+template<typename Fn>
+bool wait_for(Fn&& done)
+{
+	const auto start = clock_type::now();
+	while (!done())
+	{
+		if (clock_type::now() - start > drain_timeout)
+			return false;
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	return true;
+}
+
+float percentile(const std::vector<float>& sorted, float p)
+{
+	if (sorted.empty())
+		return 0.0f;
+	return sorted[std::min(sorted.size() - 1, static_cast<size_t>(p * static_cast<float>(sorted.size())))];
+}
+
+// a fresh server, proxy and client per scenario
+bool run(const scenario& s)
+{
+	std::atomic<size_t> client_id{ 0 };
+	std::atomic<size_t> bulk_received{ 0 };
+
+	// server echoes pings and counts bulk bytes
+	oe::networking::Server server;
+	oe::utils::connect_guard cg_server_connect, cg_server_receive;
+	cg_server_connect.connect<oe::networking::ServerConnectEvent>(server.m_dispatcher, [&client_id](const oe::networking::ServerConnectEvent& e) {
+		client_id = e.client_id;
+	});
+	cg_server_receive.connect<oe::networking::ServerReceiveEvent>(server.m_dispatcher, [&](const oe::networking::ServerReceiveEvent& e) {
+		if (e.data.empty())
+			return;
+		if (e.data[0] == ping_kind)
+			server.send_to(e.data.begin(), e.data.end(), e.client_id);
+		else
+			bulk_received += e.data.size();
+	});
+
+	oe::networking::impairment_proxy proxy;
+	proxy.configure(s.impairment);
+
+	// client times the echoes
+	oe::networking::Client client;
+	std::vector<clock_type::time_point> ping_sent(ping_count);
+	std::vector<float> rtt_ms(ping_count, 0.0f);
+	std::atomic<size_t> pongs{ 0 };
+	oe::utils::connect_guard cg_client_receive;
+	cg_client_receive.connect<oe::networking::ClientReceiveEvent>(client.m_dispatcher, [&](const oe::networking::ClientReceiveEvent& e) {
+		uint32_t index;
+		if (e.data.size() != 1 + sizeof(index) || e.data[0] != ping_kind)
+			return;
+		std::memcpy(&index, e.data.data() + 1, sizeof(index));
+		rtt_ms[index] = std::chrono::duration<float, std::milli>(clock_type::now() - ping_sent[index]).count();
+		pongs++;
+	});
+
+	if (server.open(server_port).failed() || proxy.open(proxy_port, "localhost", server_port).failed() || client.connect("localhost", proxy_port).failed())
+	{
+		spdlog::critical("{}: connection failed", s.name);
+		return false;
+	}
+
+	// pings
+	for (uint32_t i = 0; i < ping_count; i++)
+	{
+		uint8_t message[1 + sizeof(i)] = { ping_kind };
+		std::memcpy(message + 1, &i, sizeof(i));
+		ping_sent[i] = clock_type::now();
+		client.send(std::begin(message), std::end(message));
+		std::this_thread::sleep_for(ping_interval);
+	}
+	const bool pinged = wait_for([&](){ return pongs == ping_count; });
+	std::vector<float> sorted = rtt_ms;
+	std::sort(sorted.begin(), sorted.end());
+
+	// bulk reliable transfer, a few KiB per tick until the send queue is full
+	std::vector<uint8_t> bulk(bulk_message_size, 0x5a);
+	bulk[0] = bulk_kind;
+	const auto stats_before = client.stats();
+	const auto start = clock_type::now();
+	for (size_t sent = 0; sent < bulk_bytes;)
+	{
+		for (size_t i = 0; i < bulk_messages_per_tick && sent < bulk_bytes; i++, sent += bulk.size())
+			if (client.send(bulk.begin(), bulk.end()).failed())
+				break;
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	const bool delivered = wait_for([&](){ return bulk_received >= bulk_bytes; });
+	const float seconds = std::chrono::duration<float>(clock_type::now() - start).count();
+	const auto stats_after = client.stats();
+
+	const auto up = proxy.upstream_stats();
+	const auto down = proxy.downstream_stats();
+	spdlog::info("{:<10} rtt p50 {:6.1f} ms, p90 {:6.1f} ms, p99 {:6.1f} ms, max {:6.1f} ms ({}/{} pongs, ENet {} ms)",
+		s.name, percentile(sorted, 0.5f), percentile(sorted, 0.9f), percentile(sorted, 0.99f), sorted.back(), pongs.load(), ping_count, client.server_round_trip_time().count());
+	spdlog::info("{:<10} bulk {:8.1f} KiB/s ({}/{} bytes), retransmits: client {} (bulk {}), server {}, packet loss: client {:.3f}, server {:.3f}",
+		"", bulk_received / seconds / 1024.0f, bulk_received.load(), bulk_bytes,
+		stats_after.retransmits, stats_after.retransmits - stats_before.retransmits, server.stats().retransmits,
+		server.client_packet_loss(client_id), client.server_packet_loss());
+	spdlog::info("{:<10} proxy up: {} forwarded, {} lost, {} duplicated, {} overflowed; down: {} forwarded, {} lost, {} duplicated, {} overflowed",
+		"", up.forwarded_packets, up.lost_packets, up.duplicated_packets, up.overflow_packets,
+		down.forwarded_packets, down.lost_packets, down.duplicated_packets, down.overflow_packets);
+
+	client.close();
+	proxy.close();
+	server.close();
+	return pinged && delivered;
+}
+
+int main()
+{
+	oe::Engine::getSingleton().init({});
+
+	const std::vector<scenario> scenarios = {
+		{ "loopback", {} },
+		{ "lan", { 1ms, 1ms } },
+		{ "broadband", { 20ms, 5ms, 0.01f } },
+		{ "mobile", { 60ms, 20ms, 0.03f, 0.01f, 256 * 1024 } },
+		{ "congested", { 40ms, 10ms, 0.02f, 0.0f, 64 * 1024, 32 * 1024 } },
+	};
+
+	bool ok = true;
+	for (const auto& s : scenarios)
+		ok &= run(s);
+	return ok ? 0 : -1;
+}
@@ -0,0 +1,142 @@
+#include <engine/include.hpp>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+
+
+/*
+
+	Loopback load test
+	hundreds of clients spread over the shards of one Server, messages both ways
+
+*/
+
+constexpr uint16_t port = 12224;
+constexpr size_t shard_count = 4;
+constexpr size_t client_count = 256;
+constexpr size_t messages_per_client = 200;
+constexpr size_t message_size = 32;
+constexpr auto drain_timeout = std::chrono::seconds(20);
+
+using clock_type = std::chrono::high_resolution_clock;
+
+template<typename Fn>
+bool wait_for(Fn&& done)
+{
+	const auto start = clock_type::now();
+	while (!done())
+	{
+		if (clock_type::now() - start > drain_timeout)
+			return false;
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	return true;
+}
+
+float seconds_since(clock_type::time_point start)
+{
+	return std::chrono::duration<float>(clock_type::now() - start).count();
+}
+
+int main()
+{
+	oe::Engine::getSingleton().init({});
+
+	// server
+	oe::networking::Server server{ client_count / shard_count + 1 };
+	std::mutex ids_mtx;
+	std::vector<size_t> client_ids;
+	std::atomic<size_t> server_received{ 0 };
+	std::atomic<size_t> disconnects{ 0 };
+	oe::utils::connect_guard cg_server_connect, cg_server_disconnect, cg_server_receive;
+	cg_server_connect.connect<oe::networking::ServerConnectEvent>(server.m_dispatcher, [&](const oe::networking::ServerConnectEvent& e) {
+		std::scoped_lock lock(ids_mtx);
+		client_ids.push_back(e.client_id);
+	});
+	cg_server_disconnect.connect<oe::networking::ServerDisconnectEvent>(server.m_dispatcher, [&disconnects](const oe::networking::ServerDisconnectEvent&) {
+		disconnects++;
+	});
+	cg_server_receive.connect<oe::networking::ServerReceiveEvent>(server.m_dispatcher, [&server_received](const oe::networking::ServerReceiveEvent&) {
+		server_received++;
+	});
+
+	auto result = server.open(port, shard_count);
+	if (result.failed())
+	{
+		spdlog::critical("Server open failed: {}", result.message());
+		return -1;
+	}
+
+	// clients, round robin over the shard ports
+	std::vector<std::unique_ptr<oe::networking::Client>> clients;
+	std::vector<oe::utils::connect_guard> cg_client_receive(client_count);
+	std::atomic<size_t> client_received{ 0 };
+	auto start = clock_type::now();
+	for (size_t i = 0; i < client_count; i++)
+	{
+		auto& client = clients.emplace_back(std::make_unique<oe::networking::Client>());
+		cg_client_receive[i].connect<oe::networking::ClientReceiveEvent>(client->m_dispatcher, [&client_received](const oe::networking::ClientReceiveEvent&) {
+			client_received++;
+		});
+		result = client->connect("localhost", server.shard_port(i % shard_count));
+		if (result.failed())
+		{
+			spdlog::critical("Client {} connect failed: {}", i, result.message());
+			return -1;
+		}
+	}
+	if (!wait_for([&](){ return server.client_count() == client_count; }))
+	{
+		spdlog::critical("Only {}/{} clients connected", server.client_count(), client_count);
+		return -1;
+	}
+	spdlog::info("{} clients over {} shards connected in {:.3f} s", client_count, shard_count, seconds_since(start));
+
+	// every client -> server
+	const std::vector<uint8_t> message(message_size, 0x5a);
+	constexpr size_t total = client_count * messages_per_client;
+	start = clock_type::now();
+	for (size_t m = 0; m < messages_per_client; m++)
+		for (auto& client : clients)
+			client->send(message.begin(), message.end());
+	const bool upstream = wait_for([&](){ return server_received == total; });
+	const float upstream_time = seconds_since(start);
+	spdlog::info("client -> server: {}/{} messages in {:.3f} s, {:.0f} msg/s", server_received.load(), total, upstream_time, server_received / upstream_time);
+
+	// server -> every client, by id
+	std::vector<size_t> ids;
+	{
+		std::scoped_lock lock(ids_mtx);
+		ids = client_ids;
+	}
+	start = clock_type::now();
+	for (size_t m = 0; m < messages_per_client; m++)
+		for (const size_t id : ids)
+			server.send_to(message.begin(), message.end(), id);
+	const bool downstream = wait_for([&](){ return client_received == total; });
+	const float downstream_time = seconds_since(start);
+	spdlog::info("server -> client: {}/{} messages in {:.3f} s, {:.0f} msg/s", client_received.load(), total, downstream_time, client_received / downstream_time);
+
+	// every shard saw its share of the clients
+	std::vector<size_t> per_shard(server.shard_count(), 0);
+	for (const size_t id : ids)
+		per_shard[oe::networking::Server::client_shard(id)]++;
+	for (size_t shard = 0; shard < per_shard.size(); shard++)
+		spdlog::info("shard {} (port {}): {} clients", shard, server.shard_port(shard), per_shard[shard]);
+
+	const auto stats = server.stats();
+	spdlog::info("server wire: sent {} bytes / {} packets, received {} bytes / {} packets", stats.sent_bytes, stats.sent_packets, stats.received_bytes, stats.received_packets);
+
+	start = clock_type::now();
+	for (auto& client : clients)
+		client->close();
+	const bool disconnected = wait_for([&](){ return disconnects == client_count; });
+	const size_t left = server.client_count();
+	spdlog::info("{} clients disconnected in {:.3f} s, {} left", disconnects.load(), seconds_since(start), left);
+
+	server.close();
+	return upstream && downstream && disconnected && left == 0 ? 0 : -1;
+}
@@ -0,0 +1,103 @@
+#include <engine/include.hpp>
+
+#include <atomic>
+#include <thread>
+
+
+
+/*
+
+	Schema messages over loopback
+	encoded size vs the raw struct, typed dispatch on both ends
+
+*/
+
+constexpr uint16_t port = 12225;
+constexpr size_t message_count = 1000;
+
+struct PlayerState
+{
+	uint32_t entity = 0;
+	glm::vec2 position{ 0.0f };
+	float rotation = 0.0f;
+	int16_t health = 0;
+
+	static constexpr auto schema()
+	{
+		using namespace oe::networking;
+		return std::make_tuple(
+			field(&PlayerState::entity),
+			field(&PlayerState::position, quantize{ -1000.0f, 1000.0f, 20 }),
+			field(&PlayerState::rotation, quantize{ 0.0f, glm::two_pi<float>(), 10 }),
+			field(&PlayerState::health));
+	}
+};
+
+struct Chat
+{
+	uint32_t sender = 0;
+	std::string_view text; // points into the received packet
+
+	static constexpr auto schema()
+	{
+		using namespace oe::networking;
+		return std::make_tuple(field(&Chat::sender), field(&Chat::text));
+	}
+};
+
+using protocol = oe::networking::message_protocol<PlayerState, Chat>;
+
+int main()
+{
+	oe::Engine::getSingleton().init({});
+	auto& random = oe::utils::Random::getSingleton();
+
+	std::vector<uint8_t> encoded;
+	protocol::encode(PlayerState{ 1234, { 12.5f, -200.0f }, 1.0f, 100 }, encoded);
+	spdlog::info("PlayerState: {} bytes encoded, {} bytes as a struct", encoded.size(), sizeof(PlayerState));
+
+	oe::networking::Server server;
+	oe::networking::message_dispatch<protocol> server_dispatch{ server };
+	std::atomic<size_t> states{ 0 }, chats{ 0 }, errors{ 0 };
+	std::atomic<size_t> client_id{ ~size_t(0) };
+	oe::utils::connect_guard cg_connect, cg_state, cg_chat;
+	cg_connect.connect<oe::networking::ServerConnectEvent>(server.m_dispatcher, [&client_id](const oe::networking::ServerConnectEvent& e) {
+		client_id = e.client_id;
+	});
+	cg_state.connect<oe::networking::ServerMessageEvent<PlayerState>>(server.m_dispatcher, [&](const oe::networking::ServerMessageEvent<PlayerState>& e) {
+		if (e.message.health != 100 || std::abs(e.message.position.x) > 1000.0f)
+			errors++;
+		states++;
+	});
+
+	oe::networking::Client client;
+	oe::networking::message_dispatch<protocol> client_dispatch{ client };
+	cg_chat.connect<oe::networking::ClientMessageEvent<Chat>>(client.m_dispatcher, [&](const oe::networking::ClientMessageEvent<Chat>& e) {
+		if (e.message.text != "hello")
+			errors++;
+		chats++;
+	});
+
+	if (server.open(port).failed() || client.connect("localhost", port).failed())
+	{
+		spdlog::critical("Connection failed");
+		return -1;
+	}
+	while (client_id == ~size_t(0))
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+	for (size_t i = 0; i < message_count; i++)
+	{
+		protocol::send(client, PlayerState{ static_cast<uint32_t>(i), random.randomVec2(-1000.0f, 1000.0f), random.randomf(0.0f, glm::two_pi<float>()), 100 });
+		protocol::send_to(server, client_id, Chat{ 0, "hello" });
+	}
+
+	const auto start = std::chrono::high_resolution_clock::now();
+	while ((states < message_count || chats < message_count) && std::chrono::high_resolution_clock::now() - start < std::chrono::seconds(10))
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	spdlog::info("received {}/{} PlayerState, {}/{} Chat, {} errors", states.load(), message_count, chats.load(), message_count, errors.load());
+
+	client.close();
+	server.close();
+	return states == message_count && chats == message_count && errors == 0 ? 0 : -1;
+}
@@ -0,0 +1,242 @@
+#include <engine/include.hpp>
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+
+/*
+
+	Client-side prediction over an impaired link
+	60 ups on both ends, ~130 ms RTT with jitter and loss through an impairment_proxy
+	the server pushes the player once without telling the client, the prediction has to correct and converge
+	and a client that starts well past prediction_history ticks
+	a remote bot circles on the server and is interpolated on the client
+
+*/
+
+constexpr uint16_t server_port = 12228;
+constexpr uint16_t proxy_port = 12229;
+constexpr size_t ups = 60;
+constexpr uint32_t tick_count = 360;
+constexpr uint32_t idle_ticks = 60; // no input at the end, both ends have to agree after it
+constexpr uint32_t push_tick = 120;
+constexpr float speed = 100.0f; // units per second
+constexpr float bot_radius = 50.0f;
+
+enum move_bits : uint8_t { move_left = 1, move_right = 2, move_up = 4, move_down = 8 };
+
+struct InputMessage
+{
+	uint32_t first_tick = 0;
+	gsl::span<const uint8_t> moves; // one direction mask per tick from first_tick
+
+	static constexpr auto schema()
+	{
+		using namespace oe::networking;
+		return std::make_tuple(field(&InputMessage::first_tick), field(&InputMessage::moves));
+	}
+};
+
+struct StateMessage
+{
+	uint32_t server_tick = 0;
+	uint32_t acked_tick = 0;
+	glm::vec2 position{ 0.0f };
+	glm::vec2 bot{ 0.0f };
+
+	static constexpr auto schema()
+	{
+		using namespace oe::networking;
+		return std::make_tuple(field(&StateMessage::server_tick), field(&StateMessage::acked_tick), field(&StateMessage::position), field(&StateMessage::bot));
+	}
+};
+
+using protocol = oe::networking::message_protocol<InputMessage, StateMessage>;
+
+// the same on both ends
+glm::vec2 simulate(const glm::vec2& position, const uint8_t& input)
+{
+	glm::vec2 dir{ 0.0f };
+	if (input & move_left) dir.x -= 1.0f;
+	if (input & move_right) dir.x += 1.0f;
+	if (input & move_up) dir.y += 1.0f;
+	if (input & move_down) dir.y -= 1.0f;
+	return position + dir * (speed / static_cast<float>(ups));
+}
+
+glm::vec2 bot_position(float server_tick)
+{
+	const float angle = server_tick / static_cast<float>(ups);
+	return glm::vec2{ std::cos(angle), std::sin(angle) } * bot_radius;
+}
+
+int main()
+{
+	oe::Engine::getSingleton().init({});
+	using namespace std::chrono_literals;
+	const auto lerp = [](const glm::vec2& a, const glm::vec2& b, float t) { return glm::mix(a, b, t); };
+
+	// a client 500 ticks in before the server hears from it: the queue starts at the oldest resent input
+	// and an ack for a tick that already left the history does not roll the prediction back
+	bool late_start = true;
+	{
+		constexpr uint32_t history = static_cast<uint32_t>(oe::networking::prediction_history);
+		oe::networking::client_prediction<uint8_t, glm::vec2> late{ simulate, glm::vec2{ 0.0f } };
+		oe::networking::input_queue<uint8_t> late_inputs;
+		for (uint32_t t = 0; t < 500; t++)
+			late.predict(move_right);
+		late.for_each_unacked([&](uint32_t t, const uint8_t& move) { late_inputs.push(t, move); });
+		late_start &= late_inputs.buffered() == history;
+
+		uint32_t expected = late.tick() - history + 1;
+		while (auto next = late_inputs.next())
+			late_start &= next->first == expected++;
+		late_start &= late_inputs.processed() == late.tick() && late_inputs.buffered() == 0;
+
+		const glm::vec2 current = late.current();
+		late_start &= !late.reconcile(10, glm::vec2{ 0.0f }) && late.current() == current && late.corrections() == 0;
+		late_start &= late.reconcile(late.tick() - 1, glm::vec2{ 0.0f }) && late.current() == simulate(glm::vec2{ 0.0f }, move_right);
+	}
+	if (!late_start)
+		spdlog::error("late start failed");
+
+	// server: authoritative player and the bot
+	oe::networking::Server server;
+	oe::networking::message_dispatch<protocol> server_dispatch{ server };
+	std::mutex server_mtx;
+	oe::networking::input_queue<uint8_t> inputs;
+	std::atomic<size_t> client_id{ 0 };
+	oe::utils::connect_guard cg_connect, cg_input, cg_state;
+	cg_connect.connect<oe::networking::ServerConnectEvent>(server.m_dispatcher, [&client_id](const oe::networking::ServerConnectEvent& e) {
+		client_id = e.client_id;
+	});
+	cg_input.connect<oe::networking::ServerMessageEvent<InputMessage>>(server.m_dispatcher, [&](const oe::networking::ServerMessageEvent<InputMessage>& e) {
+		std::scoped_lock lock(server_mtx);
+		for (size_t i = 0; i < e.message.moves.size(); i++)
+			inputs.push(e.message.first_tick + static_cast<uint32_t>(i), e.message.moves[i]);
+	});
+
+	// client: predicted player, interpolated bot
+	oe::networking::Client client;
+	oe::networking::message_dispatch<protocol> client_dispatch{ client };
+	oe::networking::client_prediction<uint8_t, glm::vec2> prediction{ simulate, glm::vec2{ 0.0f }, [](const glm::vec2& a, const glm::vec2& b) { return glm::distance(a, b) < 1e-3f; } };
+	oe::utils::spsc_queue<StateMessage> states{ 256 };
+	oe::networking::interpolation_buffer<glm::vec2> bot;
+	oe::networking::interpolation_clock clock{ 3.0f };
+	cg_state.connect<oe::networking::ClientMessageEvent<StateMessage>>(client.m_dispatcher, [&](const oe::networking::ClientMessageEvent<StateMessage>& e) {
+		(void)states.try_push(e.message);
+	});
+
+	oe::networking::impairment_proxy proxy;
+	proxy.configure({ 60ms, 10ms, 0.03f });
+	if (server.open(server_port).failed() || proxy.open(proxy_port, "localhost", server_port).failed() || client.connect("localhost", proxy_port).failed())
+	{
+		spdlog::critical("Connection failed");
+		return -1;
+	}
+
+	glm::vec2 server_position{ 0.0f };
+	uint32_t server_tick = 0;
+	uint32_t acked = 0;
+	size_t unacked_sum = 0;
+	float interpolation_error = 0.0f;
+	size_t interpolation_samples = 0;
+	std::vector<uint8_t> moves;
+
+	// fixed rate ticks like UpdateSystem<ups>, the lag between them drives the interpolation like GameLoop::getUpdateLag
+	const auto target = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::seconds(1)) / ups;
+	auto previous = std::chrono::high_resolution_clock::now();
+	std::chrono::nanoseconds lag{ 0 };
+	uint32_t tick = 0;
+	while (tick < tick_count)
+	{
+		const auto now = std::chrono::high_resolution_clock::now();
+		lag += now - previous;
+		previous = now;
+
+		while (lag >= target && tick < tick_count)
+		{
+			lag -= target;
+			tick++;
+
+			// client tick
+			while (auto state = states.try_pop())
+			{
+				prediction.receive(state->acked_tick, state->position);
+				bot.push(state->server_tick, state->bot);
+				clock.received(state->server_tick);
+			}
+			clock.update();
+
+			const uint8_t input = tick + idle_ticks > tick_count ? 0 : (tick / 90) % 2 ? uint8_t(move_right | move_up) : uint8_t(move_left);
+			prediction.predict(input);
+			unacked_sum += prediction.unacked();
+
+			moves.clear();
+			uint32_t first_tick = 0;
+			prediction.for_each_unacked([&](uint32_t t, const uint8_t& move) {
+				if (moves.empty())
+					first_tick = t;
+				moves.push_back(move);
+			});
+			protocol::send(client, InputMessage{ first_tick, { moves.data(), moves.size() } }, oe::networking::delivery::unreliable);
+
+			// server tick
+			{
+				std::scoped_lock lock(server_mtx);
+				server_tick++;
+				while (auto next = inputs.next())
+				{
+					server_position = simulate(server_position, next->second);
+					acked = next->first;
+					if (acked == push_tick)
+						server_position += glm::vec2{ 0.0f, -20.0f };
+				}
+			}
+			protocol::send_to(server, client_id, StateMessage{ server_tick, acked, server_position, bot_position(static_cast<float>(server_tick)) }, oe::networking::delivery::unreliable);
+		}
+
+		// "frame": where the bot is drawn vs where it was at that server tick
+		const float render_tick = clock.render_tick(std::chrono::duration<float>(lag) / std::chrono::duration<float>(target));
+		if (const auto drawn = bot.sample(render_tick, lerp); drawn && tick > 30)
+		{
+			interpolation_error += glm::distance(*drawn, bot_position(render_tick));
+			interpolation_samples++;
+		}
+		std::this_thread::sleep_for(1ms);
+	}
+
+	// let the last acks arrive while idle, predicting no movement
+	for (size_t i = 0; i < 30; i++)
+	{
+		std::this_thread::sleep_for(target);
+		std::scoped_lock lock(server_mtx);
+		while (auto next = inputs.next())
+		{
+			server_position = simulate(server_position, next->second);
+			acked = next->first;
+		}
+		protocol::send_to(server, client_id, StateMessage{ ++server_tick, acked, server_position, bot_position(static_cast<float>(server_tick)) }, oe::networking::delivery::unreliable);
+	}
+	std::this_thread::sleep_for(200ms);
+	while (auto state = states.try_pop())
+		prediction.receive(state->acked_tick, state->position);
+	prediction.predict(0);
+
+	const float divergence = glm::distance(prediction.current(), server_position);
+	spdlog::info("ticks: {}, acked: {}, mean unacked: {:.1f} ticks, corrections: {}, re-simulated: {} ticks",
+		prediction.tick(), prediction.acked(), static_cast<float>(unacked_sum) / tick_count, prediction.corrections(), prediction.resimulated_ticks());
+	spdlog::info("final client ({:.3f}, {:.3f}) server ({:.3f}, {:.3f}), divergence {:.5f}",
+		prediction.current().x, prediction.current().y, server_position.x, server_position.y, divergence);
+	spdlog::info("bot interpolation: {} frames, mean error {:.3f} units at {:.1f} ticks delay",
+		interpolation_samples, interpolation_samples ? interpolation_error / interpolation_samples : 0.0f, clock.delay());
+	spdlog::info("proxy: {} lost up, {} lost down", proxy.upstream_stats().lost_packets, proxy.downstream_stats().lost_packets);
+
+	client.close();
+	proxy.close();
+	server.close();
+	return late_start && divergence < 1e-3f && prediction.corrections() != 0 ? 0 : -1;
+}
@@ -0,0 +1,94 @@
+#include <engine/utility/perf_logger.hpp>
+#include <engine/internal_libs.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+
+
+/*
+
+	PerfLogger window statistics against known distributions
+	uniform and log-normal samples, percentiles compared to the exact sorted window
+	and a window that slides over to a different distribution
+
+*/
+
+using namespace std::chrono_literals;
+
+constexpr size_t window = 10'000;
+// a bucket is 1/32 of its power of two wide and reports its middle
+constexpr double max_error = 1.0 / oe::utils::latency_histogram::sub_bucket_count;
+
+std::chrono::nanoseconds exact_percentile(std::vector<std::chrono::nanoseconds> samples, double percent)
+{
+	const size_t rank = std::max<size_t>(1, static_cast<size_t>(std::ceil(percent / 100.0 * static_cast<double>(samples.size()))));
+	std::nth_element(samples.begin(), samples.begin() + (rank - 1), samples.end());
+	return samples[rank - 1];
+}
+
+bool close_to(std::chrono::nanoseconds value, std::chrono::nanoseconds expected)
+{
+	return std::abs(static_cast<double>(value.count() - expected.count())) <= static_cast<double>(expected.count()) * max_error;
+}
+
+bool check(std::string_view name, const oe::utils::PerfLogger& logger, const std::vector<std::chrono::nanoseconds>& samples)
+{
+	const auto p50 = exact_percentile(samples, 50.0);
+	const auto p99 = exact_percentile(samples, 99.0);
+	const auto [min, max] = std::minmax_element(samples.begin(), samples.end());
+	const bool ok = close_to(logger.p50(), p50) && close_to(logger.p99(), p99) && logger.m_min_time == *min && logger.m_max_time == *max;
+	spdlog::info("{:<12} p50 {:8} ns (exact {:8}), p99 {:8} ns (exact {:8}) {}", name, logger.p50().count(), p50.count(), logger.p99().count(), p99.count(), ok ? "ok" : "FAIL");
+	return ok;
+}
+
+int main()
+{
+	std::mt19937_64 random{ 42 };
+	oe::utils::PerfLogger logger{ window };
+	bool ok = true;
+
+	ok &= logger.p50() == 0ns && logger.p99() == 0ns && logger.getSampleCount() == 0;
+
+	// 1..10000 us shuffled, p50 is 5 ms and p99 is 9.9 ms
+	std::vector<std::chrono::nanoseconds> uniform;
+	for (size_t i = 1; i <= window; i++)
+		uniform.push_back(std::chrono::microseconds{ i });
+	std::shuffle(uniform.begin(), uniform.end(), random);
+	for (const auto sample : uniform)
+		logger.log(sample);
+	ok &= logger.getSampleCount() == window && logger.m_cached_average_time == 5'000'500ns;
+	ok &= check("uniform", logger, uniform);
+
+	// log-normal around 2 ms with a long tail, the whole uniform window slides out
+	std::lognormal_distribution<double> distribution{ std::log(2'000'000.0), 0.75 };
+	std::vector<std::chrono::nanoseconds> lognormal;
+	for (size_t i = 0; i < window; i++)
+	{
+		lognormal.emplace_back(static_cast<std::chrono::nanoseconds::rep>(distribution(random)));
+		logger.log(lognormal.back());
+	}
+	ok &= logger.getSampleCount() == window && logger.getHistogram().count() == window;
+	ok &= check("log-normal", logger, lognormal);
+
+	// half slid over to a constant 100 us, the median is in the constant half
+	std::vector<std::chrono::nanoseconds> mixed(lognormal.begin() + window / 2, lognormal.end());
+	for (size_t i = 0; i < window / 2 + 1; i++)
+	{
+		mixed.push_back(100us);
+		logger.log(100us);
+	}
+	mixed.erase(mixed.begin());
+	ok &= check("mixed", logger, mixed) && close_to(logger.p50(), 100us);
+
+	// percentile edges
+	ok &= logger.percentile(0.0) <= logger.p50() && logger.p50() <= logger.p99() && logger.p99() <= logger.percentile(100.0);
+	ok &= close_to(logger.percentile(100.0), logger.m_max_time) && close_to(logger.percentile(0.0), logger.m_min_time);
+
+	logger.setWindow(window);
+	ok &= logger.getSampleCount() == 0 && logger.p99() == 0ns;
+
+	return ok ? 0 : -1;
+}
@@ -0,0 +1,144 @@
+#include <engine/utility/profiler.hpp>
+#include <engine/internal_libs.hpp>
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+
+/*
+
+	Profiler
+	ring wrap around and clear, snapshots racing a writer that keeps overwriting them
+	and zones from several threads ending up in the trace
+
+*/
+
+constexpr size_t ring_capacity = 64;
+constexpr size_t race_events = 2'000'000;
+constexpr size_t zone_threads = 4;
+constexpr size_t zones_per_thread = 1000;
+
+// every event carries its index, so a torn copy shows up as a mismatch
+oe::utils::profile_event make_event(size_t i)
+{
+	return { "event", i, i * 3 + 1 };
+}
+
+bool consistent(const std::vector<oe::utils::profile_event>& events, size_t first, size_t count)
+{
+	if (events.size() != count)
+		return false;
+	for (size_t i = 0; i < count; i++)
+		if (events[i].begin_ns != first + i || events[i].end_ns != (first + i) * 3 + 1)
+			return false;
+	return true;
+}
+
+size_t count_of(const std::string& str, const std::string& what)
+{
+	size_t count = 0;
+	for (size_t at = str.find(what); at != std::string::npos; at = str.find(what, at + what.size()))
+		count++;
+	return count;
+}
+
+int main()
+{
+	bool ok = true;
+	std::vector<oe::utils::profile_event> events;
+
+	// wrap around and clear
+	{
+		oe::utils::profile_ring ring{ ring_capacity, 0 };
+		for (size_t i = 0; i < 10; i++)
+			ring.push(make_event(i));
+		ring.snapshot(events);
+		ok &= consistent(events, 0, 10);
+
+		for (size_t i = 10; i < ring_capacity * 3; i++)
+			ring.push(make_event(i));
+		events.clear();
+		ring.snapshot(events);
+		ok &= consistent(events, ring_capacity * 2, ring_capacity);
+
+		ring.clear();
+		ring.push(make_event(ring_capacity * 3));
+		events.clear();
+		ring.snapshot(events);
+		ok &= consistent(events, ring_capacity * 3, 1);
+	}
+
+	// snapshots while the writer laps the ring, whatever comes out has to be whole and in order
+	{
+		oe::utils::profile_ring ring{ ring_capacity, 0 };
+		std::atomic<bool> done{ false };
+		std::thread writer([&](){
+			for (size_t i = 0; i < race_events; i++)
+				ring.push(make_event(i));
+			done = true;
+		});
+
+		size_t snapshots = 0, copied = 0, torn = 0;
+		while (!done)
+		{
+			events.clear();
+			ring.snapshot(events);
+			for (size_t i = 0; i < events.size(); i++)
+			{
+				const bool whole = events[i].end_ns == events[i].begin_ns * 3 + 1 && (i == 0 || events[i].begin_ns > events[i - 1].begin_ns);
+				torn += whole ? 0 : 1;
+			}
+			copied += events.size();
+			snapshots++;
+		}
+		writer.join();
+		ok &= torn == 0;
+
+		events.clear();
+		ring.snapshot(events);
+		ok &= consistent(events, race_events - ring_capacity, ring_capacity);
+		spdlog::info("{} snapshots racing the writer, {} events copied, {} torn", snapshots, copied, torn);
+	}
+
+	// zones from several threads, each with its own ring and name
+	{
+		auto& profiler = oe::utils::Profiler::getSingleton();
+		profiler.clear();
+
+		std::vector<std::thread> threads;
+		for (size_t t = 0; t < zone_threads; t++)
+		{
+			threads.emplace_back([&profiler, t](){
+				profiler.setThreadName(fmt::format("zone thread {}", t));
+				for (size_t i = 0; i < zones_per_thread; i++)
+				{
+					const oe::utils::profile_zone outer{ "outer" };
+					const oe::utils::profile_zone inner{ "inner" };
+				}
+			});
+		}
+		for (auto& thread : threads)
+			thread.join();
+
+		// disabled, nothing recorded
+		profiler.setEnabled(false);
+		{
+			const oe::utils::profile_zone skipped{ "skipped" };
+		}
+		profiler.setEnabled(true);
+
+		const std::string trace = profiler.chromeTrace();
+		ok &= count_of(trace, "\"name\":\"outer\"") == zone_threads * zones_per_thread;
+		ok &= count_of(trace, "\"name\":\"inner\"") == zone_threads * zones_per_thread;
+		ok &= count_of(trace, "\"ph\":\"X\"") == zone_threads * zones_per_thread * 2;
+		ok &= count_of(trace, "skipped") == 0;
+		for (size_t t = 0; t < zone_threads; t++)
+			ok &= count_of(trace, fmt::format("\"zone thread {}\"", t)) == 1;
+		spdlog::info("{} zones in a {} byte trace", count_of(trace, "\"ph\":\"X\""), trace.size());
+	}
+
+	return ok ? 0 : -1;
+}
@@ -0,0 +1,141 @@
+#include <engine/utility/ts_queue.hpp>
+#include <engine/utility/spsc_queue.hpp>
+#include <engine/utility/mpmc_queue.hpp>
+#include <engine/internal_libs.hpp>
+
+#include <array>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+
+
+/*
+
+	Queue contention benchmark
+	ts_queue vs spsc_queue vs mpmc_queue
+
+*/
+
+constexpr size_t message_count = 1'000'000;
+constexpr size_t batch_size = 32;
+
+struct result_t
+{
+	std::chrono::duration<float> time;
+	uint64_t checksum;
+};
+
+template<typename Producer, typename Consumer>
+result_t run(size_t producers, size_t consumers, Producer&& produce, Consumer&& consume)
+{
+	std::atomic<uint64_t> checksum{ 0 };
+	std::vector<std::thread> threads;
+
+	const auto start = std::chrono::high_resolution_clock::now();
+	for (size_t i = 0; i < producers; i++)
+		threads.emplace_back([&, i](){ produce(i * (message_count / producers), (i + 1) * (message_count / producers)); });
+	for (size_t i = 0; i < consumers; i++)
+		threads.emplace_back([&](){ checksum += consume(message_count / consumers); });
+	for (auto& thread : threads)
+		thread.join();
+
+	return { std::chrono::high_resolution_clock::now() - start, checksum };
+}
+
+result_t ts_queue_bench(size_t producers)
+{
+	// ts_queue front() and pop() are separate locks, so only one consumer is safe
+	oe::utils::ts_queue<uint64_t> queue;
+	return run(producers, 1,
+		[&](size_t first, size_t last){
+			for (size_t i = first; i < last; i++)
+				queue.push(i);
+		},
+		[&](size_t count){
+			uint64_t sum = 0;
+			for (size_t i = 0; i < count; i++)
+			{
+				queue.wait();
+				sum += queue.front().first;
+				queue.pop();
+			}
+			return sum;
+		});
+}
+
+template<typename Queue>
+result_t lockfree_bench(size_t producers, size_t consumers, bool batched)
+{
+	Queue queue{ 4096 };
+	return run(producers, consumers,
+		[&](size_t first, size_t last){
+			if (!batched)
+			{
+				for (size_t i = first; i < last; i++)
+					queue.push(i);
+				return;
+			}
+
+			std::array<uint64_t, batch_size> batch;
+			for (size_t i = first; i < last;)
+			{
+				const size_t count = std::min(batch_size, last - i);
+				std::iota(batch.begin(), batch.begin() + count, i);
+				auto iter = batch.begin();
+				while ((iter = queue.try_push(iter, batch.begin() + count)) != batch.begin() + count)
+					queue.wait_writable();
+				i += count;
+			}
+		},
+		[&](size_t count){
+			uint64_t sum = 0;
+			std::array<uint64_t, batch_size> batch;
+			for (size_t i = 0; i < count;)
+			{
+				if (!batched)
+				{
+					sum += queue.wait_pop();
+					i++;
+					continue;
+				}
+
+				queue.wait();
+				const size_t popped = queue.try_pop(batch.begin(), std::min(batch_size, count - i));
+				sum = std::accumulate(batch.begin(), batch.begin() + popped, sum);
+				i += popped;
+			}
+			return sum;
+		});
+}
+
+void report(std::string_view name, const result_t& result)
+{
+	constexpr uint64_t expected = static_cast<uint64_t>(message_count) * (message_count - 1) / 2;
+	if (result.checksum != expected)
+		spdlog::critical("{}: checksum mismatch {} != {}", name, result.checksum, expected);
+	spdlog::info("{:<28} {:8.3f} ms {:8.2f} Mmsg/s", name, result.time.count() * 1000.0f, message_count / result.time.count() / 1'000'000.0f);
+}
+
+int main()
+{
+	const size_t threads = std::thread::hardware_concurrency() >= 8 ? 4 : 2;
+
+	spdlog::info("1 producer, 1 consumer");
+	report("ts_queue", ts_queue_bench(1));
+	report("spsc_queue", lockfree_bench<oe::utils::spsc_queue<uint64_t>>(1, 1, false));
+	report("spsc_queue (batched)", lockfree_bench<oe::utils::spsc_queue<uint64_t>>(1, 1, true));
+	report("mpmc_queue", lockfree_bench<oe::utils::mpmc_queue<uint64_t>>(1, 1, false));
+	report("mpmc_queue (batched)", lockfree_bench<oe::utils::mpmc_queue<uint64_t>>(1, 1, true));
+
+	spdlog::info("{} producers, 1 consumer", threads);
+	report("ts_queue", ts_queue_bench(threads));
+	report("mpmc_queue", lockfree_bench<oe::utils::mpmc_queue<uint64_t>>(threads, 1, false));
+	report("mpmc_queue (batched)", lockfree_bench<oe::utils::mpmc_queue<uint64_t>>(threads, 1, true));
+
+	spdlog::info("{} producers, {} consumers", threads, threads);
+	report("mpmc_queue", lockfree_bench<oe::utils::mpmc_queue<uint64_t>>(threads, threads, false));
+	report("mpmc_queue (batched)", lockfree_bench<oe::utils::mpmc_queue<uint64_t>>(threads, threads, true));
+
+	return 0;
+}
\ No newline at end of file
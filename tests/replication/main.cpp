@@ -0,0 +1,148 @@
+#include <engine/include.hpp>
+
+#include <atomic>
+#include <thread>
+
+
+
+/*
+
+	Delta-compressed ECS replication over loopback
+	bytes per tick for 1k and 10k entities, full world and with an interest radius
+
+*/
+
+constexpr uint16_t port = 12223;
+constexpr float world_size = 2000.0f;
+constexpr float interest_radius = 100.0f;
+constexpr float moving_fraction = 0.1f;
+constexpr size_t tick_count = 100;
+constexpr auto tick_interval = std::chrono::milliseconds(16);
+
+struct Position { glm::vec2 value; };
+struct Health { int32_t current; int32_t max; };
+
+struct scenario_t
+{
+	size_t entity_count;
+	float radius; // < 0 for the whole world
+};
+
+void run(oe::networking::Server& server, oe::networking::Client& client, size_t client_id, const scenario_t& scenario)
+{
+	auto& random = oe::utils::Random::getSingleton();
+	oe::ecs::World server_world;
+	oe::ecs::World client_world;
+
+	oe::networking::ReplicationServer replication_server{ server, server_world };
+	replication_server.replicate<Position>();
+	replication_server.replicate<Health>();
+	oe::networking::ReplicationClient replication_client{ client, client_world };
+	replication_client.replicate<Position>();
+	replication_client.replicate<Health>();
+
+	// the connect event already happened, pretend it did not
+	server.m_dispatcher.trigger(oe::networking::ServerConnectEvent{ client_id });
+	if (scenario.radius >= 0.0f)
+		replication_server.set_interest(client_id, glm::vec2{ 0.0f }, scenario.radius);
+
+	std::vector<entt::entity> entities;
+	entities.reserve(scenario.entity_count);
+	for (size_t i = 0; i < scenario.entity_count; i++)
+	{
+		const auto entity = server_world.m_scene.create();
+		const glm::vec2 position = random.randomVec2(-world_size * 0.5f, world_size * 0.5f);
+		server_world.m_scene.emplace<Position>(entity, position);
+		server_world.m_scene.emplace<Health>(entity, 100, 100);
+		server_world.m_spatial_index.update(entity, oe::ecs::AABB{ position, position });
+		entities.push_back(entity);
+	}
+
+	const auto stats_before = server.stats();
+	size_t snapshot_bytes = 0;
+	size_t first_snapshot = 0;
+	for (size_t tick = 0; tick < tick_count; tick++)
+	{
+		// a fraction of the entities move a little, some take damage
+		const size_t moving = static_cast<size_t>(scenario.entity_count * moving_fraction);
+		for (size_t i = 0; i < moving; i++)
+		{
+			const auto entity = entities[random.randomi(0, static_cast<int32_t>(entities.size()) - 1)];
+			auto& position = server_world.m_scene.get<Position>(entity);
+			position.value += random.randomVec2(-1.0f, 1.0f);
+			server_world.m_spatial_index.update(entity, oe::ecs::AABB{ position.value, position.value });
+			if (i % 8 == 0)
+				server_world.m_scene.get<Health>(entity).current--;
+		}
+
+		replication_server.update();
+		snapshot_bytes += replication_server.last_snapshot_size(client_id);
+		if (tick == 0)
+			first_snapshot = replication_server.last_snapshot_size(client_id);
+
+		std::this_thread::sleep_for(tick_interval);
+		replication_client.update();
+	}
+
+	// let the last snapshots arrive
+	std::this_thread::sleep_for(tick_interval * 4);
+	replication_client.update();
+
+	const auto stats_after = server.stats();
+	const size_t wire_bytes = stats_after.sent_bytes - stats_before.sent_bytes;
+	const std::string area = scenario.radius < 0.0f ? "everything" : fmt::format("radius {:.0f}", scenario.radius);
+	spdlog::info("{:6} entities, {:<12} first snapshot: {:8} bytes, delta: {:7.0f} bytes/tick, wire: {:7.0f} bytes/tick, full state: {:8} bytes/tick, client has {} entities (seq {}/{})",
+		scenario.entity_count, area, first_snapshot,
+		static_cast<float>(snapshot_bytes - first_snapshot) / (tick_count - 1), static_cast<float>(wire_bytes) / tick_count,
+		scenario.entity_count * (sizeof(uint32_t) + sizeof(Position) + sizeof(Health)),
+		replication_client.entity_count(), replication_client.latest_sequence(), replication_server.sequence());
+
+	// the last ack belongs to this run, not the next one
+	std::this_thread::sleep_for(tick_interval);
+	server.m_dispatcher.trigger(oe::networking::ServerDisconnectEvent{ client_id });
+	client_world.clear();
+	server_world.clear();
+}
+
+int main()
+{
+	auto& engine = oe::Engine::getSingleton();
+	engine.init({});
+
+	// World needs a context for its renderers
+	oe::WindowInfo window_info;
+	window_info.title = "Replication";
+	window_info.swap_interval = 0;
+	oe::graphics::Window window{ window_info };
+
+	oe::networking::Server server;
+	std::atomic<size_t> client_id{ ~size_t(0) };
+	oe::utils::connect_guard cg_server_connect;
+	cg_server_connect.connect<oe::networking::ServerConnectEvent>(server.m_dispatcher, [&client_id](const oe::networking::ServerConnectEvent& e) {
+		client_id = e.client_id;
+	});
+	auto result = server.open(port);
+	if (result.failed())
+	{
+		spdlog::critical("Server open failed: {}", result.message());
+		return -1;
+	}
+
+	oe::networking::Client client;
+	result = client.connect("localhost", port);
+	if (result.failed())
+	{
+		spdlog::critical("Client connect failed: {}", result.message());
+		return -1;
+	}
+	while (client_id == ~size_t(0))
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	cg_server_connect.reset();
+
+	for (const scenario_t& scenario : { scenario_t{ 1'000, -1.0f }, scenario_t{ 10'000, -1.0f }, scenario_t{ 10'000, interest_radius } })
+		run(server, client, client_id, scenario);
+
+	client.close();
+	server.close();
+	return 0;
+}
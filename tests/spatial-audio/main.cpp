@@ -0,0 +1,173 @@
+#include <engine/include.hpp>
+
+#include <cmath>
+#include <vector>
+
+
+
+/*
+
+	Distance attenuation and panning, the loudest emitters picked for voices, playheads of virtual emitters
+	and update + mix cost with 10k emitters moving every tick
+
+*/
+
+constexpr uint32_t sample_rate = 48000;
+constexpr size_t emitter_count = 10'000;
+constexpr float world_size = 400.0f;
+constexpr size_t tick_frames = sample_rate / 60;
+constexpr size_t tick_count = 300;
+
+std::shared_ptr<const oe::utils::audio_data> make_clip(int frames, int rate)
+{
+	std::vector<int16_t> samples(static_cast<size_t>(frames));
+	for (int i = 0; i < frames; i++)
+		samples[static_cast<size_t>(i)] = static_cast<int16_t>(std::sin(static_cast<float>(i) * 0.0576f) * 16000.0f);
+	return std::make_shared<const oe::utils::audio_data>(samples.data(), 0, static_cast<int>(samples.size() * sizeof(int16_t)), 1, rate);
+}
+
+float peak(const std::vector<float>& samples, size_t frames, size_t channel)
+{
+	float peak = 0.0f;
+	for (size_t i = 0; i < frames; i++)
+		peak = std::max(peak, std::abs(samples[i * 2 + channel]));
+	return peak;
+}
+
+int main()
+{
+	oe::Engine::getSingleton().init({});
+	auto& random = oe::utils::Random::getSingleton();
+	bool ok = true;
+
+	oe::audio::device_settings settings;
+	settings.backend = oe::audio::audio_backend::none;
+	settings.sample_rate = sample_rate;
+	settings.max_voices = 64;
+	oe::audio::AudioDevice device{ settings };
+	std::vector<float> out(tick_frames * 2 * 8);
+
+	// the curve
+	{
+		oe::audio::SoundEmitter emitter;
+		emitter.min_distance = 2.0f;
+		emitter.max_distance = 20.0f;
+		ok &= oe::audio::distance_gain(emitter, 1.0f) == 1.0f && oe::audio::distance_gain(emitter, 20.0f) == 0.0f;
+		ok &= oe::audio::distance_gain(emitter, 5.0f) > oe::audio::distance_gain(emitter, 10.0f) && oe::audio::distance_gain(emitter, 19.0f) > 0.0f;
+		ok &= oe::audio::distance_pan(emitter, { 10.0f, 0.0f }) == 1.0f && oe::audio::distance_pan(emitter, { -5.0f, 5.0f }) < -0.7f && oe::audio::distance_pan(emitter, { 0.0f, 8.0f }) == 0.0f;
+		emitter.rolloff = 0.0f;
+		ok &= std::abs(oe::audio::distance_gain(emitter, 11.0f) - 0.5f) < 1e-4f;
+	}
+
+	const auto clip = make_clip(44100, 44100);
+
+	// one emitter to the right of the listener
+	{
+		oe::ecs::World world;
+		oe::audio::SpatialAudio spatial{ device, world };
+		auto entity = world.create();
+		auto& emitter = entity.setComponent<oe::audio::SoundEmitter>();
+		emitter.clip = clip;
+		emitter.position = { 2.0f, 0.0f };
+
+		spatial.update({ 0.0f, 0.0f });
+		device.render(out.data(), 4096);
+		ok &= spatial.stats().real == 1 && peak(out, 4096, 1) > 0.1f && peak(out, 4096, 0) < 0.05f;
+
+		// replaced, the old voice stops and the new one starts over
+		entity.setComponent<oe::audio::SoundEmitter>().clip = clip;
+		spatial.update({ 0.0f, 0.0f });
+		ok &= spatial.stats().demoted == 1 && spatial.stats().promoted == 1;
+
+		// destroyed
+		entity.destroy();
+		spatial.update({ 0.0f, 0.0f });
+		device.render(out.data(), oe::audio::AudioDevice::block_frames * 2);
+		ok &= spatial.stats().real == 0 && spatial.stats().demoted == 1 && device.stats().voices == 0;
+	}
+
+	// 10k emitters
+	oe::ecs::World world;
+	std::vector<entt::entity> entities;
+	for (size_t i = 0; i < emitter_count; i++)
+	{
+		auto entity = world.create();
+		auto& emitter = entity.setComponent<oe::audio::SoundEmitter>();
+		emitter.clip = clip;
+		emitter.position = random.randomVec2(-world_size * 0.5f, world_size * 0.5f);
+		emitter.pitch = random.randomf(0.8f, 1.2f);
+		emitter.max_distance = 60.0f;
+		entities.push_back(entity.m_entity);
+	}
+
+	oe::audio::SpatialAudio spatial{ device, world, { 32 } };
+	glm::vec2 listener{ 0.0f };
+	spatial.update(listener);
+	{
+		// the loudest got the voices
+		float quietest_real = 1.0f, loudest_virtual = 0.0f;
+		world.m_scene.view<oe::audio::SoundEmitter>().each([&](const oe::audio::SoundEmitter& emitter){
+			if (emitter.state.real)
+				quietest_real = std::min(quietest_real, emitter.state.gain);
+			else
+				loudest_virtual = std::max(loudest_virtual, emitter.state.gain);
+		});
+		const auto& stats = spatial.stats();
+		ok &= stats.emitters == emitter_count && stats.audible > 32 && stats.real == 32 && quietest_real >= loudest_virtual;
+		spdlog::info("{} emitters, {} audible, {} real", stats.emitters, stats.audible, stats.real);
+	}
+
+	// virtual playheads keep up with the device clock
+	{
+		const auto& emitter = world.m_scene.get<oe::audio::SoundEmitter>(entities.front());
+		const double before = emitter.state.playhead;
+		device.render(out.data(), 4800);
+		spatial.update(listener);
+		const double expected = std::fmod(before + 4800.0 * std::clamp(emitter.pitch, 0.125f, 8.0f) * 44100.0 / sample_rate, 44100.0);
+		ok &= std::abs(emitter.state.playhead - expected) < 1e-3;
+	}
+
+	// everything moving, the listener too
+	{
+		float update_ms = 0.0f, update_peak = 0.0f, mix_ms = 0.0f;
+		size_t promoted = 0, demoted = 0, updated = 0, max_real = 0;
+		std::vector<glm::vec2> velocities(emitter_count);
+		for (auto& velocity : velocities)
+			velocity = random.randomVec2(-0.5f, 0.5f);
+
+		for (size_t tick = 0; tick < tick_count; tick++)
+		{
+			for (size_t i = 0; i < emitter_count; i++)
+				world.m_scene.get<oe::audio::SoundEmitter>(entities[i]).position += velocities[i];
+			listener += glm::vec2{ 0.3f, 0.1f };
+
+			spatial.update(listener);
+			const auto start = std::chrono::high_resolution_clock::now();
+			device.render(out.data(), tick_frames);
+			mix_ms += std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+			const auto& stats = spatial.stats();
+			update_ms += stats.update_ms;
+			update_peak = std::max(update_peak, stats.update_ms);
+			promoted += stats.promoted;
+			demoted += stats.demoted;
+			updated += stats.updated;
+			max_real = std::max(max_real, stats.real);
+		}
+		const auto device_stats = device.stats();
+		const float tick_ms = 1000.0f / 60.0f;
+
+		ok &= max_real <= 32 && device_stats.voices <= device.max_voices() && promoted > 0 && demoted > 0;
+		spdlog::info("{} emitters, {} ticks: update {:.3f} ms average, {:.3f} ms peak", emitter_count, tick_count, update_ms / tick_count, update_peak);
+		spdlog::info("mix {:.3f} ms per {} frame tick, update + mix {:.2f}% of the tick", mix_ms / tick_count, tick_frames, (update_ms + mix_ms) / tick_count / tick_ms * 100.0f);
+		spdlog::info("{} promoted, {} demoted, {} voice updates", promoted, demoted, updated);
+	}
+
+	// cleared World, every voice stopped
+	world.clear();
+	spatial.update(listener);
+	device.render(out.data(), oe::audio::AudioDevice::block_frames * 2);
+	ok &= spatial.stats().real == 0 && device.stats().voices == 0;
+
+	return ok ? 0 : -1;
+}
@@ -0,0 +1,95 @@
+#include <engine/include.hpp>
+
+
+
+/*
+
+	Spatial index and culling benchmark
+	camera views covering 1% and 100% of a 1M entity world
+	culled by testing every quad and through the spatial index
+
+*/
+
+constexpr size_t entity_count = 1'000'000;
+constexpr float world_size = 2000.0f;
+constexpr size_t iterations = 10;
+
+template<typename Fn>
+std::chrono::duration<float, std::milli> benchmark(Fn&& fn)
+{
+	const auto start = std::chrono::high_resolution_clock::now();
+	for (size_t i = 0; i < iterations; i++)
+		fn();
+	return std::chrono::duration_cast<std::chrono::duration<float, std::milli>>(std::chrono::high_resolution_clock::now() - start) / iterations;
+}
+
+int main()
+{
+	auto& engine = oe::Engine::getSingleton();
+	engine.init({});
+
+	oe::WindowInfo window_info;
+	window_info.title = "Spatial";
+	window_info.swap_interval = 0;
+	oe::graphics::Window window{ window_info };
+	auto& random = oe::utils::Random::getSingleton();
+
+	// world
+	oe::ecs::World world;
+	oe::graphics::Renderer renderer{ static_cast<int32_t>(entity_count) };
+	oe::asset::DefaultShader shader;
+	for (size_t i = 0; i < entity_count; i++)
+	{
+		auto entity = world.create();
+		auto& quad = entity.setComponent<oe::ecs::QuadComponent>();
+		quad.quad_holder = renderer.create();
+		quad.quad_holder->setPosition(random.randomVec2(-world_size * 0.5f, world_size * 0.5f));
+		quad.quad_holder->setSize(random.randomVec2(0.1f, 2.0f));
+		quad.quad_holder->setRotation(random.randomf(0.0f, glm::two_pi<float>()));
+		quad.quad_holder->setColor(oe::colors::white);
+	}
+
+	const auto build_time = benchmark([&](){ world.updateSpatialIndex(); });
+	spdlog::info("spatial index build + 9 idle updates: {:.3f} ms", build_time.count());
+
+	// 1% moving
+	const auto move_time = benchmark([&](){
+		world.m_scene.view<oe::ecs::QuadComponent>().each([&random](oe::ecs::QuadComponent& quad) {
+			if (random.randomf(0.0f, 1.0f) < 0.01f)
+				quad.quad_holder->setPosition(random.randomVec2(-world_size * 0.5f, world_size * 0.5f));
+		});
+		world.updateSpatialIndex();
+	});
+	spdlog::info("1% moved + spatial index update: {:.3f} ms", move_time.count());
+
+	shader.bind();
+	for (const float coverage : { 0.01f, 1.0f })
+	{
+		// square camera covering 'coverage' of the world area
+		const float half_view = world_size * 0.5f * std::sqrt(coverage);
+		const oe::ecs::AABB view{ glm::vec2{ -half_view }, glm::vec2{ half_view } };
+		const glm::mat4 pr_matrix = glm::ortho(-half_view, half_view, half_view, -half_view);
+		shader.setProjectionMatrix(pr_matrix);
+
+		size_t found = 0;
+		const auto query_time = benchmark([&](){ found = 0; world.m_spatial_index.query(view, [&found](entt::entity){ found++; }); });
+		const auto radius_time = benchmark([&](){ found = 0; world.m_spatial_index.query(glm::vec2{ 0.0f }, half_view, [&found](entt::entity){ found++; }); });
+
+		renderer.disableCulling();
+		const auto render_time = benchmark([&](){ renderer.render(); });
+		renderer.setCullArea(pr_matrix);
+		const auto culled_render_time = benchmark([&](){ renderer.render(); });
+		renderer.setCullSource(world.cullSource(renderer));
+		const auto index_render_time = benchmark([&](){ renderer.render(); });
+		renderer.setCullSource({});
+		window->update();
+
+		spdlog::info("view {:5.1f}% - rect query: {:.3f} ms, radius query: {:.3f} ms ({} entities), render: {:.3f} ms, culled render: {:.3f} ms, index culled render: {:.3f} ms",
+			coverage * 100.0f, query_time.count(), radius_time.count(), found, render_time.count(), culled_render_time.count(), index_render_time.count());
+	}
+
+	// renderer first, so that the quads won't search for themselves one by one
+	renderer.clear();
+	world.clear();
+	return 0;
+}
\ No newline at end of file
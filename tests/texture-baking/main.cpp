@@ -0,0 +1,137 @@
+#include <engine/include.hpp>
+
+#include <cstring>
+#include <vector>
+
+
+
+/*
+
+	Texture load times, PNG vs baked
+	decoding PNGs and building their mip levels vs mapping .oetex files with the levels already in them
+	raw and lz4 compressed, and a sprite pack's sprite table surviving the round trip
+
+*/
+
+constexpr size_t image_count = 16;
+constexpr int image_size = 1024;
+
+using clock_type = std::chrono::high_resolution_clock;
+
+oe::utils::image_data make_image(size_t seed)
+{
+	oe::utils::image_data image{ oe::formats::rgba, image_size, image_size };
+	for (int y = 0; y < image_size; y++)
+		for (int x = 0; x < image_size; x++)
+		{
+			uint8_t* pixel = image.data + (static_cast<size_t>(y) * image_size + x) * 4;
+			pixel[0] = static_cast<uint8_t>((x / 32 + y / 32 + seed) % 2 ? 220 : 40);
+			pixel[1] = static_cast<uint8_t>(x >> 2);
+			pixel[2] = static_cast<uint8_t>(y >> 2);
+			pixel[3] = 255;
+		}
+	return image;
+}
+
+// what a texture needs on the CPU side before the upload: full size pixels and every mip level
+size_t load_png(const oe::utils::FileIO& path)
+{
+	const auto image = path.read<oe::utils::image_data>();
+	size_t bytes = image.size;
+	oe::utils::image_data level = image;
+	while (level.width > 1 || level.height > 1)
+	{
+		level = level.cast(oe::formats::none, std::max(1, level.width / 2), std::max(1, level.height / 2), oe::utils::image_filter::box);
+		bytes += level.size;
+	}
+	return bytes;
+}
+
+size_t load_baked(const oe::utils::FileIO& path)
+{
+	const oe::asset::BakedTexture baked{ path };
+	const oe::TextureInfo info = baked.texture_info();
+	size_t bytes = 0;
+	for (size_t i = 0; i < baked.levels(); i++)
+		bytes += baked.level(i).size();
+	return info.mipmaps.size() + 1 == baked.levels() ? bytes : 0;
+}
+
+float time_ms(const std::vector<oe::utils::FileIO>& paths, size_t(*load)(const oe::utils::FileIO&), size_t& bytes)
+{
+	bytes = 0;
+	const auto start = clock_type::now();
+	for (const auto& path : paths)
+		bytes += load(path);
+	return std::chrono::duration<float, std::milli>(clock_type::now() - start).count();
+}
+
+int main()
+{
+	oe::Engine::getSingleton().init({});
+	bool ok = true;
+
+	const oe::utils::FileIO folder = oe::utils::FileIO{ fs::temp_directory_path() } / "oe_texture_baking";
+	std::vector<oe::utils::FileIO> pngs, raw, compressed;
+	size_t png_size = 0, raw_size = 0, compressed_size = 0;
+	for (size_t i = 0; i < image_count; i++)
+	{
+		const auto image = make_image(i);
+		pngs.push_back(folder / fmt::format("image_{}.png", i));
+		raw.push_back(folder / fmt::format("image_{}.oetex", i));
+		compressed.push_back(folder / fmt::format("image_{}_lz4.oetex", i));
+
+		const auto png = image.save();
+		const auto baked_raw = oe::asset::BakedTexture::bake(image);
+		const auto baked_compressed = oe::asset::BakedTexture::bake(image, { true, true });
+		pngs.back().write(png);
+		raw.back().write(baked_raw);
+		compressed.back().write(baked_compressed);
+		png_size += png.size();
+		raw_size += baked_raw.size();
+		compressed_size += baked_compressed.size();
+
+		// same pixels as the PNG
+		const oe::asset::BakedTexture check{ compressed.back() };
+		ok &= check.levels() == 11 && check.width() == image_size && std::memcmp(check.level(0).data(), image.data, image.size) == 0;
+	}
+
+	size_t png_bytes, raw_bytes, compressed_bytes;
+	const float png_time = time_ms(pngs, load_png, png_bytes);
+	const float raw_time = time_ms(raw, load_baked, raw_bytes);
+	const float compressed_time = time_ms(compressed, load_baked, compressed_bytes);
+	ok &= png_bytes == raw_bytes && raw_bytes == compressed_bytes;
+
+	constexpr float mib = 1024.0f * 1024.0f;
+	spdlog::info("{} {}x{} textures with mip levels", image_count, image_size, image_size);
+	spdlog::info("PNG decode + mipmaps: {:8.3f} ms, {:6.2f} MiB on disk", png_time, png_size / mib);
+	spdlog::info("baked, mapped:        {:8.3f} ms, {:6.2f} MiB on disk ({:.1f}x faster)", raw_time, raw_size / mib, png_time / raw_time);
+	spdlog::info("baked, lz4:           {:8.3f} ms, {:6.2f} MiB on disk ({:.1f}x faster)", compressed_time, compressed_size / mib, png_time / compressed_time);
+
+	// sprite table
+	{
+		oe::graphics::SpritePack pack;
+		for (size_t i = 0; i < 4; i++)
+			pack.create(make_image(i).cast(oe::formats::none, 64 + static_cast<int>(i) * 16, 64));
+		const oe::utils::FileIO atlas_path = folder / "atlas.oetex";
+		atlas_path.write(oe::asset::BakedTexture::bake(pack));
+
+		const oe::asset::BakedTexture atlas{ atlas_path };
+		const auto sprites = atlas.sprites(oe::graphics::Texture{});
+		ok &= sprites.size() == pack.getSprites().size();
+		for (size_t i = 0; i < sprites.size() && ok; i++)
+			ok &= sprites[i].position == pack.getSprites()[i]->position && sprites[i].size == pack.getSprites()[i]->size && sprites[i].opacity == pack.getSprites()[i]->opacity;
+		spdlog::info("atlas: {}x{}, {} sprites", atlas.width(), atlas.height(), sprites.size());
+	}
+
+	// not a baked texture
+	try
+	{
+		const oe::asset::BakedTexture invalid{ pngs.front() };
+		ok = false;
+	}
+	catch (const std::exception&) {}
+
+	folder.remove();
+	return ok ? 0 : -1;
+}
@@ -0,0 +1,83 @@
+#include <engine/include.hpp>
+
+#include <string>
+#include <vector>
+
+
+
+/*
+
+	Bakes images into .oetex files for oe::asset::BakedTexture
+
+	texture-baker [--atlas] [--no-mipmaps] [--lz4] <output.oetex> <image>...
+		one image is baked as is
+		more than one, or --atlas, are packed into a sprite pack
+		the sprites keep the argument order after the pack's own white pixel at index 0
+
+*/
+
+constexpr std::string_view usage = "usage: texture-baker [--atlas] [--no-mipmaps] [--lz4] <output.oetex> <image>...";
+
+int main(int argc, char** argv)
+{
+	oe::Engine::getSingleton().init({});
+
+	bool atlas = false;
+	oe::asset::bake_settings settings;
+	std::vector<std::string> paths;
+	for (int i = 1; i < argc; i++)
+	{
+		const std::string_view arg = argv[i];
+		if (arg == "--atlas")
+			atlas = true;
+		else if (arg == "--no-mipmaps")
+			settings.mipmaps = false;
+		else if (arg == "--lz4")
+			settings.compress = true;
+		else if (arg.size() > 1 && arg.front() == '-')
+		{
+			spdlog::error("unknown option '{}'\n{}", arg, usage);
+			return -1;
+		}
+		else
+			paths.emplace_back(arg);
+	}
+
+	if (paths.size() < 2)
+	{
+		spdlog::error(usage);
+		return -1;
+	}
+
+	const oe::utils::FileIO output = paths.front();
+	const std::vector<std::string> inputs{ paths.begin() + 1, paths.end() };
+	try
+	{
+		const auto start = std::chrono::high_resolution_clock::now();
+		oe::utils::byte_string baked;
+		if (inputs.size() == 1 && !atlas)
+		{
+			baked = oe::asset::BakedTexture::bake(oe::utils::FileIO{ inputs.front() }.read<oe::utils::image_data>(), settings);
+		}
+		else
+		{
+			oe::graphics::SpritePack pack;
+			for (const auto& input : inputs)
+				pack.create(oe::utils::FileIO{ input });
+			baked = oe::asset::BakedTexture::bake(pack, settings);
+		}
+		output.write(baked);
+
+		const oe::asset::BakedTexture check{ output };
+		const std::chrono::duration<float, std::milli> time = std::chrono::high_resolution_clock::now() - start;
+		spdlog::info("{}: {}x{}, {} levels, {} images, {} bytes in {:.1f} ms",
+			output.getPath().generic_string(), check.width(), check.height(), check.levels(), inputs.size(), baked.size(), time.count());
+	}
+	catch (const std::exception& e)
+	{
+		spdlog::error("baking '{}' failed: {}", output.getPath().generic_string(), e.what());
+		return -1;
+	}
+
+	return 0;
+}